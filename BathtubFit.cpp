@@ -0,0 +1,201 @@
+/*!
+ \file   BathtubFit.cpp
+ \brief  Dual-Dirac Bathtub Fit - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+
+#include <math.h>
+
+#include "BathtubFit.h"
+
+
+const double BathtubFit::TRANSITION_DENSITY = 0.5;
+
+
+/*!
+ \brief Fit the dual-Dirac model to a bathtub curve
+
+ The curve is expected in the form produced by a bathtub scan (see
+ EyeMonitor): log10(BER) for each phase step across 1 UI, shifted so that
+ the crossing point is at the left end, and with points below the
+ measurement floor set to globals::BELOW_DETECTION_LIMIT.
+
+ The open part of the eye (points below the floor, or the lowest point if
+ there are none) splits the curve into a left and a right tail. Points on
+ each tail with BER <= fitBERMax are converted to Q and fitted.
+
+ \param curve      Bathtub curve: log10(BER) at each phase step (1 UI in total)
+ \param fitBERMax  Highest BER used in the fit (only the tails follow the model)
+ \param result     Used to return the fit result
+
+ \return globals::OK            Both tails fitted (result->valid is set)
+ \return globals::OVERFLOW      Parameter out of range
+ \return globals::INVALID_DATA  Not enough points on the tails to fit
+*/
+int BathtubFit::fit(const QVector<double> &curve,
+                    const double fitBERMax,
+                    result_t *result)
+{
+    const int nPoints = curve.size();
+    QVector<double> xLeft, qLeft, xRight, qRight;
+    double intercept, slope;
+    int i, openStart, openStop, minIndex;
+    int fitResult;
+
+    *result = result_t();
+    result->valid = false;
+    if (nPoints < (2 * MIN_TAIL_POINTS) || fitBERMax <= 0.0 || fitBERMax >= TRANSITION_DENSITY) return globals::OVERFLOW;
+
+    // Find the open part of the eye:
+    openStart = -1;
+    openStop  = -1;
+    minIndex  = 0;
+    for (i = 0; i < nPoints; i++)
+    {
+        if (curve[i] == globals::BELOW_DETECTION_LIMIT)
+        {
+            if (openStart < 0) openStart = i;
+            openStop = i;
+        }
+        if (curve[i] < curve[minIndex]) minIndex = i;
+    }
+    if (openStart < 0) { openStart = minIndex; openStop = minIndex; }
+
+    // Convert the tails to Q-scale (x in UI):
+    for (i = 0; i < nPoints; i++)
+    {
+        if ((i >= openStart) && (i <= openStop)) continue;
+        if (curve[i] == globals::BELOW_DETECTION_LIMIT) continue;
+        const double ber = pow(10.0, curve[i]);
+        if (ber > fitBERMax) continue;
+        const double x = static_cast<double>(i) / static_cast<double>(nPoints);
+        if (i < openStart) { xLeft.append(x);  qLeft.append(qFromBER(ber));  }
+        else               { xRight.append(x); qRight.append(qFromBER(ber)); }
+    }
+    result->pointsLeft  = xLeft.size();
+    result->pointsRight = xRight.size();
+
+    // Left tail: Q = (x - mu) / sigma
+    fitResult = fitTail(xLeft, qLeft, &intercept, &slope, &result->rSquaredLeft);
+    if (fitResult != globals::OK || slope <= 0.0) return globals::INVALID_DATA;
+    result->sigmaLeft = 1.0 / slope;
+    result->muLeft    = -intercept * result->sigmaLeft;
+
+    // Right tail: Q = (mu - x) / sigma
+    fitResult = fitTail(xRight, qRight, &intercept, &slope, &result->rSquaredRight);
+    if (fitResult != globals::OK || slope >= 0.0) return globals::INVALID_DATA;
+    result->sigmaRight = -1.0 / slope;
+    result->muRight    = intercept * result->sigmaRight;
+
+    result->rjRMS       = 0.5 * (result->sigmaLeft + result->sigmaRight);
+    result->djDualDirac = 1.0 - (result->muRight - result->muLeft);
+    result->valid       = true;
+    return globals::OK;
+}
+
+
+/*!
+ \brief Extrapolated eye opening at a given BER
+ \param result  Fit result (see fit)
+ \param ber     BER at which to find the opening (e.g. 1e-12)
+ \return Eye opening in UI (0 if the eye is closed, or the fit isn't valid)
+*/
+double BathtubFit::eyeOpening(const result_t &result, const double ber)
+{
+    if (!result.valid) return 0.0;
+    const double q = qFromBER(ber);
+    const double opening = (result.muRight - (q * result.sigmaRight)) - (result.muLeft + (q * result.sigmaLeft));
+    return (opening > 0.0) ? opening : 0.0;
+}
+
+
+/*!
+ \brief Convert BER to Q (number of standard deviations from the Dirac edge)
+ Uses the rational approximation to the inverse normal CDF by P. J. Acklam
+ (relative error < 1.2e-9), with BER = rho * 0.5 * erfc(Q / sqrt(2)).
+ \param ber  BER (0 < ber < TRANSITION_DENSITY)
+ \return Q
+*/
+double BathtubFit::qFromBER(const double ber)
+{
+    static const double a[] = { -3.969683028665376e+01,  2.209460984245205e+02, -2.759285104469687e+02,
+                                 1.383577518672690e+02, -3.066479806614716e+01,  2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01,  1.615858368580409e+02, -1.556989798598866e+02,
+                                 6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00,  4.374664141464968e+00,  2.938163982698783e+00 };
+    static const double d[] = {  7.784695709041462e-03,  3.224671290700398e-01,  2.445134137142996e+00,
+                                 3.754408661907416e+00 };
+    double p = ber / TRANSITION_DENSITY;   // Probability of a Gaussian tail beyond Q
+    double q, r;
+    if (p <= 0.0) p = 1.0e-300;
+    if (p > 0.5)  p = 0.5;
+    if (p < 0.02425)
+    {
+        // Lower region:
+        q = sqrt(-2.0 * log(p));
+        return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+                 ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    // Central region:
+    q = p - 0.5;
+    r = q * q;
+    return -(((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5]) * q /
+             (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Least squares straight line fit of one tail
+ \param x          x values (UI)
+ \param q          Q values
+ \param intercept  Used to return the intercept of the line
+ \param slope      Used to return the slope of the line
+ \param rSquared   Used to return the coefficient of determination
+ \return globals::OK
+ \return globals::INVALID_DATA  Not enough points (see MIN_TAIL_POINTS), or all x equal
+*/
+int BathtubFit::fitTail(const QVector<double> &x,
+                        const QVector<double> &q,
+                        double *intercept,
+                        double *slope,
+                        double *rSquared)
+{
+    const int n = x.size();
+    double sumX = 0.0, sumQ = 0.0, sumXX = 0.0, sumXQ = 0.0;
+    double ssTotal = 0.0, ssResidual = 0.0;
+    double meanQ, denominator, residual;
+    int i;
+    *intercept = 0.0;
+    *slope = 0.0;
+    *rSquared = 0.0;
+    if (n < MIN_TAIL_POINTS) return globals::INVALID_DATA;
+    for (i = 0; i < n; i++)
+    {
+        sumX  += x[i];
+        sumQ  += q[i];
+        sumXX += x[i] * x[i];
+        sumXQ += x[i] * q[i];
+    }
+    denominator = (n * sumXX) - (sumX * sumX);
+    if (denominator == 0.0) return globals::INVALID_DATA;
+    *slope     = ((n * sumXQ) - (sumX * sumQ)) / denominator;
+    *intercept = (sumQ - (*slope * sumX)) / n;
+
+    meanQ = sumQ / n;
+    for (i = 0; i < n; i++)
+    {
+        residual    = q[i] - (*intercept + (*slope * x[i]));
+        ssResidual += residual * residual;
+        ssTotal    += (q[i] - meanQ) * (q[i] - meanQ);
+    }
+    *rSquared = (ssTotal > 0.0) ? (1.0 - (ssResidual / ssTotal)) : 1.0;
+    return globals::OK;
+}
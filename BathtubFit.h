@@ -0,0 +1,69 @@
+/*!
+ \file   BathtubFit.h
+ \brief  Dual-Dirac Bathtub Fit - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef BATHTUBFIT_H
+#define BATHTUBFIT_H
+
+#include <QVector>
+
+#include "globals.h"
+
+
+/*!
+ \brief Dual-Dirac Bathtub Fit
+ Fits the dual-Dirac (Q-scale) jitter model to the tails of a measured
+ bathtub curve, so that the eye opening can be extrapolated to BERs far
+ below the measurement floor (e.g. 1e-12) without long scans.
+
+ Each tail is modelled as a Gaussian (random jitter, sigma) centred on
+ one Dirac (deterministic jitter) edge (mu):
+   BER(x) = rho * 0.5 * erfc(Q / sqrt(2));  Q = (x - mu) / sigma
+ where rho is the transition density. In Q-scale the tail is a straight
+ line, so mu and sigma are found by linear regression of Q against x.
+*/
+class BathtubFit
+{
+public:
+
+    // Result of a fit. All positions are in UI from the left end of the bathtub curve:
+    typedef struct result_t
+    {
+        bool   valid;           // true if both tails could be fitted
+        double muLeft;          // Left tail: Dirac edge (UI) and RMS random jitter (UI)
+        double sigmaLeft;       //
+        double muRight;         // Right tail: Dirac edge (UI) and RMS random jitter (UI)
+        double sigmaRight;      //
+        double rSquaredLeft;    // Fit quality (coefficient of determination) for each tail
+        double rSquaredRight;   //
+        int    pointsLeft;      // Number of points used for each tail
+        int    pointsRight;     //
+        double rjRMS;           // Combined RMS random jitter (UI)
+        double djDualDirac;     // Dual-Dirac deterministic jitter (UI)
+    } result_t;
+
+    static int fit(const QVector<double> &curve,
+                   const double fitBERMax,
+                   result_t *result);
+
+    static double eyeOpening(const result_t &result, const double ber);
+
+    static double qFromBER(const double ber);
+
+    static const double TRANSITION_DENSITY;   // Transition density (rho) for PRBS data
+    static const int    MIN_TAIL_POINTS = 3;  // Minimum points on each tail for a valid fit
+
+private:
+
+    static int fitTail(const QVector<double> &x,
+                       const QVector<double> &q,
+                       double *intercept,
+                       double *slope,
+                       double *rSquared);
+
+};
+
+#endif // BATHTUBFIT_H
@@ -11,6 +11,7 @@
 #include <QDebug>
 #include <QEventLoop>
 #include <QStringList>
+#include <algorithm>
 
 #include "globals.h"
 #include "I2CComms.h"
@@ -163,6 +164,80 @@ void BertWorker::WorkerStop()
 }
 
 
+/*!
+ \brief Start a Frequency Sweep
+ Steps through a list of LMX frequency profiles and measures the BER on
+ each ED lane at each rate (see FrequencySweep). Results are sent with
+ FreqSweepResult, one row per rate, then FreqSweepFinished.
+ If the sweep can't be started, FreqSweepFinished is sent straight away
+ with the error code.
+ \param profiles        Indexes of frequency profiles to step through
+ \param pgPattern       PG pattern index
+ \param edPattern       ED pattern index
+ \param measureSeconds  Measurement time for each rate (maximum time if confidence > 0)
+ \param targetBER       BER limit for confidence-bounded measurements
+ \param confidence      Confidence level (0 - 1), or 0 for fixed time measurements
+*/
+void BertWorker::FreqSweepStart(QVector<int> profiles, int pgPattern, int edPattern,
+                                double measureSeconds, double targetBER, double confidence)
+{
+    Q_ASSERT(flagWorkerReady);
+    if (!flagWorkerReady) return;  // Thread not running yet?
+    int result = freqSweep->start(profiles, pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    if (result != globals::OK)
+    {
+        qDebug() << "BertWorker: Frequency sweep not started (" << result << ")";
+        emit FreqSweepFinished(result, 0);
+    }
+}
+
+
+/*!
+ \brief Start a Frequency Sweep over a Frequency Range
+ As FreqSweepStart, from frequencyFrom to frequencyTo (MHz; clock frequency):
+  - frequencyStep > 0: Steps through evenly spaced frequencies, which
+    don't need to be in the list of profiles (see FrequencySweep::startFrequencies).
+  - frequencyStep = 0: Steps through every frequency profile in the range.
+ frequencyTo may be below frequencyFrom, to sweep downwards.
+*/
+void BertWorker::FreqSweepStartRange(double frequencyFrom, double frequencyTo, double frequencyStep,
+                                     int pgPattern, int edPattern,
+                                     double measureSeconds, double targetBER, double confidence)
+{
+    Q_ASSERT(flagWorkerReady);
+    if (!flagWorkerReady) return;  // Thread not running yet?
+    int result;
+    if (frequencyStep > 0.0)
+    {
+        QVector<double> frequencies;
+        result = FrequencySweep::frequencySteps(frequencyFrom, frequencyTo, frequencyStep, &frequencies);
+        if (result == globals::OK) result = freqSweep->startFrequencies(frequencies, pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    }
+    else
+    {
+        QVector<int> profiles;
+        result = freqSweep->profilesInRange(qMin(frequencyFrom, frequencyTo), qMax(frequencyFrom, frequencyTo), &profiles);
+        if (frequencyTo < frequencyFrom) std::reverse(profiles.begin(), profiles.end());
+        if (result == globals::OK) result = freqSweep->start(profiles, pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    }
+    if (result != globals::OK)
+    {
+        qDebug() << "BertWorker: Frequency sweep not started (" << result << ")";
+        emit FreqSweepFinished(result, 0);
+    }
+}
+
+
+/*!
+ \brief Cancel a Frequency Sweep
+ FreqSweepFinished will be sent with globals::CANCELLED (if a sweep was running).
+*/
+void BertWorker::FreqSweepCancel()
+{
+    if (freqSweep) freqSweep->cancel();
+}
+
+
 // Private Slots: ///////////////////////////////////////////////////////////
 
 /*!
@@ -281,6 +356,8 @@ int BertWorker::findComponents()
             qDebug() << "BertWorker: PCA9557 IO Controller found on address " << INT_AS_HEX(address,2) << ", ID " << deviceID;
             pca9557 = new PCA9557(comms, address, deviceID);
             pca9557Set.append(pca9557);
+            // LMX Lock Detect pin is wired to the IO controller on the same board:
+            if (deviceID < lmxClockSet.count()) lmxClockSet.at(deviceID)->setLockDetect(pca9557);
             emit PCA9557Added(pca9557, deviceID);
             deviceID++;
         }
@@ -304,6 +381,8 @@ int BertWorker::findComponents()
             qDebug() << "BertWorker: SI5340 Ref Clock generator found on address " << INT_AS_HEX(address,2) << ", ID " << deviceID;
             si5340 = new SI5340(comms, address, deviceID);
             si5340Set.append(si5340);
+            // SI5340 is the reference for the LMX on the same board:
+            if (deviceID < lmxClockSet.count()) lmxClockSet.at(deviceID)->setRefClock(si5340);
             emit SI5340Added(si5340, deviceID);
             deviceID++;
         }
@@ -486,6 +565,9 @@ int BertWorker::initComponents()
 void BertWorker::shutdownComponents()
 {
     qDebug() << "BertWorker: hardware clean up...";
+    // Stop any frequency sweep before the components it uses are removed:
+    if (freqSweep) freqSweep->cancel();
+
     // ====== GT1724 ICs: =========================================================
     qDebug() << "BertWorker: REMOVE Core modules...";
     GT1724 *gt1724;
@@ -558,6 +640,12 @@ void BertWorker::run()
     // Comms Layer: I2C Comms class
     comms = new I2CComms();
 
+    // Frequency sweep engine:
+    freqSweep = new FrequencySweep(&lmxClockSet, &gt1724Set);
+    connect(freqSweep, SIGNAL(FreqSweepResult(int, int, double, int, QVector<int>, QVector<int>, QVector<double>, QVector<double>)),
+            this,      SIGNAL(FreqSweepResult(int, int, double, int, QVector<int>, QVector<int>, QVector<double>, QVector<double>)));
+    connect(freqSweep, SIGNAL(FreqSweepFinished(int, int)), this, SIGNAL(FreqSweepFinished(int, int)));
+
     // Get a list of serial ports:
     RefreshSerialPorts();
 
@@ -579,5 +667,7 @@ void BertWorker::run()
     shutdownComponents();
     if (comms->portIsOpen()) comms->close();
     delete comms;
+    delete freqSweep;
+    freqSweep = NULL;
 }
 
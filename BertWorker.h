@@ -30,6 +30,7 @@
 #include "PCA9557.h"
 #include "M24M02.h"
 #include "SI5340.h"
+#include "FrequencySweep.h"
 
 class BertWorker : public QThread
 {
@@ -81,6 +82,10 @@ public:
     void SI5340Added(SI5340 *si5340, int deviceID);                \
     void StatusConnect(bool connected);                            \
     void OptionsSent();                                            \
+    void FreqSweepResult(int step, int profileIndex, double frequency, int lockTimeMs,                 \
+                         QVector<int> lanes, QVector<int> relockMs,                                    \
+                         QVector<double> bits, QVector<double> errors);                                \
+    void FreqSweepFinished(int result, int steps);                                                     \
 
 
 #define BERT_WORKER_SLOTS \
@@ -89,7 +94,13 @@ public:
     void CommsDisconnect();          \
     void GetOptions();               \
     void InitComponents();           \
-    void WorkerStop();
+    void WorkerStop();               \
+    void FreqSweepStart(QVector<int> profiles, int pgPattern, int edPattern,                              \
+                        double measureSeconds, double targetBER, double confidence);                      \
+    void FreqSweepStartRange(double frequencyFrom, double frequencyTo, double frequencyStep,              \
+                             int pgPattern, int edPattern,                                                \
+                             double measureSeconds, double targetBER, double confidence);                 \
+    void FreqSweepCancel();
 
 #define BERT_WORKER_CONNECT_SIGNALS(CLIENT, WORKER) \
     connect(WORKER, SIGNAL(WorkerResult(int)),                CLIENT, SLOT(WorkerResult(int)));                \
@@ -102,12 +113,20 @@ public:
     connect(WORKER, SIGNAL(SI5340Added(SI5340 *, int)),       CLIENT, SLOT(SI5340Added(SI5340 *, int)));       \
     connect(WORKER, SIGNAL(StatusConnect(bool)),              CLIENT, SLOT(StatusConnect(bool)));              \
     connect(WORKER, SIGNAL(OptionsSent()),                    CLIENT, SLOT(OptionsSent()));                    \
+    connect(WORKER, SIGNAL(FreqSweepResult(int, int, double, int, QVector<int>, QVector<int>, QVector<double>, QVector<double>)),    \
+            CLIENT, SLOT(FreqSweepResult(int, int, double, int, QVector<int>, QVector<int>, QVector<double>, QVector<double>)));     \
+    connect(WORKER, SIGNAL(FreqSweepFinished(int, int)),      CLIENT, SLOT(FreqSweepFinished(int, int)));      \
     connect(CLIENT, SIGNAL(RefreshSerialPorts()),             WORKER, SLOT(RefreshSerialPorts()));             \
     connect(CLIENT, SIGNAL(CommsConnect(QString)),            WORKER, SLOT(CommsConnect(QString)));            \
     connect(CLIENT, SIGNAL(CommsDisconnect()),                WORKER, SLOT(CommsDisconnect()));                \
     connect(CLIENT, SIGNAL(GetOptions()),                     WORKER, SLOT(GetOptions()));                     \
     connect(CLIENT, SIGNAL(InitComponents()),                 WORKER, SLOT(InitComponents()));                 \
-    connect(CLIENT, SIGNAL(WorkerStop()),                     WORKER, SLOT(WorkerStop()));
+    connect(CLIENT, SIGNAL(WorkerStop()),                     WORKER, SLOT(WorkerStop()));                     \
+    connect(CLIENT, SIGNAL(FreqSweepStart(QVector<int>, int, int, double, double, double)),                        \
+            WORKER, SLOT(FreqSweepStart(QVector<int>, int, int, double, double, double)));                         \
+    connect(CLIENT, SIGNAL(FreqSweepStartRange(double, double, double, int, int, double, double, double)),         \
+            WORKER, SLOT(FreqSweepStartRange(double, double, double, int, int, double, double, double)));          \
+    connect(CLIENT, SIGNAL(FreqSweepCancel()),                WORKER, SLOT(FreqSweepCancel()));
 
 signals:
     BERT_WORKER_SIGNALS
@@ -138,6 +157,9 @@ private:
     QList<M24M02 *>  m24m02Set;    // There will be 1 x M24M02 IC per board
     QList<SI5340 *>  si5340Set;    // There may be 1 x SI5340 IC per board (selected models only)
 
+    // Frequency sweep engine (uses the LMX clocks and GT1724s above):
+    FrequencySweep *freqSweep = NULL;
+
 };
 
 #endif // BERTWORKER_H
@@ -0,0 +1,276 @@
+/*!
+ \file   EyeArchive.cpp
+ \brief  Binary Eye Scan Archive - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+#include <QFile>
+#include <QByteArray>
+#include <QtEndian>
+#include <math.h>
+#include <string.h>
+
+#include "EyeArchive.h"
+
+const char EyeArchive::MAGIC[8] = { 'S', 'B', 'E', 'Y', 'E', 'A', 'R', 'C' };
+
+
+/*!
+ \brief Save a scan to an archive file
+ An existing file is overwritten.
+ \param fileName  Full path of file to write
+ \param record    Scan to save
+ \return globals::OK
+ \return globals::INVALID_DATA  Record has no counts, or counts don't match the resolution
+ \return globals::FILE_ERROR    Couldn't write file
+*/
+int EyeArchive::save(const QString &fileName, const record_t &record)
+{
+    const int nCells = record.xRes * record.yRes;
+    if (nCells <= 0 || record.counts.size() != nCells) return globals::INVALID_DATA;
+
+    const quint32 saturated  = saturatedCount(record);
+    const int     countBytes = (saturated <= 0xFFFF) ? 2 : 4;
+
+    // Worst case: Every cell in a literal run of its own:
+    QByteArray fileData(HEADER_SIZE + (nCells * (2 + countBytes)), 0);
+    uchar *header = reinterpret_cast<uchar *>(fileData.data());
+    uchar *out = header + HEADER_SIZE;
+    int i = 0, j, runType;
+
+    //// Encode the payload: ///////////////////////////////////
+    while (i < nCells)
+    {
+        const quint32 count = record.counts[i];
+        if      (count == 0)                           runType = RUN_ZERO;
+        else if (saturated > 0 && count >= saturated)  runType = RUN_SATURATED;
+        else                                           runType = RUN_LITERAL;
+        // Find the end of the run:
+        for (j = i + 1; j < nCells && (j - i) < RUN_LENGTH_MAX; j++)
+        {
+            const quint32 next = record.counts[j];
+            if      (runType == RUN_ZERO)      { if (next != 0) break; }
+            else if (runType == RUN_SATURATED) { if (next < saturated) break; }
+            else if (next == 0 || (saturated > 0 && next >= saturated)) break;
+        }
+        qToLittleEndian<quint16>(static_cast<quint16>((runType << 14) | (j - i)), out);
+        out += 2;
+        if (runType == RUN_LITERAL)
+        {
+            for (; i < j; i++)
+            {
+                if (countBytes == 2) qToLittleEndian<quint16>(static_cast<quint16>(record.counts[i]), out);
+                else                 qToLittleEndian<quint32>(record.counts[i], out);
+                out += countBytes;
+            }
+        }
+        i = j;
+    }
+    const quint32 payloadSize = static_cast<quint32>(out - (header + HEADER_SIZE));
+
+    //// Header: //////////////////////////////////////////////
+    QByteArray serial = record.serial.toLatin1();
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    qToLittleEndian<quint16>(FORMAT_VERSION, header + 8);
+    qToLittleEndian<quint16>(HEADER_SIZE, header + 10);
+    qToLittleEndian<qint16> (static_cast<qint16>(record.lane), header + 12);
+    header[14] = static_cast<uchar>(record.type);
+    header[15] = static_cast<uchar>(record.countResBits);
+    qToLittleEndian<quint16>(static_cast<quint16>(record.xRes), header + 16);
+    qToLittleEndian<quint16>(static_cast<quint16>(record.yRes), header + 18);
+    qToLittleEndian<quint16>(static_cast<quint16>(record.hStep), header + 20);
+    qToLittleEndian<quint16>(static_cast<quint16>(record.vStep), header + 22);
+    qToLittleEndian<quint16>(static_cast<quint16>(record.vOffset), header + 24);
+    qToLittleEndian<qint16> (static_cast<qint16>(record.phaseShift), header + 26);
+    qToLittleEndian<quint32>(static_cast<quint32>(record.repeatCount), header + 28);
+    qToLittleEndian<qint64> (record.timestamp, header + 32);
+    memcpy(header + 40, serial.constData(), static_cast<size_t>(qMin(serial.size(), static_cast<int>(SERIAL_SIZE))));
+    qToLittleEndian<quint32>(static_cast<quint32>(nCells), header + 72);
+    qToLittleEndian<quint32>(payloadSize, header + 76);
+    qToLittleEndian<quint32>(qChecksum(reinterpret_cast<const char *>(header + HEADER_SIZE), payloadSize), header + 80);
+    header[84] = static_cast<uchar>(countBytes);
+
+    //// Write: ///////////////////////////////////////////////
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return globals::FILE_ERROR;
+    const qint64 fileSize = HEADER_SIZE + payloadSize;
+    const qint64 written = file.write(fileData.constData(), fileSize);
+    file.close();
+    if (written != fileSize) return globals::FILE_ERROR;
+
+    qDebug() << "Eye archive saved: " << fileName << "; " << nCells << " cells; " << fileSize << " bytes";
+    return globals::OK;
+}
+
+
+/*!
+ \brief Load a scan from an archive file
+ The file is mapped into memory and decoded directly (see decode).
+ \param fileName  Full path of file to read
+ \param record    Used to return the scan
+ \return globals::OK
+ \return globals::FILE_ERROR    Couldn't open or map file
+ \return [error code]           See decode
+*/
+int EyeArchive::load(const QString &fileName, record_t *record)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return globals::FILE_ERROR;
+    const qint64 fileSize = file.size();
+    uchar *data = file.map(0, fileSize);
+    if (!data)
+    {
+        file.close();
+        return globals::FILE_ERROR;
+    }
+    const int result = decode(data, fileSize, record);
+    file.unmap(data);
+    file.close();
+    return result;
+}
+
+
+/*!
+ \brief Decode an archive held in memory (e.g. a mapped file)
+ \param data    Archive data
+ \param size    Size of data (bytes)
+ \param record  Used to return the scan
+ \return globals::OK
+ \return globals::INVALID_DATA  Not an archive, unknown version, or data are truncated / inconsistent
+ \return globals::BAD_CHECKSUM  Payload checksum didn't match
+*/
+int EyeArchive::decode(const uchar *data, qint64 size, record_t *record)
+{
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) return globals::INVALID_DATA;
+    if (qFromLittleEndian<quint16>(data + 8) != FORMAT_VERSION) return globals::INVALID_DATA;
+
+    const qint64  headerSize  = qFromLittleEndian<quint16>(data + 10);
+    const quint32 nCells      = qFromLittleEndian<quint32>(data + 72);
+    const quint32 payloadSize = qFromLittleEndian<quint32>(data + 76);
+    const int     countBytes  = data[84];
+    if (headerSize < HEADER_SIZE || (headerSize + payloadSize) > size) return globals::INVALID_DATA;
+    if (countBytes != 2 && countBytes != 4) return globals::INVALID_DATA;
+
+    const uchar *in  = data + headerSize;
+    const uchar *end = in + payloadSize;
+    if (qChecksum(reinterpret_cast<const char *>(in), payloadSize) != qFromLittleEndian<quint32>(data + 80))
+        return globals::BAD_CHECKSUM;
+
+    record->lane         = qFromLittleEndian<qint16>(data + 12);
+    record->type         = data[14];
+    record->countResBits = data[15];
+    record->xRes         = qFromLittleEndian<quint16>(data + 16);
+    record->yRes         = qFromLittleEndian<quint16>(data + 18);
+    record->hStep        = qFromLittleEndian<quint16>(data + 20);
+    record->vStep        = qFromLittleEndian<quint16>(data + 22);
+    record->vOffset      = qFromLittleEndian<quint16>(data + 24);
+    record->phaseShift   = qFromLittleEndian<qint16>(data + 26);
+    record->repeatCount  = static_cast<int>(qFromLittleEndian<quint32>(data + 28));
+    record->timestamp    = qFromLittleEndian<qint64>(data + 32);
+    record->serial       = QString::fromLatin1(reinterpret_cast<const char *>(data + 40),
+                                               static_cast<int>(strnlen(reinterpret_cast<const char *>(data + 40), SERIAL_SIZE)));
+    if (nCells != static_cast<quint32>(record->xRes * record->yRes) || nCells == 0) return globals::INVALID_DATA;
+
+    //// Decode the payload: //////////////////////////////////
+    const quint32 saturated = saturatedCount(*record);
+    record->counts.resize(static_cast<int>(nCells));
+    quint32 *counts = record->counts.data();
+    quint32 i = 0;
+    while (in < end)
+    {
+        if ((end - in) < 2) return globals::INVALID_DATA;
+        const quint16 token   = qFromLittleEndian<quint16>(in);
+        const int     runType = token >> 14;
+        const quint32 length  = token & RUN_LENGTH_MAX;
+        in += 2;
+        if (length == 0 || (i + length) > nCells) return globals::INVALID_DATA;
+        switch (runType)
+        {
+        case RUN_LITERAL:
+            if ((end - in) < static_cast<qint64>(length * countBytes)) return globals::INVALID_DATA;
+            for (quint32 n = 0; n < length; n++)
+            {
+                if (countBytes == 2) counts[i++] = qFromLittleEndian<quint16>(in);
+                else                 counts[i++] = qFromLittleEndian<quint32>(in);
+                in += countBytes;
+            }
+            break;
+        case RUN_ZERO:
+            memset(counts + i, 0, length * sizeof(quint32));
+            i += length;
+            break;
+        case RUN_SATURATED:
+            for (quint32 n = 0; n < length; n++) counts[i++] = saturated;
+            break;
+        default:
+            return globals::INVALID_DATA;
+        }
+    }
+    if (i != nCells) return globals::INVALID_DATA;
+    return globals::OK;
+}
+
+
+/*!
+ \brief Compare a scan with a golden scan
+ Differences are in decades of BER (log10). The two scans may have
+ different repeat counts or count resolutions, so BERs are clipped to
+ the floor of the less sensitive scan (one error in the number of bits
+ analysed) before comparing; cells with no errors are at the floor.
+ The delta plane can be plotted as an overlay (same layout as counts).
+ \param scan              Scan to check
+ \param golden            Golden (reference) scan
+ \param toleranceDecades  Differences at or below this size aren't counted as worse / better
+ \param diff              Used to return the result
+ \return globals::OK
+ \return globals::INVALID_DATA  Scans have different types or resolutions
+*/
+int EyeArchive::compare(const record_t &scan, const record_t &golden, double toleranceDecades, diff_t *diff)
+{
+    const int nCells = scan.xRes * scan.yRes;
+    if ( scan.type != golden.type || scan.xRes != golden.xRes || scan.yRes != golden.yRes ||
+         scan.counts.size() != nCells || golden.counts.size() != nCells || nCells == 0 ) return globals::INVALID_DATA;
+
+    // Bits analysed per cell in each scan:
+    const double nBitsScan   = static_cast<double>(1 << scan.countResBits)   * static_cast<double>(qMax(scan.repeatCount, 1));
+    const double nBitsGolden = static_cast<double>(1 << golden.countResBits) * static_cast<double>(qMax(golden.repeatCount, 1));
+    const double logFloor    = log10(1.0 / qMin(nBitsScan, nBitsGolden));
+
+    double sumSquares = 0.0;
+    diff->delta.resize(nCells);
+    diff->maxDelta        = 0.0;
+    diff->cellsWorse      = 0;
+    diff->cellsBetter     = 0;
+    diff->openCells       = 0;
+    diff->openCellsGolden = 0;
+    for (int i = 0; i < nCells; i++)
+    {
+        const quint32 countScan   = scan.counts[i];
+        const quint32 countGolden = golden.counts[i];
+        if (countScan == 0)   diff->openCells++;
+        if (countGolden == 0) diff->openCellsGolden++;
+        const double logScan   = (countScan == 0)   ? logFloor : qMax(log10(countScan / nBitsScan), logFloor);
+        const double logGolden = (countGolden == 0) ? logFloor : qMax(log10(countGolden / nBitsGolden), logFloor);
+        const double delta = logScan - logGolden;
+        diff->delta[i] = delta;
+        sumSquares += delta * delta;
+        if (fabs(delta) > fabs(diff->maxDelta)) diff->maxDelta = delta;
+        if      (delta >  toleranceDecades) diff->cellsWorse++;
+        else if (delta < -toleranceDecades) diff->cellsBetter++;
+    }
+    diff->rmsDelta = sqrt(sumSquares / nCells);
+    return globals::OK;
+}
+
+
+/*!
+ \brief Count for a cell where every bit was an error
+ \return repeatCount * (2^countResBits - 1); 0 if unknown
+*/
+quint32 EyeArchive::saturatedCount(const record_t &record)
+{
+    if (record.countResBits < 1 || record.countResBits > 8 || record.repeatCount < 1) return 0;
+    return static_cast<quint32>(record.repeatCount) * ((1u << record.countResBits) - 1u);
+}
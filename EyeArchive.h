@@ -0,0 +1,117 @@
+/*!
+ \file   EyeArchive.h
+ \brief  Binary Eye Scan Archive - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef EYEARCHIVE_H
+#define EYEARCHIVE_H
+
+#include <QString>
+#include <QVector>
+
+#include "globals.h"
+
+
+/*!
+ \brief Binary Eye Scan Archive
+ Saves and loads eye and bathtub scan results (accumulated error counts
+ plus scan settings) in a compact binary file, and compares a scan with
+ a stored "golden" scan.
+
+ File format (all values little endian):
+   Offset  Size  Item
+        0     8  Magic: "SBEYEARC"
+        8     2  Format version (FORMAT_VERSION)
+       10     2  Header size (offset of payload; HEADER_SIZE for this version)
+       12     2  Lane (signed)
+       14     1  Scan type (GT1724_EYE_SCAN, GT1724_BATHTUB_SCAN)
+       15     1  Count resolution bits (1, 2, 4, 8)
+       16     2  xRes: Samples per row
+       18     2  yRes: Number of rows
+       20     2  Phase step
+       22     2  Offset step
+       24     2  Offset of first row (1 - 127)
+       26     2  Phase shift applied to the data (signed; samples)
+       28     4  Repeat count
+       32     8  Timestamp (ms since 1970-01-01 UTC, signed)
+       40    32  Instrument serial number (Latin1, zero padded)
+       72     4  Number of cells (xRes * yRes)
+       76     4  Payload size (bytes)
+       80     4  Payload checksum (CRC-16 from qChecksum, in low 16 bits)
+       84     1  Bytes per count in literal runs (2 or 4)
+       85    11  Reserved (zero)
+       96     -  Payload
+
+ The payload is the count plane, row by row, as a sequence of runs. Each
+ run starts with a 16 bit token: Bits 15-14 are the run type, bits 13-0
+ the run length (1 - RUN_LENGTH_MAX cells):
+   RUN_LITERAL:   Followed by one count for each cell
+   RUN_ZERO:      Cells with no errors (open part of the eye)
+   RUN_SATURATED: Cells where every bit was an error (closed part of the eye)
+ Most of an eye is zero or saturated, so files are typically a small
+ fraction of the raw count plane.
+
+ Files are loaded by mapping them into memory and decoding in a single
+ pass, without reading into intermediate buffers.
+*/
+class EyeArchive
+{
+public:
+
+    // One eye or bathtub scan:
+    typedef struct record_t
+    {
+        int     lane;
+        int     type;           // GT1724_EYE_SCAN or GT1724_BATHTUB_SCAN
+        int     xRes;           // Samples per row
+        int     yRes;           // Number of rows
+        int     hStep;          // Phase step
+        int     vStep;          // Offset step
+        int     vOffset;        // Offset of first row (1 - 127)
+        int     phaseShift;     // Phase shift applied to the data (samples)
+        int     countResBits;   // Count resolution (1, 2, 4 or 8 bits)
+        int     repeatCount;    // Number of scans accumulated into counts
+        qint64  timestamp;      // ms since 1970-01-01 UTC
+        QString serial;         // Instrument serial number
+        QVector<quint32> counts;  // Accumulated error counts, xRes * yRes (row by row)
+    } record_t;
+
+    // Result of a comparison with a golden scan:
+    typedef struct diff_t
+    {
+        QVector<double> delta;  // Per cell: log10(BER) of scan minus log10(BER) of golden scan (decades)
+        double maxDelta;        // Largest difference (signed; decades)
+        double rmsDelta;        // RMS difference (decades)
+        int    cellsWorse;      // Number of cells where BER is higher than golden by more than the tolerance
+        int    cellsBetter;     // Number of cells where BER is lower than golden by more than the tolerance
+        int    openCells;       // Number of cells with no errors (scan)
+        int    openCellsGolden; // Number of cells with no errors (golden scan)
+    } diff_t;
+
+    static int save(const QString &fileName, const record_t &record);
+    static int load(const QString &fileName, record_t *record);
+    static int decode(const uchar *data, qint64 size, record_t *record);
+
+    static int compare(const record_t &scan,
+                       const record_t &golden,
+                       double toleranceDecades,  // Differences smaller than this aren't counted as worse / better
+                       diff_t *diff);
+
+    static quint32 saturatedCount(const record_t &record);
+
+    static const int HEADER_SIZE    = 96;
+    static const int FORMAT_VERSION = 1;
+    static const int SERIAL_SIZE    = 32;
+
+private:
+    static const int RUN_LITERAL    = 0;
+    static const int RUN_ZERO       = 1;
+    static const int RUN_SATURATED  = 2;
+    static const int RUN_LENGTH_MAX = 0x3FFF;
+
+    static const char MAGIC[8];
+};
+
+#endif // EYEARCHIVE_H
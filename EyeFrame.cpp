@@ -0,0 +1,119 @@
+/*!
+ \file   EyeFrame.cpp
+ \brief  Shared Eye Scan Result Frame and Per-Lane Mailbox - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+
+#include "EyeFrame.h"
+
+
+EyeFrame::EyeFrame()
+{}
+
+
+/*!
+ \brief Construct a frame
+ The data vector is shared, not copied: Nb the caller must not write to
+ its own copy of the vector afterwards, or Qt will detach (deep copy) it.
+*/
+EyeFrame::EyeFrame(int lane, int type, const QVector<double> &data, int xRes, int yRes, int repeatCount, double floor)
+{
+    frameData_t *frameData = new frameData_t;
+    frameData->lane        = lane;
+    frameData->type        = type;
+    frameData->xRes        = xRes;
+    frameData->yRes        = yRes;
+    frameData->repeatCount = repeatCount;
+    frameData->floor       = floor;
+    frameData->data        = data;
+    d = QExplicitlySharedDataPointer<frameData_t>(frameData);
+}
+
+
+/*!
+ \brief Construct a frame from a frame buffer
+ The buffer is shared, not copied: Nb the caller must not change the
+ buffer while any frame uses it (see bufferInUse).
+*/
+EyeFrame::EyeFrame(frameData_t *frameData)
+ : d(frameData)
+{}
+
+
+/*!
+ \brief Check whether a frame buffer is used by any frame
+ \param frameData  Buffer, with one reference held by the caller (its owner)
+ \return true if any frame (or copy of a frame) still uses the buffer
+*/
+bool EyeFrame::bufferInUse(const frameData_t *frameData)
+{
+    return frameData->ref.loadAcquire() > 1;
+}
+
+
+/*!
+ \brief Get frame data
+ \return Normalised scan data (log10 BER), or an empty vector for a null frame
+*/
+const QVector<double> &EyeFrame::data() const
+{
+    static const QVector<double> emptyData;
+    if (!d) return emptyData;
+    return d->data;
+}
+
+
+
+QMutex              EyeFrameMailbox::mutex;
+QMap<int, EyeFrame> EyeFrameMailbox::frames;
+int                 EyeFrameMailbox::framesDropped = 0;
+
+
+/*!
+ \brief Post a frame
+ Replaces any frame for the same lane which hasn't been collected yet.
+ \return true   No frame was waiting: Notify the UI (e.g. EyeScanFinished)
+ \return false  An earlier frame was replaced: The UI has already been
+                notified, and will collect this frame instead
+*/
+bool EyeFrameMailbox::post(const EyeFrame &frame)
+{
+    QMutexLocker locker(&mutex);
+    const bool notify = !frames.contains(frame.lane());
+    if (!notify)
+    {
+        framesDropped++;
+        qDebug() << "Eye frame for lane " << frame.lane() << " replaced before collection (dropped: " << framesDropped << ")";
+    }
+    frames.insert(frame.lane(), frame);
+    return notify;
+}
+
+
+/*!
+ \brief Collect the latest frame for a lane
+ \return Most recent frame, or a null frame if there is no new frame
+         since the last collect (i.e. it was collected earlier)
+*/
+EyeFrame EyeFrameMailbox::collect(int lane)
+{
+    QMutexLocker locker(&mutex);
+    EyeFrame frame = frames.value(lane);
+    frames.remove(lane);
+    return frame;
+}
+
+
+/*!
+ \brief Discard any uncollected frame for a lane (e.g. when a scan is cancelled)
+ \param lane  Lane, or globals::ALL_LANES to discard frames for all lanes
+*/
+void EyeFrameMailbox::clear(int lane)
+{
+    QMutexLocker locker(&mutex);
+    if (lane == globals::ALL_LANES) frames.clear();
+    else                            frames.remove(lane);
+}
@@ -0,0 +1,101 @@
+/*!
+ \file   EyeFrame.h
+ \brief  Shared Eye Scan Result Frame and Per-Lane Mailbox - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef EYEFRAME_H
+#define EYEFRAME_H
+
+#include <QVector>
+#include <QMap>
+#include <QMutex>
+#include <QSharedData>
+
+#include "globals.h"
+
+
+/*!
+ \brief Eye Scan Result Frame
+ Immutable result of one eye or bathtub scan repeat, with its metadata.
+
+ Frames are cheap to copy: all copies share the same (reference counted)
+ data, so a frame can be passed from the worker thread to the UI without
+ copying the scan grid. A frame can't be changed after it is created;
+ the worker always builds a new frame for the next repeat.
+
+ The data live in a frameData_t buffer, which carries its own reference
+ count (one for each frame which uses it, plus one for an owner which
+ keeps the buffer for reuse). The owner may reuse a buffer once it holds
+ the only reference (see bufferInUse).
+*/
+class EyeFrame
+{
+public:
+    // Frame buffer: Filled in by the owner, then shared by frames:
+    typedef struct frameData_t : public QSharedData
+    {
+        int lane;
+        int type;
+        int xRes;
+        int yRes;
+        int repeatCount;
+        double floor;
+        QVector<double> data;
+    } frameData_t;
+
+    EyeFrame();  // Null frame
+    explicit EyeFrame(frameData_t *frameData);  // Frame using a buffer filled in by the caller (not copied)
+    EyeFrame(int lane,
+             int type,                     // GT1724_EYE_SCAN or GT1724_BATHTUB_SCAN
+             const QVector<double> &data,  // Normalised data (log10 BER), xRes * yRes values
+             int xRes,
+             int yRes,
+             int repeatCount,              // Number of repeats accumulated into the data
+             double floor);                // log10 of lowest BER which can be measured (1 / bits analysed)
+
+    bool   isNull()      const { return !d; }
+    int    lane()        const { return !d ? 0 : d->lane; }
+    int    type()        const { return !d ? 0 : d->type; }
+    int    xRes()        const { return !d ? 0 : d->xRes; }
+    int    yRes()        const { return !d ? 0 : d->yRes; }
+    int    repeatCount() const { return !d ? 0 : d->repeatCount; }
+    double floor()       const { return !d ? 0.0 : d->floor; }
+    const QVector<double> &data() const;
+
+    static bool bufferInUse(const frameData_t *frameData);
+
+private:
+    QExplicitlySharedDataPointer<frameData_t> d;
+};
+
+
+
+/*!
+ \brief Eye Frame Mailbox
+ Holds the most recent frame for each lane, for hand over from the worker
+ thread (post) to the UI thread (collect).
+
+ Latest frame wins: If the UI hasn't collected the previous frame for a
+ lane when a new one is posted, the old frame is dropped rather than
+ queued, so a slow UI skips intermediate repeats instead of falling behind.
+ Notifications are coalesced the same way: post reports whether the UI
+ needs to be told about the frame, so there is at most one notification
+ pending for each lane.
+ Safe to call from any thread.
+*/
+class EyeFrameMailbox
+{
+public:
+    static bool post(const EyeFrame &frame);
+    static EyeFrame collect(int lane);
+    static void clear(int lane);
+
+private:
+    static QMutex mutex;
+    static QMap<int, EyeFrame> frames;   // Latest uncollected frame for each lane
+    static int framesDropped;            // Number of frames replaced before collection (for debug)
+};
+
+#endif // EYEFRAME_H
@@ -0,0 +1,451 @@
+/*!
+ \file   EyeMetrics.cpp
+ \brief  Eye Diagram Metrics - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+
+#include <algorithm>
+#include <math.h>
+
+#include "EyeMetrics.h"
+
+
+/*!
+ \brief Compute eye metrics at one BER threshold
+
+ Width, height, area, centre and crossing are found in a single pass over
+ the grid, in storage order: the longest open run on each row is tracked
+ as the row is read, and the longest open run in every column is tracked
+ with one small state array (current run / best run per column).
+ The centre column is the middle of the widest row run; height is the
+ best run in that column.
+
+ Contours are then traced by marching squares on log10(BER).
+
+ Scratch buffers come from the workspace, which is grown if it is too
+ small for the grid (see workspacePrepare). The contour lists in metrics
+ are cleared rather than released, so a caller which reuses both the
+ workspace and the metrics makes no heap allocations once the contours
+ have reached their largest size.
+
+ \param counts     Error count grid (sizeX * sizeY)
+ \param sizeX      Grid size (columns, rows)
+ \param sizeY      |
+ \param nBits      Number of bits analysed per cell
+ \param ber        BER threshold
+ \param metrics    Used to return the metrics
+ \param workspace  Scratch buffers
+
+ \return globals::OK
+ \return globals::OVERFLOW      Parameter out of range, or grid size doesn't match
+ \return globals::MALLOC_ERROR  Couldn't grow the workspace
+*/
+int EyeMetrics::compute(const QVector<double> &counts,
+                        const int sizeX,
+                        const int sizeY,
+                        const double nBits,
+                        const double ber,
+                        metrics_t *metrics,
+                        workspace_t *workspace)
+{
+    int x, y, i, rowRun, rowRunStart;
+    double maxCount;
+
+    metrics->ber       = ber;
+    metrics->width     = 0;
+    metrics->height    = 0;
+    metrics->area      = 0;
+    metrics->centreX   = 0.0;
+    metrics->centreY   = 0.0;
+    metrics->widthRow  = 0;
+    metrics->crossingX = 0;
+    metrics->contourPoints.clear();
+    metrics->contourSizes.clear();
+    if ((sizeX < 2) || (sizeY < 1) || (counts.size() != (sizeX * sizeY)) || (nBits <= 0.0) || (ber <= 0.0)) return globals::OVERFLOW;
+    if (workspacePrepare(workspace, sizeX, sizeY) != globals::OK) return globals::MALLOC_ERROR;
+
+    QVector<int> &columnRun       = workspace->columnRun;
+    QVector<int> &columnBest      = workspace->columnBest;
+    QVector<int> &columnBestStart = workspace->columnBestStart;
+    std::fill_n(columnRun.begin(), sizeX, 0);
+    std::fill_n(columnBest.begin(), sizeX, 0);
+    std::fill_n(columnBestStart.begin(), sizeX, 0);
+
+    const double countLimit = ber * nBits;
+    int widthStart = 0;
+    metrics->width = 0;
+    metrics->area = 0;
+    i = 0;
+    for (y = 0; y < sizeY; y++)
+    {
+        rowRun = 0;
+        rowRunStart = 0;
+        for (x = 0; x < sizeX; x++, i++)
+        {
+            if (counts[i] <= countLimit)
+            {
+                metrics->area++;
+                if (rowRun == 0) rowRunStart = x;
+                rowRun++;
+                if (rowRun > metrics->width)
+                {
+                    metrics->width = rowRun;
+                    metrics->widthRow = y;
+                    widthStart = rowRunStart;
+                }
+                columnRun[x]++;
+                if (columnRun[x] > columnBest[x])
+                {
+                    columnBest[x] = columnRun[x];
+                    columnBestStart[x] = y - columnRun[x] + 1;
+                }
+            }
+            else
+            {
+                rowRun = 0;
+                columnRun[x] = 0;
+            }
+        }
+    }
+
+    if (metrics->width > 0)
+    {
+        const int centreColumn = widthStart + (metrics->width / 2);
+        metrics->height  = columnBest[centreColumn];
+        metrics->centreX = (double)widthStart + ((double)(metrics->width - 1) / 2.0);
+        metrics->centreY = (double)columnBestStart[centreColumn] + ((double)(metrics->height - 1) / 2.0);
+    }
+
+    // Crossing: Column with the most errors on the row used for width:
+    maxCount = -1.0;
+    for (x = 0; x < sizeX; x++)
+    {
+        if (counts[(metrics->widthRow * sizeX) + x] > maxCount)
+        {
+            maxCount = counts[(metrics->widthRow * sizeX) + x];
+            metrics->crossingX = x;
+        }
+    }
+
+    // Contours: Trace on log10(BER). Cells with no errors are set to half a count, or
+    // below the threshold if that is lower (threshold may be below the measurement floor):
+    const double zeroValue = qMin(log10(0.5 / nBits), log10(ber) - 1.0);
+    QVector<double> &field = workspace->field;
+    for (i = 0; i < counts.size(); i++) field[i] = (counts[i] > 0.0) ? log10(counts[i] / nBits) : zeroValue;
+    contourTrace(workspace, sizeX, sizeY, log10(ber), metrics->contourPoints, metrics->contourSizes);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Compute eye metrics at one BER threshold, using temporary scratch buffers
+ See compute (with workspace) above; this allocates a workspace for each call.
+*/
+int EyeMetrics::compute(const QVector<double> &counts,
+                        const int sizeX,
+                        const int sizeY,
+                        const double nBits,
+                        const double ber,
+                        metrics_t *metrics)
+{
+    workspace_t workspace;
+    return compute(counts, sizeX, sizeY, nBits, ber, metrics, &workspace);
+}
+
+
+
+/*!
+ \brief Size a workspace for compute
+
+ Buffers are only grown, never shrunk, so a workspace prepared for the
+ largest grid (e.g. 128 x 128) can be reused for any scan without
+ allocating. Contours need at most 2 segments per 2 x 2 block of cells,
+ and there are 2 edges per cell.
+
+ \param workspace  Workspace to prepare
+ \param sizeXMax   Largest grid size (columns, rows)
+ \param sizeYMax   |
+ \return globals::OK
+ \return globals::MALLOC_ERROR  Couldn't allocate buffers
+*/
+int EyeMetrics::workspacePrepare(workspace_t *workspace,
+                                 const int sizeXMax,
+                                 const int sizeYMax)
+{
+    const int cells = sizeXMax * sizeYMax;
+    if (workspace->columnRun.size() < sizeXMax)
+    {
+        workspace->columnRun.resize(sizeXMax);
+        workspace->columnBest.resize(sizeXMax);
+        workspace->columnBestStart.resize(sizeXMax);
+    }
+    if (workspace->field.size() < cells)
+    {
+        workspace->field.resize(cells);
+        workspace->edgeX.resize(2 * cells);
+        workspace->edgeY.resize(2 * cells);
+        workspace->edgeSegmentA.resize(2 * cells);
+        workspace->edgeSegmentB.resize(2 * cells);
+        workspace->segmentEdges.resize(4 * cells);
+        workspace->segmentUsed.resize(2 * cells);
+    }
+    if ( (workspace->columnBestStart.size() < sizeXMax) || (workspace->segmentUsed.size() < (2 * cells)) ) return globals::MALLOC_ERROR;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Estimate the phase of the eye centre
+
+ Each row is one UI wide and wraps around, so the eye may be split
+ across the ends of the row. The centre is found as the widest
+ low-error window of columns, on a circular row:
+
+  1) One pass over the grid builds an "openness" profile: for each
+     column, the weighted fraction of cells at or below the BER
+     threshold. Rows are weighted by a parabola which peaks at the
+     centre row (0 mV), so the noisy top and bottom of the eye count
+     for little and a single bad row can't move the centre.
+  2) Each column is scored from -1 (least open) to +1 (most open),
+     relative to the middle of the openness range.
+  3) The window with the highest total score is found by circular
+     maximum subarray: prefix sums over the row laid out twice, with
+     a monotonic queue of the lowest prefix sum for windows up to
+     sizeX - 1 columns wide. A few noisy columns inside the eye lower
+     the score of the window, but don't split it.
+
+ The confidence is the openness range (0 for a flat profile, e.g. a
+ closed eye) scaled by how cleanly the window separates open from closed
+ columns. Callers should ignore estimates with low confidence.
+
+ \param counts  Error count grid (sizeX * sizeY)
+ \param sizeX   Grid size (columns, rows)
+ \param sizeY   |
+ \param nBits   Number of bits analysed per cell
+ \param ber     BER threshold for a "low error" cell
+ \param centre  Used to return the estimate
+
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range, or grid size doesn't match
+*/
+int EyeMetrics::centreFind(const QVector<double> &counts,
+                           const int sizeX,
+                           const int sizeY,
+                           const double nBits,
+                           const double ber,
+                           centre_t *centre)
+{
+    int x, y;
+    if (sizeX < 2 || sizeY < 1 || nBits <= 0.0 || counts.size() < (sizeX * sizeY)) return globals::OVERFLOW;
+    centre->centreX     = 0.0;
+    centre->windowStart = 0;
+    centre->windowWidth = 0;
+    centre->crossingX   = 0;
+    centre->confidence  = 0.0;
+
+    //// Openness profile: ///////////////////////////////////////
+    const double countMax = ber * nBits;
+    const double yMid  = (sizeY - 1) / 2.0;
+    const double yHalf = (sizeY / 2.0) + 0.5;
+    QVector<double> open(sizeX, 0.0);
+    double weightTotal = 0.0;
+    const double *cell = counts.constData();
+    for (y = 0; y < sizeY; y++)
+    {
+        const double dy = (y - yMid) / yHalf;
+        const double weight = 1.0 - (dy * dy);
+        weightTotal += weight;
+        for (x = 0; x < sizeX; x++, cell++)
+        {
+            if (*cell <= countMax) open[x] += weight;
+        }
+    }
+    double openMin = 1.0, openMax = 0.0;
+    for (x = 0; x < sizeX; x++)
+    {
+        open[x] /= weightTotal;
+        openMin = qMin(openMin, open[x]);
+        openMax = qMax(openMax, open[x]);
+    }
+    const double openRange = openMax - openMin;
+    if (openRange < 1.0e-6) return globals::OK;  // Flat: no eye (or all open). Confidence 0.
+
+    //// Circular maximum subarray: ///////////////////////////////
+    // prefix[k] = sum of the scores of columns 0 ... k-1 (row laid out twice).
+    // Window (i, j] has score prefix[j] - prefix[i], and width j - i (up to sizeX - 1).
+    const int nPrefix = (2 * sizeX) - 1;
+    const double openMid = (openMax + openMin) / 2.0;
+    QVector<double> prefix(nPrefix + 1, 0.0);
+    QVector<int> queue(nPrefix + 1, 0);   // Indexes with increasing prefix sums
+    int queueHead = 0, queueTail = 0;
+    double bestScore = 0.0;
+    int bestStart = 0, bestWidth = 0;
+    for (x = 1; x <= nPrefix; x++)
+    {
+        prefix[x] = prefix[x - 1] + ((open[(x - 1) % sizeX] - openMid) / (openRange / 2.0));
+    }
+    for (x = 1; x <= nPrefix; x++)
+    {
+        // Add the window start x - 1; drop starts which would make the window too wide:
+        while (queueTail > queueHead && prefix[queue[queueTail - 1]] >= prefix[x - 1]) queueTail--;
+        queue[queueTail++] = x - 1;
+        if (queue[queueHead] < (x - (sizeX - 1))) queueHead++;
+        const int start = queue[queueHead];
+        const double score = prefix[x] - prefix[start];
+        if ( (score > bestScore) || ((score == bestScore) && ((x - start) > bestWidth)) )
+        {
+            bestScore = score;
+            bestStart = start;
+            bestWidth = x - start;
+        }
+    }
+    if (bestWidth == 0) return globals::OK;
+
+    //// Results: /////////////////////////////////////////////////
+    const double scoreTotal = prefix[sizeX];
+    const double inside  = bestScore / bestWidth;                                   // Mean score in window (0 to 1)
+    const double outside = -(scoreTotal - bestScore) / (sizeX - bestWidth);        // Mean score outside, negated (0 to 1)
+    centre->windowStart = bestStart % sizeX;
+    centre->windowWidth = bestWidth;
+    centre->centreX     = fmod(centre->windowStart + ((bestWidth - 1) / 2.0), static_cast<double>(sizeX));
+    centre->crossingX   = static_cast<int>(floor(centre->centreX + (sizeX / 2.0) + 0.5)) % sizeX;
+    centre->confidence  = qBound(0.0, openRange * (inside + outside) / 2.0, 1.0);
+    return globals::OK;
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Trace contour polylines by marching squares
+
+ Each 2 x 2 block of cells gives 0, 1 or 2 line segments which cross the
+ block edges where the field crosses 'level' (positions are interpolated
+ linearly). Saddle blocks are resolved using the average of the corners.
+ Segments are joined into polylines through their shared edge points.
+
+ \param workspace  Scratch buffers, sized for the grid: Field values
+                   (sizeX * sizeY) in workspace->field
+ \param sizeX      Grid size
+ \param sizeY      |
+ \param level      Contour level
+ \param points     Used to return polyline points: x, y pairs
+ \param sizes      Used to return the number of points in each polyline
+*/
+void EyeMetrics::contourTrace(workspace_t *workspace,
+                              const int sizeX,
+                              const int sizeY,
+                              const double level,
+                              QVector<double> &points,
+                              QVector<int> &sizes)
+{
+    // Edge IDs: horizontal edge from (x, y) to (x+1, y) is (y * sizeX + x);
+    //           vertical edge from (x, y) to (x, y+1) is (sizeX * sizeY) + (y * sizeX + x)
+    // Each segment joins two edges; an edge is shared by at most 2 segments.
+    // Edges crossed for each case (corner bits: 1 = top left, 2 = top right,
+    // 4 = bottom right, 8 = bottom left; edges: 0 = top, 1 = right, 2 = bottom, 3 = left):
+    static const int CASE_EDGES[16][4] =
+    {
+        { -1, -1, -1, -1 }, { 3, 0, -1, -1 }, { 0, 1, -1, -1 }, { 3, 1, -1, -1 },
+        { 1, 2, -1, -1 },   { 3, 0, 1, 2 },   { 0, 2, -1, -1 }, { 3, 2, -1, -1 },
+        { 2, 3, -1, -1 },   { 2, 0, -1, -1 }, { 0, 1, 2, 3 },   { 2, 1, -1, -1 },
+        { 1, 3, -1, -1 },   { 1, 0, -1, -1 }, { 0, 3, -1, -1 }, { -1, -1, -1, -1 }
+    };
+    const int nEdges = 2 * sizeX * sizeY;
+    const QVector<double> &field = workspace->field;
+    QVector<double> &edgeX     = workspace->edgeX;
+    QVector<double> &edgeY     = workspace->edgeY;
+    QVector<int> &edgeSegmentA = workspace->edgeSegmentA;
+    QVector<int> &edgeSegmentB = workspace->edgeSegmentB;
+    QVector<int> &segmentEdges = workspace->segmentEdges;
+    QVector<bool> &used        = workspace->segmentUsed;
+    int nSegments = 0;
+    int x, y, c, k, edgeIds[4];
+    double t, a, b;
+
+    points.clear();
+    sizes.clear();
+    std::fill_n(edgeSegmentA.begin(), nEdges, -1);
+    std::fill_n(edgeSegmentB.begin(), nEdges, -1);
+
+    for (y = 0; y < (sizeY - 1); y++)
+    {
+        for (x = 0; x < (sizeX - 1); x++)
+        {
+            const double v[4] = { field[(y * sizeX) + x],           field[(y * sizeX) + x + 1],
+                                  field[((y + 1) * sizeX) + x + 1], field[((y + 1) * sizeX) + x] };
+            c = ((v[0] > level) ? 1 : 0) | ((v[1] > level) ? 2 : 0) |
+                ((v[2] > level) ? 4 : 0) | ((v[3] > level) ? 8 : 0);
+            if (c == 0 || c == 15) continue;
+            // Saddle: The table pairs edges to cut off the corners above 'level',
+            // which is right when the centre is below. If the centre is above,
+            // the high corners are joined, so cut off the low corners instead:
+            if ((c == 5 || c == 10) && (((v[0] + v[1] + v[2] + v[3]) / 4.0) > level)) c = 15 - c;
+            for (k = 0; (k < 4) && (CASE_EDGES[c][k] >= 0); k++)
+            {
+                const int edge = CASE_EDGES[c][k];
+                switch (edge)
+                {
+                case 0:  edgeIds[k] = (y * sizeX) + x;                       a = v[0]; b = v[1]; break;
+                case 1:  edgeIds[k] = (sizeX * sizeY) + (y * sizeX) + x + 1; a = v[1]; b = v[2]; break;
+                case 2:  edgeIds[k] = ((y + 1) * sizeX) + x;                 a = v[3]; b = v[2]; break;
+                default: edgeIds[k] = (sizeX * sizeY) + (y * sizeX) + x;     a = v[0]; b = v[3]; break;
+                }
+                t = (b != a) ? ((level - a) / (b - a)) : 0.5;
+                if (edge == 0 || edge == 2) { edgeX[edgeIds[k]] = x + t;                         edgeY[edgeIds[k]] = y + ((edge == 2) ? 1.0 : 0.0); }
+                else                        { edgeX[edgeIds[k]] = x + ((edge == 1) ? 1.0 : 0.0); edgeY[edgeIds[k]] = y + t; }
+            }
+            for (k = 0; (k < 4) && (CASE_EDGES[c][k] >= 0); k += 2)
+            {
+                const int segment = nSegments++;
+                segmentEdges[2 * segment]       = edgeIds[k];
+                segmentEdges[(2 * segment) + 1] = edgeIds[k + 1];
+                if (edgeSegmentA[edgeIds[k]] < 0)     edgeSegmentA[edgeIds[k]] = segment;
+                else                                  edgeSegmentB[edgeIds[k]] = segment;
+                if (edgeSegmentA[edgeIds[k + 1]] < 0) edgeSegmentA[edgeIds[k + 1]] = segment;
+                else                                  edgeSegmentB[edgeIds[k + 1]] = segment;
+            }
+        }
+    }
+
+    // Join segments into polylines: Start from open ends first (edges at the
+    // grid boundary, used by one segment only), then closed loops:
+    std::fill_n(used.begin(), nSegments, false);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int s = 0; s < nSegments; s++)
+        {
+            if (used[s]) continue;
+            int edge = segmentEdges[2 * s];
+            if (pass == 0)
+            {
+                if      (edgeSegmentB[edge] < 0)                       { }
+                else if (edgeSegmentB[segmentEdges[(2 * s) + 1]] < 0) { edge = segmentEdges[(2 * s) + 1]; }
+                else continue;
+            }
+            int nPoints = 1;
+            int segment = s;
+            points.append(edgeX[edge]);
+            points.append(edgeY[edge]);
+            while (segment >= 0)
+            {
+                used[segment] = true;
+                edge = (segmentEdges[2 * segment] == edge) ? segmentEdges[(2 * segment) + 1] : segmentEdges[2 * segment];
+                points.append(edgeX[edge]);
+                points.append(edgeY[edge]);
+                nPoints++;
+                if      ((edgeSegmentA[edge] >= 0) && !used[edgeSegmentA[edge]]) segment = edgeSegmentA[edge];
+                else if ((edgeSegmentB[edge] >= 0) && !used[edgeSegmentB[edge]]) segment = edgeSegmentB[edge];
+                else                                                             segment = -1;
+            }
+            sizes.append(nPoints);
+        }
+    }
+}
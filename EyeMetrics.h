@@ -0,0 +1,109 @@
+/*!
+ \file   EyeMetrics.h
+ \brief  Eye Diagram Metrics - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef EYEMETRICS_H
+#define EYEMETRICS_H
+
+#include <QVector>
+
+#include "globals.h"
+
+
+/*!
+ \brief Eye Diagram Metrics
+ Extracts eye metrics from an eye scan error count grid, at one or
+ more BER thresholds, so that limit checks and logging don't need
+ any extra scans or processing in the UI.
+
+ Grid coordinates: x = column (phase), y = row (voltage offset);
+ the grid is stored row by row ([y * sizeX + x]), as produced by
+ EyeMonitor::scanStepFinish. A cell is "open" at a threshold if its
+ BER (count / bits) is at or below the threshold.
+*/
+class EyeMetrics
+{
+public:
+
+    // Metrics at one BER threshold. Sizes and positions are in grid cells:
+    typedef struct metrics_t
+    {
+        double ber;            // BER threshold
+        int    width;          // Widest open run on any row
+        int    height;         // Longest open run in the centre column
+        int    area;           // Number of open cells
+        double centreX;        // Eye centre (middle of width / height runs)
+        double centreY;        //
+        int    widthRow;       // Row on which width was measured
+        int    crossingX;      // Column with the most errors on widthRow (crossing point)
+        QVector<double> contourPoints;  // Contour polylines at the threshold: x, y pairs ...
+        QVector<int>    contourSizes;   // ... and the number of points in each polyline
+    } metrics_t;
+
+    // Eye centre estimate (see centreFind). Positions are in grid columns:
+    typedef struct centre_t
+    {
+        double centreX;      // Centre of the widest low-error phase window (may be fractional)
+        int    windowStart;  // First column of the window (the window may wrap past the end of the row)
+        int    windowWidth;  // Width of the window
+        int    crossingX;    // Column half a UI from the centre (eye crossing)
+        double confidence;   // 0 (no eye found) to 1 (fully open window with fully closed edges)
+    } centre_t;
+
+    // Scratch buffers for compute (see workspacePrepare). Keep one of these
+    // to reuse for repeated calls, so that compute doesn't allocate:
+    typedef struct workspace_t
+    {
+        QVector<int>    columnRun;        // Current open run in each column
+        QVector<int>    columnBest;       // Longest open run in each column...
+        QVector<int>    columnBestStart;  // ... and the row where it starts
+        QVector<double> field;            // log10(BER) for each cell
+        QVector<double> edgeX;            // Contour crossing point on each cell edge
+        QVector<double> edgeY;            //
+        QVector<int>    edgeSegmentA;     // Contour segments which use each edge (-1 = none)
+        QVector<int>    edgeSegmentB;     //
+        QVector<int>    segmentEdges;     // Two edge IDs per contour segment
+        QVector<bool>   segmentUsed;      // Segment already joined into a polyline
+    } workspace_t;
+
+    static int workspacePrepare(workspace_t *workspace,
+                                const int sizeXMax,
+                                const int sizeYMax);
+
+    static int compute(const QVector<double> &counts,
+                       const int sizeX,
+                       const int sizeY,
+                       const double nBits,
+                       const double ber,
+                       metrics_t *metrics);
+
+    static int compute(const QVector<double> &counts,
+                       const int sizeX,
+                       const int sizeY,
+                       const double nBits,
+                       const double ber,
+                       metrics_t *metrics,
+                       workspace_t *workspace);
+
+    static int centreFind(const QVector<double> &counts,
+                          const int sizeX,
+                          const int sizeY,
+                          const double nBits,
+                          const double ber,
+                          centre_t *centre);
+
+private:
+
+    static void contourTrace(workspace_t *workspace,
+                             const int sizeX,
+                             const int sizeY,
+                             const double level,
+                             QVector<double> &points,
+                             QVector<int> &sizes);
+
+};
+
+#endif // EYEMETRICS_H
@@ -6,10 +6,13 @@
 */
 
 #include <cstdlib>
+#include <algorithm>
 #include <QMutex>
 #include <QDebug>
 
 #include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
 
 #include <math.h>
 #include <stdint.h>
@@ -18,12 +21,24 @@
 #include "globals.h"
 
 #include "EyeMonitor.h"
+#include "BathtubFit.h"
+#include "EyeMetrics.h"
+#include "EyeFrame.h"
+
+
+const double EyeMonitor::BATHTUB_FIT_R2_MIN = 0.95;
+const double EyeMonitor::CENTRE_BER = 1.0e-2;
+const double EyeMonitor::CENTRE_CONFIDENCE_MIN = 0.2;
+const double EyeMonitor::DRIFT_DUTY_MAX = 0.5;
+const double EyeMonitor::DRIFT_EWMA_WEIGHT = 0.25;
+const double EyeMonitor::DRIFT_SIGMA_K = 3.0;
 
 
 EyeMonitor::EyeMonitor(GT1724 *parent, int laneOffset, int lane)
  : laneOffset(laneOffset), scanLane(lane)
 {
     this->parent = parent;
+    ScanPlanner::defaultParams(&costParams);
 }
 
 
@@ -38,15 +53,11 @@ EyeMonitor::~EyeMonitor()
  may require multiple macro calls and take some time to
  complete.
 
- This method will call "processEvents" periodically during its
- operations to check for the "EyeScanCancel" signal (see
- GT1724.cpp). It is essential that no other signals (particularly
- those which require the serial port) be received by the worker,
- as these could interrupt the eye scan process.
-
- The caller should lock all UI functions, leaving only a
- "Cancel Scan" button. This is connected to the "EyeScanCancel" signal
- which calls cancelScan().
+ This method only sets up the scan: The caller must then call
+ scanStep repeatedly until it reports 'done' (see GT1724::eyeScanService).
+ Control returns to the worker's event loop between steps, so other
+ commands (ED polling, etc) and the "EyeScanCancel" signal (which calls
+ cancelScan()) are handled while the scan runs.
 
  \param type          Type of scan: Eye or bathtub
  \param hStepIndex    Horizontal (phase) step index (from EYESCAN_VHSTEP_LOOKUP)
@@ -71,7 +82,7 @@ int EyeMonitor::startScan(int type,
               (vStepIndex >= 0)    && (vStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
               (countResIndex >= 0) && (countResIndex <= 3) );
 
-    stopFlag     = false;
+    stopFlag.storeRelease(0);
     scanType     = type;
     scanHStep    = static_cast<uint8_t>(GT1724::EYESCAN_VHSTEP_LOOKUP[hStepIndex]);  // Horizontal (phase) step  (1 - 128)
     scanVStep    = static_cast<uint8_t>(GT1724::EYESCAN_VHSTEP_LOOKUP[vStepIndex]);  // Vertical (voltage offset) step (1 - 127) (EYE SCAN ONLY; use 1 for bathtub scan)
@@ -81,6 +92,8 @@ int EyeMonitor::startScan(int type,
     scanCountResBits  = static_cast<uint8_t>(1 << countResIndex); // Converted to number of bits (1, 2, 4 or 8), for size calcs.
 
     scanRepeatCount = 1;
+    eyeDataValid    = false;
+    eyeDataRepeats  = 0;
 
     qDebug() << "Eye Scan Configuration:";
     qDebug() << " Type:       " << ((scanType == GT1724::GT1724_EYE_SCAN) ? "Eye Scan" : "Bathtub Scan");
@@ -90,536 +103,2795 @@ int EyeMonitor::startScan(int type,
     qDebug() << " V Offset:   " << scanVOffset;
     qDebug() << " Resolution: " << scanCountResBits << " (index " << scanCountResIndex << ")";
 
-    return eyeScanRun(true);
+    scanResetFlag = true;
+    scanState     = SCAN_SETUP;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Repeat Scan
+        The previous scan is repeated with the same parameters.
+        New data are added to the existing data, then normalised.
+        NOTE: If a scan has not previously been run, an error is
+        returned.
+        As for startScan, the scan is then run by calling scanStep.
+ \return globals::OK
+ \return [error code]
+*/
+int EyeMonitor::repeatScan()
+{
+    Q_ASSERT(scanRepeatCount > 0);
+    if (scanRepeatCount == 0) return globals::GEN_ERROR;
+    stopFlag.storeRelease(0);
+    scanRepeatCount++;
+    scanResetFlag = false;
+    scanState     = SCAN_SETUP;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set up and start a BER contour scan
+
+ Instead of measuring every phase / offset point, the contour scan
+ looks for the boundary of the eye, i.e. the voltage offset at which
+ the BER crosses targetBER, for each phase column:
+
+  1) The centre row (0 mV) is scanned once to find the columns which
+     are open; the widest run of open columns is taken as the eye.
+  2) For each column in the eye, the upper and lower boundaries are
+     found by bisection, using single point sweeps at the requested
+     count resolution. The boundary found in the neighbouring column
+     is tried first, so a smooth eye usually needs only 2 points per
+     boundary.
+  3) Each boundary point is confirmed using 8 bit count resolution
+     and boundaryRepeats sweeps, and moved in or out if needed.
+
+ The result is sent using the EyeContourFinished signal (see GT1724.h).
+
+ As for startScan, this method only sets up the scan: The caller then
+ calls scanStep until 'done' is set (see GT1724::eyeScanService). The
+ first step scans the centre row, and each step after that finds one
+ boundary point, so cancel and progress work the same way as for startScan.
+
+ \param hStepIndex       Horizontal (phase) step index (from EYESCAN_VHSTEP_LOOKUP)
+ \param countResIndex    Count resolution used while searching (0 = 1 bit ... 3 = 8 bit)
+ \param targetBER        BER which defines the boundary of the eye (0 < targetBER < 1)
+ \param boundaryRepeats  Number of sweeps used to confirm each boundary point (>= 1)
+
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range
+ \return [error code]
+*/
+int EyeMonitor::startContourScan(int hStepIndex,
+                                 int countResIndex,
+                                 double targetBER,
+                                 int boundaryRepeats)
+{
+    uint8_t sizeMSB = 0, sizeLSB = 0;
+    int result;
+
+    Q_ASSERT( (hStepIndex >= 0)    && (hStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
+              (countResIndex >= 0) && (countResIndex <= 3) );
+    if ( (hStepIndex < 0) || (hStepIndex >= GT1724::EYESCAN_VHSTEP_LOOKUP.size()) ||
+         (countResIndex < 0) || (countResIndex > 3) ||
+         (targetBER <= 0.0) || (targetBER >= 1.0) ||
+         (boundaryRepeats < 1) )
+    {
+        parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_CONTOUR_SCAN, globals::OVERFLOW);
+        return globals::OVERFLOW;
+    }
+
+    stopFlag.storeRelease(0);
+    contourHStep           = static_cast<uint8_t>(GT1724::EYESCAN_VHSTEP_LOOKUP[hStepIndex]);
+    contourCountResIndex   = static_cast<uint8_t>(countResIndex);
+    contourTargetBER       = targetBER;
+    contourBoundaryRepeats = boundaryRepeats;
+
+    qDebug() << "Contour Scan Configuration:";
+    qDebug() << " Lane:       " << scanLane;
+    qDebug() << " H Step:     " << contourHStep;
+    qDebug() << " Resolution: " << (1 << contourCountResIndex) << " (index " << contourCountResIndex << ")";
+    qDebug() << " Target BER: " << contourTargetBER;
+    qDebug() << " Repeats:    " << contourBoundaryRepeats;
+
+    contourPointsMeasured = 0;
+    result = queryEyeScanMem(&imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB);
+    if (result != globals::OK)
+    {
+        qDebug() << "Error reading output memory attributes: " << result;
+        parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_CONTOUR_SCAN, result);
+        return result;
+    }
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_CONTOUR_SCAN, 0);
+    scanState = SCAN_CONTOUR_CENTRE;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set up an eye mask test
+
+ The mask test checks whether any errors occur inside a mask (one or more
+ polygons) placed relative to the centre of the eye. Only the cells inside
+ the mask are measured: The mask is split into rectangular windows (see
+ maskBuildWindows), and each window is swept with 8 bit count resolution.
+
+ Mask coordinates:
+   x: Phase, in UI relative to the eye centre (-0.5 to +0.5)
+   y: Voltage offset, in offset steps relative to 0 mV (-64 to +62)
+
+ The test then runs as a state machine, like an eye scan: The caller
+ calls scanStep until 'done' is set (see GT1724::eyeScanService). The
+ first step scans the centre row to place the mask (see maskStepCentre),
+ and each step after that sweeps one window, so tests on both lanes run
+ together and the worker returns to its event loop between windows. After each full
+ pass over the mask, the error counts are checked against the BER bound
+ (see maskDecision): The test passes once the BER in every cell is shown
+ to be below targetBER with the requested confidence, and fails once any
+ cell is shown to be above it. The result is sent using the
+ EyeMaskTestFinished signal.
+
+ \param hStepIndex        Horizontal (phase) step index (from EYESCAN_VHSTEP_LOOKUP)
+ \param maskPoints        Mask polygon vertices, as x, y pairs (see above)
+ \param maskPolygonSizes  Number of vertices in each polygon (>= 3 each)
+ \param targetBER         Maximum BER allowed inside the mask (0 < targetBER < 1)
+ \param confidence        Confidence level required for a pass (0 < confidence < 1)
+
+ \return globals::OK
+ \return globals::OVERFLOW      Parameter out of range, or targetBER can't be reached
+                                within MASK_REPEATS_MAX repeats
+ \return globals::INVALID_DATA  Bad mask definition (a mask which doesn't cover any
+                                cells is reported with EyeScanError; see maskStepCentre)
+ \return [error code]
+*/
+int EyeMonitor::startMaskTest(int hStepIndex,
+                              const QVector<double> &maskPoints,
+                              const QVector<int> &maskPolygonSizes,
+                              double targetBER,
+                              double confidence)
+{
+    int result = globals::OK;
+    uint8_t sizeMSB = 0, sizeLSB = 0;
+    int nVertices = 0;
+    int i;
+    double repeatsRequired;
+
+    maskWindows.clear();
+    maskRepeatsDone = 0;
+    maskWindowIndex = 0;
+    maskHitCount    = 0;
+
+    if ( (hStepIndex < 0) || (hStepIndex >= GT1724::EYESCAN_VHSTEP_LOOKUP.size()) ||
+         (targetBER <= 0.0) || (targetBER >= 1.0) ||
+         (confidence <= 0.0) || (confidence >= 1.0) )
+    {
+        result = globals::OVERFLOW;
+        goto finished;
+    }
+    for (i = 0; i < maskPolygonSizes.size(); i++)
+    {
+        if (maskPolygonSizes[i] < 3) { result = globals::INVALID_DATA; goto finished; }
+        nVertices += maskPolygonSizes[i];
+    }
+    if ( maskPolygonSizes.isEmpty() || ((nVertices * 2) != maskPoints.size()) )
+    {
+        result = globals::INVALID_DATA;
+        goto finished;
+    }
+
+    // Number of repeats needed to show that BER < targetBER with the requested
+    // confidence, if no errors are seen: n bits >= -ln(1 - confidence) / targetBER
+    // Each sweep checks 2^8 bits per cell (8 bit count resolution; see scanStepFinish):
+    repeatsRequired = ceil( -log(1.0 - confidence) / (targetBER * 256.0) );
+    if (repeatsRequired > (double)MASK_REPEATS_MAX)
+    {
+        qDebug() << "Mask Test: Target BER " << targetBER << " needs " << repeatsRequired
+                 << " repeats; limit is " << MASK_REPEATS_MAX;
+        result = globals::OVERFLOW;
+        goto finished;
+    }
+    maskRepeatsRequired = qMax(static_cast<int>(repeatsRequired), 1);
+
+    stopFlag.storeRelease(0);
+    maskHStep      = static_cast<uint8_t>(GT1724::EYESCAN_VHSTEP_LOOKUP[hStepIndex]);
+    maskTargetBER  = targetBER;
+    maskConfidence = confidence;
+
+    result = queryEyeScanMem(&imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB);
+    if (result != globals::OK)
+    {
+        qDebug() << "Error reading output memory attributes: " << result;
+        goto finished;
+    }
+    imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    result = arenaPrepare(imageMaximumSize);
+    if (result != globals::OK) goto finished;
+
+    maskVertices     = maskPoints;
+    maskVertexCounts = maskPolygonSizes;
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_MASK_TEST, 0);
+    scanState = SCAN_MASK_CENTRE;
+
+  finished:
+    if (result != globals::OK) parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_MASK_TEST, result);
+    return result;
+}
+
+
+
+/*!
+ \brief Mask test step: Scan the centre row, and place the mask
+ The eye centre is the middle of the widest open run on the centre row
+ (see scanCentreRow). The cells inside the mask are marked, and split
+ into windows (see maskBuildWindows).
+ See startMaskTest and scanStep.
+ \return globals::OK
+ \return globals::INVALID_DATA  Mask doesn't cover any cells
+ \return [error code]
+*/
+int EyeMonitor::maskStepCentre()
+{
+    int result;
+    int runStart = 0, runLength = 0;
+    int nCells = 0;
+    int p, o, i, polygonStart;
+    double x, y;
+
+    result = scanCentreRow(maskHStep, 3, maskTargetBER, &runStart, &runLength);
+    if (result != globals::OK) return result;
+    if (runLength > 0) maskCentrePhase = ((runStart * maskHStep) + ((runLength * maskHStep) / 2)) % 128;
+    else               maskCentrePhase = 64;  // Eye closed at centre: Test will fail anyway.
+
+    // Mark the cells inside the mask:
+    maskCells.fill(false, MASK_GRID_SIZE * MASK_GRID_SIZE);
+    maskCellErrors.fill(0.0, MASK_GRID_SIZE * MASK_GRID_SIZE);
+    for (o = 1; o <= 127; o++)
+    {
+        y = static_cast<double>(o - CONTOUR_OFFSET_CENTRE);
+        for (p = 0; p < 128; p += maskHStep)
+        {
+            // Phase relative to eye centre, wrapped to -0.5 ... +0.5 UI:
+            x = static_cast<double>(((p - maskCentrePhase + 192) % 128) - 64) / 128.0;
+            polygonStart = 0;
+            for (i = 0; i < maskVertexCounts.size(); i++)
+            {
+                if (pointInPolygon(x, y, maskVertices.constData() + (2 * polygonStart), maskVertexCounts[i]))
+                {
+                    maskCells[(o * MASK_GRID_SIZE) + p] = true;
+                    nCells++;
+                    break;
+                }
+                polygonStart += maskVertexCounts[i];
+            }
+        }
+    }
+    if (nCells == 0) return globals::INVALID_DATA;
+    maskBuildWindows(maskCells, maskWindows);
+
+    qDebug() << "Mask Test Configuration:";
+    qDebug() << " Lane:             " << scanLane;
+    qDebug() << " H Step:           " << maskHStep;
+    qDebug() << " Eye Centre:       " << maskCentrePhase;
+    qDebug() << " Cells:            " << nCells << " in " << maskWindows.size() << " windows";
+    qDebug() << " Target BER:       " << maskTargetBER << " (confidence " << maskConfidence << ")";
+    qDebug() << " Repeats Required: " << maskRepeatsRequired << " (if no errors)";
+
+    scanState = SCAN_MASK;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Mask test step: Sweep one window of the mask
+ After the last window, the counts are checked (see maskDecision); on a
+ pass, the margin search starts (see maskStepMargin).
+ See startMaskTest and scanStep.
+*/
+int EyeMonitor::maskStepSweep()
+{
+    int result;
+    int decision = MASK_UNDECIDED;
+    bool hit = false;
+    int i, percent;
+
+    result = maskSweepWindow(maskWindows[maskWindowIndex], maskCellErrors, &hit);
+    if (result != globals::OK) return result;
+
+    maskWindowIndex++;
+    if (maskWindowIndex >= maskWindows.size())
+    {
+        maskWindowIndex = 0;
+        maskRepeatsDone++;
+        decision = maskDecision();
+    }
+    // Progress assumes no errors; with errors, more repeats may be needed to decide:
+    percent = static_cast<int>( (100.0 * ((double)maskRepeatsDone + ((double)maskWindowIndex / (double)maskWindows.size())))
+                                / (double)maskRepeatsRequired );
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_MASK_TEST, qMin(percent, 99));
+
+    if (decision == MASK_UNDECIDED) return globals::OK;
+
+    maskHitCount = 0;
+    for (i = 0; i < maskCells.size(); i++)
+    {
+        if (maskCells[i] && (maskCellErrors[i] > 0.0)) maskHitCount++;
+    }
+    if (decision == MASK_FAIL)
+    {
+        // Margin is negative: the depth of the deepest failing cell inside the mask,
+        // i.e. how far the mask would have to shrink vertically to pass:
+        double margin = 0.0;
+        maskVerticalDistance(maskCells, false, maskDistance);
+        for (i = 0; i < maskCells.size(); i++)
+        {
+            if ( maskCells[i] && (maskCellErrors[i] > 0.0) && (maskDistance[i] > -margin) ) margin = -(double)maskDistance[i];
+        }
+        maskTestFinish(false, margin);
+        return globals::OK;
+    }
+
+    // Pass: Grow the mask vertically one step at a time (see maskStepMargin):
+    maskVerticalDistance(maskCells, true, maskDistance);
+    maskMarginDistance = 1;
+    maskMarginRing();
+    scanState = SCAN_MASK_MARGIN;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Mask test step: Sweep one window of the margin search
+ After a pass, the mask is grown vertically one step at a time, and only
+ the new cells (the "ring") are swept, once each, until an error is seen
+ or MASK_MARGIN_MAX is reached. Margin is the last clean step.
+ See startMaskTest and scanStep.
+*/
+int EyeMonitor::maskStepMargin()
+{
+    int result;
+    bool hit = false;
+
+    if (maskRingWindows.isEmpty())
+    {
+        maskTestFinish(true, (double)(maskMarginDistance - 1));  // Reached edge of scan range
+        return globals::OK;
+    }
+    result = maskSweepWindow(maskRingWindows[maskWindowIndex], maskRingCounts, &hit);
+    if (result != globals::OK) return result;
+    if (hit)
+    {
+        maskTestFinish(true, (double)(maskMarginDistance - 1));
+        return globals::OK;
+    }
+    maskWindowIndex++;
+    if (maskWindowIndex < maskRingWindows.size()) return globals::OK;
+
+    // Ring is clean: Try the next one out:
+    if (maskMarginDistance >= MASK_MARGIN_MAX)
+    {
+        maskTestFinish(true, (double)MASK_MARGIN_MAX);
+        return globals::OK;
+    }
+    maskMarginDistance++;
+    maskMarginRing();
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Decide whether the mask test has passed or failed
+ Each mask cell has had maskRepeatsDone x 2^8 bits checked. With k errors
+ in the worst cell, and an expected count of L = bits x targetBER:
+  - Pass: P(k or fewer errors | L) < 1 - confidence, i.e. the BER in the
+    worst cell (and so in every cell) is below targetBER. For k = 0, this
+    needs maskRepeatsRequired repeats.
+  - Fail: P(k or more errors | L) < 1 - confidence, i.e. the BER in the
+    worst cell is above targetBER.
+ If neither can be shown after MASK_REPEATS_MAX repeats, the test fails
+ (the BER wasn't shown to be below the target).
+ \return MASK_PASS, MASK_FAIL or MASK_UNDECIDED
+*/
+int EyeMonitor::maskDecision() const
+{
+    const double lambda = (double)maskRepeatsDone * 256.0 * maskTargetBER;
+    const double alpha = 1.0 - maskConfidence;
+    double worst = 0.0;
+    for (int i = 0; i < maskCells.size(); i++)
+    {
+        if (maskCells[i] && (maskCellErrors[i] > worst)) worst = maskCellErrors[i];
+    }
+    if (globals::poissonCdf(worst, lambda) < alpha) return MASK_PASS;
+    if ((worst > 0.0) && ((1.0 - globals::poissonCdf(worst - 1.0, lambda)) < alpha)) return MASK_FAIL;
+    if (maskRepeatsDone >= MASK_REPEATS_MAX) return MASK_FAIL;
+    return MASK_UNDECIDED;
+}
+
+
+
+/*!
+ \brief Margin search: Set up the windows for ring maskMarginDistance
+ (the cells that distance outside the mask; see maskStepMargin).
+*/
+void EyeMonitor::maskMarginRing()
+{
+    const int nCells = MASK_GRID_SIZE * MASK_GRID_SIZE;
+    QVector<bool> ringCells(nCells, false);
+    for (int i = MASK_GRID_SIZE; i < (128 * MASK_GRID_SIZE); i++)  // Offsets 1 - 127 only
+    {
+        if (maskDistance[i] == maskMarginDistance) ringCells[i] = true;
+    }
+    maskBuildWindows(ringCells, maskRingWindows);  // Empty if the ring is outside the scan range
+    maskRingCounts.fill(0.0, nCells);
+    maskWindowIndex = 0;
+}
+
+
+
+/*!
+ \brief Region of interest (zoom) scan
+
+ Scans only a rectangular window of the eye, e.g. to look closely at
+ the eye centre at step 1 without paying for a full resolution scan
+ of the whole diagram. The window is swept in as few parts as the
+ scan output memory allows (several complete rows per part).
+
+ The phase window may wrap past 127 (phaseStop up to phaseStart + 127),
+ e.g. when the eye centre is close to phase 0; phases are taken mod 128.
+
+ The result is sent using the EyeROIScanFinished signal, as log10(BER)
+ for each point (rows from offsetStart upwards), with the position of
+ the window so that it can be overlaid on the full eye diagram. The
+ phase shift applied to the last full eye scan (see scanStepFinish) is
+ included, so the caller can place the window on the shifted plot.
+
+ As for startScan, this method only sets up the scan: The caller then
+ calls scanStep until 'done' is set (see GT1724::eyeScanService), and
+ each step sweeps one part (see roiStep), so cancel and progress work
+ the same way as for startScan.
+
+ \param phaseStart     First phase (0 - 127)
+ \param phaseStop      Last phase (phaseStart to phaseStart + 127)
+ \param phaseStep      Phase step (1 - 128)
+ \param offsetStart    First voltage offset (1 - 127)
+ \param offsetStop     Last voltage offset (offsetStart - 127)
+ \param offsetStep     Offset step (1 - 127)
+ \param countResIndex  Resolution of error count at each point (0 = 1 bit ... 3 = 8 bit)
+
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range
+ \return [error code]
+*/
+int EyeMonitor::startROIScan(int phaseStart,
+                             int phaseStop,
+                             int phaseStep,
+                             int offsetStart,
+                             int offsetStop,
+                             int offsetStep,
+                             int countResIndex)
+{
+    int result = globals::OK;
+    uint8_t sizeMSB = 0, sizeLSB = 0;
+
+    if ( (phaseStart < 0)  || (phaseStart > 127) ||
+         (phaseStop < phaseStart)   || (phaseStop > (phaseStart + 127)) ||
+         (phaseStep < 1)   || (phaseStep > 128) ||
+         (offsetStart < 1) || (offsetStop > 127) || (offsetStop < offsetStart) ||
+         (offsetStep < 1)  || (offsetStep > 127) ||
+         (countResIndex < 0) || (countResIndex > 3) )
+    {
+        result = globals::OVERFLOW;
+        goto finished;
+    }
+
+    stopFlag.storeRelease(0);
+    roiPhaseStart     = phaseStart;
+    roiPhaseStop      = phaseStop;
+    roiPhaseStep      = phaseStep;
+    roiOffsetStart    = offsetStart;
+    roiOffsetStep     = offsetStep;
+    roiCountResIndex  = static_cast<uint8_t>(countResIndex);
+    roiNumPhaseSteps  = ((phaseStop - phaseStart) / phaseStep) + 1;
+    roiNumOffsetSteps = ((offsetStop - offsetStart) / offsetStep) + 1;
+    roiColumn         = 0;
+    roiRow            = 0;
+    roiSamplesDone    = 0;
+
+    qDebug() << "ROI Scan Configuration:";
+    qDebug() << " Lane:       " << scanLane;
+    qDebug() << " Phase:      " << phaseStart << " - " << phaseStop << " step " << phaseStep;
+    qDebug() << " Offset:     " << offsetStart << " - " << offsetStop << " step " << offsetStep;
+    qDebug() << " Resolution: " << (1 << countResIndex) << " (index " << countResIndex << ")";
+
+    result = queryEyeScanMem(&imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB);
+    if (result != globals::OK)
+    {
+        qDebug() << "Error reading output memory attributes: " << result;
+        goto finished;
+    }
+    imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    result = arenaPrepare(imageMaximumSize);
+    if (result != globals::OK) goto finished;
+    bufferReset(roiData, roiNumPhaseSteps * roiNumOffsetSteps);
+
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_ROI_SCAN, 0);
+    scanState = SCAN_ROI;
+
+  finished:
+    if (result != globals::OK) parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_ROI_SCAN, result);
+    return result;
+}
+
+
+
+/*!
+ \brief ROI scan step: Sweep one part of the window
+
+ The window is split into (at most) two phase segments if it wraps past
+ phase 127. Each segment is swept in parts of several rows (as many as
+ fit in the output memory); each step sweeps and reads back one part.
+ After the last part, the result is sent (see roiFinish).
+ See startROIScan and scanStep.
+*/
+int EyeMonitor::roiStep()
+{
+    const int countResBits = 1 << roiCountResIndex;
+    const int segmentStart = (roiPhaseStart + (roiColumn * roiPhaseStep)) % 128;
+    int segmentStop = roiPhaseStop % 128;
+    int segmentColumns, rowsPerPart;
+    int thisOffsetStart, thisOffsetStop, thisRows;
+    int result;
+
+    if ( (roiPhaseStart + (roiColumn * roiPhaseStep) < 128) && (roiPhaseStop >= 128) )
+        segmentStop = segmentStart + (((127 - segmentStart) / roiPhaseStep) * roiPhaseStep);  // Last phase before wrap
+    segmentColumns = ((segmentStop - segmentStart) / roiPhaseStep) + 1;
+    segmentStop = segmentStart + ((segmentColumns - 1) * roiPhaseStep);
+
+    // Rows which fit in memory (samples are packed, so round down to whole rows):
+    rowsPerPart = (static_cast<int>(imageMaximumSize) * 8) / (segmentColumns * countResBits);
+    if (rowsPerPart < 1) return globals::OVERFLOW;
+
+    thisRows = qMin(rowsPerPart, roiNumOffsetSteps - roiRow);
+    thisOffsetStart = roiOffsetStart + (roiRow * roiOffsetStep);
+    thisOffsetStop  = thisOffsetStart + ((thisRows - 1) * roiOffsetStep);
+    result = roiSweepPart(static_cast<uint8_t>(segmentStart), static_cast<uint8_t>(segmentStop), static_cast<uint8_t>(roiPhaseStep),
+                          static_cast<uint8_t>(thisOffsetStart), static_cast<uint8_t>(thisOffsetStop), static_cast<uint8_t>(roiOffsetStep),
+                          roiCountResIndex,
+                          roiData, roiNumPhaseSteps, roiColumn, roiRow, segmentColumns, thisRows);
+    if (result != globals::OK) return result;
+    roiRow += thisRows;
+    roiSamplesDone += segmentColumns * thisRows;
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_ROI_SCAN,
+                                      (roiSamplesDone * 100) / roiData.size());
+    if (roiRow < roiNumOffsetSteps) return globals::OK;
+
+    // Segment finished: Start the next one, or send the result:
+    roiColumn += segmentColumns;
+    roiRow = 0;
+    if (roiColumn >= roiNumPhaseSteps) roiFinish();
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief ROI scan: Normalise the data, and send the result
+ See startROIScan.
+*/
+void EyeMonitor::roiFinish()
+{
+    // Normalise (log10 BER), using the same floor as the full eye scan:
+    const double nBitsAnalysed = (double)((uint16_t)(1 << (1 << roiCountResIndex)));
+    double ber;
+    for (int i = 0; i < roiData.size(); i++)
+    {
+        ber = roiData[i] / nBitsAnalysed;
+        if (ber < (1.0 / nBitsAnalysed)) ber = 1.0 / nBitsAnalysed;
+        roiData[i] = log10(ber);
+    }
+
+    qDebug() << "--ROI Scan data aquired! " << roiNumPhaseSteps << " x " << roiNumOffsetSteps;
+    parent->emitEyeROIScanFinished(laneOffset + scanLane, roiData, roiNumPhaseSteps, roiNumOffsetSteps,
+                                   roiPhaseStart, roiPhaseStep, roiOffsetStart, roiOffsetStep, nShift * scanHStep);
+    scanState = SCAN_IDLE;
+}
+
+
+
+/*!
+ \brief Multi-row bathtub scan
+
+ Measures bathtub curves at several voltage offsets together. The
+ offsets are sorted and split into evenly spaced groups; each group is
+ swept as one controlEyeSweep offset range (in as few parts as the
+ output memory allows), so e.g. bathtubs at 5 evenly spaced thresholds
+ cost about the same as one 5 row eye scan rather than 5 separate scans.
+
+ If useEyeData is set and the last scan on this lane was a full eye scan
+ which includes all of the requested offsets (i.e. offsets are on the eye
+ scan's vertical grid), the curves are taken from the eye data instead,
+ with no extra bus traffic, and sent straight away. In this case the
+ phase step of the eye scan is used and hStepIndex / countResIndex are
+ ignored.
+
+ Otherwise, as for startScan, this method only sets up the scan: The
+ caller then calls scanStep until 'done' is set (see
+ GT1724::eyeScanService), and each step sweeps one part (see bathtubStep).
+
+ The curves are sent using the EyeBathtubsFinished signal: one curve
+ (xRes points, log10 BER) per requested offset, in the order requested.
+ All curves are shifted by the same amount (found from the row closest
+ to 0 mV) so that they line up.
+
+ \param hStepIndex     Horizontal (phase) step index (from EYESCAN_VHSTEP_LOOKUP)
+ \param vOffsets       Voltage offsets (1 - 127; see EYESCAN_VOFF_LOOKUP)
+ \param countResIndex  Resolution of error count at each point (0 = 1 bit ... 3 = 8 bit)
+ \param useEyeData     Use data from the last eye scan if possible
+
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range
+ \return [error code]
+*/
+int EyeMonitor::startBathtubScan(int hStepIndex,
+                                 const QVector<int> &vOffsets,
+                                 int countResIndex,
+                                 bool useEyeData)
+{
+    int result = globals::OK;
+    uint8_t sizeMSB = 0, sizeLSB = 0;
+    QVector<int> offsetsSorted;
+    QVector<double> curves;
+    int numPhaseSteps;
+
+    if ( (hStepIndex < 0) || (hStepIndex >= GT1724::EYESCAN_VHSTEP_LOOKUP.size()) ||
+         (countResIndex < 0) || (countResIndex > 3) || vOffsets.isEmpty() )
+    {
+        result = globals::OVERFLOW;
+        goto finished;
+    }
+    foreach (int offset, vOffsets)
+    {
+        if ((offset < 1) || (offset > 127)) { result = globals::OVERFLOW; goto finished; }
+        if (!offsetsSorted.contains(offset)) offsetsSorted.append(offset);
+    }
+    std::sort(offsetsSorted.begin(), offsetsSorted.end());
+
+    if (useEyeData && bathtubFromEyeData(vOffsets, curves, &numPhaseSteps))
+    {
+        qDebug() << "Bathtub Scan - " << vOffsets.size() << " curve(s) taken from eye scan data.";
+        parent->emitEyeBathtubsFinished(laneOffset + scanLane, vOffsets, curves, numPhaseSteps);
+        goto finished;
+    }
+
+    stopFlag.storeRelease(0);
+    bathtubHStep         = static_cast<uint8_t>(GT1724::EYESCAN_VHSTEP_LOOKUP[hStepIndex]);
+    bathtubCountResIndex = static_cast<uint8_t>(countResIndex);
+    bathtubNumPhaseSteps = 128 / bathtubHStep;
+    bathtubOffsets       = vOffsets;
+    bathtubOffsetsSorted = offsetsSorted;
+
+    qDebug() << "Multi-row Bathtub Scan Configuration:";
+    qDebug() << " Lane:       " << scanLane;
+    qDebug() << " H Step:     " << bathtubHStep;
+    qDebug() << " V Offsets:  " << bathtubOffsetsSorted;
+    qDebug() << " Resolution: " << (1 << countResIndex) << " (index " << countResIndex << ")";
+
+    result = queryEyeScanMem(&imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB);
+    if (result != globals::OK)
+    {
+        qDebug() << "Error reading output memory attributes: " << result;
+        goto finished;
+    }
+    imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    result = arenaPrepare(imageMaximumSize);
+    if (result != globals::OK) goto finished;
+    bathtubRowsPerPart = (static_cast<int>(imageMaximumSize) * 8) / (bathtubNumPhaseSteps * (1 << countResIndex));
+    if (bathtubRowsPerPart < 1) { result = globals::OVERFLOW; goto finished; }
+    bufferReset(bathtubRowData, bathtubNumPhaseSteps * bathtubOffsetsSorted.size());
+    bathtubRow = 0;
+    bathtubGroupFind(0);
+
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_BATHTUB_SCAN, 0);
+    scanState = SCAN_BATHTUBS;
+
+  finished:
+    if (result != globals::OK) parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_BATHTUB_SCAN, result);
+    return result;
+}
+
+
+
+/*!
+ \brief Multi-row bathtub scan: Find the group of evenly spaced offsets from groupStart
+ Sets bathtubGroupEnd and bathtubGroupStep; the group is swept as one
+ offset range (see bathtubStep).
+ \param groupStart  Index (in bathtubOffsetsSorted) of the first offset in the group
+*/
+void EyeMonitor::bathtubGroupFind(int groupStart)
+{
+    bathtubGroupEnd  = groupStart;
+    bathtubGroupStep = 1;
+    if ((groupStart + 1) < bathtubOffsetsSorted.size())
+    {
+        bathtubGroupStep = bathtubOffsetsSorted[groupStart + 1] - bathtubOffsetsSorted[groupStart];
+        bathtubGroupEnd = groupStart + 1;
+        while ( ((bathtubGroupEnd + 1) < bathtubOffsetsSorted.size()) &&
+                ((bathtubOffsetsSorted[bathtubGroupEnd + 1] - bathtubOffsetsSorted[bathtubGroupEnd]) == bathtubGroupStep) ) bathtubGroupEnd++;
+    }
+}
+
+
+
+/*!
+ \brief Multi-row bathtub scan step: Sweep one part of an offset group
+ After the last part, the curves are sent (see bathtubFinish).
+ See startBathtubScan and scanStep.
+*/
+int EyeMonitor::bathtubStep()
+{
+    const int thisRows = qMin(bathtubRowsPerPart, bathtubGroupEnd - bathtubRow + 1);
+    int result = roiSweepPart(0, 127, bathtubHStep,
+                              static_cast<uint8_t>(bathtubOffsetsSorted[bathtubRow]),
+                              static_cast<uint8_t>(bathtubOffsetsSorted[bathtubRow + thisRows - 1]),
+                              static_cast<uint8_t>(bathtubGroupStep),
+                              bathtubCountResIndex,
+                              bathtubRowData, bathtubNumPhaseSteps, 0, bathtubRow, bathtubNumPhaseSteps, thisRows);
+    if (result != globals::OK) return result;
+    bathtubRow += thisRows;
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_BATHTUB_SCAN,
+                                      (bathtubRow * 100) / bathtubOffsetsSorted.size());
+    if (bathtubRow <= bathtubGroupEnd) return globals::OK;
+    if (bathtubRow < bathtubOffsetsSorted.size())
+    {
+        bathtubGroupFind(bathtubRow);
+        return globals::OK;
+    }
+    return bathtubFinish();
+}
+
+
+
+/*!
+ \brief Multi-row bathtub scan: Shift and normalise the curves, and send them
+ See startBathtubScan.
+ \return globals::OK
+ \return [error code]  See dataShift
+*/
+int EyeMonitor::bathtubFinish()
+{
+    const int numPhaseSteps = bathtubNumPhaseSteps;
+    const uint8_t countResBits = static_cast<uint8_t>(1 << bathtubCountResIndex);
+    QVector<double> curves;
+    int centreRow, shift, row, i, x;
+    double nBitsAnalysed, ber;
+    int result;
+
+    // Shift: Find the peak on the row closest to 0 mV, and shift all rows by the same amount:
+    centreRow = 0;
+    for (i = 1; i < bathtubOffsetsSorted.size(); i++)
+    {
+        if (abs(bathtubOffsetsSorted[i] - CONTOUR_OFFSET_CENTRE) < abs(bathtubOffsetsSorted[centreRow] - CONTOUR_OFFSET_CENTRE)) centreRow = i;
+    }
+    {
+        QVector<double> centreData = bathtubRowData.mid(centreRow * numPhaseSteps, numPhaseSteps);
+        EyeMetrics::centre_t centre;
+        EyeMetrics::centreFind(centreData, numPhaseSteps, 1, (double)(1 << countResBits), CENTRE_BER, &centre);
+        const int peakIndex = centre.crossingX;
+        if (peakIndex <= (numPhaseSteps / 2)) shift = peakIndex;
+        else                                  shift = peakIndex - numPhaseSteps;
+    }
+    result = dataShift(bathtubRowData, numPhaseSteps, bathtubOffsetsSorted.size(), shift);
+    if (result != globals::OK) return result;
+
+    // Normalise, and arrange curves in the order requested:
+    nBitsAnalysed = (double)((uint16_t)(1 << countResBits));
+    bufferReset(curves, numPhaseSteps * bathtubOffsets.size());
+    for (i = 0; i < bathtubOffsets.size(); i++)
+    {
+        row = bathtubOffsetsSorted.indexOf(bathtubOffsets[i]);
+        for (x = 0; x < numPhaseSteps; x++)
+        {
+            ber = bathtubRowData[(row * numPhaseSteps) + x] / nBitsAnalysed;
+            if (ber < (1.0 / nBitsAnalysed)) curves[(i * numPhaseSteps) + x] = globals::BELOW_DETECTION_LIMIT;
+            else                              curves[(i * numPhaseSteps) + x] = log10(ber);
+        }
+    }
+
+    qDebug() << "--Bathtub Scan data aquired! " << bathtubOffsets.size() << " curve(s)";
+    parent->emitEyeBathtubsFinished(laneOffset + scanLane, bathtubOffsets, curves, numPhaseSteps);
+    scanState = SCAN_IDLE;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set options for the dual-Dirac bathtub fit (see bathtubFitRun)
+ \param targetBERs  BERs at which to report the extrapolated eye opening (e.g. 1e-12, 1e-15)
+ \param fitBERMax   Highest BER used in the fit (0 < fitBERMax < 0.5)
+ \param tolerance   Fit has converged when the openings change by less than this (UI) between repeats
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range
+*/
+int EyeMonitor::setBathtubFitOptions(const QVector<double> &targetBERs,
+                                     double fitBERMax,
+                                     double tolerance)
+{
+    if (targetBERs.isEmpty() || (fitBERMax <= 0.0) || (fitBERMax >= BathtubFit::TRANSITION_DENSITY) || (tolerance <= 0.0)) return globals::OVERFLOW;
+    foreach (double ber, targetBERs)
+    {
+        if ((ber <= 0.0) || (ber >= BathtubFit::TRANSITION_DENSITY)) return globals::OVERFLOW;
+    }
+    bathtubFitTargets   = targetBERs;
+    bathtubFitBERMax    = fitBERMax;
+    bathtubFitTolerance = tolerance;
+    bathtubFitOpenings.clear();
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set options for the repeated scan auto-stop policy (see autoStopEvaluate)
+ \param enabled    Enable auto-stop
+ \param tolerance  Metrics are stable when they change by less than this fraction between
+                    repeats; at least (1 - tolerance) of points must be resolved (0 < tolerance < 1)
+ \param floorBER   Stop when the measurement floor reaches this BER (0 = don't use floor target)
+ \param metricBER  BER which defines the open part of the eye for metrics (0 < metricBER < 1)
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range
+*/
+int EyeMonitor::setAutoStopOptions(bool enabled,
+                                   double tolerance,
+                                   double floorBER,
+                                   double metricBER)
+{
+    if ((tolerance <= 0.0) || (tolerance >= 1.0) || (floorBER < 0.0) || (metricBER <= 0.0) || (metricBER >= 1.0)) return globals::OVERFLOW;
+    autoStopEnabled   = enabled;
+    autoStopTolerance = tolerance;
+    autoStopFloorBER  = floorBER;
+    autoStopMetricBER = metricBER;
+    autoStopMetrics.clear();
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set BER thresholds for eye metrics (see metricsRun)
+ \param thresholds  BER thresholds (0 < BER < 1); metrics are found at each one
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range
+*/
+int EyeMonitor::setMetricsThresholds(const QVector<double> &thresholds)
+{
+    if (thresholds.isEmpty()) return globals::OVERFLOW;
+    foreach (double ber, thresholds)
+    {
+        if ((ber <= 0.0) || (ber >= 1.0)) return globals::OVERFLOW;
+    }
+    metricsThresholds = thresholds;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Save the last eye or bathtub scan to an archive file
+ The accumulated error counts from the last completed repeat are saved,
+ with the scan settings (see EyeArchive). May be called between repeats.
+ The result is sent using the EyeArchiveSaved signal.
+ \param fileName  Full path of file to write
+ \param serial    Instrument serial number, stored in the file
+ \return globals::OK
+ \return globals::INVALID_DATA  No completed scan to save
+ \return [error code]           See EyeArchive::save
+*/
+int EyeMonitor::archiveSave(const QString &fileName, const QString &serial)
+{
+    EyeArchive::record_t record;
+    int result = archiveRecord(serial, &record);
+    if (result == globals::OK) result = EyeArchive::save(fileName, record);
+    if (result != globals::OK) qDebug() << "Error saving eye archive " << fileName << ": " << result;
+    parent->emitEyeArchiveSaved(laneOffset + scanLane, fileName, result);
+    return result;
+}
+
+
+
+/*!
+ \brief Compare the last eye or bathtub scan with a golden scan
+ The golden scan is loaded from an archive file (see archiveSave), and
+ must have the same type and resolution as the last scan. The result
+ (see EyeArchive::compare) is sent using the EyeArchiveCompareFinished
+ signal, including the difference at each point for plotting as an overlay.
+ \param goldenFileName    Archive file holding the golden scan
+ \param toleranceDecades  Differences (in decades of BER) above this count as worse / better
+ \return globals::OK
+ \return [error code]
+*/
+int EyeMonitor::archiveCompare(const QString &goldenFileName, double toleranceDecades)
+{
+    EyeArchive::record_t record, golden;
+    EyeArchive::diff_t diff = EyeArchive::diff_t();
+    int result = archiveRecord(QString(), &record);
+    if (result != globals::OK) goto finished;
+    result = EyeArchive::load(goldenFileName, &golden);
+    if (result != globals::OK) goto finished;
+    result = EyeArchive::compare(record, golden, toleranceDecades, &diff);
+
+  finished:
+    if (result != globals::OK) qDebug() << "Error comparing with golden eye " << goldenFileName << ": " << result;
+    parent->emitEyeArchiveCompareFinished(laneOffset + scanLane, result, diff.delta, scanHRes, scanVRes,
+                                          diff.maxDelta, diff.rmsDelta, diff.cellsWorse, diff.cellsBetter);
+    return result;
+}
+
+
+
+/*!
+ \brief Cancel the eye scan
+ Sets the cancel flag, which is checked between scan steps.
+ Safe to call from any thread.
+*/
+void EyeMonitor::cancelScan()
+  {  stopFlag.storeRelease(1);  }
+
+
+
+/*!
+ \brief Start the eye drift monitor
+
+ For long soak tests: Watches for the eye closing over time, using
+ periodic low cost snapshots instead of full eye scans. Each snapshot
+ sweeps DRIFT_ROWS rows around 0 mV (DRIFT_ROW_SPACING offset steps
+ apart) in one Control Eye Sweep, and measures the opening of each row
+ (see driftSnapshot). Metrics (UI):
+   0 to DRIFT_ROWS - 1:  Width of each row at targetBER, lowest row first
+   DRIFT_ROWS:           Mean width of all rows
+
+ The first DRIFT_BASELINE_SNAPSHOTS snapshots set the baseline (mean and
+ standard deviation of each metric), which is sent with EyeDriftBaseline.
+ After that, each metric is smoothed (EWMA) and compared with its baseline
+ (see driftEvaluate). EyeDriftAlarm is sent, with only the metrics which
+ have changed, when the opening shrinks by more than the threshold.
+
+ This method only sets up the monitor: The caller must call driftStep when
+ driftMsUntilDue reaches 0 (see GT1724::eyeDriftService). After each
+ snapshot, the next one is delayed so that snapshots use the bus for no
+ more than dutyCycle of the time. Errors are sent with EyeScanError
+ (type GT1724_DRIFT_MONITOR), and stop the monitor.
+
+ \param hStepIndex     Horizontal (phase) step index (from EYESCAN_VHSTEP_LOOKUP)
+ \param countResIndex  Count resolution (0 = 1 bit ... 3 = 8 bit)
+ \param targetBER      BER which defines the open part of each row (0 < targetBER < 1)
+ \param threshold      Shrink in opening which raises an alarm (UI; 0 < threshold < 1).
+                       Shrinks within DRIFT_SIGMA_K standard deviations of the
+                       baseline are treated as noise.
+ \param dutyCycle      Largest fraction of the time that snapshots may use the bus
+                       (0 < dutyCycle <= DRIFT_DUTY_MAX)
+
+ If the scan output memory can't hold all DRIFT_ROWS rows at the requested
+ phase step and count resolution, each snapshot is split into several
+ sweeps (see driftSnapshot).
+
+ \return globals::OK
+ \return globals::OVERFLOW  Parameter out of range, or one row doesn't fit in the output memory
+ \return [error code]       Error from hardware/comms functions
+*/
+int EyeMonitor::driftStart(int hStepIndex,
+                           int countResIndex,
+                           double targetBER,
+                           double threshold,
+                           double dutyCycle)
+{
+    const driftStat_t statReset = { 0.0, 0.0, 0.0, false };
+    uint8_t sizeMSB = 0, sizeLSB = 0;
+    int numPhaseSteps, rowsPerPart;
+    int result;
+
+    Q_ASSERT( (hStepIndex >= 0)    && (hStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
+              (countResIndex >= 0) && (countResIndex <= 3) );
+    if ( (hStepIndex < 0) || (hStepIndex >= GT1724::EYESCAN_VHSTEP_LOOKUP.size()) ||
+         (countResIndex < 0) || (countResIndex > 3) ||
+         (targetBER <= 0.0) || (targetBER >= 1.0) ||
+         (threshold <= 0.0) || (threshold >= 1.0) ||
+         (dutyCycle <= 0.0) || (dutyCycle > DRIFT_DUTY_MAX) )
+    {
+        parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_DRIFT_MONITOR, globals::OVERFLOW);
+        return globals::OVERFLOW;
+    }
+
+    result = queryEyeScanMem(&imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB);
+    if (result != globals::OK)
+    {
+        qDebug() << "Error reading output memory attributes: " << result;
+        parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_DRIFT_MONITOR, result);
+        return result;
+    }
+    imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+
+    // Rows which fit in memory (samples are packed, so round down to whole rows):
+    numPhaseSteps = 128 / GT1724::EYESCAN_VHSTEP_LOOKUP[hStepIndex];
+    rowsPerPart = (static_cast<int>(imageMaximumSize) * 8) / (numPhaseSteps * (1 << (1 << countResIndex)));
+    if (rowsPerPart < 1)
+    {
+        qDebug() << "Drift Monitor: One row (" << numPhaseSteps << " samples) doesn't fit in output memory (" << imageMaximumSize << " bytes)";
+        parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_DRIFT_MONITOR, globals::OVERFLOW);
+        return globals::OVERFLOW;
+    }
+    driftRowsPerPart = qMin(rowsPerPart, static_cast<int>(DRIFT_ROWS));
+    driftRawData.resize(imageMaximumSize);
+
+    driftHStep         = static_cast<uint8_t>(GT1724::EYESCAN_VHSTEP_LOOKUP[hStepIndex]);
+    driftCountResIndex = static_cast<uint8_t>(countResIndex);
+    driftTargetBER     = targetBER;
+    driftThreshold     = threshold;
+    driftDutyCycle     = dutyCycle;
+    driftSnapshots     = 0;
+    driftStats.fill(statReset, DRIFT_METRICS);
+    driftClock.start();
+    driftDueTime       = 0;
+    driftEnabled       = true;
+
+    qDebug() << "Drift Monitor Configuration:";
+    qDebug() << " Lane:       " << scanLane;
+    qDebug() << " H Step:     " << driftHStep;
+    qDebug() << " Resolution: " << (1 << driftCountResIndex) << " (index " << driftCountResIndex << ")";
+    qDebug() << " Target BER: " << driftTargetBER;
+    qDebug() << " Threshold:  " << driftThreshold << " UI";
+    qDebug() << " Duty Cycle: " << driftDutyCycle;
+    qDebug() << " Rows/Sweep: " << driftRowsPerPart;
+    return globals::OK;
+}
+
+
+/*!
+ \brief Take one drift monitor snapshot, and schedule the next one
+ See driftStart. Sends EyeDriftBaseline / EyeDriftAlarm as needed.
+ \return globals::OK
+ \return [error code]  Snapshot failed; EyeScanError has been sent and the monitor stopped.
+*/
+int EyeMonitor::driftStep()
+{
+    QVector<double> metrics;
+    QElapsedTimer stepTimer;
+    qint64 delayMs;
+    int result;
+
+    if (!driftEnabled) return globals::OK;
+    stepTimer.start();
+    result = driftSnapshot(metrics);
+    if (result != globals::OK)
+    {
+        qDebug() << "Drift Monitor: Error taking snapshot: " << result;
+        driftStop();
+        parent->emitEyeScanError(laneOffset + scanLane, GT1724::GT1724_DRIFT_MONITOR, result);
+        return result;
+    }
+    driftEvaluate(metrics);
+
+    // Wait long enough to keep the bus time used by snapshots within the duty cycle:
+    delayMs = static_cast<qint64>(ceil(static_cast<double>(stepTimer.elapsed()) * (1.0 - driftDutyCycle) / driftDutyCycle));
+    if (delayMs < ScanPlanner::MACRO_POLL_MS) delayMs = ScanPlanner::MACRO_POLL_MS;
+    driftDueTime = driftClock.elapsed() + delayMs;
+    return globals::OK;
+}
+
+
+/*!
+ \brief Stop the eye drift monitor
+*/
+void EyeMonitor::driftStop()
+{
+    if (driftEnabled) qDebug() << "Drift Monitor stopped: Lane " << scanLane << "; Snapshots: " << driftSnapshots;
+    driftEnabled = false;
+}
+
+
+/*!
+ \brief Time until the next drift monitor snapshot is due
+ \return Time in mS (0 if due now; -1 if the drift monitor isn't running)
+*/
+qint64 EyeMonitor::driftMsUntilDue() const
+{
+    if (!driftEnabled) return -1;
+    const qint64 ms = driftDueTime - driftClock.elapsed();
+    return (ms > 0) ? ms : 0;
+}
+
+
+
+
+
+
+
+
+
+
+/*!
+ \brief Advance the Eye Scan by one step
+
+ Eye and bathtub scans (see startScan) run as a state machine, so that
+ the worker thread isn't blocked for the whole scan. Each call does one
+ step of the scan, then returns:
+   SCAN_SETUP:  Read the output memory attributes and work out the scan geometry
+   SCAN_SWEEP:  Sweep one part of the eye and read back / unpack the data
+                (several parts are needed if the scan doesn't fit in the
+                output memory in one go)
+   SCAN_FINISH: Accumulate and normalise the data, run the analyses, and
+                send the results
+ Mask tests (see startMaskTest) run the same way:
+   SCAN_MASK_CENTRE: Scan the centre row, and place the mask
+   SCAN_MASK:        Sweep one window of the mask
+   SCAN_MASK_MARGIN: Sweep one window outside the mask (margin search)
+ ... and so do ROI, multi-row bathtub and contour scans:
+   SCAN_ROI:            Sweep one part of the window (see startROIScan)
+   SCAN_BATHTUBS:       Sweep one part of an offset group (see startBathtubScan)
+   SCAN_CONTOUR_CENTRE: Scan the centre row (see startContourScan)
+   SCAN_CONTOUR:        Find one boundary point
+
+ Nb: A sweep and its read back are done in one step, because both eye
+ monitors share the output memory.
+
+ The cancel flag (see cancelScan) is checked before each step, so a
+ cancel takes effect within one step.
+
+ \param done  Set to true when the scan is finished (or failed, or was
+              cancelled). Nothing more to do for this scan.
+ \return globals::OK
+ \return [error code]  Scan failed; EyeScanError has been sent.
+*/
+int EyeMonitor::scanStep(bool *done)
+{
+    int scanResult = globals::OK;
+    const int errorType = scanTypeActive();
+    *done = false;
+    if (scanState == SCAN_IDLE)
+    {
+        *done = true;
+        return globals::OK;
+    }
+    if (cancelRequested())
+    {
+        qDebug() << "--Scan Cancelled. Stop.--";
+        scanResult = globals::CANCELLED;
+        goto finished;
+    }
+    switch (scanState)
+    {
+    case SCAN_SETUP:
+        scanResult = scanStepSetup();
+        break;
+    case SCAN_SWEEP:
+        scanResult = scanStepSweep();
+        break;
+    case SCAN_FINISH:
+        scanResult = scanStepFinish();
+        break;
+    case SCAN_MASK_CENTRE:
+        scanResult = maskStepCentre();
+        break;
+    case SCAN_MASK:
+        scanResult = maskStepSweep();
+        break;
+    case SCAN_MASK_MARGIN:
+        scanResult = maskStepMargin();
+        break;
+    case SCAN_ROI:
+        scanResult = roiStep();
+        break;
+    case SCAN_BATHTUBS:
+        scanResult = bathtubStep();
+        break;
+    case SCAN_CONTOUR_CENTRE:
+        scanResult = contourStepCentre();
+        break;
+    case SCAN_CONTOUR:
+        scanResult = contourStepBoundary();
+        break;
+    default:
+        break;
+    }
+    if (scanResult != globals::OK) goto finished;
+    if (scanState == SCAN_IDLE)
+    {
+        qDebug() << "**Eye Scan finshed OK. **";
+        *done = true;
+    }
+    return globals::OK;
+
+  finished:
+    scanState = SCAN_IDLE;
+    *done = true;
+    if (scanResult == globals::OVERFLOW) qDebug() << "ERROR: Ran out of space in output buffer!";
+    // Don't leave a frame from an earlier repeat for the UI to pick up later:
+    EyeFrameMailbox::clear(laneOffset + scanLane);
+    parent->emitEyeScanError(laneOffset + scanLane, errorType, scanResult);
+    return scanResult;
+}
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Type of the scan in progress (GT1724_EYE_SCAN, etc), for EyeScanError
+*/
+int EyeMonitor::scanTypeActive() const
+{
+    switch (scanState)
+    {
+    case SCAN_MASK_CENTRE:
+    case SCAN_MASK:
+    case SCAN_MASK_MARGIN:
+        return GT1724::GT1724_MASK_TEST;
+    case SCAN_ROI:
+        return GT1724::GT1724_ROI_SCAN;
+    case SCAN_BATHTUBS:
+        return GT1724::GT1724_BATHTUB_SCAN;
+    case SCAN_CONTOUR_CENTRE:
+    case SCAN_CONTOUR:
+        return GT1724::GT1724_CONTOUR_SCAN;
+    default:
+        return scanType;
+    }
+}
+
+
+
+/*!
+ \brief Eye Scan step: Set up the scan
+ Works out the scan geometry, and the rows to scan in each part.
+ See scanStep.
+*/
+int EyeMonitor::scanStepSetup()
+{
+    int scanResult = globals::OK;
+
+    ///////// Determine the output memory attributes: ///////////////////////
+    uint16_t imageStartAddress;
+    uint8_t sizeMSB, sizeLSB;
+    int bytesPerLine;
+    imageAddressMSB = 0;
+    imageAddressLSB = 0;
+    sizeMSB    = 0;
+    sizeLSB    = 0;
+    scanResult = queryEyeScanMem( &imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB );
+    if (scanResult != globals::OK)
+    {
+        qDebug() << "Error reading output memory attributes: " << scanResult;
+        return scanResult;
+    }
+    imageStartAddress = static_cast<uint16_t>(static_cast<uint16_t>(imageAddressMSB) << 8) + static_cast<uint16_t>(imageAddressLSB);
+    imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    qDebug() << "Eye Scan - Image Start Address: " << imageStartAddress
+             << "; Size: " << imageMaximumSize;
+    costParams.imageMaximumSize = imageMaximumSize;
+
+    /**** Eye Scan: *****************************************************/
+    qDebug() << "**Starting Eye Scan**";
+
+    uint8_t offsetStart;
+
+    // Calculate the number of steps in one scan line:
+    scanNumPhaseSteps = 128 / scanHStep;
+
+    /* OLD - From GT1724 Manual - DEPRECATED
+     * Note: The calculation below is for arbitrary values of
+     * phaseStart / phaseStop / scanHStep.
+     * However, we simplify it (above) because we always scan
+     * an entire row (phaseStart=0; phaseStop=127) and scanHStep
+     * is 1, 2, 4 or 8.
+    scanNumPhaseSteps = (uint8_t)
+            ceil( (double)(phaseStop - phaseStart + 1) / (double)scanHStep );
+    */
+    scanHRes = scanNumPhaseSteps;
+
+    // Calculate the number of lines that will fit in memory. While the ED is
+    // running, parts are also kept short enough that ED readings can continue
+    // between them (see GT1724::edSweepBegin):
+    bytesPerLine = (scanNumPhaseSteps * scanCountResBits) / 8;  // Number of bytes in one 'horizontal' scan line (i.e. one offset step)
+    costParams.opLatencyMs = parent->comms->getOpLatency();
+    costParams.stepMsMax   = parent->edAnyRunning() ? static_cast<double>(GT1724::EYESCAN_STEP_MS_MAX) : 0.0;
+    scanNumOffsetStepsMax = static_cast<uint8_t>(ScanPlanner::sweepLinesMax(costParams, scanNumPhaseSteps, scanCountResIndex));
+
+    /* OLD  - From GT1724 Manual - DEPRECATED
+     * This is the general calculation for arbitraty values of scanNumPhaseSteps, etc.
+     * We simplify it above.
+    // From section 5.5.2 of datasheet
+    scanNumOffsetStepsMax = (uint8_t)
+            (  (double)imageMaximumSize /
+               (
+                   (double)scanNumPhaseSteps * ( (double)scanCountResBits / 8.0 )
+                   )
+               );
+    */
+
+    qDebug() << " numPhaseSteps: " << scanNumPhaseSteps
+             << "; bytesPerLine: " << bytesPerLine
+             << "; numOffsetStepsMax: " << scanNumOffsetStepsMax;
+
+    // Calculate the number of lines in the full scan:
+    if (scanType == GT1724::GT1724_EYE_SCAN)
+    {
+        // FULL eye scan:
+        offsetStart    = 1;
+        scanOffsetStop = 127;
+        scanNumOffsetSteps = 128 / scanVStep;
+        if (scanNumOffsetSteps == 128) scanNumOffsetSteps = 127;
+
+        /* OLD - From GT1724 Manual - DEPRECATED
+         * Note: The calculation below is for arbitrary values of
+         * offsetStart / scanOffsetStop / scanVStep.
+         * However, we simplify it (above) because we always scan
+         * the entire diagram (Start=0; Stop=127) and scanVStep
+         * is 1, 2, 4 or 8.
+        scanNumOffsetSteps = (uint8_t)
+                ceil(  (double)(scanOffsetStop - offsetStart + 1) / (double)scanVStep  );
+        */
+
+        scanVRes = scanNumOffsetSteps;
+        qDebug() << "Eye Scan - Total number of lines: " << scanNumOffsetSteps;
+    }
+    else
+    {
+        // One line scan (bathtub plot):
+        offsetStart    = scanVOffset;
+        scanOffsetStop = scanVOffset;
+        scanPartOffsetStart = offsetStart;
+        scanPartOffsetStop = scanOffsetStop;
+        scanNumOffsetSteps = 1;
+        scanVRes = 1;
+        scanVStep = 1;
+        qDebug() << "Bathtub Scan - One line at specified offset.";
+    }
+
+    // Calculate total number of samples. Scratch buffers are owned by this monitor
+    // and reused for every repeat (see arenaPrepare), so nothing is allocated here:
+    scanResult = arenaPrepare(imageMaximumSize);
+    if (scanResult != globals::OK) return scanResult;
+    Q_ASSERT(scanSamples.size() >= (scanNumPhaseSteps * scanNumOffsetSteps));
+    scanSampleIndex = 0;
+
+    ////// Eye scan will be run more than once for resolutions > 8 bit: /////////////////
+    scanPartOffsetStart = offsetStart;
+
+    //////////////////////////////////////////////////////////////
+    /////// Scan the eye (in several steps if needed): ///////////
+    //////////////////////////////////////////////////////////////
+
+    if (scanNumOffsetSteps > scanNumOffsetStepsMax) scanPartOffsetStop = offsetStart + (scanNumOffsetStepsMax - 1) * scanVStep;
+    else                                            scanPartOffsetStop = scanOffsetStop;
+
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, 0);
+
+    scanState = SCAN_SWEEP;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Eye Scan step: Sweep one part of the eye and read back the data
+ See scanStep.
+*/
+int EyeMonitor::scanStepSweep()
+{
+    int scanResult = globals::OK;
+    uint8_t outputSizeMSB = 0;
+    uint8_t outputSizeLSB = 0;
+    uint16_t outputSize;
+    const int numSamples = scanNumPhaseSteps * scanNumOffsetSteps;
+    const int sampleIndexMax = numSamples - 1;   // For sanity check
+
+    //// SCAN: /////////////////////////////////////////////
+    qDebug() << "** Starting part scan: **\n"
+             << "   phaseStart: " << 0
+             << "   phaseStop: " << 127
+             << "   phaseStep: " << scanHStep << "\n"
+             << "   thisOffsetStart: " << scanPartOffsetStart
+             << "   thisOffsetStop: " << scanPartOffsetStop
+             << "   offsetStep: " << scanVStep << "\n"
+             << "   resolution: " << scanCountResBits;
+
+    QElapsedTimer sweepTimer;
+    sweepTimer.start();
+    scanResult = controlEyeSweep(0,        // phaseStart
+                                 127,      // phaseStop
+                                 scanHStep,
+                                 scanPartOffsetStart,
+                                 scanPartOffsetStop,
+                                 scanVStep,
+                                 scanCountResIndex,
+                                 &outputSizeMSB,
+                                 &outputSizeLSB);
+    qDebug() << "** Part scan finished. Result: " << scanResult;
+    if (scanResult != globals::OK)
+    {
+        qDebug() << "Error running scan: " << scanResult;
+        return scanResult;
+    }
+    // Update the sweep time used for scan cost estimates:
+    costParams.opLatencyMs = parent->comms->getOpLatency();
+    ScanPlanner::sweepTimeRecord(&costParams,
+                                 scanCountResIndex,
+                                 (((scanPartOffsetStop - scanPartOffsetStart) / scanVStep) + 1) * scanNumPhaseSteps,
+                                 static_cast<double>(sweepTimer.elapsed()));
+    // Read back data:
+
+    outputSize = static_cast<uint16_t>(static_cast<uint16_t>(outputSizeMSB) << 8) + static_cast<uint16_t>(outputSizeLSB);
+    //// READ DATA: /////////////////////////////////////////////
+    qDebug() << "--Reading back scan data: " << outputSize << " bytes --";
+
+    scanResult = parent->rawRead24(0xFC,
+                                   imageAddressMSB,
+                                   imageAddressLSB,
+                                   scanRawData.data(),
+                                   static_cast<size_t>(outputSize));
+    if (scanResult != globals::OK)
+    {
+        qDebug() << "Error reading back scan data: " << scanResult;
+        return scanResult;
+    }
+    //// UNPACK DATA: //////////////////////////////////////////
+    qDebug() << "--Unpacking scan data...\n"
+             << "  Tot Num Samples:  " << numSamples << "\n"
+             << "  THIS block size:  " << outputSize << "\n"
+             << "  Buffer Remaining: " << sampleIndexMax - scanSampleIndex + 1;
+
+
+
+    for (size_t sampleIndex = 0; sampleIndex < static_cast<size_t>(outputSize); sampleIndex++)
+    {
+        // Sanity check: Make sure we aren't about to overflow the output buffer:
+        Q_ASSERT(scanSampleIndex <= sampleIndexMax);
+        if (scanSampleIndex > sampleIndexMax) return globals::OVERFLOW;
+
+        switch (scanCountResBits)
+        {
+        case 1: // 1  bit per sample:
+            for (int bitIndex = 0; bitIndex < 8; bitIndex++)
+            {
+                // For each bit, shift and mask, and store to output as uint8_t:
+                scanSamples[scanSampleIndex] = static_cast<double>((scanRawData[sampleIndex] >> (7-bitIndex)) & 0x01);
+                scanSampleIndex++;
+            }
+            break;
+        case 2: // 2  bits per sample:
+            for (int bitIndex = 0; bitIndex < 8; bitIndex+=2)
+            {
+                // For each bit, shift and mask, and store to output as uint8_t:
+                scanSamples[scanSampleIndex] = static_cast<double>((scanRawData[sampleIndex] >> (6-bitIndex)) & 0x03);
+                scanSampleIndex++;
+            }
+            break;
+        case 4: // 4  bits per sample:
+            for (int bitIndex = 0; bitIndex < 8; bitIndex+=4)
+            {
+                // For each bit, shift and mask, and store to output as uint8_t:
+                scanSamples[scanSampleIndex] = static_cast<double>((scanRawData[sampleIndex] >> (4-bitIndex)) & 0x0F);
+                scanSampleIndex++;
+            }
+            break;
+        case 8: // 8  bits per sample:
+            scanSamples[scanSampleIndex] = static_cast<double>(scanRawData[sampleIndex]);
+            scanSampleIndex++;
+        }
+    }
+
+    //// Advance start and stop offsets: ///////////////////////
+    qDebug() << "--Adjusting offsets for next part...";
+    //Start = Stop + OffsetStep:
+    scanPartOffsetStart = scanPartOffsetStop + scanVStep;
+    //Stop = Start + (NumOffsetStepsMax - 1) * OffsetStep:
+    scanPartOffsetStop = scanPartOffsetStart + ( (scanNumOffsetStepsMax - 1) * scanVStep );
+    //If Stop is greater than OffsetStop then Stop = OffsetStop:
+    if (scanPartOffsetStop > scanOffsetStop) scanPartOffsetStop = scanOffsetStop;
+
+    // Update progress:
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, (scanSampleIndex * 100) / numSamples);
+
+    if (scanPartOffsetStart > scanOffsetStop) scanState = SCAN_FINISH;
+    return globals::OK;
+}
+
+
+
+#define BERT_EYESCAN_SHIFT 1    // Define this to enable eye / bathtub "Shift" (make sure eye starts at left edge for visual appeal)
+// #define BERT_EYESCAN_EXTEND 1   // Define this to enable eye "Extend" (copy some data from start of eye and place it at end for visual appeal; i.e. width of plot is greater than 1 UI)
+
+/*!
+ \brief Eye Scan step: Accumulate and normalise the data, and send the results
+ See scanStep.
+*/
+int EyeMonitor::scanStepFinish()
+{
+    uint8_t numPhaseSteps  = scanNumPhaseSteps;
+    uint8_t numOffsetSteps = scanNumOffsetSteps;
+
+    // Finished successfully.
+    // Nb: Shift and Extend are both done by index remapping while
+    // accumulating (see below), so the scan data are never copied.
+    int numPhaseStepsOut = numPhaseSteps;  // Width of output rows (after extend)
+
+    if (scanType == GT1724::GT1724_EYE_SCAN)
+    {
+#ifdef BERT_EYESCAN_SHIFT
+        //////// SHIFT: //////////////////////////////////////////////////
+        // For eye plots: We want the "eye" to be centred in the plot; however
+        // sample 0 of scan data is actually before the eye start. Cut the left
+        // end and splice it onto the right end. The amount to rotate depends on
+        // whether we are also doing an "extend" (see below).
+        // Nb: Only adjust the shift amount on the first scan after a reset:
+        // Nb: If the eye centre can't be found reliably, the previous shift is kept.
+        uint8_t peakIndex;
+        if (scanResetFlag && crossingFind(numPhaseSteps, numOffsetSteps, &peakIndex))
+        {
+            const uint8_t xMid = (numPhaseSteps / 2);  // Index of mid point
+     #ifdef BERT_EYESCAN_EXTEND
+            // If "extending" the diagram, shift a bit less (for visual appeal):
+            if (peakIndex <= xMid) nShift = (int)(peakIndex/scanHStep) + 1;
+            else                   nShift = ((int)peakIndex - (int)numPhaseSteps) / (int)scanHStep - 1;
+            nShift = nShift - (int)(0.11*(double)numPhaseSteps);
+            if (nShift < (-1 * (int)numPhaseSteps)) nShift = (-1 * (int)numPhaseSteps);
+    #else
+            // Not using "Extend": shift "peak" errors to left edge.
+            if (peakIndex <= xMid) nShift = static_cast<int>(peakIndex);
+            else                   nShift = static_cast<int>(peakIndex - numPhaseSteps);
+
+            /* OLD Don't know why this was divided by scanHStep ???
+            if (peakIndex <= xMid) nShift = (int)(peakIndex/scanHStep);
+            else                   nShift = ((int)peakIndex - (int)numPhaseSteps) / (int)scanHStep;
+            */
+    #endif
+        }
+        qDebug() << "SHIFT: Rotate eye plot " << nShift << " samples";
+#endif  // Shift ?
+
+#ifdef BERT_EYESCAN_EXTEND
+        //////// EXTEND: /////////////////////////////////////////////////
+        // For eye plot: "extend" the eye width by copying the left side
+        // and adding it to the right side (improves readability).
+        // Output row width is increased here; the extra samples are
+        // taken from the start of each row while accumulating:
+        uint8_t extraPhaseSteps = (uint8_t)((float)numPhaseSteps * 0.215f);
+        qDebug() << "EXTEND: Extending eye by " << extraPhaseSteps << " steps.";
+        numPhaseStepsOut = numPhaseSteps + extraPhaseSteps;
+        scanHRes = numPhaseStepsOut;
+        ////////////////////////////////////////////////////////////////////
+#endif  // Extend?
+
+    }
+    else
+    {
+#ifdef BERT_EYESCAN_SHIFT
+        //////// SHIFT: ////////////////////////////////////////////////////
+        // For bathtub plots: We want the plot to show one "eye" (tub),
+        // with the left side being the max error point at the start of the
+        // eye; however sample 0 of scan data is actually before the eye
+        // start. Cut the left end and splice it onto the right end:
+        // Nb: Only adjust the shift amount on the first scan after a reset:
+        uint8_t peakIndex;
+        if (scanResetFlag && crossingFind(numPhaseSteps, numOffsetSteps, &peakIndex))
+        {
+            const uint8_t xMid = (numPhaseSteps / 2);  // Index of mid point
+
+            if (peakIndex <= xMid) nShift = static_cast<int>(peakIndex);
+            else                   nShift = static_cast<int>(peakIndex - numPhaseSteps);
+
+            /* OLD Don't know why this was divided by scanHStep ???
+            if (peakIndex <= xMid) nShift = (int)(peakIndex/scanHStep);
+            else                   nShift = ((int)peakIndex - (int)numPhaseSteps) / (int)scanHStep;
+            */
+        }
+        qDebug() << "SHIFT: Rotate bathtub plot " << nShift << " samples";
+        ////////////////////////////////////////////////////////////////////
+#endif  // Shift ?
+
+    }
+
+    // Data are stored in a global buffer which accumulates data between
+    // repeated scans, until a new scan is started.
+    // Nb: bufferReset only reallocates if the size changes.
+    const int numSamplesOut = numPhaseStepsOut * numOffsetSteps;
+    if (scanResetFlag)
+    {
+        // New Scan... reset the global scan data buffer.
+        bufferReset(eyeDataBuffer, numSamplesOut);
+    }
+    // Ensure that global scan data buffer is the same size as the results from this scan:
+    Q_ASSERT(eyeDataBuffer.size() == numSamplesOut);
+    if (eyeDataBuffer.size() != numSamplesOut)
+    {
+        // For production, if the size changes for some reason, throw away the old data:
+        bufferReset(eyeDataBuffer, numSamplesOut);
+    }
+
+    ////// ACCUMULATE / NORMALISE: ////////////////////////////////////////////////
+    double nBitsAnalysed = (double)((uint16_t)(1 << scanCountResBits)) * (double)scanRepeatCount;
+    const double eyeScanLogFloor = 1.0 / (double)nBitsAnalysed;
+
+    // Normalised data go into a buffer which isn't used by any frame sent earlier:
+    EyeFrame::frameData_t *frameBuffer = frameBufferAcquire(numSamplesOut);
+    QVector<double> &normBuffer = frameBuffer->data;
+
+    // For debugging eye scan data as CSV: #define DEBUG_EYE_DATA(MSG) qDebug() << MSG;
+    #define DEBUG_EYE_DATA(MSG)  // No debug.
+    DEBUG_EYE_DATA("Repeats Done: " << scanRepeatCount << "; Bits Analysed: " << nBitsAnalysed << "; Log Floor: " << eyeScanLogFloor)
+    DEBUG_EYE_DATA("-----------------------------------------")
+    DEBUG_EYE_DATA("Repeats,TotalBits,Floor")
+    DEBUG_EYE_DATA(scanRepeatCount << "," << nBitsAnalysed << "," << eyeScanLogFloor)
+    DEBUG_EYE_DATA("")
+    DEBUG_EYE_DATA("i,Errors,BER")
+
+// Eye Data Quantisation Error: Quick Fix:
+// Define EYE_DATA_QUANTISATION_QUICKFIX to crop counts of 1 (these contain quantisation error).
+// Note this is a quick fix which introduces an opposite error, i.e. dropping some valid error counts.
+//#define EYE_DATA_QUANTISATION_QUICKFIX 1
+
+    // Column in the scratch buffer for each output column: Applies the shift
+    // (rotate the row by nShift) and extend (wrap extra columns to start of row):
+    int sourceColumn[256];
+    Q_ASSERT(numPhaseStepsOut <= 256);
+    {
+        int shift = 0;
+#ifdef BERT_EYESCAN_SHIFT
+        shift = ((nShift % numPhaseSteps) + numPhaseSteps) % numPhaseSteps;
+#endif
+        for (int x = 0; x < numPhaseStepsOut; x++) sourceColumn[x] = ((x % numPhaseSteps) + shift) % numPhaseSteps;
+    }
+    int sourceX = 0, sourceRow = 0;
+
+    for (int i = 0; i < numSamplesOut; i++)
+    {
+        const double thisSample = scanSamples[sourceRow + sourceColumn[sourceX]];
+        if (++sourceX == numPhaseStepsOut)
+        {
+            sourceX = 0;
+            sourceRow += numPhaseSteps;
+        }
+#ifdef EYE_DATA_QUANTISATION_QUICKFIX
+        if (thisSample > 1)
+        {
+            eyeDataBuffer[i] += thisSample;   // Add most recent scan to all previous scans
+        }
+        /* EXPERIMENTAL AND HACKY.
+        else if (thisSample == 1)
+        {
+            // Error count of 1: This count includes a slight over-estimate of errors, so fudge it a bit...
+            // I.e. only count the error 75% of the time.
+            if((rand() % 100) > 85) eyeDataBuffer[i]++;
+        }
+        */
+#else
+        eyeDataBuffer[i] += thisSample;   // Add most recent scan to all previous scans
+#endif
+        // Normalise the data point (using log 10):
+        double thisValue = eyeDataBuffer[i] / nBitsAnalysed;
+        if (thisValue < eyeScanLogFloor)
+        {
+            DEBUG_EYE_DATA("," << eyeDataBuffer[i] << "," << eyeScanLogFloor << ", V")
+            if (scanType == GT1724::GT1724_EYE_SCAN) normBuffer[i] = log10(eyeScanLogFloor);
+            else                                     normBuffer[i] = globals::BELOW_DETECTION_LIMIT;
+                // For Bathtub Plot Only: Set "floor" of plot (= error rate below detection limit) to a very negative value.
+                // Used by bathtub plot widget to hide invalid values at the bottom of the plot curve.
+        }
+        else
+        {
+            DEBUG_EYE_DATA("," << eyeDataBuffer[i] << "," << thisValue << ", ")
+            normBuffer[i] = log10(thisValue);
+        }
+    }
+    DEBUG_EYE_DATA("-----------------------------------------")
+    frameBuffer->lane        = laneOffset + scanLane;
+    frameBuffer->type        = scanType;
+    frameBuffer->xRes        = scanHRes;
+    frameBuffer->yRes        = scanVRes;
+    frameBuffer->repeatCount = scanRepeatCount;
+    frameBuffer->floor       = log10(eyeScanLogFloor);
+    eyeDataFrame = EyeFrame(frameBuffer);  // Shared, not copied
+    ////////////////////////////////////////////////////////////////////////////////
+
+    // Data successfully aquired!
+    qDebug() << "--Scan data aquired! Transmitting results...";
+
+//#define BERT_EYESCAN_EXTRA_DEBUG
+#ifdef BERT_EYESCAN_EXTRA_DEBUG
+    //// DEBUG: Dump Eye Data: ///////////////////////////
+    qDebug() << "---- RAW Data ------------------------------------------";
+    qDebug() << "scanHRes,scanVRes";
+    qDebug() << scanHRes << "," << scanVRes;
+    qDebug() << "";
+    size_t xx, yy;
+    for (yy=0; yy < scanVRes; yy++)
+    {
+        QString debugString;
+        for (xx=0; xx < scanHRes; xx++)
+        {
+            debugString += QString::number(eyeDataBuffer[(yy * scanHRes) + xx]);
+            if (xx < (scanHRes-1)) debugString += QString(", ");
+        }
+        qDebug() << debugString;
+    }
+    qDebug() << "--------------------------------------------------------" << endl;
+    //////////////////////////////////////////////////////
+#endif
+
+    // Bathtub scan: Fit the dual-Dirac model, to extrapolate to low BERs:
+    if (scanType == GT1724::GT1724_BATHTUB_SCAN) bathtubFitRun(scanResetFlag);
+
+    // Auto-stop: Check whether more repeats are worth doing:
+    if (autoStopEnabled) autoStopEvaluate(scanResetFlag, nBitsAnalysed);
+
+    // Eye scan: Extract metrics, sent just before the data:
+    if (scanType == GT1724::GT1724_EYE_SCAN) metricsRun(nBitsAnalysed);
+
+    // Eye data may be used later to extract bathtub curves (see startBathtubScan):
+    eyeDataValid = (scanType == GT1724::GT1724_EYE_SCAN);
+    eyeDataFloor = log10(eyeScanLogFloor);
+    // Accumulated counts may be saved to an archive (see archiveSave):
+    eyeDataRepeats = scanRepeatCount;
+    eyeDataTime    = QDateTime::currentMSecsSinceEpoch();
+
+    // Publish the data as a frame: Nb the frame shares its buffer, so the UI
+    // gets the data without a copy. Latest frame wins, and there is only one
+    // notification pending for each lane (see EyeFrameMailbox).
+    if (EyeFrameMailbox::post(eyeDataFrame)) parent->emitEyeScanFinished(laneOffset + scanLane, scanType);
+qDebug() << "--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << scanVRes;
+
+    scanState = SCAN_IDLE;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Contour scan step: Scan the centre row to find the open columns
+ Then sets up the boundary trace (see contourStepBoundary).
+ See startContourScan and scanStep.
+*/
+int EyeMonitor::contourStepCentre()
+{
+    const int numPhaseSteps = 128 / contourHStep;
+    int result = scanCentreRow(contourHStep, contourCountResIndex, contourTargetBER, &contourRunStart, &contourRunLength);
+    if (result != globals::OK) return result;
+    contourPointsMeasured += numPhaseSteps;
+    qDebug() << "Contour Scan - Eye opening at centre: " << contourRunLength << " columns, from column " << contourRunStart;
+
+    // Trace the upper and lower boundaries: Start in the middle of the eye and
+    // work outwards, using the boundary from the previous column as the first guess:
+    contourUpper.fill(0, contourRunLength);
+    contourLower.fill(0, contourRunLength);
+    contourPass      = 0;
+    contourColumn    = contourRunLength / 2;
+    contourDirection = 1;
+    if (contourRunLength > 0) scanState = SCAN_CONTOUR;
+    else                      contourFinish();  // Eye closed at centre
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Contour scan step: Find one boundary (upper or lower) of one column
+ Columns are traced from the middle of the eye to the right, then from the
+ middle to the left. After the last column, the contour is sent (see
+ contourFinish).
+ See startContourScan and scanStep.
+*/
+int EyeMonitor::contourStepBoundary()
+{
+    const int numPhaseSteps = 128 / contourHStep;
+    const int kMid  = contourRunLength / 2;
+    const int kStep = (contourPass == 0) ? 1 : -1;
+    const int k     = contourColumn;
+    const uint8_t phase = static_cast<uint8_t>(((contourRunStart + k) % numPhaseSteps) * contourHStep);
+    const bool haveGuess = (k != kMid);
+    int result;
+
+    if (contourDirection > 0)
+    {
+        result = contourFindBoundary(phase, 1, haveGuess ? contourUpper[k - kStep] : -1, &contourUpper[k]);
+        if (result != globals::OK) return result;
+        contourDirection = -1;
+        return globals::OK;
+    }
+    result = contourFindBoundary(phase, -1, haveGuess ? contourLower[k - kStep] : -1, &contourLower[k]);
+    if (result != globals::OK) return result;
+    contourDirection = 1;
+
+    const int columnsDone = (contourPass == 0) ? (k - kMid + 1) : (contourRunLength - k);
+    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, GT1724::GT1724_CONTOUR_SCAN, (columnsDone * 100) / contourRunLength);
+
+    contourColumn += kStep;
+    if ( (contourPass == 0) && (contourColumn >= contourRunLength) )
+    {
+        contourPass   = 1;
+        contourColumn = kMid - 1;
+    }
+    if ( (contourPass == 1) && (contourColumn < 0) ) contourFinish();
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Contour scan: Build the contour polygon, and send it
+ See startContourScan.
+*/
+void EyeMonitor::contourFinish()
+{
+    const int numPhaseSteps = 128 / contourHStep;
+    QVector<double> contourPhase;      // Contour polygon: phase (may be > 127 if the eye wraps)
+    QVector<double> contourOffset;     //                  voltage offset (1 - 127)
+    double eyeWidth = 0.0, eyeHeight = 0.0;
+    int k;
+
+    // Upper edge left to right, then lower edge right to left:
+    for (k = 0; k < contourRunLength; k++)
+    {
+        contourPhase.append((double)((contourRunStart + k) * contourHStep));
+        contourOffset.append((double)(CONTOUR_OFFSET_CENTRE + contourUpper[k]));
+        if ((double)(contourUpper[k] + contourLower[k]) > eyeHeight) eyeHeight = (double)(contourUpper[k] + contourLower[k]);
+    }
+    for (k = contourRunLength - 1; k >= 0; k--)
+    {
+        contourPhase.append((double)((contourRunStart + k) * contourHStep));
+        contourOffset.append((double)(CONTOUR_OFFSET_CENTRE - contourLower[k]));
+    }
+    eyeWidth = (double)(contourRunLength * contourHStep);
+
+    qDebug() << "--Contour Scan finished. Width: " << eyeWidth << " phase steps; Height: " << eyeHeight
+             << " offset steps; Points measured: " << contourPointsMeasured
+             << " (full scan: " << numPhaseSteps * 127 << ")";
+    parent->emitEyeContourFinished(laneOffset + scanLane, contourPhase, contourOffset, eyeWidth, eyeHeight);
+    scanState = SCAN_IDLE;
+}
+
+
+
+/*!
+ \brief Scan the centre row of the eye, and find the widest run of open columns
+ The centre (0 mV) row is scanned once, and each column is marked as open if
+ its BER is less than or equal to targetBER. The widest run of open columns
+ is assumed to be the eye. The run may wrap around from the last column back
+ to the first. imageAddressMSB / imageAddressLSB must have been set by
+ queryEyeScanMem.
+
+ \param hStep       Phase step (1, 2, 4 or 8)
+ \param resolution  Count resolution index (0 - 3)
+ \param targetBER   Threshold BER for open columns
+ \param runStart    Used to return the index (phase / hStep) of the first open column in the run
+ \param runLength   Used to return the number of columns in the run (0 if the eye is closed)
+
+ \return globals::OK
+ \return globals::OVERFLOW  Output data didn't fit in buffer
+ \return [error code]       Error from hardware/comms functions
+*/
+int EyeMonitor::scanCentreRow(const uint8_t hStep,
+                              const uint8_t resolution,
+                              const double targetBER,
+                              int *runStart,
+                              int *runLength)
+{
+    const int numPhaseSteps = 128 / hStep;
+    const uint8_t countResBits = static_cast<uint8_t>(1 << resolution);
+    uint8_t rowData[128];  // Raw data for centre row: at most 128 samples x 8 bits
+    uint8_t sizeMSB, sizeLSB;
+    uint16_t outputSize;
+    int result;
+
+    *runStart = 0;
+    *runLength = 0;
+    result = controlEyeSweep(0, 127, hStep,
+                             CONTOUR_OFFSET_CENTRE, CONTOUR_OFFSET_CENTRE, 1,
+                             resolution,
+                             &sizeMSB, &sizeLSB);
+    if (result != globals::OK)
+    {
+        qDebug() << "Error running centre row scan: " << result;
+        return result;
+    }
+    outputSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    if (outputSize > sizeof(rowData)) return globals::OVERFLOW;
+    result = parent->rawRead24(0xFC, imageAddressMSB, imageAddressLSB, rowData, static_cast<size_t>(outputSize));
+    if (result != globals::OK)
+    {
+        qDebug() << "Error reading back centre row: " << result;
+        return result;
+    }
+    openRunFind(rowData, outputSize, 0, numPhaseSteps, countResBits, targetBER, runStart, runLength);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Take one drift monitor snapshot
+ Sweeps DRIFT_ROWS rows around 0 mV, and measures the width of the widest
+ run of open columns in each row (as for scanCentreRow). The rows are swept
+ in one Control Eye Sweep if they fit in the output memory, otherwise in
+ parts of driftRowsPerPart rows (see driftStart). See driftStart for the
+ metrics.
+ \param metrics  Used to return the metrics (DRIFT_METRICS values)
+ \return globals::OK
+ \return globals::OVERFLOW  Output data didn't fit in buffer
+ \return [error code]       Error from hardware/comms functions
+*/
+int EyeMonitor::driftSnapshot(QVector<double> &metrics)
+{
+    const int numPhaseSteps = 128 / driftHStep;
+    const uint8_t countResBits = static_cast<uint8_t>(1 << driftCountResIndex);
+    const uint8_t offsetStart  = static_cast<uint8_t>(CONTOUR_OFFSET_CENTRE - ((DRIFT_ROWS / 2) * DRIFT_ROW_SPACING));
+    uint8_t partOffsetStart, partOffsetStop;
+    uint8_t sizeMSB, sizeLSB;
+    uint16_t outputSize;
+    int row, partRows, k, runStart, runLength;
+    double widthSum = 0.0;
+    int result;
+    QElapsedTimer sweepTimer;
+
+    metrics.fill(0.0, DRIFT_METRICS);
+    for (row = 0; row < DRIFT_ROWS; row += partRows)
+    {
+        partRows = qMin(driftRowsPerPart, DRIFT_ROWS - row);
+        partOffsetStart = static_cast<uint8_t>(offsetStart + (row * DRIFT_ROW_SPACING));
+        partOffsetStop  = static_cast<uint8_t>(partOffsetStart + ((partRows - 1) * DRIFT_ROW_SPACING));
+
+        sweepTimer.start();
+        result = controlEyeSweep(0, 127, driftHStep,
+                                 partOffsetStart, partOffsetStop, DRIFT_ROW_SPACING,
+                                 driftCountResIndex,
+                                 &sizeMSB, &sizeLSB);
+        if (result != globals::OK) return result;
+        // Update the sweep time used for scan cost estimates:
+        costParams.opLatencyMs = parent->comms->getOpLatency();
+        ScanPlanner::sweepTimeRecord(&costParams, driftCountResIndex, partRows * numPhaseSteps,
+                                     static_cast<double>(sweepTimer.elapsed()));
+
+        outputSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+        if (outputSize > driftRawData.size()) return globals::OVERFLOW;
+        result = parent->rawRead24(0xFC, imageAddressMSB, imageAddressLSB, driftRawData.data(), static_cast<size_t>(outputSize));
+        if (result != globals::OK) return result;
+
+        for (k = 0; k < partRows; k++)
+        {
+            openRunFind(driftRawData.constData(), outputSize, k * numPhaseSteps, numPhaseSteps,
+                        countResBits, driftTargetBER, &runStart, &runLength);
+            metrics[row + k] = static_cast<double>(runLength) / static_cast<double>(numPhaseSteps);
+            widthSum += metrics[row + k];
+        }
+    }
+    metrics[DRIFT_ROWS] = widthSum / static_cast<double>(DRIFT_ROWS);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Compare a drift monitor snapshot with the baseline
+
+ Streaming statistics, so no snapshots are stored:
+  - Baseline: Mean and variance of each metric over the first
+    DRIFT_BASELINE_SNAPSHOTS snapshots (Welford's method).
+  - After that: EWMA of each metric (weight DRIFT_EWMA_WEIGHT), so a
+    single noisy snapshot doesn't raise an alarm.
+
+ A metric has shrunk if its EWMA is below the baseline mean by more than
+ the threshold (or DRIFT_SIGMA_K baseline standard deviations, if that is
+ larger). EyeDriftAlarm is sent with the metrics which have newly shrunk;
+ each metric can alarm again once it has recovered to within half of the
+ limit.
+
+ \param metrics  Metrics from driftSnapshot
+*/
+void EyeMonitor::driftEvaluate(const QVector<double> &metrics)
+{
+    QVector<int> changed;
+    QVector<double> baseline, current;
+    double delta, stdDev, limit, shrink;
+    int i;
+
+    driftSnapshots++;
+    if (driftSnapshots <= DRIFT_BASELINE_SNAPSHOTS)
+    {
+        for (i = 0; i < DRIFT_METRICS; i++)
+        {
+            driftStat_t &stat = driftStats[i];
+            delta = metrics[i] - stat.mean;
+            stat.mean += delta / static_cast<double>(driftSnapshots);
+            stat.m2   += delta * (metrics[i] - stat.mean);
+            stat.ewma  = stat.mean;
+        }
+        if (driftSnapshots == DRIFT_BASELINE_SNAPSHOTS)
+        {
+            for (i = 0; i < DRIFT_METRICS; i++)
+            {
+                baseline.append(driftStats[i].mean);
+                current.append(sqrt(driftStats[i].m2 / static_cast<double>(DRIFT_BASELINE_SNAPSHOTS - 1)));
+            }
+            qDebug() << "Drift Monitor: Lane " << scanLane << ": Baseline: " << baseline << "; Std Dev: " << current;
+            parent->emitEyeDriftBaseline(laneOffset + scanLane, baseline, current);
+        }
+        return;
+    }
+
+    for (i = 0; i < DRIFT_METRICS; i++)
+    {
+        driftStat_t &stat = driftStats[i];
+        stat.ewma += DRIFT_EWMA_WEIGHT * (metrics[i] - stat.ewma);
+        stdDev = sqrt(stat.m2 / static_cast<double>(DRIFT_BASELINE_SNAPSHOTS - 1));
+        limit  = std::max(driftThreshold, DRIFT_SIGMA_K * stdDev);
+        shrink = stat.mean - stat.ewma;
+        if (!stat.alarm && (shrink > limit))
+        {
+            stat.alarm = true;
+            changed.append(i);
+            baseline.append(stat.mean);
+            current.append(stat.ewma);
+        }
+        else if (stat.alarm && (shrink < (limit / 2.0)))
+        {
+            stat.alarm = false;
+            qDebug() << "Drift Monitor: Lane " << scanLane << ": Metric " << i << " recovered (" << stat.ewma << " UI)";
+        }
+    }
+    if (changed.isEmpty()) return;
+    qDebug() << "Drift Monitor: Lane " << scanLane << ": ALARM after " << driftSnapshots << " snapshots: Metrics "
+             << changed << "; Baseline: " << baseline << "; Now: " << current;
+    parent->emitEyeDriftAlarm(laneOffset + scanLane, changed, baseline, current);
+}
+
+
+
+/*!
+ \brief Find one boundary (upper or lower) of the eye for one phase column
+
+ The boundary is expressed as the distance (in offset steps) from the
+ centre of the eye (CONTOUR_OFFSET_CENTRE) to the last point where the
+ BER is less than or equal to contourTargetBER. The centre point is
+ assumed to be open (see contourStepCentre).
+
+ \param phase      Phase of the column to search (0 - 127)
+ \param direction  +1 to search upwards (upper boundary); -1 to search downwards
+ \param guess      Starting guess for the boundary distance (e.g. from the
+                   neighbouring column), or -1 for no guess
+ \param boundary   Used to return the boundary distance (0 - 62 up, 0 - 64 down)
+
+ \return globals::OK
+ \return [error code]  Error from hardware/comms functions
+*/
+int EyeMonitor::contourFindBoundary(const uint8_t phase,
+                                    const int direction,
+                                    const int guess,
+                                    int *boundary)
+{
+    const int limit = (direction > 0) ? (127 - CONTOUR_OFFSET_CENTRE) : (CONTOUR_OFFSET_CENTRE - 1);
+    int lo = 0;          // Furthest distance known to be open
+    int hi = limit + 1;  // Nearest distance known to be closed (limit + 1 is outside the scan range)
+    int mid;
+    bool open;
+    int result;
+
+    // Try the guess first: If the boundary hasn't moved, this finds it in two points.
+    if (guess > 0 && guess <= limit)
+    {
+        result = contourProbe(phase, direction, guess, contourCountResIndex, 1, &open);
+        if (result != globals::OK) return result;
+        if (open)
+        {
+            lo = guess;
+            if (guess < limit)
+            {
+                result = contourProbe(phase, direction, guess + 1, contourCountResIndex, 1, &open);
+                if (result != globals::OK) return result;
+                if (open) lo = guess + 1;
+                else      hi = guess + 1;
+            }
+        }
+        else
+        {
+            hi = guess;
+        }
+    }
+
+    // Bisection: lo is open, hi is closed.
+    while ((hi - lo) > 1)
+    {
+        mid = (lo + hi) / 2;
+        result = contourProbe(phase, direction, mid, contourCountResIndex, 1, &open);
+        if (result != globals::OK) return result;
+        if (open) lo = mid;
+        else      hi = mid;
+    }
+
+    // Refine: Confirm the boundary using full count resolution and repeats.
+    // Not needed if the search was already done at that resolution.
+    if ( (contourCountResIndex < 3) || (contourBoundaryRepeats > 1) )
+    {
+        for (int step = 0; step < CONTOUR_REFINE_STEPS_MAX; step++)
+        {
+            if (lo > 0)
+            {
+                result = contourProbe(phase, direction, lo, 3, contourBoundaryRepeats, &open);
+                if (result != globals::OK) return result;
+                if (!open) { lo--; continue; }   // Boundary is further in
+            }
+            if (lo < limit)
+            {
+                result = contourProbe(phase, direction, lo + 1, 3, contourBoundaryRepeats, &open);
+                if (result != globals::OK) return result;
+                if (open) { lo++; continue; }    // Boundary is further out
+            }
+            break;
+        }
+    }
+    *boundary = lo;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Measure one point relative to the eye centre, and decide whether it is open
+ \param phase       Phase of the point (0 - 127)
+ \param direction   +1 = above centre; -1 = below centre
+ \param distance    Distance from centre (offset steps)
+ \param resolution  Count resolution index (0 - 3)
+ \param repeats     Number of sweeps to accumulate
+ \param open        Set to true if the BER at the point is <= contourTargetBER
+ \return globals::OK
+ \return [error code]
+*/
+int EyeMonitor::contourProbe(const uint8_t phase,
+                             const int direction,
+                             const int distance,
+                             const uint8_t resolution,
+                             const int repeats,
+                             bool *open)
+{
+    double ber = 1.0;
+    *open = false;
+    int result = measurePoint(phase,
+                              static_cast<uint8_t>(CONTOUR_OFFSET_CENTRE + (direction * distance)),
+                              resolution,
+                              repeats,
+                              &ber);
+    if (result != globals::OK) return result;
+    *open = (ber <= contourTargetBER);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Measure the BER at a single phase / offset point
+ Runs a one point eye sweep 'repeats' times and reads back the count.
+ imageAddressMSB / imageAddressLSB must have been set by queryEyeScanMem.
+
+ \param phase       Phase (0 - 127)
+ \param offset      Voltage offset (1 - 127)
+ \param resolution  Count resolution index (0 - 3); see controlEyeSweep
+ \param repeats     Number of sweeps to accumulate (>= 1)
+ \param ber         Used to return the BER (normalised in the same way as scanStepFinish)
+
+ \return globals::OK
+ \return [error code]  Error from hardware/comms functions
+*/
+int EyeMonitor::measurePoint(const uint8_t phase,
+                             const uint8_t offset,
+                             const uint8_t resolution,
+                             const int repeats,
+                             double *ber)
+{
+    const uint8_t countResBits = static_cast<uint8_t>(1 << resolution);
+    uint8_t sizeMSB, sizeLSB;
+    uint8_t rawData = 0;
+    double count = 0.0;
+    int result;
+    *ber = 1.0;
+    for (int i = 0; i < repeats; i++)
+    {
+        result = controlEyeSweep(phase, phase, 1, offset, offset, 1, resolution, &sizeMSB, &sizeLSB);
+        if (result != globals::OK) return result;
+        result = parent->rawRead24(0xFC, imageAddressMSB, imageAddressLSB, &rawData, 1);
+        if (result != globals::OK) return result;
+        count += (double)unpackSample(&rawData, 0, countResBits);
+        contourPointsMeasured++;
+    }
+    *ber = count / ((double)((uint16_t)(1 << countResBits)) * (double)repeats);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Get one sample from packed scan data
+ Samples are packed into bytes MSB first (see scanStepSweep).
+ \param data          Raw scan data
+ \param sampleIndex   Index of sample
+ \param countResBits  Number of bits per sample (1, 2, 4 or 8)
+ \return Sample value (error count)
+*/
+int EyeMonitor::unpackSample(const uint8_t *data,
+                             const int sampleIndex,
+                             const uint8_t countResBits)
+{
+    const int bitIndex = sampleIndex * countResBits;
+    const uint8_t mask = static_cast<uint8_t>((1 << countResBits) - 1);
+    return (data[bitIndex / 8] >> (8 - countResBits - (bitIndex % 8))) & mask;
+}
+
+
+
+/*!
+ \brief Find the widest run of open columns in one row of packed scan data
+ Each column is open if its BER is less than or equal to targetBER. The run
+ may wrap around from the last column back to the first. Columns beyond the
+ end of the data are treated as closed.
+ \param data           Raw scan data (see unpackSample)
+ \param dataSize       Size of data (bytes)
+ \param firstSample    Index of the first sample in the row
+ \param numPhaseSteps  Number of columns in the row
+ \param countResBits   Number of bits per sample (1, 2, 4 or 8)
+ \param targetBER      Threshold BER for open columns
+ \param runStart       Used to return the index of the first open column in the run
+ \param runLength      Used to return the number of columns in the run (0 if the row is closed)
+*/
+void EyeMonitor::openRunFind(const uint8_t *data,
+                             const uint16_t dataSize,
+                             const int firstSample,
+                             const int numPhaseSteps,
+                             const uint8_t countResBits,
+                             const double targetBER,
+                             int *runStart,
+                             int *runLength)
+{
+    const double nBitsPerSample = (double)((uint16_t)(1 << countResBits));
+    QVector<bool> columnOpen(numPhaseSteps, false);
+    int k, thisRunLength;
+
+    *runStart = 0;
+    *runLength = 0;
+    for (k = 0; k < numPhaseSteps; k++)
+    {
+        if (((firstSample + k) * countResBits) / 8 >= dataSize) break;
+        columnOpen[k] = ((double)unpackSample(data, firstSample + k, countResBits) / nBitsPerSample) <= targetBER;
+    }
+
+    thisRunLength = 0;
+    for (k = 0; k < 2 * numPhaseSteps; k++)
+    {
+        if (columnOpen[k % numPhaseSteps])
+        {
+            thisRunLength++;
+            if (thisRunLength > numPhaseSteps) thisRunLength = numPhaseSteps;  // All open
+            if (thisRunLength > *runLength)
+            {
+                *runLength = thisRunLength;
+                *runStart = (k - thisRunLength + 1) % numPhaseSteps;
+            }
+        }
+        else
+        {
+            thisRunLength = 0;
+        }
+    }
 }
 
 
 
 /*!
- \brief Repeat Scan
-        The previous scan is repeated with the same parameters.
-        New data are added to the existing data, then normalised.
-        NOTE: If a scan has not previously been run, an error is
-        returned.
-        See notes above re: slots / signals
- \return globals::OK
- \return [error code]
+ \brief Finish the mask test: Send the result and stop
+ \param pass    Result (see maskDecision)
+ \param margin  Margin in offset steps: The last clean ring outside the
+                mask for a pass (see maskStepMargin), or minus the depth
+                of the deepest failing cell inside the mask for a fail
 */
-int EyeMonitor::repeatScan()
+void EyeMonitor::maskTestFinish(bool pass, double margin)
 {
-    Q_ASSERT(scanRepeatCount > 0);
-    if (scanRepeatCount == 0) return globals::GEN_ERROR;
-    scanRepeatCount++;
-    return eyeScanRun(false);
+    scanState = SCAN_IDLE;
+    maskWindows.clear();
+    qDebug() << "--Mask Test finished: " << (pass ? "PASS" : "FAIL")
+             << "; Hits: " << maskHitCount << "; Margin: " << margin
+             << "; Repeats: " << maskRepeatsDone;
+    parent->emitEyeMaskTestFinished(laneOffset + scanLane, pass, maskHitCount, margin,
+                                    (double)maskRepeatsDone * 256.0);
 }
 
 
 
-
 /*!
- \brief Cancel the eye scan
+ \brief Split a set of cells into rectangular sweep windows
+ Each row is split into runs of cells; a run is merged with a window
+ from the row below if it covers the same phases, and the window would
+ still fit in the scan output memory (8 bits per sample).
+ \param cells    Grid of cells (see maskCells)
+ \param windows  Used to return the list of windows
 */
-void EyeMonitor::cancelScan()
-  {  stopFlag = true;  }
-
-
+void EyeMonitor::maskBuildWindows(const QVector<bool> &cells,
+                                  QVector<maskWindow_t> &windows)
+{
+    int o, p, j, pStart, pStop, maxRows;
+    bool merged;
+    windows.clear();
+    for (o = 1; o <= 127; o++)
+    {
+        p = 0;
+        while (p < 128)
+        {
+            if (!cells[(o * MASK_GRID_SIZE) + p]) { p += maskHStep; continue; }
+            pStart = p;
+            while ( ((p + maskHStep) < 128) && cells[(o * MASK_GRID_SIZE) + p + maskHStep] ) p += maskHStep;
+            pStop = p;
+            p += maskHStep;
+
+            maxRows = imageMaximumSize / (((pStop - pStart) / maskHStep) + 1);
+            merged = false;
+            for (j = 0; j < windows.size(); j++)
+            {
+                if ( (windows[j].phaseStart == pStart) &&
+                     (windows[j].phaseStop == pStop) &&
+                     (windows[j].offsetStop == (o - 1)) &&
+                     ((o - windows[j].offsetStart + 1) <= maxRows) )
+                {
+                    windows[j].offsetStop = static_cast<uint8_t>(o);
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged)
+            {
+                maskWindow_t window = { static_cast<uint8_t>(pStart), static_cast<uint8_t>(pStop),
+                                        static_cast<uint8_t>(o),      static_cast<uint8_t>(o) };
+                windows.append(window);
+            }
+        }
+    }
+}
 
 
 
+/*!
+ \brief Sweep one window (8 bit count resolution) and add the counts to a grid
+ \param window      Window to sweep
+ \param cellCounts  Grid of counts (see maskCellErrors); counts for the window are added
+ \param hit         Set to true if any errors were seen in the window
+ \return globals::OK
+ \return globals::OVERFLOW      Output data didn't fit in buffer
+ \return globals::INVALID_DATA  Less data than expected
+ \return [error code]           Error from hardware/comms functions
+*/
+int EyeMonitor::maskSweepWindow(const maskWindow_t &window,
+                                QVector<double> &cellCounts,
+                                bool *hit)
+{
+    uint8_t sizeMSB, sizeLSB;
+    uint16_t outputSize;
+    int result, o, p;
+    int i = 0;
+    *hit = false;
+    result = controlEyeSweep(window.phaseStart, window.phaseStop, maskHStep,
+                             window.offsetStart, window.offsetStop, 1,
+                             3, &sizeMSB, &sizeLSB);
+    if (result != globals::OK) return result;
+    outputSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    if (outputSize > scanRawData.size()) return globals::OVERFLOW;
+    result = parent->rawRead24(0xFC, imageAddressMSB, imageAddressLSB, scanRawData.data(), static_cast<size_t>(outputSize));
+    if (result != globals::OK) return result;
+    for (o = window.offsetStart; o <= window.offsetStop; o++)
+    {
+        for (p = window.phaseStart; p <= window.phaseStop; p += maskHStep)
+        {
+            if (i >= outputSize) return globals::INVALID_DATA;
+            cellCounts[(o * MASK_GRID_SIZE) + p] += static_cast<double>(scanRawData[i]);
+            if (scanRawData[i] > 0) *hit = true;
+            i++;
+        }
+    }
+    return globals::OK;
+}
 
 
 
+/*!
+ \brief Find the vertical distance from each cell to the nearest cell with a given state
+ \param cells     Grid of cells (see maskCells)
+ \param target    State to look for
+ \param distance  Used to return distance (offset steps) for each cell;
+                  0 if the cell itself is in the target state;
+                  2 * MASK_GRID_SIZE if there is no such cell in the column.
+*/
+void EyeMonitor::maskVerticalDistance(const QVector<bool> &cells,
+                                      const bool target,
+                                      QVector<int> &distance)
+{
+    const int noCell = 2 * MASK_GRID_SIZE;
+    int p, o, last;
+    distance.fill(noCell, MASK_GRID_SIZE * MASK_GRID_SIZE);
+    for (p = 0; p < MASK_GRID_SIZE; p++)
+    {
+        last = -noCell;
+        for (o = 0; o < MASK_GRID_SIZE; o++)
+        {
+            if (cells[(o * MASK_GRID_SIZE) + p] == target) last = o;
+            if ((o - last) < distance[(o * MASK_GRID_SIZE) + p]) distance[(o * MASK_GRID_SIZE) + p] = o - last;
+        }
+        last = MASK_GRID_SIZE + noCell;
+        for (o = MASK_GRID_SIZE - 1; o >= 0; o--)
+        {
+            if (cells[(o * MASK_GRID_SIZE) + p] == target) last = o;
+            if ((last - o) < distance[(o * MASK_GRID_SIZE) + p]) distance[(o * MASK_GRID_SIZE) + p] = last - o;
+        }
+    }
+}
 
 
-////////////// PRIVATE: ////////////////////////////////////////////////////////////
 
 /*!
- \brief Run the Eye Scan
+ \brief Check whether a point is inside a polygon (even-odd rule)
+ \param x          Point x
+ \param y          Point y
+ \param polygon    Polygon vertices, as x, y pairs
+ \param nVertices  Number of vertices
+ \return true if the point is inside the polygon
 */
-int EyeMonitor::eyeScanRun(bool resetFlag)
+bool EyeMonitor::pointInPolygon(const double x,
+                                const double y,
+                                const double *polygon,
+                                const int nVertices)
 {
-    int scanResult = globals::OK;
-    uint8_t *rawDataBuffer = NULL;
-    QVector<double> eyeDataBufferTmp;
+    bool inside = false;
+    for (int i = 0, j = nVertices - 1; i < nVertices; j = i++)
+    {
+        const double xi = polygon[2 * i], yi = polygon[(2 * i) + 1];
+        const double xj = polygon[2 * j], yj = polygon[(2 * j) + 1];
+        if ( ((yi > y) != (yj > y)) &&
+             (x < (((xj - xi) * (y - yi)) / (yj - yi)) + xi) ) inside = !inside;
+    }
+    return inside;
+}
 
-    int numSamples = 1;
-    int eyeDataBufferIndexMax = 1;
-    int eyeDataBufferIndex = 0;
 
-    ///////// Determine the output memory attributes: ///////////////////////
-    uint16_t imageStartAddress;
-    uint16_t imageMaximumSize;
-    uint8_t imageAddressMSB, imageAddressLSB;
+
+/*!
+ \brief Sweep one part of an ROI scan and unpack it into the ROI data
+ \param phaseStart     Sweep window for controlEyeSweep (no wrap)
+ \param phaseStop      |
+ \param phaseStep      |
+ \param offsetStart    |
+ \param offsetStop     |
+ \param offsetStep     |
+ \param resolution     Count resolution index (0 - 3)
+ \param roiData        ROI data (error counts); the counts for this part are stored here
+ \param roiColumns     Number of columns in roiData
+ \param column         Column and row in roiData of the first sample in this part
+ \param row            |
+ \param nColumns       Number of columns and rows in this part
+ \param nRows          |
+ \return globals::OK
+ \return globals::OVERFLOW      Output data didn't fit in buffer
+ \return globals::INVALID_DATA  Less data than expected
+ \return [error code]           Error from hardware/comms functions
+*/
+int EyeMonitor::roiSweepPart(const uint8_t phaseStart,
+                             const uint8_t phaseStop,
+                             const uint8_t phaseStep,
+                             const uint8_t offsetStart,
+                             const uint8_t offsetStop,
+                             const uint8_t offsetStep,
+                             const uint8_t resolution,
+                             QVector<double> &roiData,
+                             const int roiColumns,
+                             const int column,
+                             const int row,
+                             const int nColumns,
+                             const int nRows)
+{
     uint8_t sizeMSB, sizeLSB;
-    int bytesPerLine;
-    imageAddressMSB = 0;
-    imageAddressLSB = 0;
-    sizeMSB    = 0;
-    sizeLSB    = 0;
-    scanResult = queryEyeScanMem( &imageAddressMSB, &imageAddressLSB, &sizeMSB, &sizeLSB );
-    if (scanResult != globals::OK)
+    uint16_t outputSize;
+    const uint8_t countResBits = static_cast<uint8_t>(1 << resolution);
+    int result, x, y;
+    result = controlEyeSweep(phaseStart, phaseStop, phaseStep,
+                             offsetStart, offsetStop, offsetStep,
+                             resolution, &sizeMSB, &sizeLSB);
+    if (result != globals::OK) return result;
+    outputSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+    if (outputSize > scanRawData.size()) return globals::OVERFLOW;
+    if ((static_cast<int>(outputSize) * 8) < (nColumns * nRows * countResBits)) return globals::INVALID_DATA;
+    result = parent->rawRead24(0xFC, imageAddressMSB, imageAddressLSB, scanRawData.data(), static_cast<size_t>(outputSize));
+    if (result != globals::OK) return result;
+    for (y = 0; y < nRows; y++)
     {
-        qDebug() << "Error reading output memory attributes: " << scanResult;
-        goto finished;
+        for (x = 0; x < nColumns; x++)
+        {
+            roiData[((row + y) * roiColumns) + column + x] =
+                    static_cast<double>(unpackSample(scanRawData.constData(), (y * nColumns) + x, countResBits));
+        }
     }
-    imageStartAddress = static_cast<uint16_t>(static_cast<uint16_t>(imageAddressMSB) << 8) + static_cast<uint16_t>(imageAddressLSB);
-    imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
-    qDebug() << "Eye Scan - Image Start Address: " << imageStartAddress
-             << "; Size: " << imageMaximumSize;
+    return globals::OK;
+}
 
-    /**** Eye Scan: *****************************************************/
-    qDebug() << "**Starting Eye Scan**";
 
-    uint8_t numPhaseSteps;
-    uint8_t numOffsetStepsMax;
-    uint8_t numOffsetSteps;
 
-    uint8_t offsetStart, offsetStop;
-    uint8_t thisOffsetStart, thisOffsetStop;
+/*!
+ \brief Extract bathtub curves from the last eye scan
+ The eye data are already shifted and normalised (log10 BER); points at
+ the floor of the eye plot are set to BELOW_DETECTION_LIMIT, as for a
+ bathtub scan.
+ \param vOffsets  Voltage offsets (1 - 127)
+ \param curves    Used to return the curves (xRes points per offset)
+ \param xRes      Used to return the number of points per curve
+ \return true if eye data were available for all of the offsets
+*/
+bool EyeMonitor::bathtubFromEyeData(const QVector<int> &vOffsets,
+                                    QVector<double> &curves,
+                                    int *xRes)
+{
+    int i, x, row;
+    if (!eyeDataValid) return false;
+    foreach (int offset, vOffsets)
+    {
+        if ( (((offset - 1) % scanVStep) != 0) || (((offset - 1) / scanVStep) >= scanVRes) ) return false;
+    }
+    bufferReset(curves, scanHRes * vOffsets.size());
+    for (i = 0; i < vOffsets.size(); i++)
+    {
+        row = (vOffsets[i] - 1) / scanVStep;
+        for (x = 0; x < scanHRes; x++)
+        {
+            const double value = eyeDataFrame.data().at((row * scanHRes) + x);
+            if (value <= eyeDataFloor) curves[(i * scanHRes) + x] = globals::BELOW_DETECTION_LIMIT;
+            else                       curves[(i * scanHRes) + x] = value;
+        }
+    }
+    *xRes = scanHRes;
+    return true;
+}
 
-    uint8_t outputSizeMSB, outputSizeLSB;
-    uint16_t outputSize;
 
-    // Calculate the number of steps in one scan line:
-    numPhaseSteps = 128 / scanHStep;
 
-    /* OLD - From GT1724 Manual - DEPRECATED
-     * Note: The calculation below is for arbitrary values of
-     * phaseStart / phaseStop / scanHStep.
-     * However, we simplify it (above) because we always scan
-     * an entire row (phaseStart=0; phaseStop=127) and scanHStep
-     * is 1, 2, 4 or 8.
-    numPhaseSteps = (uint8_t)
-            ceil( (double)(phaseStop - phaseStart + 1) / (double)scanHStep );
-    */
-    scanHRes = numPhaseSteps;
+/*!
+ \brief Get the last completed eye or bathtub scan as an archive record
+ \param serial  Instrument serial number
+ \param record  Used to return the record
+ \return globals::OK
+ \return globals::INVALID_DATA  No completed scan
+*/
+int EyeMonitor::archiveRecord(const QString &serial, EyeArchive::record_t *record)
+{
+    const int nCells = scanHRes * scanVRes;
+    if (eyeDataRepeats == 0 || eyeDataBuffer.size() != nCells) return globals::INVALID_DATA;
+
+    record->lane         = laneOffset + scanLane;
+    record->type         = scanType;
+    record->xRes         = scanHRes;
+    record->yRes         = scanVRes;
+    record->hStep        = scanHStep;
+    record->vStep        = scanVStep;
+    record->vOffset      = (scanType == GT1724::GT1724_EYE_SCAN) ? 1 : scanVOffset;
+    record->phaseShift   = nShift;
+    record->countResBits = scanCountResBits;
+    record->repeatCount  = eyeDataRepeats;
+    record->timestamp    = eyeDataTime;
+    record->serial       = serial;
+    record->counts.resize(nCells);
+    for (int i = 0; i < nCells; i++) record->counts[i] = static_cast<quint32>(qMax(qRound(eyeDataBuffer[i]), 0));
+    return globals::OK;
+}
 
-    // Calculate the number of lines that will fit in memory:
-    bytesPerLine = (numPhaseSteps * scanCountResBits) / 8;  // Number of bytes in one 'horizontal' scan line (i.e. one offset step)
-    numOffsetStepsMax = static_cast<uint8_t>(imageMaximumSize / bytesPerLine);
 
-    /* OLD  - From GT1724 Manual - DEPRECATED
-     * This is the general calculation for arbitraty values of numPhaseSteps, etc.
-     * We simplify it above.
-    // From section 5.5.2 of datasheet
-    numOffsetStepsMax = (uint8_t)
-            (  (double)imageMaximumSize /
-               (
-                   (double)numPhaseSteps * ( (double)scanCountResBits / 8.0 )
-                   )
-               );
-    */
 
-    qDebug() << " numPhaseSteps: " << numPhaseSteps
-             << "; bytesPerLine: " << bytesPerLine
-             << "; numOffsetStepsMax: " << numOffsetStepsMax;
+/*!
+ \brief Fit the dual-Dirac model to the last bathtub scan, and send the result
 
-    // Calculate the number of lines in the full scan:
-    if (scanType == GT1724::GT1724_EYE_SCAN)
-    {
-        // FULL eye scan:
-        offsetStart = 1;
-        offsetStop  = 127;
-        numOffsetSteps = 128 / scanVStep;
-        if (numOffsetSteps == 128) numOffsetSteps = 127;
+ Reaching low BERs by repeating the scan is slow, as the measurement floor
+ only drops in proportion to the number of repeats. Instead, the tails of
+ the bathtub are fitted (see BathtubFit) and the eye opening is
+ extrapolated to the target BERs.
 
-        /* OLD - From GT1724 Manual - DEPRECATED
-         * Note: The calculation below is for arbitrary values of
-         * offsetStart / offsetStop / scanVStep.
-         * However, we simplify it (above) because we always scan
-         * the entire diagram (Start=0; Stop=127) and scanVStep
-         * is 1, 2, 4 or 8.
-        numOffsetSteps = (uint8_t)
-                ceil(  (double)(offsetStop - offsetStart + 1) / (double)scanVStep  );
-        */
+ The fit is treated as converged once both tails fit well (R^2 of at
+ least BATHTUB_FIT_R2_MIN) and the extrapolated openings have changed by
+ less than bathtubFitTolerance since the previous repeat. The caller may
+ then stop repeating the scan.
 
-        scanVRes = numOffsetSteps;
-        qDebug() << "Eye Scan - Total number of lines: " << numOffsetSteps;
-    }
-    else
+ The result is sent using the EyeBathtubFitFinished signal.
+ \param resetFlag  true for the first scan (no previous result to compare)
+*/
+void EyeMonitor::bathtubFitRun(bool resetFlag)
+{
+    BathtubFit::result_t fitResult;
+    QVector<double> openings;
+    bool converged = false;
+    int i;
+
+    if (resetFlag) bathtubFitOpenings.clear();
+    BathtubFit::fit(eyeDataFrame.data(), bathtubFitBERMax, &fitResult);
+    foreach (double ber, bathtubFitTargets) openings.append(BathtubFit::eyeOpening(fitResult, ber));
+
+    const double rSquared = qMin(fitResult.rSquaredLeft, fitResult.rSquaredRight);
+    if ( fitResult.valid && (rSquared >= BATHTUB_FIT_R2_MIN) &&
+         (bathtubFitOpenings.size() == openings.size()) )
     {
-        // One line scan (bathtub plot):
-        offsetStart = scanVOffset;
-        offsetStop  = scanVOffset;
-        thisOffsetStart = offsetStart;
-        thisOffsetStop = offsetStop;
-        numOffsetSteps = 1;
-        scanVRes = 1;
-        scanVStep = 1;
-        qDebug() << "Bathtub Scan - One line at specified offset.";
+        converged = true;
+        for (i = 0; i < openings.size(); i++)
+        {
+            if (fabs(openings[i] - bathtubFitOpenings[i]) > bathtubFitTolerance) converged = false;
+        }
     }
+    if (fitResult.valid) bathtubFitOpenings = openings;
+
+    qDebug() << "Bathtub Fit: Valid: " << fitResult.valid
+             << "; Points: " << fitResult.pointsLeft << " / " << fitResult.pointsRight
+             << "; RJ: " << fitResult.rjRMS << "; DJ: " << fitResult.djDualDirac
+             << "; R^2: " << rSquared << "; Openings: " << openings << "; Converged: " << converged;
+    parent->emitEyeBathtubFitFinished(laneOffset + scanLane, bathtubFitTargets, openings,
+                                      fitResult.rjRMS, fitResult.djDualDirac, rSquared,
+                                      fitResult.valid, converged);
+}
 
-    // Calculate total number of samples, and allocate buffer for data:
-    numSamples = numPhaseSteps * numOffsetSteps;
-    bufferReset(eyeDataBufferTmp, numSamples);
-    Q_ASSERT(eyeDataBufferTmp.size() == numSamples);  // Malloc error?
-    eyeDataBufferIndex = 0;
-    eyeDataBufferIndexMax = numSamples - 1;   // For sanity check
-    rawDataBuffer = new uint8_t[imageMaximumSize];
-    if (!rawDataBuffer || (eyeDataBufferTmp.size() != numSamples))
-    {
-        scanResult = globals::MALLOC_ERROR;
-        goto finished;
-    }
 
-    ////// Eye scan will be run more than once for resolutions > 8 bit: /////////////////
-    thisOffsetStart = offsetStart;
-    outputSizeMSB = 0;
-    outputSizeLSB = 0;
 
-    //////////////////////////////////////////////////////////////
-    /////// Scan the eye (in several steps if needed): ///////////
-    //////////////////////////////////////////////////////////////
+/*!
+ \brief Decide whether a repeated scan should stop (auto-stop policy)
 
-    if (numOffsetSteps > numOffsetStepsMax) thisOffsetStop = offsetStart + (numOffsetStepsMax - 1) * scanVStep;
-    else                                    thisOffsetStop = offsetStop;
+ Called after each repeat with the accumulated error counts in eyeDataBuffer.
 
-    parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, 0);
+ Each point is "resolved" if its BER is known to be above or below
+ autoStopMetricBER with reasonable confidence, i.e. the difference is more
+ than 2 standard deviations of the error count (Poisson: sqrt(count)).
+ Points with no errors are resolved once the floor is below autoStopMetricBER.
 
-    while (thisOffsetStart <= offsetStop)
+ Metrics (using points with BER <= autoStopMetricBER as "open"):
+   Width:  Longest open run on the centre row
+   Height: Longest open run in the centre column of that run (eye scan only)
+   Area:   Number of open points (eye scan only)
+
+ The scan should stop when:
+   - The measurement floor (1 / bits analysed) has reached autoStopFloorBER; or
+   - All metrics changed by less than autoStopTolerance (relative) since the
+     previous repeat, and at least (1 - autoStopTolerance) of points are resolved.
+
+ The result is sent using the EyeScanAutoStop signal; the caller decides
+ whether to request another repeat.
+ \param resetFlag      true for the first scan (no previous metrics)
+ \param nBitsAnalysed  Number of bits analysed per point, over all repeats
+*/
+void EyeMonitor::autoStopEvaluate(bool resetFlag, double nBitsAnalysed)
+{
+    const int sizeX = scanHRes;
+    const int sizeY = scanVRes;
+    const int centreRow = sizeY / 2;
+    const double floorBER = 1.0 / nBitsAnalysed;
+    QVector<bool> &open = autoStopOpen;  // Sized in arenaPrepare
+    QVector<double> metrics;
+    int resolved = 0, area = 0;
+    int runLength, runStart, bestLength, bestStart, i, x, y;
+    bool stable = false, stop;
+
+    if (resetFlag) autoStopMetrics.clear();
+    if (open.size() < eyeDataBuffer.size()) open.resize(eyeDataBuffer.size());  // Extended plot only
+
+    for (i = 0; i < eyeDataBuffer.size(); i++)
     {
-        parent->eyeScanCheckForCancel();
-        if (stopFlag)
+        const double count = eyeDataBuffer[i];
+        open[i] = ((count / nBitsAnalysed) <= autoStopMetricBER);
+        if (open[i]) area++;
+        if (count == 0.0)
         {
-            qDebug() << "--Scan Cancelled. Stop.--";
-            scanResult = globals::CANCELLED;
-            goto finished;
+            if (floorBER < autoStopMetricBER) resolved++;
         }
-        //// SCAN: /////////////////////////////////////////////
-        qDebug() << "** Starting part scan: **\n"
-                 << "   phaseStart: " << 0
-                 << "   phaseStop: " << 127
-                 << "   phaseStep: " << scanHStep << "\n"
-                 << "   thisOffsetStart: " << thisOffsetStart
-                 << "   thisOffsetStop: " << thisOffsetStop
-                 << "   offsetStep: " << scanVStep << "\n"
-                 << "   resolution: " << scanCountResBits;
-
-        scanResult = controlEyeSweep(0,        // phaseStart
-                                     127,      // phaseStop
-                                     scanHStep,
-                                     thisOffsetStart,
-                                     thisOffsetStop,
-                                     scanVStep,
-                                     scanCountResIndex,
-                                     &outputSizeMSB,
-                                     &outputSizeLSB);
-        qDebug() << "** Part scan finished. Result: " << scanResult;
-        if (scanResult != globals::OK)
+        else if (fabs(count - (autoStopMetricBER * nBitsAnalysed)) > (2.0 * sqrt(count)))
         {
-            qDebug() << "Error running scan: " << scanResult;
-            goto finished;
+            resolved++;
         }
-        parent->eyeScanCheckForCancel();
-        if (stopFlag)
+    }
+    const double confidence = (eyeDataBuffer.isEmpty()) ? 0.0 : (double)resolved / (double)eyeDataBuffer.size();
+
+    // Width: Longest open run on the centre row:
+    bestLength = 0;
+    bestStart  = 0;
+    runLength  = 0;
+    runStart   = 0;
+    for (x = 0; x < sizeX; x++)
+    {
+        if (open[(centreRow * sizeX) + x])
         {
-            qDebug() << "--Scan Cancelled. Stop.--";
-            scanResult = globals::CANCELLED;
-            goto finished;
+            if (runLength == 0) runStart = x;
+            runLength++;
+            if (runLength > bestLength) { bestLength = runLength; bestStart = runStart; }
         }
-        // Read back data:
-
-        outputSize = static_cast<uint16_t>(static_cast<uint16_t>(outputSizeMSB) << 8) + static_cast<uint16_t>(outputSizeLSB);
-        //// READ DATA: /////////////////////////////////////////////
-        qDebug() << "--Reading back scan data: " << outputSize << " bytes --";
-
-        scanResult = parent->rawRead24(0xFC,
-                                       imageAddressMSB,
-                                       imageAddressLSB,
-                                       &rawDataBuffer[0],
-                                       static_cast<size_t>(outputSize));
-        if (scanResult != globals::OK)
+        else
         {
-            qDebug() << "Error reading back scan data: " << scanResult;
-            goto finished;
+            runLength = 0;
         }
-        //// UNPACK DATA: //////////////////////////////////////////
-        qDebug() << "--Unpacking scan data...\n"
-                 << "  Tot Num Samples:  " << numSamples << "\n"
-                 << "  THIS block size:  " << outputSize << "\n"
-                 << "  Buffer Remaining: " << eyeDataBufferIndexMax - eyeDataBufferIndex + 1;
-
-
-
-        for (size_t sampleIndex = 0; sampleIndex < static_cast<size_t>(outputSize); sampleIndex++)
+    }
+    metrics.append((double)bestLength);
+    if (scanType == GT1724::GT1724_EYE_SCAN)
+    {
+        // Height: Longest open run in the centre column:
+        const int centreColumn = bestStart + (bestLength / 2);
+        int height = 0;
+        runLength = 0;
+        for (y = 0; y < sizeY; y++)
         {
-            // Sanity check: Make sure we aren't about to overflow the output buffer:
-            Q_ASSERT(eyeDataBufferIndex <= eyeDataBufferIndexMax);
-            if (eyeDataBufferIndex > eyeDataBufferIndexMax) { scanResult = globals::OVERFLOW; goto finished; }
-
-            switch (scanCountResBits)
-            {
-            case 1: // 1  bit per sample:
-                for (int bitIndex = 0; bitIndex < 8; bitIndex++)
-                {
-                    // For each bit, shift and mask, and store to output as uint8_t:
-                    eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>((rawDataBuffer[sampleIndex] >> (7-bitIndex)) & 0x01);
-                    eyeDataBufferIndex++;
-                }
-                break;
-            case 2: // 2  bits per sample:
-                for (int bitIndex = 0; bitIndex < 8; bitIndex+=2)
-                {
-                    // For each bit, shift and mask, and store to output as uint8_t:
-                    eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>((rawDataBuffer[sampleIndex] >> (6-bitIndex)) & 0x03);
-                    eyeDataBufferIndex++;
-                }
-                break;
-            case 4: // 4  bits per sample:
-                for (int bitIndex = 0; bitIndex < 8; bitIndex+=4)
-                {
-                    // For each bit, shift and mask, and store to output as uint8_t:
-                    eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>((rawDataBuffer[sampleIndex] >> (4-bitIndex)) & 0x0F);
-                    eyeDataBufferIndex++;
-                }
-                break;
-            case 8: // 8  bits per sample:
-                eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>(rawDataBuffer[sampleIndex]);
-                eyeDataBufferIndex++;
-            }
+            if (open[(y * sizeX) + centreColumn]) { runLength++; if (runLength > height) height = runLength; }
+            else                                    runLength = 0;
         }
-
-        //// Advance start and stop offsets: ///////////////////////
-        qDebug() << "--Adjusting offsets for next part...";
-        //Start = Stop + OffsetStep:
-        thisOffsetStart = thisOffsetStop + scanVStep;
-        //Stop = Start + (NumOffsetStepsMax - 1) * OffsetStep:
-        thisOffsetStop = thisOffsetStart + ( (numOffsetStepsMax - 1) * scanVStep );
-        //If Stop is greater than OffsetStop then Stop = OffsetStop:
-        if (thisOffsetStop > offsetStop) thisOffsetStop = offsetStop;
-
-        // Update progress:
-        parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, (eyeDataBufferIndex * 100) / numSamples);
+        metrics.append((double)height);
+        metrics.append((double)area);
     }
 
-#define BERT_EYESCAN_SHIFT 1    // Define this to enable eye / bathtub "Shift" (make sure eye starts at left edge for visual appeal)
-// #define BERT_EYESCAN_EXTEND 1   // Define this to enable eye "Extend" (copy some data from start of eye and place it at end for visual appeal; i.e. width of plot is greater than 1 UI)
-
-    if (scanResult == globals::OK)
+    if (autoStopMetrics.size() == metrics.size())
     {
-        // Finished successfully.
-        QVector<double> eyeDataBufferTmpAdj;  // Vector for adjusted data (shift / extend)
-
-        if (scanType == GT1724::GT1724_EYE_SCAN)
+        stable = true;
+        for (i = 0; i < metrics.size(); i++)
         {
-    #ifdef BERT_EYESCAN_SHIFT
-            //////// SHIFT: //////////////////////////////////////////////////
-            // For eye plots: We want the "eye" to be centred in the plot; however
-            // sample 0 of scan data is actually before the eye start. Cut the left
-            // end and splice it onto the right end. The amount to rotate depends on
-            // whether we are also doing an "extend" (see below).
-            // Nb: Only adjust the shift amount on the first scan after a reset:
-            if (resetFlag)
-            {
-                uint8_t peakIndex = peakFind(eyeDataBufferTmp, numPhaseSteps, numOffsetSteps);
-                const uint8_t xMid = (numPhaseSteps / 2);  // Index of mid point
-         #ifdef BERT_EYESCAN_EXTEND
-                // If "extending" the diagram, shift a bit less (for visual appeal):
-                if (peakIndex <= xMid) nShift = (int)(peakIndex/scanHStep) + 1;
-                else                   nShift = ((int)peakIndex - (int)numPhaseSteps) / (int)scanHStep - 1;
-                nShift = nShift - (int)(0.11*(double)numPhaseSteps);
-                if (nShift < (-1 * (int)numPhaseSteps)) nShift = (-1 * (int)numPhaseSteps);
-        #else
-                // Not using "Extend": shift "peak" errors to left edge.
-                if (peakIndex <= xMid) nShift = static_cast<int>(peakIndex);
-                else                   nShift = static_cast<int>(peakIndex - numPhaseSteps);
-
-                /* OLD Don't know why this was divided by scanHStep ???
-                if (peakIndex <= xMid) nShift = (int)(peakIndex/scanHStep);
-                else                   nShift = ((int)peakIndex - (int)numPhaseSteps) / (int)scanHStep;
-                */
-        #endif
-            }
-            qDebug() << "SHIFT: Rotate eye plot " << nShift << " samples";
-            QVector<double> eyeDataBufferTmpShf;  // Vector for shifted data
-            scanResult = dataShift(eyeDataBufferTmp,
-                                   eyeDataBufferTmpShf,
-                                   numPhaseSteps,
-                                   numOffsetSteps,
-                                   nShift);
-            if (scanResult != globals::OK) goto finished;
-    #else   // No Shift:
-            QVector<double> eyeDataBufferTmpShf;  // Vector for shifted data
-            eyeDataBufferTmpShf = eyeDataBufferTmp;
-    #endif  // Shift ?
-
-    #ifdef BERT_EYESCAN_EXTEND
-            //////// EXTEND: /////////////////////////////////////////////////
-            // For eye plot: "extend" the eye width by copying the left side
-            // and adding it to the right side (improves readability):
-            uint8_t extraPhaseSteps = (uint8_t)((float)numPhaseSteps * 0.215f);
-            qDebug() << "EXTEND: Extending eye by " << extraPhaseSteps << " steps.";
-
-            uint8_t numPhaseStepsExt = numPhaseSteps + extraPhaseSteps;
-            size_t numSamplesExt = numPhaseStepsExt * numOffsetSteps;
-            eyeDataBufferTmpAdj.clear();
-            eyeDataBufferTmpAdj.resize((int)numSamplesExt);
-            eyeDataBufferTmpAdj.fill(0.0);
-
-            size_t x, y, sampleIndex, storeIndex;
-            storeIndex = 0;
-            for (y = 0; y < numOffsetSteps; y++)
-            {
-                for (x = 0; x < numPhaseStepsExt; x++)
-                {
-                    if (x < numPhaseSteps) sampleIndex = (y * numPhaseSteps) + x;
-                    else                   sampleIndex = (y * numPhaseSteps) + (x - numPhaseSteps);
-                    eyeDataBufferTmpAdj[storeIndex] = eyeDataBufferTmpShf[sampleIndex];
-                    storeIndex++;
-                }
-            }
-            scanHRes = numPhaseStepsExt;
-            ////////////////////////////////////////////////////////////////////
-    #else   // No Extend:
-        eyeDataBufferTmpAdj = eyeDataBufferTmpShf;
-    #endif  // Extend?
-
+            if ( fabs(metrics[i] - autoStopMetrics[i]) > (autoStopTolerance * qMax(autoStopMetrics[i], 1.0)) ) stable = false;
         }
-        else
-        {
-    #ifdef BERT_EYESCAN_SHIFT
-            //////// SHIFT: ////////////////////////////////////////////////////
-            // For bathtub plots: We want the plot to show one "eye" (tub),
-            // with the left side being the max error point at the start of the
-            // eye; however sample 0 of scan data is actually before the eye
-            // start. Cut the left end and splice it onto the right end:
-            // Nb: Only adjust the shift amount on the first scan after a reset:
-            if (resetFlag)
-            {
-                uint8_t peakIndex = peakFind(eyeDataBufferTmp, numPhaseSteps, numOffsetSteps);
-                const uint8_t xMid = (numPhaseSteps / 2);  // Index of mid point
+    }
+    autoStopMetrics = metrics;
 
-                if (peakIndex <= xMid) nShift = static_cast<int>(peakIndex);
-                else                   nShift = static_cast<int>(peakIndex - numPhaseSteps);
+    stop = ( (autoStopFloorBER > 0.0) && (floorBER <= autoStopFloorBER) ) ||
+           ( stable && (confidence >= (1.0 - autoStopTolerance)) );
 
-                /* OLD Don't know why this was divided by scanHStep ???
-                if (peakIndex <= xMid) nShift = (int)(peakIndex/scanHStep);
-                else                   nShift = ((int)peakIndex - (int)numPhaseSteps) / (int)scanHStep;
-                */
-            }
-            qDebug() << "SHIFT: Rotate bathtub plot " << nShift << " samples";
-            scanResult = dataShift(eyeDataBufferTmp,
-                                   eyeDataBufferTmpAdj,
-                                   numPhaseSteps,
-                                   numOffsetSteps,
-                                   nShift);
-            if (scanResult != globals::OK) goto finished;
-            ////////////////////////////////////////////////////////////////////
-    #else   // No Shift:
-            eyeDataBufferTmpAdj = eyeDataBufferTmp;
-    #endif  // Shift ?
-
-        }
-
-        // Data are stored in a global buffer which accumulates data between
-        // repeated scans, until a new scan is started.
-        if (resetFlag)
-        {
-            // New Scan... reset the global scan data buffer.
-            bufferReset(eyeDataBuffer, eyeDataBufferTmpAdj.size());
-            bufferReset(eyeDataBufferNorm, eyeDataBufferTmpAdj.size());
-        }
-        // Ensure that global scan data buffer is the same size as the results from this scan:
-        Q_ASSERT(eyeDataBuffer.size() == eyeDataBufferTmpAdj.size());
-        if (eyeDataBuffer.size() != eyeDataBufferTmpAdj.size())
-        {
-            // For production, if the size changes for some reason, throw away the old data:
-            bufferReset(eyeDataBuffer, eyeDataBufferTmpAdj.size());
-            bufferReset(eyeDataBufferNorm, eyeDataBufferTmpAdj.size());
-        }
-
-        ////// ACCUMULATE / NORMALISE: ////////////////////////////////////////////////
-        double nBitsAnalysed = (double)((uint16_t)(1 << scanCountResBits)) * (double)scanRepeatCount;
-        const double eyeScanLogFloor = 1.0 / (double)nBitsAnalysed;
-
-        // For debugging eye scan data as CSV: #define DEBUG_EYE_DATA(MSG) qDebug() << MSG;
-        #define DEBUG_EYE_DATA(MSG)  // No debug.
-        DEBUG_EYE_DATA("Repeats Done: " << scanRepeatCount << "; Bits Analysed: " << nBitsAnalysed << "; Log Floor: " << eyeScanLogFloor)
-        DEBUG_EYE_DATA("-----------------------------------------")
-        DEBUG_EYE_DATA("Repeats,TotalBits,Floor")
-        DEBUG_EYE_DATA(scanRepeatCount << "," << nBitsAnalysed << "," << eyeScanLogFloor)
-        DEBUG_EYE_DATA("")
-        DEBUG_EYE_DATA("i,Errors,BER")
+    qDebug() << "Auto-Stop: Repeats: " << scanRepeatCount << "; Floor: " << floorBER
+             << "; Metrics: " << metrics << "; Resolved: " << confidence
+             << "; Stable: " << stable << "; Stop: " << stop;
+    parent->emitEyeScanAutoStop(laneOffset + scanLane, scanType, stop, floorBER, confidence);
+}
 
-// Eye Data Quantisation Error: Quick Fix:
-// Define EYE_DATA_QUANTISATION_QUICKFIX to crop counts of 1 (these contain quantisation error).
-// Note this is a quick fix which introduces an opposite error, i.e. dropping some valid error counts.
-//#define EYE_DATA_QUANTISATION_QUICKFIX 1
 
-        for (int i = 0; i < eyeDataBufferTmpAdj.size(); i++)
-        {
-#ifdef EYE_DATA_QUANTISATION_QUICKFIX
-            if (eyeDataBufferTmpAdj[i] > 1)
-            {
-                eyeDataBuffer[i] += eyeDataBufferTmpAdj[i];   // Add most recent scan to all previous scans
-            }
-            /* EXPERIMENTAL AND HACKY.
-            else if (eyeDataBufferTmpAdj[i] == 1)
-            {
-                // Error count of 1: This count includes a slight over-estimate of errors, so fudge it a bit...
-                // I.e. only count the error 75% of the time.
-                if((rand() % 100) > 85) eyeDataBuffer[i]++;
-            }
-            */
-#else
-            eyeDataBuffer[i] += eyeDataBufferTmpAdj[i];   // Add most recent scan to all previous scans
-#endif
-            // Normalise the data point (using log 10):
-            double thisValue = eyeDataBuffer[i] / nBitsAnalysed;
-            if (thisValue < eyeScanLogFloor)
-            {
-                DEBUG_EYE_DATA("," << eyeDataBuffer[i] << "," << eyeScanLogFloor << ", V")
-                if (scanType == GT1724::GT1724_EYE_SCAN) eyeDataBufferNorm[i] = log10(eyeScanLogFloor);
-                else                                     eyeDataBufferNorm[i] = globals::BELOW_DETECTION_LIMIT;
-                    // For Bathtub Plot Only: Set "floor" of plot (= error rate below detection limit) to a very negative value.
-                    // Used by bathtub plot widget to hide invalid values at the bottom of the plot curve.
-            }
-            else
-            {
-                DEBUG_EYE_DATA("," << eyeDataBuffer[i] << "," << thisValue << ", ")
-                eyeDataBufferNorm[i] = log10(thisValue);
-            }
-        }
-        DEBUG_EYE_DATA("-----------------------------------------")
-        ////////////////////////////////////////////////////////////////////////////////
 
-        // Data successfully aquired!
-        qDebug() << "--Scan data aquired! Transmitting results...";
+/*!
+ \brief Extract eye metrics from the accumulated eye scan counts, and send them
+
+ Metrics are found at each BER in metricsThresholds (see EyeMetrics), and
+ sent using the EyeMetricsFinished signal as a flat list, with
+ GT1724::EYE_METRICS_VALUES values for each threshold:
+   BER, width (UI), height (offset steps), area (UI x offset steps),
+   centre phase, centre offset, crossing phase, number of contour polylines
+ Phase is in steps of 1/128 UI from the left edge of the (shifted) plot;
+ offset is in offset steps (1 - 127). Contour points use the same units.
+ \param nBitsAnalysed  Number of bits analysed per point, over all repeats
+*/
+void EyeMonitor::metricsRun(double nBitsAnalysed)
+{
+    EyeMetrics::metrics_t &metrics = metricsResult;
+    QVector<double> values, contourPoints;
+    QVector<int> contourSizes;
+    int i;
 
-//#define BERT_EYESCAN_EXTRA_DEBUG
-#ifdef BERT_EYESCAN_EXTRA_DEBUG
-        //// DEBUG: Dump Eye Data: ///////////////////////////
-        qDebug() << "---- RAW Data ------------------------------------------";
-        qDebug() << "scanHRes,scanVRes";
-        qDebug() << scanHRes << "," << scanVRes;
-        qDebug() << "";
-        size_t xx, yy;
-        for (yy=0; yy < scanVRes; yy++)
-        {
-            QString debugString;
-            for (xx=0; xx < scanHRes; xx++)
-            {
-                debugString += QString::number(eyeDataBuffer[(yy * scanHRes) + xx]);
-                if (xx < (scanHRes-1)) debugString += QString(", ");
-            }
-            qDebug() << debugString;
+    foreach (double ber, metricsThresholds)
+    {
+        if (EyeMetrics::compute(eyeDataBuffer, scanHRes, scanVRes, nBitsAnalysed, ber, &metrics, &metricsWorkspace) != globals::OK) continue;
+        values.append(ber);
+        values.append((double)(metrics.width * scanHStep) / 128.0);
+        values.append((double)(metrics.height * scanVStep));
+        values.append((double)(metrics.area * scanHStep * scanVStep) / 128.0);
+        values.append(metrics.centreX * scanHStep);
+        values.append(1.0 + (metrics.centreY * scanVStep));
+        values.append((double)(metrics.crossingX * scanHStep));
+        values.append((double)metrics.contourSizes.size());
+        for (i = 0; i < metrics.contourPoints.size(); i += 2)
+        {
+            contourPoints.append(metrics.contourPoints[i] * scanHStep);
+            contourPoints.append(1.0 + (metrics.contourPoints[i + 1] * scanVStep));
         }
-        qDebug() << "--------------------------------------------------------" << endl;
-        //////////////////////////////////////////////////////
-#endif
-
-        parent->emitEyeScanFinished(laneOffset + scanLane, scanType, eyeDataBufferNorm, scanHRes, scanVRes);
-qDebug() << "--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << scanVRes;
+        contourSizes += metrics.contourSizes;
+        qDebug() << "Eye Metrics @ BER " << ber << ": Width: " << metrics.width << "; Height: " << metrics.height
+                 << "; Area: " << metrics.area << "; Centre: " << metrics.centreX << ", " << metrics.centreY
+                 << "; Contours: " << metrics.contourSizes.size();
     }
-    qDebug() << "**Eye Scan finshed OK. **";
-
-  finished:
-    // Clean up temp buffer:
-    if (rawDataBuffer) delete [] rawDataBuffer;
-
-    if (scanResult == globals::OVERFLOW) qDebug() << "ERROR: Ran out of space in output buffer!";
-    if (scanResult != globals::OK) parent->emitEyeScanError(laneOffset + scanLane, scanType, scanResult);
-    return scanResult;
+    parent->emitEyeMetricsFinished(laneOffset + scanLane, values, contourPoints, contourSizes);
 }
 
 
@@ -627,59 +2899,60 @@ qDebug() << "--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << s
 
 
 /*!
- \brief Find the location of the "peak" in the centre row of the eye scan
- \param data   Reference to vector of scan data (doubles)
-               The array pointed to by data must contain
-               sizeX * sizeY elements
- \param sizeX  Number of sample points horizontally (minimum 2)
- \param sizeY  Number of rows (sample points vertically) (minimum 1)
-
- \return index  Index of maximum value on the x axis, for
-                the row through the vertical centre of the plot
-                This is a value between 0 and sizeX inclusive.
+ \brief Find the eye crossing in the latest scan, to set the phase shift
+
+ Uses EyeMetrics::centreFind on the raw (unshifted) scan in scanSamples.
+ The crossing is half a UI from the centre of the widest low-error
+ window, with rows near 0 mV weighted most; this is stable from scan to
+ scan, even for noisy or nearly closed eyes.
+
+ If the estimate isn't reliable (confidence below CENTRE_CONFIDENCE_MIN),
+ false is returned and the caller should keep the previous shift, so the
+ plot doesn't jump. nShift is rescaled here if the phase resolution has
+ changed since it was found.
+
+ \param numPhaseSteps   Scan size (columns, rows)
+ \param numOffsetSteps  |
+ \param crossingIndex   Used to return the column of the crossing (0 - numPhaseSteps-1)
+ \return true if the crossing was found
 */
-uint8_t EyeMonitor::peakFind(QVector<double> &data,
-                             const size_t sizeX,
-                             const size_t sizeY)
+bool EyeMonitor::crossingFind(const uint8_t numPhaseSteps,
+                              const uint8_t numOffsetSteps,
+                              uint8_t *crossingIndex)
 {
-qDebug() << "PEAK FIND:";
-    double zMax = 0.0;
-    size_t maxIndex = 0;
-    const size_t yMid = sizeY / 2;
-    const size_t startIndex = (yMid * sizeX);
-    size_t sampleIndex = startIndex;
-    for (size_t x = 0; x < sizeX; x++)
+    EyeMetrics::centre_t centre;
+    const double nBits = (double)((uint16_t)(1 << scanCountResBits));
+    EyeMetrics::centreFind(scanSamples, numPhaseSteps, numOffsetSteps, nBits, CENTRE_BER, &centre);
+    qDebug() << "CENTRE FIND: Centre " << centre.centreX << "; Width " << centre.windowWidth
+             << "; Crossing " << centre.crossingX << "; Confidence " << centre.confidence;
+    if (centre.confidence < CENTRE_CONFIDENCE_MIN)
     {
-        if (data[sampleIndex] >= zMax)
+        if (centreShiftRes > 0 && centreShiftRes != numPhaseSteps)
         {
-            maxIndex = (sampleIndex - startIndex);
-            zMax = data[sampleIndex];
+            nShift = (nShift * numPhaseSteps) / centreShiftRes;
+            centreShiftRes = numPhaseSteps;
         }
-        sampleIndex++;
+        return false;
     }
-    return maxIndex;
+    *crossingIndex = static_cast<uint8_t>(centre.crossingX);
+    centreShiftRes = numPhaseSteps;
+    return true;
 }
 
 
 
 
 /*!
- \brief Rotate data array left or right
-
- Allocates a NEW data array of the same size as the
- source array. The CALLER must free the new array
- with  delete [] (BUT see notes on return value below)
+ \brief Rotate data array left or right (in place)
 
  Each element is shifted left or right within its row, with
  the end of the row being 'wrapped' around, according to the
- value of nShift
-
- \param data         Reference to array of raw scan data (doubles)
-                     The array pointed to by data must contain
-                     sizeX * sizeY elements
+ value of nShift. The data are rotated in place, so no memory
+ is allocated.
 
- \param dataShifted  Reference to a vector to receive the shifted data.
-                     If it contains any existing data, the data will be overwritten.
+ \param data   Reference to array of raw scan data (doubles)
+               The array must contain at least sizeX * sizeY
+               elements; only the first sizeX * sizeY are used.
 
  \param sizeX  Number of sample points horizontally (minimum 2)
  \param sizeY  Number of rows (sample points vertically) (minimum 1)
@@ -693,7 +2966,6 @@ qDebug() << "PEAK FIND:";
  \return globals::GEN_ERROR   Couldn't shift (shift size too big?)
 */
 int EyeMonitor::dataShift(QVector<double> &data,
-                          QVector<double> &dataShifted,
                           const size_t sizeX,
                           const size_t sizeY,
                           const int nShift)
@@ -708,22 +2980,16 @@ int EyeMonitor::dataShift(QVector<double> &data,
       {  nShiftAbs = (size_t)(sizeX + nShift);  }
     // Check bounds: Must be between 0 and sizeX:
     if (nShiftAbs > sizeX) return globals::GEN_ERROR;
+    if (nShiftAbs == sizeX) nShiftAbs = 0;
 
     const size_t nSamples = (sizeX * sizeY);
-    Q_ASSERT(nSamples == (size_t)data.size());
-    if (nSamples != (size_t)data.size()) return globals::GEN_ERROR;
-    bufferReset(dataShifted, (int)nSamples);
-    size_t x, y, sampleIndex, storeIndex;
-    storeIndex = 0;
-    for (y = 0; y < sizeY; y++)
+    Q_ASSERT(nSamples <= (size_t)data.size());
+    if (nSamples > (size_t)data.size()) return globals::GEN_ERROR;
+    double *rowStart = data.data();
+    for (size_t y = 0; y < sizeY; y++)
     {
-        for (x = 0; x < sizeX; x++)
-        {
-            sampleIndex = (y * sizeX) + x;
-            if (x < nShiftAbs) storeIndex = (y * sizeX) + x + (sizeX - nShiftAbs);
-            else               storeIndex = (y * sizeX) + x - nShiftAbs;
-            dataShifted[storeIndex] = data[sampleIndex];
-        }
+        std::rotate(rowStart, rowStart + nShiftAbs, rowStart + sizeX);
+        rowStart += sizeX;
     }
     return globals::OK;
 }
@@ -847,15 +3113,92 @@ int EyeMonitor::controlEyeSweep(const uint8_t phaseStart,
 
 /*!
  \brief Clear a buffer of double values, and set to a new size.
-        The new vector is filled with 0.0
+        The vector is filled with 0.0. Memory is only reallocated
+        if the size changes, so repeated scans with the same
+        settings don't allocate.
  \param buffer
  \param newSize
 */
 void EyeMonitor::bufferReset(QVector<double> &buffer, int newSize)
 {
-    buffer.clear();
-    buffer.resize(newSize);
+    if (buffer.size() != newSize) buffer.resize(newSize);
     buffer.fill(0.0);
 }
 
 
+
+/*!
+ \brief Get a free output buffer for normalised eye data
+
+ Frames sent to the UI use one of the buffers in framePool. Each buffer
+ counts its references (framePool holds one; each frame using it adds one),
+ so a buffer is only reused once no frame uses it (i.e. the UI has dropped
+ the frame, and eyeDataFrame has moved on). Published frames are therefore
+ never changed. Normally the UI holds one buffer, eyeDataFrame one, and
+ one is free; if the UI is holding on to more frames than that, a new
+ buffer is allocated.
+
+ \param size  Number of samples needed
+ \return Pointer to the buffer (not used by any frame; safe to write).
+         Contents are undefined.
+*/
+EyeFrame::frameData_t *EyeMonitor::frameBufferAcquire(int size)
+{
+    int i;
+    for (i = 0; i < FRAME_POOL_SIZE; i++)
+    {
+        if (!framePool[i] || !EyeFrame::bufferInUse(framePool[i].data())) break;
+    }
+    if (i == FRAME_POOL_SIZE)
+    {
+        qDebug() << "Eye frame buffers all in use: Allocating a new buffer.";
+        i = 0;
+        framePool[i].reset();  // Drop our reference; the frames keep the old buffer
+    }
+    if (!framePool[i]) framePool[i] = new EyeFrame::frameData_t;
+    if (framePool[i]->data.size() != size) framePool[i]->data.resize(size);
+    return framePool[i].data();
+}
+
+
+
+/*!
+ \brief Prepare the scratch buffers used for scanning
+
+ Each eye monitor owns one set of scratch buffers, which are reused for
+ every scan and repeat (raw data read back from the scan output memory,
+ unpacked samples, the frame buffers sent to the UI, and the auto-stop
+ and eye metrics scratch buffers). They are only (re)allocated if the
+ output memory size reported by queryEyeScanMem grows, so in practice
+ this happens once; a repeat-forever scan then makes no heap allocations
+ for its data (unless the UI holds on to more frames than the pool has).
+
+ Everything else is sized for the largest possible scan (128 phases x
+ 128 offsets), which also covers every output memory size. Frame buffers
+ which are still used by a frame are left alone: they are sized when
+ they are next acquired (see frameBufferAcquire).
+
+ \param outputMemorySize  Size of the scan output memory (from queryEyeScanMem)
+ \return globals::OK
+ \return globals::MALLOC_ERROR  Couldn't allocate buffers
+*/
+int EyeMonitor::arenaPrepare(uint16_t outputMemorySize)
+{
+    int i;
+    if (scanRawData.size() < outputMemorySize) scanRawData.resize(outputMemorySize);
+    if (scanSamples.size() < ARENA_SAMPLES_MAX) scanSamples.resize(ARENA_SAMPLES_MAX);
+    if (autoStopOpen.size() < ARENA_SAMPLES_MAX) autoStopOpen.resize(ARENA_SAMPLES_MAX);
+    if ( (scanRawData.size() < outputMemorySize) || (scanSamples.size() < ARENA_SAMPLES_MAX) ||
+         (autoStopOpen.size() < ARENA_SAMPLES_MAX) ) return globals::MALLOC_ERROR;
+    if (EyeMetrics::workspacePrepare(&metricsWorkspace, 128, 128) != globals::OK) return globals::MALLOC_ERROR;
+    for (i = 0; i < FRAME_POOL_SIZE; i++)
+    {
+        if (!framePool[i]) framePool[i] = new EyeFrame::frameData_t;
+        if (EyeFrame::bufferInUse(framePool[i].data())) continue;
+        framePool[i]->data.reserve(ARENA_SAMPLES_MAX);
+        if (framePool[i]->data.capacity() < ARENA_SAMPLES_MAX) return globals::MALLOC_ERROR;
+    }
+    return globals::OK;
+}
+
+
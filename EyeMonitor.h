@@ -8,7 +8,14 @@
 #ifndef EYEMONITOR_H
 #define EYEMONITOR_H
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
 #include "GT1724.h"
+#include "EyeArchive.h"
+#include "EyeFrame.h"
+#include "EyeMetrics.h"
+#include "ScanPlanner.h"
 
 /*!
  \brief Eye Monitor Functions
@@ -33,8 +40,68 @@ public:
 
     int repeatScan();  // Repeats the previous scan, and adds the new data to the existing data
 
+    // All scans except drift: start, then call scanStep until 'done' is set:
+    int scanStep(bool *done);
+    bool scanActive() const { return scanState != SCAN_IDLE; }
+    bool eyeScanActive() const { return scanState == SCAN_SETUP || scanState == SCAN_SWEEP || scanState == SCAN_FINISH; }
+    bool scanSweepNext() const { return scanActive() && scanState != SCAN_SETUP && scanState != SCAN_FINISH; }  // Next step sweeps the eye (see GT1724::edSweepBegin)
+
+    int startContourScan(int hStepIndex,
+                         int countResIndex,     // Count resolution used while searching for the boundary
+                         double targetBER,      // BER which defines the eye boundary
+                         int boundaryRepeats);  // Repeats (at 8 bit resolution) used to confirm each boundary point
+
+    int startMaskTest(int hStepIndex,
+                      const QVector<double> &maskPoints,     // Polygon vertices: x (UI from eye centre), y (offset steps from 0 mV) pairs
+                      const QVector<int> &maskPolygonSizes,  // Number of vertices in each polygon
+                      double targetBER,
+                      double confidence);                    // Confidence level for a pass (e.g. 0.95)
+    bool maskTestActive() const { return scanState == SCAN_MASK_CENTRE || scanState == SCAN_MASK || scanState == SCAN_MASK_MARGIN; }
+
+    int startROIScan(int phaseStart,      // Phase window: 0 - 127; phaseStop may wrap past 127 (up to phaseStart + 127)
+                     int phaseStop,       //
+                     int phaseStep,       //
+                     int offsetStart,     // Offset window: 1 - 127
+                     int offsetStop,      //
+                     int offsetStep,      //
+                     int countResIndex);
+
+    int startBathtubScan(int hStepIndex,
+                         const QVector<int> &vOffsets,  // Voltage offsets (1 - 127) of bathtub curves
+                         int countResIndex,
+                         bool useEyeData);              // Take curves from last eye scan if possible
+
+    int setBathtubFitOptions(const QVector<double> &targetBERs,  // BERs at which to report extrapolated eye opening
+                             double fitBERMax,                   // Highest BER used in the fit
+                             double tolerance);                  // Convergence tolerance for eye openings (UI)
+
+    int setAutoStopOptions(bool enabled,
+                           double tolerance,   // Relative change in metrics between repeats which counts as stable
+                           double floorBER,    // Stop when measurement floor reaches this BER (0 = no floor target)
+                           double metricBER);  // BER which defines the open part of the eye for metrics
+
+    int setMetricsThresholds(const QVector<double> &thresholds);  // BER thresholds for eye metrics
+
+    int archiveSave(const QString &fileName, const QString &serial);  // Save last eye / bathtub scan (see EyeArchive)
+    int archiveCompare(const QString &goldenFileName,                  // Compare last scan with a saved golden scan
+                       double toleranceDecades);
+
     void cancelScan();
 
+    // Drift monitor: start, then call driftStep whenever driftMsUntilDue reaches 0 (see GT1724::eyeDriftService):
+    int driftStart(int hStepIndex,
+                   int countResIndex,
+                   double targetBER,    // BER which defines the open part of each row
+                   double threshold,    // Shrink in eye opening (UI) which raises an alarm
+                   double dutyCycle);   // Largest fraction of the time that snapshots may use the bus
+
+    int driftStep();
+    void driftStop();
+    bool driftActive() const { return driftEnabled; }
+    qint64 driftMsUntilDue() const;
+
+    ScanPlanner::costParams_t getCostParams() const { return costParams; }  // Timings for scan cost estimates
+
 
 private:
 
@@ -50,26 +117,309 @@ private:
     uint8_t  scanHRes      = 1;  // Number of sample points
     uint8_t  scanVRes      = 1;  //
     uint8_t  scanVOffset   = 0;  // Only used for bathtub scan
-    int      nShift        = 0;  // Number of samples to rotate plot (horizontal)
+    int      nShift         = 0;  // Number of samples to rotate plot (horizontal)
+    int      centreShiftRes = 0;  // Phase steps per row when nShift was found (see crossingFind)
 
     uint8_t  scanCountResIndex = 0;
     uint8_t  scanCountResBits  = 1;
 
     int scanRepeatCount = 0;
 
-    bool stopFlag = false;
+    ScanPlanner::costParams_t costParams;  // Output memory size and sweep times measured by the last scans
+
+    // Cancel flag: Set by cancelScan (from any thread), checked between scan steps:
+    QAtomicInt stopFlag;
+    bool cancelRequested() const { return stopFlag.loadAcquire() != 0; }
+
+    // State of the scan in progress (see scanStep):
+    enum ScanState
+    {
+        SCAN_IDLE,            // No scan in progress
+        SCAN_SETUP,           // Scan started (or repeated); geometry not known yet
+        SCAN_SWEEP,           // Sweeping parts of the eye
+        SCAN_FINISH,          // All parts read back; process and send results
+        SCAN_MASK_CENTRE,     // Mask test: Scanning the centre row to place the mask (see maskStepCentre)
+        SCAN_MASK,            // Mask test: Sweeping the mask windows (see maskStepSweep)
+        SCAN_MASK_MARGIN,     // Mask test passed: Sweeping outside the mask to find the margin (see maskStepMargin)
+        SCAN_ROI,             // ROI scan: Sweeping parts of the window (see roiStep)
+        SCAN_BATHTUBS,        // Multi-row bathtub scan: Sweeping parts of the offset groups (see bathtubStep)
+        SCAN_CONTOUR_CENTRE,  // Contour scan: Scanning the centre row to find the open columns (see contourStepCentre)
+        SCAN_CONTOUR          // Contour scan: Finding one boundary of one column (see contourStepBoundary)
+    };
+    ScanState scanState             = SCAN_IDLE;
+    bool      scanResetFlag         = false;  // true for the first scan after start (i.e. not a repeat)
+    uint8_t   scanNumPhaseSteps     = 1;      // Scan geometry (see scanStepSetup)
+    uint8_t   scanNumOffsetSteps    = 1;      //
+    uint8_t   scanNumOffsetStepsMax = 1;      // Max rows in one part (fit in the output memory, and in the step time limit)
+    uint8_t   scanOffsetStop        = 1;      // Last row to scan
+    uint8_t   scanPartOffsetStart   = 1;      // Rows for the next part scan
+    uint8_t   scanPartOffsetStop    = 1;      //
+    int       scanSampleIndex       = 0;      // Next free sample in scanSamples
+
+    // Scratch buffers, owned by this monitor and reused for every scan (see arenaPrepare):
+    QVector<uint8_t> scanRawData;   // Data read back from scan output memory
+    QVector<double>  scanSamples;   // Unpacked samples for one scan
+    static const int ARENA_SAMPLES_MAX = 128 * 128;
+
+    // Output buffers for normalised eye data, shared with frames sent to the UI
+    // (the pool holds one reference to each buffer; see frameBufferAcquire):
+    static const int FRAME_POOL_SIZE = 3;
+    QExplicitlySharedDataPointer<EyeFrame::frameData_t> framePool[FRAME_POOL_SIZE];
 
     QVector<double> eyeDataBuffer;
-    QVector<double> eyeDataBufferNorm;
+    EyeFrame eyeDataFrame;        // Last frame sent: Normalised data (shared with the UI: Read only!)
+    bool   eyeDataValid = false;  // true if eyeDataFrame holds a full eye scan (see startBathtubScan)
+    int    eyeDataRepeats = 0;    // Number of repeats accumulated in eyeDataBuffer (0 if no completed scan)
+    qint64 eyeDataTime = 0;       // Time of last completed repeat (ms since epoch)
+    double eyeDataFloor = 0.0;    // log10 floor value of eyeDataFrame
+
+    // Settings and state for dual-Dirac bathtub fit:
+    QVector<double> bathtubFitTargets   = { 1.0e-12, 1.0e-15 };
+    double          bathtubFitBERMax    = 1.0e-2;
+    double          bathtubFitTolerance = 0.005;   // UI
+    QVector<double> bathtubFitOpenings;            // Openings from previous repeat (for convergence check)
+    static const double BATHTUB_FIT_R2_MIN;        // Minimum fit quality for convergence
+
+    // Settings for eye centre estimate (see crossingFind):
+    static const double CENTRE_BER;                // BER threshold for "low error" cells
+    static const double CENTRE_CONFIDENCE_MIN;     // Estimates below this confidence are ignored
+
+    // Settings and state for repeated scan auto-stop:
+    bool            autoStopEnabled   = false;
+    double          autoStopTolerance = 0.02;
+    double          autoStopFloorBER  = 0.0;
+    double          autoStopMetricBER = 1.0e-3;
+    QVector<double> autoStopMetrics;               // Metrics from previous repeat (for stability check)
+    QVector<bool>   autoStopOpen;                  // Scratch: Open flag for each point (see arenaPrepare)
+
+    // BER thresholds for eye metrics, and scratch buffers (see arenaPrepare):
+    QVector<double> metricsThresholds = { 1.0e-2, 1.0e-3 };
+    EyeMetrics::workspace_t metricsWorkspace;
+    EyeMetrics::metrics_t   metricsResult;        // Reused, so its contour lists keep their capacity
+
+    // Settings and state for contour scan:
+    uint8_t  contourHStep           = 1;
+    uint8_t  contourCountResIndex   = 0;
+    double   contourTargetBER       = 1.0e-3;
+    int      contourBoundaryRepeats = 1;
+    int      contourPointsMeasured  = 0;   // Number of single point measurements made by the last contour scan
+    int      contourRunStart        = 0;   // Widest run of open columns on the centre row (phase step index)
+    int      contourRunLength       = 0;   //
+    int      contourPass            = 0;   // Column to trace next: 0 = centre outwards to the right; 1 = to the left
+    int      contourColumn          = 0;   //
+    int      contourDirection       = 1;   // Boundary to find next: +1 = upper; -1 = lower
+    QVector<int> contourUpper;             // Boundary distances from centre, for each column in the eye
+    QVector<int> contourLower;             //
+
+    // Settings and state for ROI scan:
+    int      roiPhaseStart     = 0;
+    int      roiPhaseStop      = 0;
+    int      roiPhaseStep      = 1;
+    int      roiOffsetStart    = 1;
+    int      roiOffsetStep     = 1;
+    uint8_t  roiCountResIndex  = 0;
+    int      roiNumPhaseSteps  = 1;
+    int      roiNumOffsetSteps = 1;
+    int      roiColumn         = 0;   // First column of the phase segment being swept
+    int      roiRow            = 0;   // Next row to sweep in that segment
+    int      roiSamplesDone    = 0;
+    QVector<double> roiData;          // Error counts, then log10 BER
+
+    // Settings and state for multi-row bathtub scan:
+    uint8_t  bathtubHStep         = 1;
+    uint8_t  bathtubCountResIndex = 0;
+    int      bathtubNumPhaseSteps = 1;
+    int      bathtubRowsPerPart   = 1;
+    int      bathtubGroupEnd      = 0;   // Last row of the group being swept (see bathtubGroupFind)
+    int      bathtubGroupStep     = 1;   // Offset step in that group
+    int      bathtubRow           = 0;   // Next row to sweep
+    QVector<int>    bathtubOffsets;        // Offsets in the order requested
+    QVector<int>    bathtubOffsetsSorted;  // Offsets in the order swept
+    QVector<double> bathtubRowData;        // Error counts for each row in bathtubOffsetsSorted
+
+    // Settings and state for drift monitor:
+    typedef struct driftStat_t
+    {
+        double mean;    // Baseline mean and sum of squared differences (Welford)
+        double m2;      //
+        double ewma;    // Smoothed value since the baseline was set
+        bool   alarm;   // Alarm raised (re-armed when the metric recovers)
+    } driftStat_t;
+
+    bool     driftEnabled       = false;
+    uint8_t  driftHStep         = 1;
+    uint8_t  driftCountResIndex = 3;
+    double   driftTargetBER     = 1.0e-2;
+    double   driftThreshold     = 0.05;   // UI
+    double   driftDutyCycle     = 0.01;
+    int      driftSnapshots     = 0;      // Snapshots taken since start
+    qint64   driftDueTime       = 0;      // Time of next snapshot (ms on driftClock)
+    QElapsedTimer driftClock;             // Monotonic clock for snapshot times; started by driftStart
+    QVector<driftStat_t> driftStats;      // One for each metric (see driftSnapshot)
+    QVector<uint8_t>     driftRawData;    // Data read back for one part of a snapshot
+    int                  driftRowsPerPart = DRIFT_ROWS;  // Rows in each sweep (limited by output memory size; see driftStart)
+
+    static const int    DRIFT_ROWS               = 5;   // Rows in each snapshot, centred on 0 mV
+    static const int    DRIFT_ROW_SPACING        = 8;   // Offset steps between rows
+    static const int    DRIFT_METRICS            = DRIFT_ROWS + 1;
+    static const int    DRIFT_BASELINE_SNAPSHOTS = 8;
+    static const double DRIFT_DUTY_MAX;
+    static const double DRIFT_EWMA_WEIGHT;
+    static const double DRIFT_SIGMA_K;
+
+    // Settings and state for mask test:
+    typedef struct maskWindow_t
+    {
+        uint8_t phaseStart;    // One rectangular region for controlEyeSweep
+        uint8_t phaseStop;     //
+        uint8_t offsetStart;   //
+        uint8_t offsetStop;    //
+    } maskWindow_t;
+
+    uint8_t  maskHStep           = 1;
+    double   maskTargetBER       = 1.0e-3;
+    double   maskConfidence      = 0.95;
+    int      maskRepeatsRequired = 1;   // Number of repeats needed for a pass if no errors are seen
+    int      maskRepeatsDone     = 0;
+    int      maskWindowIndex     = 0;   // Next window to sweep (mask or margin ring)
+    int      maskCentrePhase     = 0;   // Phase of eye centre (0 - 127)
+    int      maskHitCount        = 0;   // Number of mask cells with errors
+    int      maskMarginDistance  = 0;   // Ring (offset steps outside the mask) being swept by the margin search
+    QVector<double>       maskVertices;    // Mask polygon vertices (see startMaskTest)
+    QVector<int>          maskVertexCounts;// Number of vertices in each polygon
+    QVector<bool>         maskCells;       // MASK_GRID_SIZE x MASK_GRID_SIZE grid ([offset * MASK_GRID_SIZE + phase]); true if cell is in mask
+    QVector<double>       maskCellErrors;  // Accumulated error count for each cell
+    QVector<maskWindow_t> maskWindows;     // Sweep windows which cover the mask
+    QVector<int>          maskDistance;    // Margin search: Distance from each cell to the mask (see maskVerticalDistance)
+    QVector<double>       maskRingCounts;  // Margin search: Error counts for the current ring
+    QVector<maskWindow_t> maskRingWindows; // Margin search: Sweep windows which cover the current ring
 
-    int eyeScanRun(bool resetFlag);
+    static const int MASK_GRID_SIZE   = 128;
+    static const int MASK_MARGIN_MAX  = 16;   // Max margin (offset steps) checked after a pass
+    static const int MASK_REPEATS_MAX = 4096; // Max repeats (2^8 bits per cell each) before the test gives up
+    static const int MASK_UNDECIDED   = 0;    // Results from maskDecision
+    static const int MASK_PASS        = 1;    //
+    static const int MASK_FAIL        = 2;    //
 
-    uint8_t peakFind( QVector<double> &data,
-                      const size_t sizeX,
-                      const size_t sizeY );
+    uint8_t  imageAddressMSB  = 0;  // Location of scan output memory, from queryEyeScanMem
+    uint8_t  imageAddressLSB  = 0;  //
+    uint16_t imageMaximumSize = 0;  //
+
+    static const uint8_t CONTOUR_OFFSET_CENTRE   = 65;  // Voltage offset for 0 mV (see EYESCAN_VOFF_LOOKUP)
+    static const int     CONTOUR_REFINE_STEPS_MAX = 4;  // Max steps a boundary point may move during refinement
+
+    int scanStepSetup();
+    int scanStepSweep();
+    int scanStepFinish();
+
+    int scanTypeActive() const;
+
+    int  contourStepCentre();
+    int  contourStepBoundary();
+    void contourFinish();
+
+    int  roiStep();
+    void roiFinish();
+
+    int  bathtubStep();
+    void bathtubGroupFind(int groupStart);
+    int  bathtubFinish();
+
+    int  maskStepCentre();
+    int  maskStepSweep();
+    int  maskStepMargin();
+    int  maskDecision() const;
+    void maskMarginRing();
+    void maskTestFinish(bool pass, double margin);
+
+    void maskBuildWindows( const QVector<bool> &cells,
+                           QVector<maskWindow_t> &windows );
+
+    int maskSweepWindow( const maskWindow_t &window,
+                         QVector<double> &cellCounts,
+                         bool *hit );
+
+    static void maskVerticalDistance( const QVector<bool> &cells,
+                                      const bool target,
+                                      QVector<int> &distance );
+
+    static bool pointInPolygon( const double x,
+                                const double y,
+                                const double *polygon,
+                                const int nVertices );
+
+    int roiSweepPart( const uint8_t phaseStart,
+                      const uint8_t phaseStop,
+                      const uint8_t phaseStep,
+                      const uint8_t offsetStart,
+                      const uint8_t offsetStop,
+                      const uint8_t offsetStep,
+                      const uint8_t resolution,
+                      QVector<double> &roiData,
+                      const int roiColumns,
+                      const int column,
+                      const int row,
+                      const int nColumns,
+                      const int nRows );
+
+    void bathtubFitRun(bool resetFlag);
+
+    void autoStopEvaluate(bool resetFlag, double nBitsAnalysed);
+
+    void metricsRun(double nBitsAnalysed);
+
+    int archiveRecord(const QString &serial, EyeArchive::record_t *record);
+
+    bool bathtubFromEyeData( const QVector<int> &vOffsets,
+                             QVector<double> &curves,
+                             int *xRes );
+
+    int driftSnapshot(QVector<double> &metrics);
+
+    void driftEvaluate(const QVector<double> &metrics);
+
+    int scanCentreRow( const uint8_t hStep,
+                       const uint8_t resolution,
+                       const double targetBER,
+                       int *runStart,
+                       int *runLength );
+
+    int contourFindBoundary( const uint8_t phase,
+                             const int direction,
+                             const int guess,
+                             int *boundary );
+
+    int contourProbe( const uint8_t phase,
+                      const int direction,
+                      const int distance,
+                      const uint8_t resolution,
+                      const int repeats,
+                      bool *open );
+
+    int measurePoint( const uint8_t phase,
+                      const uint8_t offset,
+                      const uint8_t resolution,
+                      const int repeats,
+                      double *ber );
+
+    static int unpackSample( const uint8_t *data,
+                             const int sampleIndex,
+                             const uint8_t countResBits );
+
+    static void openRunFind( const uint8_t *data,
+                             const uint16_t dataSize,
+                             const int firstSample,
+                             const int numPhaseSteps,
+                             const uint8_t countResBits,
+                             const double targetBER,
+                             int *runStart,
+                             int *runLength );
+
+    bool crossingFind( const uint8_t numPhaseSteps,
+                       const uint8_t numOffsetSteps,
+                       uint8_t *crossingIndex );
 
     int dataShift( QVector<double> &data,
-                   QVector<double> &dataShifted,
                    const size_t sizeX,
                    const size_t sizeY,
                    const int nShift );
@@ -91,6 +441,10 @@ private:
 
     void bufferReset(QVector<double> &buffer, int newSize);
 
+    int arenaPrepare(uint16_t outputMemorySize);
+
+    EyeFrame::frameData_t *frameBufferAcquire(int size);
+
 };
 
 
@@ -0,0 +1,572 @@
+/*!
+ \file   FrequencySweep.cpp
+ \brief  Frequency Sweep Engine - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+#include <math.h>
+
+#include "FrequencySweep.h"
+
+
+// Debug macro for frequency sweep messages:
+#define DEBUG_SWEEP(MSG) qDebug() << "\t" << MSG;
+
+
+FrequencySweep::FrequencySweep(QList<LMX2594 *> *lmxClockSet, QList<GT1724 *> *gt1724Set)
+ : lmxClockSet(lmxClockSet), gt1724Set(gt1724Set)
+{
+    serviceTimer = new QTimer(this);
+    serviceTimer->setSingleShot(true);
+    connect(serviceTimer, SIGNAL(timeout()), this, SLOT(service()));
+}
+
+
+FrequencySweep::~FrequencySweep()
+{}
+
+
+
+/*!
+ \brief Start a frequency sweep
+ The sweep runs in the background (see service). Results are sent with
+ FreqSweepResult, one row per rate, then FreqSweepFinished.
+
+ \param profiles        Indexes of the frequency profiles to step through, in order
+ \param pgPattern       PG pattern (see GT1724::PG_PATTERN_LIST)
+ \param edPattern       ED pattern (see GT1724::ED_PATTERN_LIST)
+ \param measureSeconds  Measurement time at each rate (maximum time if confidence > 0)
+ \param targetBER       BER limit for confidence-bounded measurements
+ \param confidence      Confidence level (0 < confidence < 1); Use 0 for fixed time measurements
+
+ \return globals::OK               Sweep started
+ \return globals::BUSY_ERROR       Sweep already running, or ED / eye scan in use
+ \return globals::OVERFLOW         Parameter out of range
+ \return globals::NOT_INITIALISED  No clocks or GT1724s, or no frequency profiles
+*/
+int FrequencySweep::start(const QVector<int> &profiles,
+                          int pgPattern,
+                          int edPattern,
+                          double measureSeconds,
+                          double targetBER,
+                          double confidence)
+{
+    int result = startCheck(pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    if (result != globals::OK) return result;
+    if (profiles.isEmpty()) return globals::OVERFLOW;
+    foreach (int profileIndex, profiles)
+    {
+        if (profileIndex < 0 || profileIndex >= LMX2594::profileCount()) return globals::OVERFLOW;
+    }
+    this->profiles = profiles;
+    this->frequencies.clear();
+    startRun(pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Start a frequency sweep through any frequencies
+ As start, but each rate is set up by LMX2594::selectFrequency, so the
+ frequencies don't need to be in the list of profiles. Results have a
+ profile index of -1.
+
+ \param frequencies     Clock frequencies to step through, in order (MHz; clock is 1/2 bit rate)
+
+ \return globals::OK               Sweep started
+ \return globals::BUSY_ERROR       Sweep already running, or ED / eye scan in use
+ \return globals::OVERFLOW         Parameter out of range
+ \return globals::NOT_INITIALISED  No clocks or GT1724s, or no frequency profiles (used as a base for the settings)
+*/
+int FrequencySweep::startFrequencies(const QVector<double> &frequencies,
+                                     int pgPattern,
+                                     int edPattern,
+                                     double measureSeconds,
+                                     double targetBER,
+                                     double confidence)
+{
+    int result = startCheck(pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    if (result != globals::OK) return result;
+    if (frequencies.isEmpty() || frequencies.count() > FREQUENCY_STEPS_MAX) return globals::OVERFLOW;
+    foreach (double stepFrequency, frequencies)
+    {
+        if (stepFrequency <= 0.0 || stepFrequency > LMXPllPlanner::VCO_MAX_MHZ) return globals::OVERFLOW;
+    }
+    this->profiles.clear();
+    this->frequencies = frequencies;
+    startRun(pgPattern, edPattern, measureSeconds, targetBER, confidence);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Check the settings for a new sweep (see start)
+ \return globals::OK  Sweep can be started
+ \return [error code] As start
+*/
+int FrequencySweep::startCheck(int pgPattern, int edPattern, double measureSeconds, double targetBER, double confidence) const
+{
+    if (active()) return globals::BUSY_ERROR;
+    if (lmxClockSet->isEmpty() || gt1724Set->isEmpty()) return globals::NOT_INITIALISED;
+    if (LMX2594::profileCount() == 0) return globals::NOT_INITIALISED;
+    if (pgPattern < 0 || pgPattern >= GT1724::pgPatternCount()
+     || edPattern < 0 || edPattern >= GT1724::edPatternCount()
+     || measureSeconds <= 0.0
+     || confidence < 0.0 || confidence >= 1.0
+     || (confidence > 0.0 && targetBER <= 0.0)) return globals::OVERFLOW;
+    // The sweep uses the PRBS checkers, so the ED and eye scanner must be idle:
+    foreach (GT1724 *gt1724, *gt1724Set)
+    {
+        if (gt1724->edInUse()) return globals::BUSY_ERROR;
+    }
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Start the sweep timer (settings already checked by startCheck)
+*/
+void FrequencySweep::startRun(int pgPattern, int edPattern, double measureSeconds, double targetBER, double confidence)
+{
+    this->pgPattern  = pgPattern;
+    this->edPattern  = edPattern;
+    this->measureMs  = measureSeconds * 1000.0;
+    this->targetBER  = targetBER;
+    this->confidence = confidence;
+    stepIndex = 0;
+    deviceIndex = 0;
+
+    DEBUG_SWEEP("FrequencySweep: Start: " << stepCount() << " rates; " << measureSeconds
+                << " s per rate; Target BER " << targetBER << "; Confidence " << confidence)
+
+    // Nb: The PRBS checkers are started at each rate, after relock (see stepMeasure).
+    sweepState = SWEEP_RETUNE;
+    serviceTimer->start(0);
+}
+
+
+
+/*!
+ \brief Make a list of evenly spaced frequencies
+ \param frequencyFrom  First frequency (MHz)
+ \param frequencyTo    Last frequency (MHz); may be below frequencyFrom
+ \param frequencyStep  Step size (MHz)
+ \param frequencies    Set to the frequencies from frequencyFrom towards frequencyTo.
+                       frequencyTo is included if it's a whole number of steps from
+                       frequencyFrom (to within 1 kHz).
+ \return globals::OK
+ \return globals::OVERFLOW  Step not above 0, or more than FREQUENCY_STEPS_MAX frequencies
+*/
+int FrequencySweep::frequencySteps(double frequencyFrom, double frequencyTo, double frequencyStep, QVector<double> *frequencies)
+{
+    frequencies->clear();
+    if (frequencyStep <= 0.0) return globals::OVERFLOW;
+    const double span = fabs(frequencyTo - frequencyFrom);
+    const double steps = floor((span + 0.001) / frequencyStep);
+    if (steps >= static_cast<double>(FREQUENCY_STEPS_MAX)) return globals::OVERFLOW;
+    const double direction = (frequencyTo >= frequencyFrom) ? 1.0 : -1.0;
+    for (int i = 0; i <= static_cast<int>(steps); i++)
+    {
+        frequencies->append(frequencyFrom + (direction * static_cast<double>(i) * frequencyStep));
+    }
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Find the frequency profiles in a frequency range
+ \param frequencyMin  Lowest clock frequency (MHz)
+ \param frequencyMax  Highest clock frequency (MHz)
+ \param profiles      Set to the indexes of the profiles in the range, in ascending order of frequency
+ \return globals::OK
+ \return globals::NOT_INITIALISED  No frequency profiles
+ \return globals::OVERFLOW         No profiles in the range
+*/
+int FrequencySweep::profilesInRange(double frequencyMin, double frequencyMax, QVector<int> *profiles) const
+{
+    profiles->clear();
+    if (LMX2594::profileCount() == 0 || lmxClockSet->isEmpty()) return globals::NOT_INITIALISED;
+    // Nb: Profiles are stored in ascending order of frequency (see LMX2594::init).
+    for (int index = 0; index < LMX2594::profileCount(); index++)
+    {
+        float profileFrequency = 0.0f;
+        if (lmxClockSet->at(0)->getFrequency(index, &profileFrequency) != globals::OK) continue;
+        if (profileFrequency >= frequencyMin && profileFrequency <= frequencyMax) profiles->append(index);
+    }
+    if (profiles->isEmpty()) return globals::OVERFLOW;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Cancel the sweep
+ Results already sent are kept. FreqSweepFinished is sent with globals::CANCELLED.
+*/
+void FrequencySweep::cancel()
+{
+    if (!active()) return;
+    DEBUG_SWEEP("FrequencySweep: Cancelled at step " << stepIndex)
+    finish(globals::CANCELLED);
+}
+
+
+
+/*!
+ \brief Run the next part of the sweep (timer slot)
+*/
+void FrequencySweep::service()
+{
+    int result = globals::OK;
+    bool done = false;
+    switch (sweepState)
+    {
+    case SWEEP_RETUNE:
+        result = stepRetune(&done);
+        if (result != globals::OK || !done) break;
+        deviceIndex = 0;
+        sweepState = SWEEP_CONFIG;
+        break;
+
+    case SWEEP_CONFIG:
+        result = stepConfig(&done);
+        if (result != globals::OK || !done) break;
+        sweepState = SWEEP_MEASURE;
+        break;
+
+    case SWEEP_MEASURE:
+        result = stepMeasure(&done);
+        if (result != globals::OK || !done) break;
+        resultSend();
+        stepIndex++;
+        if (stepIndex >= stepCount())
+        {
+            finish(globals::OK);
+            return;
+        }
+        deviceIndex = 0;
+        sweepState = SWEEP_RETUNE;
+        break;
+
+    default:
+        return;
+    }
+    if (result != globals::OK)
+    {
+        DEBUG_SWEEP("FrequencySweep: Error at step " << stepIndex << " (" << result << ")")
+        finish(result);
+        return;
+    }
+    schedule();
+}
+
+
+
+/*!
+ \brief Retune to the profile or frequency for the current step
+ Selects the profile (or frequency) on the next LMX. Each LMX waits for
+ lock detect before returning (see LMX2594::runFCal), so only one is done
+ per call.
+ \param done  Set to true when every LMX has been retuned
+ \return globals::OK
+ \return [error code]  Error selecting the profile or frequency
+*/
+int FrequencySweep::stepRetune(bool *done)
+{
+    const int profileIndex = (frequencies.isEmpty()) ? profiles.at(stepIndex) : -1;
+    int result;
+    if (deviceIndex == 0)
+    {
+        if (profileIndex >= 0)
+        {
+            float profileFrequency = 0.0f;
+            result = lmxClockSet->at(0)->getFrequency(profileIndex, &profileFrequency);
+            if (result != globals::OK) return result;
+            frequency = static_cast<double>(profileFrequency);
+        }
+        else
+        {
+            frequency = frequencies.at(stepIndex);
+        }
+        bitRate = frequency * 2.0 * 1e6;  // Clock is 1/2 bit rate
+        lockTimeMs = 0;
+        DEBUG_SWEEP("FrequencySweep: Step " << stepIndex << ": Profile " << profileIndex << " (" << frequency << " MHz)")
+    }
+
+    LMX2594 *lmx = lmxClockSet->at(deviceIndex);
+    if (profileIndex >= 0) result = lmx->selectProfile(profileIndex);
+    else                   result = lmx->selectFrequency(frequency);
+    if (result == globals::TIMEOUT)
+    {
+        // No lock: Carry on; the ED lanes won't lock, and time out (see stepMeasure).
+        DEBUG_SWEEP("FrequencySweep: Clock not locked at " << frequency << " MHz")
+    }
+    else if (result != globals::OK) return result;
+    if (lmx->getLockTimeMs() < 0 || lockTimeMs < 0) lockTimeMs = -1;
+    else                                            lockTimeMs = qMax(lockTimeMs, lmx->getLockTimeMs());
+    lmx->GetLMXInfo();   // Keep the client's bit rate up to date
+
+    deviceIndex++;
+    *done = (deviceIndex >= lmxClockSet->count());
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set up the PG for the new bit rate on the next GT1724
+ The relock timer for the ED lanes starts when every GT1724 has been
+ set up.
+ \param done  Set to true when every GT1724 has been set up
+ \return globals::OK
+ \return [error code]  Error setting up the PG
+*/
+int FrequencySweep::stepConfig(bool *done)
+{
+    if (deviceIndex == 0) laneStates.clear();
+    GT1724 *gt1724 = gt1724Set->at(deviceIndex);
+    int result = gt1724->configPG(pgPattern, bitRate);
+    if (result != globals::OK) return result;
+    for (int edLane = 0; edLane < 2; edLane++)
+    {
+        laneState_t laneState;
+        laneState.gt1724      = gt1724;
+        laneState.edLane      = edLane;
+        laneState.lane        = gt1724->getLaneOffset() + 1 + (2 * edLane);
+        laneState.state       = LANE_WAIT_LOCK;
+        laneState.lockedReads = 0;
+        laneState.relockMs    = -1;
+        laneState.startMs     = 0;
+        laneState.nextCheckMs = 0;
+        laneState.bits        = 0.0;
+        laneState.errors      = 0.0;
+        laneStates.append(laneState);
+    }
+
+    deviceIndex++;
+    *done = (deviceIndex >= gt1724Set->count());
+    if (*done) stepTimer.start();
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Relock and measure step
+ Reads LOS / LOL for each GT1724 which has lanes waiting for lock. Once
+ no lane on a GT1724 is still waiting, restarts its PRBS checkers (clearing
+ the counters) and starts the measurement on its locked lanes: This is
+ slow, so the call returns after restarting the checkers on one GT1724.
+ Reads the counters for lanes whose measurement has finished, or is due
+ for a confidence check.
+ \param done  Set to true when every lane has finished (or timed out)
+ \return globals::OK
+ \return [error code]  Comms error
+*/
+int FrequencySweep::stepMeasure(bool *done)
+{
+    const qint64 nowMs = stepTimer.elapsed();
+    int result;
+    int i;
+
+    //// Relock: ////////////////////////////////////////////////
+    foreach (GT1724 *gt1724, *gt1724Set)
+    {
+        bool waiting = false;
+        for (i = 0; i < laneStates.count(); i++)
+        {
+            if (laneStates[i].gt1724 == gt1724 && laneStates[i].state == LANE_WAIT_LOCK) waiting = true;
+        }
+        if (waiting)
+        {
+            bool locked[2];
+            result = gt1724->edLockRead(locked);
+            if (result != globals::OK) return result;
+
+            for (i = 0; i < laneStates.count(); i++)
+            {
+                laneState_t *laneState = &laneStates[i];
+                if (laneState->gt1724 != gt1724 || laneState->state != LANE_WAIT_LOCK) continue;
+                if (locked[laneState->edLane]) laneState->lockedReads++;
+                else                           laneState->lockedReads = 0;
+                if (laneState->lockedReads >= LOCK_CONFIRM)
+                {
+                    laneState->relockMs = static_cast<int>(nowMs);
+                    laneState->state    = LANE_LOCKED;
+                    DEBUG_SWEEP("FrequencySweep: Lane " << laneState->lane << " locked after " << nowMs << " ms")
+                }
+                else if (nowMs >= RELOCK_TIMEOUT_MS)
+                {
+                    laneState->state = LANE_DONE;
+                    DEBUG_SWEEP("FrequencySweep: Lane " << laneState->lane << ": No lock")
+                }
+            }
+        }
+
+        // Both lanes on this GT1724 locked or timed out? Restart the checkers
+        // (clears the counters, so the retune isn't counted), and start measuring:
+        bool stillWaiting = false;
+        bool locked = false;
+        for (i = 0; i < laneStates.count(); i++)
+        {
+            if (laneStates[i].gt1724 != gt1724) continue;
+            if (laneStates[i].state == LANE_WAIT_LOCK) stillWaiting = true;
+            if (laneStates[i].state == LANE_LOCKED)    locked = true;
+        }
+        if (stillWaiting || !locked) continue;
+        result = gt1724->edCheckersEnable(edPattern, true);
+        if (result != globals::OK) return result;
+        const qint64 startMs = stepTimer.elapsed();
+        for (i = 0; i < laneStates.count(); i++)
+        {
+            laneState_t *laneState = &laneStates[i];
+            if (laneState->gt1724 != gt1724 || laneState->state != LANE_LOCKED) continue;
+            laneState->startMs     = startMs;
+            laneState->nextCheckMs = startMs + CHECK_MS;
+            laneState->state       = LANE_MEASURE;
+        }
+        // Carry on next time, so a cancel isn't held up by more checker restarts:
+        *done = false;
+        return globals::OK;
+    }
+
+    //// Measure: ///////////////////////////////////////////////
+    *done = true;
+    for (i = 0; i < laneStates.count(); i++)
+    {
+        laneState_t *laneState = &laneStates[i];
+        if (laneState->state == LANE_MEASURE)
+        {
+            const bool timeUp  = (nowMs - laneState->startMs) >= static_cast<qint64>(measureMs);
+            const bool checkDue = (confidence > 0.0) && (nowMs >= laneState->nextCheckMs);
+            if (timeUp || checkDue)
+            {
+                result = laneState->gt1724->edCountGet(laneState->edLane, bitRate, &laneState->bits, &laneState->errors);
+                if (result != globals::OK) return result;
+                laneState->nextCheckMs = nowMs + CHECK_MS;
+                if (timeUp || berDecision(laneState->bits, laneState->errors) != BER_UNDECIDED) laneState->state = LANE_DONE;
+            }
+        }
+        if (laneState->state != LANE_DONE) *done = false;
+    }
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Decide whether a measurement is below or above the target BER
+ With n bits and k errors, and an expected count of L = n x targetBER:
+  - BER below target: P(k or fewer errors | L) < 1 - confidence.
+    For k = 0, this is the usual n >= -ln(1 - confidence) / targetBER.
+  - BER above target: P(k or more errors | L) < 1 - confidence.
+ \return BER_BELOW, BER_ABOVE, or BER_UNDECIDED (also for fixed time measurements)
+*/
+int FrequencySweep::berDecision(double bits, double errors) const
+{
+    if (confidence <= 0.0 || bits <= 0.0) return BER_UNDECIDED;
+    const double lambda = bits * targetBER;
+    const double alpha = 1.0 - confidence;
+    if (globals::poissonCdf(errors, lambda) < alpha) return BER_BELOW;
+    if (errors > 0.0 && (1.0 - globals::poissonCdf(errors - 1.0, lambda)) < alpha) return BER_ABOVE;
+    return BER_UNDECIDED;
+}
+
+
+
+/*!
+ \brief Send the results for the current step (FreqSweepResult)
+*/
+void FrequencySweep::resultSend()
+{
+    QVector<int> lanes;
+    QVector<int> relockMs;
+    QVector<double> bits;
+    QVector<double> errors;
+    foreach (laneState_t laneState, laneStates)
+    {
+        lanes.append(laneState.lane);
+        relockMs.append(laneState.relockMs);
+        bits.append(laneState.bits);
+        errors.append(laneState.errors);
+    }
+    const int profileIndex = (frequencies.isEmpty()) ? profiles.at(stepIndex) : -1;
+    emit FreqSweepResult(stepIndex, profileIndex, frequency, lockTimeMs, lanes, relockMs, bits, errors);
+}
+
+
+
+/*!
+ \brief Set the service timer for the next thing due
+ Polls at POLL_MS while any lane is waiting for lock. Otherwise, waits
+ until the next measurement ends or the next confidence check.
+*/
+void FrequencySweep::schedule()
+{
+    if (sweepState != SWEEP_MEASURE)
+    {
+        serviceTimer->start(0);
+        return;
+    }
+    const qint64 nowMs = stepTimer.elapsed();
+    qint64 dueMs = -1;
+    foreach (laneState_t laneState, laneStates)
+    {
+        qint64 laneDueMs = -1;
+        if (laneState.state == LANE_WAIT_LOCK)
+        {
+            laneDueMs = nowMs + POLL_MS;
+        }
+        else if (laneState.state == LANE_LOCKED)
+        {
+            laneDueMs = nowMs;  // Checkers not restarted yet (see stepMeasure)
+        }
+        else if (laneState.state == LANE_MEASURE)
+        {
+            laneDueMs = laneState.startMs + static_cast<qint64>(measureMs);
+            if (confidence > 0.0) laneDueMs = qMin(laneDueMs, laneState.nextCheckMs);
+        }
+        if (laneDueMs >= 0 && (dueMs < 0 || laneDueMs < dueMs)) dueMs = laneDueMs;
+    }
+    serviceTimer->start(static_cast<int>(qMax(dueMs - nowMs, static_cast<qint64>(0))));
+}
+
+
+
+/*!
+ \brief End the sweep: Stop the PRBS checkers and send FreqSweepFinished
+ \param result  Result to send
+*/
+void FrequencySweep::finish(int result)
+{
+    serviceTimer->stop();
+    sweepState = SWEEP_IDLE;
+    checkersEnable(false);
+    DEBUG_SWEEP("FrequencySweep: Finished after " << stepIndex << " steps (" << result << ")")
+    emit FreqSweepFinished(result, stepIndex);
+}
+
+
+
+/*!
+ \brief Start or stop the PRBS checkers on all GT1724s
+ \param enable  true to start (counts are reset), false to stop
+ \return globals::OK
+ \return [error code]  Error from GT1724::edCheckersEnable
+*/
+int FrequencySweep::checkersEnable(bool enable)
+{
+    int result = globals::OK;
+    foreach (GT1724 *gt1724, *gt1724Set)
+    {
+        int resultChip = gt1724->edCheckersEnable(edPattern, enable);
+        if (result == globals::OK) result = resultChip;
+    }
+    return result;
+}
@@ -0,0 +1,171 @@
+/*!
+ \file   FrequencySweep.h
+ \brief  Frequency Sweep Engine - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef FREQUENCYSWEEP_H
+#define FREQUENCYSWEEP_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "globals.h"
+#include "GT1724.h"
+#include "LMX2594.h"
+
+
+/*!
+ \brief Frequency Sweep Engine
+ Steps the LMX clocks through a list of frequency profiles, or of any
+ frequencies (register settings planned by LMX2594::selectFrequency), and
+ measures the BER on every ED lane at each rate. Runs on the worker thread, driven
+ by a timer, so other signals (e.g. cancel) are still handled during a
+ sweep. See BertWorker::FreqSweepStart.
+
+ For each rate:
+  1) Retune: Select the profile or frequency on each LMX (only the changed
+     registers are written, and FCAL waits for lock detect; see
+     LMX2594::selectProfile),
+     then configure the PG on each GT1724 for the new bit rate. One device
+     is set up per timer call, so a cancel is handled between them.
+  2) Relock: LOS / LOL are read directly (one register read per GT1724)
+     every POLL_MS, until each ED lane has signal and CDR lock for
+     LOCK_CONFIRM reads in a row.
+  3) Measure: Once both ED lanes on a GT1724 have locked (or timed out),
+     its PRBS checkers are restarted (GT1724::setEDOptions), which clears
+     the counters, and the measurement starts on its locked lanes. So the
+     errors caused by the retune aren't counted, and each result is read
+     straight from the counters rather than as the difference of two
+     large readings (the counters are floating point, with a 10 bit
+     mantissa). Restarting the checkers takes up to 2 s for PRBS31, so
+     they are restarted on one GT1724 per timer call. The bus is left
+     idle between reads.
+
+ A lane's measurement ends after measureSeconds or, if a confidence level
+ is set, as soon as the BER is known to be below or above targetBER with
+ that confidence (Poisson statistics). Lanes which don't lock within
+ RELOCK_TIMEOUT_MS are reported as not locked.
+
+ The ED controls (GT1724::SetEDOptions) shouldn't be used during a sweep.
+*/
+class FrequencySweep : public QObject
+{
+    Q_OBJECT
+
+public:
+    FrequencySweep(QList<LMX2594 *> *lmxClockSet, QList<GT1724 *> *gt1724Set);
+    ~FrequencySweep();
+
+    int start(const QVector<int> &profiles,
+              int pgPattern,             // Index into GT1724::PG_PATTERN_LIST
+              int edPattern,             // Index into GT1724::ED_PATTERN_LIST
+              double measureSeconds,     // Measurement time for each rate (maximum time if confidence > 0)
+              double targetBER,          // BER limit for confidence-bounded measurements
+              double confidence);        // Confidence level (0 < confidence < 1), or 0 for fixed time measurements
+
+    int startFrequencies(const QVector<double> &frequencies,   // Clock frequencies (MHz)
+                         int pgPattern,
+                         int edPattern,
+                         double measureSeconds,
+                         double targetBER,
+                         double confidence);
+
+    int profilesInRange(double frequencyMin, double frequencyMax, QVector<int> *profiles) const;
+
+    static int frequencySteps(double frequencyFrom,
+                              double frequencyTo,
+                              double frequencyStep,            // Step size (MHz; > 0)
+                              QVector<double> *frequencies);
+
+    static const int FREQUENCY_STEPS_MAX = 1000;  // Most frequencies in one sweep (see frequencySteps)
+
+    void cancel();
+    bool active() const { return sweepState != SWEEP_IDLE; }
+
+signals:
+    // One row per rate (profileIndex is -1 for planned frequencies). For each ED lane: relockMs is
+    // the time from the end of the retune to CDR lock (-1 if the lane didn't lock; bits and errors will be 0):
+    void FreqSweepResult(int step, int profileIndex, double frequency, int lockTimeMs,
+                         QVector<int> lanes, QVector<int> relockMs, QVector<double> bits, QVector<double> errors);
+    void FreqSweepFinished(int result, int steps);
+
+private slots:
+    void service();
+
+private:
+    static const int POLL_MS            = 10;    // LOS / LOL poll interval while waiting for lock
+    static const int LOCK_CONFIRM       = 3;     // Consecutive locked reads needed
+    static const int RELOCK_TIMEOUT_MS  = 3000;  // Give up waiting for CDR lock after this long
+    static const int CHECK_MS           = 250;   // Counter read interval for confidence-bounded measurements
+
+    // Sweep state:
+    static const int SWEEP_IDLE    = 0;
+    static const int SWEEP_RETUNE  = 1;   // Selecting the profile on each LMX in turn
+    static const int SWEEP_CONFIG  = 2;   // Configuring the PG on each GT1724 in turn
+    static const int SWEEP_MEASURE = 3;
+
+    // ED lane state within a step:
+    static const int LANE_WAIT_LOCK = 0;
+    static const int LANE_LOCKED    = 1;   // Locked; waiting for the other lane on the GT1724 before the checkers restart
+    static const int LANE_MEASURE   = 2;
+    static const int LANE_DONE      = 3;
+
+    // Result of a confidence-bounded measurement:
+    static const int BER_UNDECIDED = 0;
+    static const int BER_BELOW     = 1;
+    static const int BER_ABOVE     = 2;
+
+    typedef struct laneState_t
+    {
+        GT1724 *gt1724;
+        int     edLane;           // ED lane on the GT1724 (0 or 1)
+        int     lane;             // ED input lane number (1, 3, 5, ...)
+        int     state;            // LANE_xxx
+        int     lockedReads;      // Consecutive locked reads
+        int     relockMs;         // Time from the end of the retune to lock (-1 if not locked)
+        qint64  startMs;          // Time the measurement started (checkers restarted)
+        qint64  nextCheckMs;      // Next counter read (confidence-bounded measurements)
+        double  bits;             // Counts for this measurement so far
+        double  errors;           //
+    } laneState_t;
+
+    QList<LMX2594 *> *lmxClockSet;
+    QList<GT1724 *>  *gt1724Set;
+    QTimer *serviceTimer;
+
+    int    sweepState = SWEEP_IDLE;
+    QVector<int> profiles;            // Profiles to step through (empty if stepping through frequencies)
+    QVector<double> frequencies;      // Frequencies to step through (MHz; empty if stepping through profiles)
+    int    stepIndex = 0;
+    int    pgPattern = 0;
+    int    edPattern = 0;
+    double measureMs = 0.0;
+    double targetBER = 0.0;
+    double confidence = 0.0;
+    int    deviceIndex = 0;           // LMX or GT1724 to set up next (SWEEP_RETUNE, SWEEP_CONFIG)
+
+    double frequency = 0.0;           // Current step: Clock frequency (MHz)
+    double bitRate = 0.0;             //               Bit rate (bits/sec)
+    int    lockTimeMs = -1;           //               Slowest LMX lock time (-1 if any not locked)
+    QElapsedTimer stepTimer;          //               Started at the end of the retune
+    QList<laneState_t> laneStates;    //               State for each ED lane
+
+    int  startCheck(int pgPattern, int edPattern, double measureSeconds, double targetBER, double confidence) const;
+    void startRun(int pgPattern, int edPattern, double measureSeconds, double targetBER, double confidence);
+    int  stepCount() const { return (frequencies.isEmpty()) ? profiles.count() : frequencies.count(); }
+    int  stepRetune(bool *done);
+    int  stepConfig(bool *done);
+    int  stepMeasure(bool *done);
+    int  berDecision(double bits, double errors) const;
+    void resultSend();
+    void schedule();
+    void finish(int result);
+    int  checkersEnable(bool enable);
+};
+
+#endif // FREQUENCYSWEEP_H
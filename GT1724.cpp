@@ -7,11 +7,13 @@
 */
 
 #include <QThread>
+#include <QTimer>
 #include <QDebug>
 #include <QFile>
 #include <QDir>
 #include <QCoreApplication>
 #include <cmath>
+#include <climits>
 
 #include "EyeMonitor.h"
 
@@ -29,6 +31,9 @@
 // Debug macro for general debug mesages from GT1724
 #define DEBUG_GT1724(MSG) qDebug() << "\t\t" << MSG;
 
+// Leave bits and errors counted during eye scan sweeps out of ED results (see edSweepBegin):
+#define BERT_ED_EXCLUDE_SWEEPS 1
+
 
 
 // Macro: Display a message in the debug log, emit error result, and return, if result code is NOT globals::OK
@@ -59,6 +64,12 @@ GT1724::GT1724(I2CComms *comms, const uint8_t i2cAddress, const uint8_t laneOffs
 
     eyeMonitor01 = new EyeMonitor(this, laneOffset, 1);  // Create eye monitor instances for
     eyeMonitor23 = new EyeMonitor(this, laneOffset, 3);  // each ED input
+
+    eyeDriftTimer = new QTimer(this);
+    eyeDriftTimer->setSingleShot(true);
+    connect(eyeDriftTimer, SIGNAL(timeout()), this, SLOT(eyeDriftService()));
+
+    ScanPlanner::defaultParams(&initCostParams);
 }
 
 
@@ -110,6 +121,7 @@ void GT1724::getOptions()
     emit ListPopulate("listEyeScanCountRes", globals::ALL_LANES, EYESCAN_COUNTRES_LIST, EYESCAN_COUNTRES_DEFAULT);
     emit ListPopulate("listBathtubCountRes", globals::ALL_LANES, EYESCAN_COUNTRES_LIST, EYESCAN_COUNTRES_DEFAULT);
     emit ListPopulate("listBathtubVOffset", globals::ALL_LANES, EYESCAN_VOFF_LIST, EYESCAN_VOFF_DEFAULT);
+    emit ListPopulate("listBathtubHStep", globals::ALL_LANES, EYESCAN_VHSTEP_LIST, 0);  // Full resolution by default
 }
 
 
@@ -126,10 +138,15 @@ int GT1724::init()
     emit ShowMessage(QString("Configuring Instrument (Core %1)...").arg(coreNumber));
     int result;
     Q_ASSERT(comms->portIsOpen());
+    QElapsedTimer seqTimer;  // Cost of each init sequence, for estimates (see initSequenceRecord)
+    quint64 seqOps;
 
     // Check whether the extension macros have been loaded yet:
     qDebug() << "GT1724: Checking Macro Version...";
+    seqTimer.start();
+    seqOps = comms->getOpCount();
     result = macroCheck(laneOffset);
+    initSequenceRecord(ScanPlanner::SEQ_MACRO_CHECK, seqTimer, seqOps);
     qDebug() << "GT1724: Macro Check Result: " << result;
     if (result == globals::MACRO_ERROR)
     {
@@ -169,22 +186,42 @@ int GT1724::init()
     // Cold Boot: Set default settings:
     emit ShowMessage(QString("Configuring Instrument (Core %1)...").arg(coreNumber));
     qDebug() << "GT1724: Cold Boot. Setting defaults for GT1724 at lane " << laneOffset;
+    seqTimer.start();
+    seqOps = comms->getOpCount();
     configSetDefaults(25e9);  // Nb: Bitrate shouldn't matter here because CDR Bypass defaults to OFF.
+    initSequenceRecord(ScanPlanner::SEQ_SET_DEFAULTS, seqTimer, seqOps);
 
   WarmBoot:
 
     // Get current instrument config, and send the info to clients:
     int pattern;
+    seqTimer.start();
+    seqOps = comms->getOpCount();
     getCurrentSettings(&pattern);
+    initSequenceRecord(ScanPlanner::SEQ_GET_SETTINGS, seqTimer, seqOps);
 
     // Force reconfigure of PG to make sure it's synced OK.
     qDebug() << "GT1724: Force resync of GT1724 at lane " << laneOffset;
+    seqTimer.start();
+    seqOps = comms->getOpCount();
     configPG(pattern, 25e9);   // Don't actually know bit rate here! Shouldn't matter because CDR Bypass should default to OFF.
+    initSequenceRecord(ScanPlanner::SEQ_CONFIG_PG, seqTimer, seqOps);
 
     return globals::OK;
 }
 
 
+// Record the transactions and time used by one part of init, for
+// CommsCostEstimate (see ScanPlanner::sequenceRecord):
+void GT1724::initSequenceRecord(int sequence, const QElapsedTimer &timer, quint64 opsStart)
+{
+    initCostParams.opLatencyMs = comms->getOpLatency();
+    ScanPlanner::sequenceRecord(&initCostParams, sequence,
+                                static_cast<int>(comms->getOpCount() - opsStart),
+                                static_cast<double>(timer.elapsed()));
+}
+
+
 
 /*!
  \brief Get Current Settings
@@ -1493,34 +1530,38 @@ void GT1724::SetEDOptions(int metaLane,
                               (int)pattern23, inv23, ena23);
 
     // If starting the ED, Reset the bit and error counts, and run timer:
-    if (ena01)
-    {
-        ed01.bitsTotal = 0.0;
-        ed01.errorsTotal = 0.0;
-        ed01.lastMeasureTimeMs = 0;
-        ed01.edRunTime->start();
-        ed01.edRunning = true;
-    }
-    else
-    {
-        ed01.edRunning = false;
-    }
-    if (ena23)
-    {
-        ed23.bitsTotal = 0.0;
-        ed23.errorsTotal = 0.0;
-        ed23.lastMeasureTimeMs = 0;
-        ed23.edRunTime->start();
-        ed23.edRunning = true;
-    }
-    else
-    {
-        ed23.edRunning = false;
-    }
+    edCountersStart(&ed01, enable01);
+    edCountersStart(&ed23, enable23);
     emit Result(result, laneOffset);
     if (result != globals::OK) emit ShowMessage("Error setting ED options.");
 }
 
+/*!
+ \brief Reset the ED counters for an ED lane
+ Called when the PRBS checker is enabled or disabled (see setEDOptions).
+ \param ed       ED parameters for the lane
+ \param enable   true if the checker has just been enabled: Counts and run timer are reset.
+                 false if disabled: The lane is marked as not running.
+*/
+void GT1724::edCountersStart(edParameters_t *ed, bool enable)
+{
+    if (!enable)
+    {
+        ed->edRunning = false;
+        return;
+    }
+    ed->bitsTotal = 0.0;
+    ed->errorsTotal = 0.0;
+    ed->lastMeasureTimeMs = 0;
+    ed->rawBits = 0.0;
+    ed->rawErrors = 0.0;
+    ed->bitsExcluded = 0.0;
+    ed->errorsExcluded = 0.0;
+    ed->edRunTime->start();
+    ed->edRunning = true;
+}
+
+
 /*!
  \brief Get Current ED Option Setting
  Calls the Query PRBS Checker Macro
@@ -1670,6 +1711,56 @@ void GT1724::GetEDCount(int lane, double bitRate)
         return;
     }
 
+    ed->bitRate = bitRate;  // Kept for ED snapshots taken during eye scans (see edSweepBegin)
+    int result = edCountRead(edLane, ed, bitRate);
+    if (result != globals::OK)
+    {
+        DEBUG_GT1724("GT1724: GetEDCount: Error reading bit / error counter for lane " << lane << " (" << result << ")")
+        emit ShowMessage("Error reading bit / error counts.");
+        return;
+    }
+
+    // Counts accumulated while this lane was being swept by the eye scanner
+    // are left out (see edSweepEnd):
+    double currentBits   = ed->rawBits - ed->bitsExcluded;
+    double currentErrors = ed->rawErrors - ed->errorsExcluded;
+
+    // Calculate CHANGE in bit and error counts: this reading - last reading:
+    double deltaBits, deltaErrors;
+    deltaBits   = currentBits - ed->bitsTotal;
+    deltaErrors = currentErrors - ed->errorsTotal;
+    if (deltaBits < 0) deltaBits = 0;      // ?? Sanity check
+    if (deltaErrors < 0) deltaErrors = 0;  //
+
+    // UPDATE the running bit and error counters with the new values:
+    ed->bitsTotal = currentBits;
+    ed->errorsTotal = currentErrors;
+
+    // Emit an ED Count signal with the results:
+    emit EDCount(lane, true, deltaBits, currentBits, deltaErrors, currentErrors);
+}
+
+
+/*!
+ \brief Read the ED counters for an ED lane
+ Updates the raw (uncompensated) bit and error totals in ed.
+
+ Bit Count Estimation System:
+ The GT1724 part doesn't ACTUALLY count bits; it just estimates the bit count
+ based on elapsed time, assuming a constant bit rate (around 25.78Gb/s).
+ We can do better: We estimate the bit rate ourselves, using time and also
+ the ACTUAL bit rate (known from clock input).
+ If BERT_REAL_BIT_COUNT is defined, use the GT1724 bit count instead.
+ Nb: Couters return the TOTAL since the ED was started!
+
+ \param edLane   ED lane (0 or 1)
+ \param ed       ED parameters for the lane
+ \param bitRate  Bit rate (used to estimate bit count)
+ \return globals::OK    Counters read
+ \return [Error Code]   Error from getEDCount
+*/
+int GT1724::edCountRead(int edLane, edParameters_t *ed, double bitRate)
+{
     // Calculate emapsed time since last measurement on this channel:
     // Note: "edRunTime->elapsed()" returns the number of milliseconds
     // since edRunTime timer started; BUT it wraps back to 0 every 24 hours
@@ -1687,51 +1778,86 @@ void GT1724::GetEDCount(int lane, double bitRate)
     }
     ed->lastMeasureTimeMs = elapsedNow;
 
-    double currentBits = 0.0;
     double currentErrors = 0.0;
-
-    /* Bit Count Estimation System:
-     * The GT1724 part doesn't ACTUALLY count bits; it just estimates the bit count
-     * based on elapsed time, assuming a constant bit rate (around 25.78Gb/s).
-     * We can do better: We estimate the bit rate ourselves, using time and also
-     * the ACTUAL bit rate (known from clock input).
-     * If BERT_REAL_BIT_COUNT is defined, use the GT1724 bit count instead.
-     * Nb: Couters return the TOTAL since the ED was started!
-     */
+    int result;
 #ifdef BERT_REAL_BIT_COUNT
+    double currentBits = 0.0;
     // Get error count and bit count from GT1724 macro:
     result = getEDCount(edLane, &currentBits, &currentErrors);
+    if (result != globals::OK) return result;
     // Multiply the error and bit counts by 2, since ED only checks every OTHER bit.
-    currentBits *= 2.0;
-    currentErrors *= 2.0;
+    ed->rawBits   = currentBits * 2.0;
+    ed->rawErrors = currentErrors * 2.0;
 #else
-    int result = getEDCount(edLane, NULL, &currentErrors);
+    result = getEDCount(edLane, NULL, &currentErrors);
+    if (result != globals::OK) return result;
     // Multiply the error count by 2, since ED only checks every OTHER bit.
-    currentErrors *= 2.0;
+    ed->rawErrors = currentErrors * 2.0;
     // Estimate bit count from run time and bit rate instead.
-    currentBits = ed->bitsTotal + ( ( (double)timeDiffMs * bitRate ) / 1000 );
+    ed->rawBits += ( (double)timeDiffMs * bitRate ) / 1000;
 #endif
+    return globals::OK;
+}
+
+
+/*!
+ \brief ED snapshot before an eye scan sweep on an ED lane
+ Called by eyeScanService before each eye scan step which sweeps the eye
+ (see EyeMonitor::scanSweepNext). If the ED is running on the lane, the
+ counters are read and sent (EDCount) so the ED readings run right up to
+ the start of the sweep.
+
+ Side effects of eye scanning on the ED counters:
+ The Control Eye Sweep macro moves the sampling phase and offset of the
+ lane being scanned across the whole eye, so while a sweep runs the PRBS
+ checker on that lane can count errors caused by the scan, not the link.
+ With BERT_ED_EXCLUDE_SWEEPS defined, the bits and errors counted during
+ each sweep are read back afterwards (edSweepEnd) and left out of all
+ later ED results for the lane: the BER is measured over the time between
+ sweeps only. Sweeps on the other ED lane don't affect this lane.
+
+ Sweeps are split into parts which are short enough that the time between
+ ED readings stays under EYESCAN_STEP_MS_MAX plus the ED read time (see
+ EyeMonitor::scanStepSetup and ScanPlanner::sweepLinesMax).
+
+ \param edLane  ED lane (0 or 1)
+ \return true   Snapshot taken; call edSweepEnd after the sweep
+ \return false  ED not running or not locked on this lane
+*/
+bool GT1724::edSweepBegin(int edLane)
+{
+    edParameters_t *ed = (edLane == 0) ? &ed01 : &ed23;
+    if (!ed->edRunning || ed->los || ed->lol) return false;
+    GetEDCount(laneOffset + 1 + (2 * edLane), ed->bitRate);
+    return true;
+}
+
 
+/*!
+ \brief ED snapshot after an eye scan sweep on an ED lane
+ See edSweepBegin.
+ \param edLane  ED lane (0 or 1)
+*/
+void GT1724::edSweepEnd(int edLane)
+{
+#ifdef BERT_ED_EXCLUDE_SWEEPS
+    edParameters_t *ed = (edLane == 0) ? &ed01 : &ed23;
+    if (!ed->edRunning) return;
+    const double bitsBefore   = ed->rawBits;
+    const double errorsBefore = ed->rawErrors;
+    int result = edCountRead(edLane, ed, ed->bitRate);
     if (result != globals::OK)
     {
-        DEBUG_GT1724("GT1724: GetEDCount: Error reading bit / error counter for lane " << lane << " (" << result << ")")
-        emit ShowMessage("Error reading bit / error counts.");
+        DEBUG_GT1724("GT1724: Error reading ED counters after eye scan sweep for ED lane " << edLane << " (" << result << ")")
         return;
     }
-
-    // Calculate CHANGE in bit and error counts: this reading - last reading:
-    double deltaBits, deltaErrors;
-    deltaBits   = currentBits - ed->bitsTotal;
-    deltaErrors = currentErrors - ed->errorsTotal;
-    if (deltaBits < 0) deltaBits = 0;      // ?? Sanity check
-    if (deltaErrors < 0) deltaErrors = 0;  //
-
-    // UPDATE the running bit and error counters with the new values:
-    ed->bitsTotal = currentBits;
-    ed->errorsTotal = currentErrors;
-
-    // Emit an ED Count signal with the results:
-    emit EDCount(lane, true, deltaBits, currentBits, deltaErrors, currentErrors);
+    ed->bitsExcluded   += (ed->rawBits - bitsBefore);
+    ed->errorsExcluded += (ed->rawErrors - errorsBefore);
+    DEBUG_GT1724("GT1724: ED lane " << edLane << ": Excluded counts during eye scan sweep: Bits: "
+                 << (ed->rawBits - bitsBefore) << "; Errors: " << (ed->rawErrors - errorsBefore))
+#else
+    Q_UNUSED(edLane)
+#endif
 }
 
 
@@ -1874,6 +2000,75 @@ void GT1724::GetLosLol(int metaLane)
 }
 
 
+/*!
+ \brief Check whether the PRBS checkers are in use
+ \return true if the ED is running, or an eye scan is active, on either ED lane
+*/
+bool GT1724::edInUse() const
+{
+    return edAnyRunning() || eyeMonitor01->scanActive() || eyeMonitor23->scanActive();
+}
+
+/*!
+ \brief Read signal and CDR lock for both ED lanes
+ Updates the LOS / LOL flags for each ED lane, like GetLosLol, but
+ doesn't emit EDLosLol.
+ \param locked  Set to true for each ED lane (0 or 1) with signal and CDR lock
+ \return globals::OK
+ \return [Error Code]  Error from getLosLol
+*/
+int GT1724::edLockRead(bool locked[2])
+{
+    uint8_t los[4];
+    uint8_t lol[4];
+    int result = getLosLol(los, lol);
+    if (result != globals::OK) return result;
+    ed01.los = (los[1] != 0);  ed01.lol = (lol[1] != 0);
+    ed23.los = (los[3] != 0);  ed23.lol = (lol[3] != 0);
+    locked[0] = (!ed01.los && !ed01.lol);
+    locked[1] = (!ed23.los && !ed23.lol);
+    return globals::OK;
+}
+
+/*!
+ \brief Start (or restart) or stop both PRBS checkers
+ As SetEDOptions, with the same pattern (not inverted) on both ED lanes.
+ Nb: Takes up to 2 seconds for PRBS31 (see setEDOptions).
+ \param pattern  Index into ED_PATTERN_LIST
+ \param enable   true to start (counts are reset), false to stop
+ \return globals::OK
+ \return [Error Code]  Error from setEDOptions
+*/
+int GT1724::edCheckersEnable(int pattern, bool enable)
+{
+    const int enableBit = (enable) ? 1 : 0;
+    int result = setEDOptions(pattern, 0, enableBit, pattern, 0, enableBit);
+    edCountersStart(&ed01, enable && result == globals::OK);
+    edCountersStart(&ed23, enable && result == globals::OK);
+    return result;
+}
+
+/*!
+ \brief Read the raw ED counts for an ED lane
+ \param edLane   ED lane (0 or 1)
+ \param bitRate  Bit rate (used to estimate the bit count; see edCountRead)
+ \param bits     Set to the bit count since the checker was started
+ \param errors   Set to the error count since the checker was started
+ \return globals::OK
+ \return [Error Code]  Error from edCountRead
+*/
+int GT1724::edCountGet(int edLane, double bitRate, double *bits, double *errors)
+{
+    edParameters_t *ed = (edLane == 0) ? &ed01 : &ed23;
+    ed->bitRate = bitRate;
+    int result = edCountRead(edLane, ed, bitRate);
+    if (result != globals::OK) return result;
+    *bits   = ed->rawBits;
+    *errors = ed->rawErrors;
+    return globals::OK;
+}
+
+
 
 
 
@@ -2457,8 +2652,13 @@ void GT1724::EyeScanStart(int lane, int type, int hStep, int vStep, int vOffset,
     EyeMonitor *em;
     if (modLane == 1) em = eyeMonitor01;
     else              em = eyeMonitor23;
+    if (em->scanActive() && !em->eyeScanActive())
+    {
+        emit EyeScanError(lane, type, globals::BUSY_ERROR);
+        return;
+    }
 
-    em->startScan(type, hStep, vStep, vOffset, countRes);
+    if (em->startScan(type, hStep, vStep, vOffset, countRes) == globals::OK) eyeScanSchedule();
 }
 
 void GT1724::EyeScanRepeat(int lane)
@@ -2468,8 +2668,13 @@ void GT1724::EyeScanRepeat(int lane)
     int modLane = LANE_MOD(lane);
     Q_ASSERT(modLane == 1 || modLane == 3);
     if (modLane != 1 && modLane != 3) return;  // Invalid lane.
-    if (modLane == 1) eyeMonitor01->repeatScan();
-    else              eyeMonitor23->repeatScan();
+    EyeMonitor *em = (modLane == 1) ? eyeMonitor01 : eyeMonitor23;
+    if (em->scanActive() && !em->eyeScanActive())
+    {
+        emit EyeScanError(lane, GT1724_EYE_SCAN, globals::BUSY_ERROR);
+        return;
+    }
+    if (em->repeatScan() == globals::OK) eyeScanSchedule();
 }
 
 void GT1724::EyeScanCancel(int lane)
@@ -2493,16 +2698,379 @@ void GT1724::EyeScanCancel(int lane)
     }
 }
 
+void GT1724::EyeContourStart(int lane, int hStep, int countRes, double targetBER, int boundaryRepeats)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye Contour START request for lane " << lane)
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    EyeMonitor *em = (modLane == 1) ? eyeMonitor01 : eyeMonitor23;
+    if (em->scanActive())
+    {
+        emit EyeScanError(lane, GT1724_CONTOUR_SCAN, globals::BUSY_ERROR);
+        return;
+    }
+    if (em->startContourScan(hStep, countRes, targetBER, boundaryRepeats) == globals::OK) eyeScanSchedule();
+}
+
+/*!
+ \brief Start an eye mask test
+ If lane is ALL_LANES (or the first lane of this chip), both ED lanes are
+ tested. The tests run as eye monitor state machines, like eye scans (see
+ eyeScanService), so tests on both lanes run together, one window at a
+ time, and the worker returns to its event loop between windows (see
+ EyeMonitor::startMaskTest).
+*/
+void GT1724::EyeMaskTestStart(int lane, int hStep, QVector<double> maskPoints, QVector<int> maskPolygonSizes, double targetBER, double confidence)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye Mask Test START request for lane " << lane)
+    QList<EyeMonitor *> monitors;
+    int modLane = LANE_MOD(lane);
+    if (modLane == 0 || modLane == 1) monitors.append(eyeMonitor01);
+    if (modLane == 0 || modLane == 3) monitors.append(eyeMonitor23);
+    if (monitors.isEmpty())
+    {
+        emit EyeScanError(lane, GT1724_MASK_TEST, globals::BAD_LANE_ID);  // Not an ED lane
+        return;
+    }
+    foreach (EyeMonitor *monitor, monitors)
+    {
+        if (monitor->scanActive())
+        {
+            emit EyeScanError(lane, GT1724_MASK_TEST, globals::BUSY_ERROR);
+            return;
+        }
+    }
+    bool started = false;
+    foreach (EyeMonitor *monitor, monitors)
+    {
+        if (monitor->startMaskTest(hStep, maskPoints, maskPolygonSizes, targetBER, confidence) == globals::OK) started = true;
+    }
+    if (started) eyeScanSchedule();
+}
+
+void GT1724::EyeROIScanStart(int lane, int phaseStart, int phaseStop, int phaseStep, int offsetStart, int offsetStop, int offsetStep, int countRes)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye ROI Scan START request for lane " << lane)
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    EyeMonitor *em = (modLane == 1) ? eyeMonitor01 : eyeMonitor23;
+    if (em->scanActive())
+    {
+        emit EyeScanError(lane, GT1724_ROI_SCAN, globals::BUSY_ERROR);
+        return;
+    }
+    if (em->startROIScan(phaseStart, phaseStop, phaseStep, offsetStart, offsetStop, offsetStep, countRes) == globals::OK) eyeScanSchedule();
+}
+
+void GT1724::EyeBathtubStart(int lane, int hStep, QVector<int> vOffsets, int countRes, bool useEyeData)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye Bathtub START request for lane " << lane)
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    EyeMonitor *em = (modLane == 1) ? eyeMonitor01 : eyeMonitor23;
+    if (em->scanActive())
+    {
+        emit EyeScanError(lane, GT1724_BATHTUB_SCAN, globals::BUSY_ERROR);
+        return;
+    }
+    if (em->startBathtubScan(hStep, vOffsets, countRes, useEyeData) == globals::OK) eyeScanSchedule();
+}
+
+void GT1724::EyeBathtubFitOptions(int lane, QVector<double> targetBERs, double fitBERMax, double tolerance)
+{
+    if (lane == globals::ALL_LANES || LANE_MOD(lane) == 0)
+    {
+        eyeMonitor01->setBathtubFitOptions(targetBERs, fitBERMax, tolerance);
+        eyeMonitor23->setBathtubFitOptions(targetBERs, fitBERMax, tolerance);
+    }
+    else
+    {
+        LANE_FILTER(lane);
+        int modLane = LANE_MOD(lane);
+        Q_ASSERT(modLane == 1 || modLane == 3);
+        if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+        if (modLane == 1) eyeMonitor01->setBathtubFitOptions(targetBERs, fitBERMax, tolerance);
+        else              eyeMonitor23->setBathtubFitOptions(targetBERs, fitBERMax, tolerance);
+    }
+}
+
+void GT1724::EyeScanAutoStopOptions(int lane, bool enabled, double tolerance, double floorBER, double metricBER)
+{
+    if (lane == globals::ALL_LANES || LANE_MOD(lane) == 0)
+    {
+        eyeMonitor01->setAutoStopOptions(enabled, tolerance, floorBER, metricBER);
+        eyeMonitor23->setAutoStopOptions(enabled, tolerance, floorBER, metricBER);
+    }
+    else
+    {
+        LANE_FILTER(lane);
+        int modLane = LANE_MOD(lane);
+        Q_ASSERT(modLane == 1 || modLane == 3);
+        if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+        if (modLane == 1) eyeMonitor01->setAutoStopOptions(enabled, tolerance, floorBER, metricBER);
+        else              eyeMonitor23->setAutoStopOptions(enabled, tolerance, floorBER, metricBER);
+    }
+}
+
+void GT1724::EyeMetricsOptions(int lane, QVector<double> thresholds)
+{
+    if (lane == globals::ALL_LANES || LANE_MOD(lane) == 0)
+    {
+        eyeMonitor01->setMetricsThresholds(thresholds);
+        eyeMonitor23->setMetricsThresholds(thresholds);
+    }
+    else
+    {
+        LANE_FILTER(lane);
+        int modLane = LANE_MOD(lane);
+        Q_ASSERT(modLane == 1 || modLane == 3);
+        if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+        if (modLane == 1) eyeMonitor01->setMetricsThresholds(thresholds);
+        else              eyeMonitor23->setMetricsThresholds(thresholds);
+    }
+}
+
+void GT1724::EyeArchiveSave(int lane, QString fileName, QString serial)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye Archive SAVE request for lane " << lane)
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    if (modLane == 1) eyeMonitor01->archiveSave(fileName, serial);
+    else              eyeMonitor23->archiveSave(fileName, serial);
+}
+
+void GT1724::EyeArchiveCompare(int lane, QString goldenFileName, double toleranceDecades)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye Archive COMPARE request for lane " << lane)
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    if (modLane == 1) eyeMonitor01->archiveCompare(goldenFileName, toleranceDecades);
+    else              eyeMonitor23->archiveCompare(goldenFileName, toleranceDecades);
+}
+
+/*!
+ \brief Start the eye drift monitor (see EyeMonitor::driftStart)
+ If lane is ALL_LANES (or the first lane of this chip), both ED lanes are
+ monitored, and each gets half of the duty cycle, so the total bus time
+ used by snapshots stays within dutyCycle. Starting again on a lane which
+ is already monitored sets a new baseline.
+*/
+void GT1724::EyeDriftStart(int lane, int hStep, int countRes, double targetBER, double threshold, double dutyCycle)
+{
+    LANE_FILTER(lane);
+    DEBUG_GT1724("GT1724: (" << this << ") Eye Drift Monitor START request for lane " << lane)
+    int modLane = LANE_MOD(lane);
+    if (modLane == 0)
+    {
+        eyeMonitor01->driftStart(hStep, countRes, targetBER, threshold, dutyCycle / 2.0);
+        eyeMonitor23->driftStart(hStep, countRes, targetBER, threshold, dutyCycle / 2.0);
+    }
+    else
+    {
+        Q_ASSERT(modLane == 1 || modLane == 3);
+        if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+        if (modLane == 1) eyeMonitor01->driftStart(hStep, countRes, targetBER, threshold, dutyCycle);
+        else              eyeMonitor23->driftStart(hStep, countRes, targetBER, threshold, dutyCycle);
+    }
+    eyeDriftSchedule();
+}
+
+void GT1724::EyeDriftStop(int lane)
+{
+    if (lane == globals::ALL_LANES || LANE_MOD(lane) == 0)
+    {
+        DEBUG_GT1724("GT1724: (" << this << ") Eye Drift Monitor STOP request for all lanes")
+        eyeMonitor01->driftStop();
+        eyeMonitor23->driftStop();
+    }
+    else
+    {
+        LANE_FILTER(lane);
+        DEBUG_GT1724("GT1724: (" << this << ") Eye Drift Monitor STOP request for lane " << lane)
+        int modLane = LANE_MOD(lane);
+        Q_ASSERT(modLane == 1 || modLane == 3);
+        if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+        if (modLane == 1) eyeMonitor01->driftStop();
+        else              eyeMonitor23->driftStop();
+    }
+    eyeDriftSchedule();
+}
+
+// **** Slots to estimate scan and comms times (see ScanPlanner): *************
+// hStep / vStep / countRes are list indexes, as for EyeScanStart.
+// nChannels is the number of channels which will be scanned at the same time.
+void GT1724::EyeScanEstimate(int lane, int type, int hStep, int vStep, int countRes, int repeatCount, int nChannels)
+{
+    LANE_FILTER(lane);
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    ScanPlanner::eyeScanCost_t cost;
+    int result = ScanPlanner::eyeScanCost(costParamsGet(modLane), type, hStep, vStep, countRes, repeatCount, nChannels, &cost);
+    if (result != globals::OK)
+    {
+        DEBUG_GT1724("GT1724: Eye scan estimate: Bad scan settings for lane " << lane)
+        return;
+    }
+    emit EyeScanEstimated(lane, type, cost.seconds, cost.repeatSeconds, cost.parts, cost.bytesRead, cost.read24Frames);
+}
+
+void GT1724::EyeScanPlan(int lane, int type, double budgetSeconds, int nChannels)
+{
+    LANE_FILTER(lane);
+    int modLane = LANE_MOD(lane);
+    Q_ASSERT(modLane == 1 || modLane == 3);
+    if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+    ScanPlanner::plan_t plan;
+    int result = ScanPlanner::planBudget(costParamsGet(modLane), type, budgetSeconds, nChannels, &plan);
+    emit EyeScanPlanned(lane, type, result, plan.hStepIndex, plan.vStepIndex, plan.countResIndex, plan.repeatCount, plan.cost.seconds);
+}
+
+void GT1724::CommsCostEstimate(int metaLane, int nEDLanes)
+{
+    LANE_FILTER(metaLane);
+    ScanPlanner::costParams_t params = costParamsGet(1);
+    emit CommsCostEstimated(metaLane,
+                            params.opLatencyMs,
+                            ScanPlanner::edPollSeconds(params, nEDLanes),
+                            ScanPlanner::initSeconds(params, false, 0),
+                            ScanPlanner::initSeconds(params, true, macroVersion->lineCount));
+}
+
+// Timings for cost estimates: Sweep times and output memory size measured by
+// the eye monitor for the lane (modLane 1 or 3), and the current I2C op latency:
+ScanPlanner::costParams_t GT1724::costParamsGet(int modLane)
+{
+    ScanPlanner::costParams_t params;
+    if (modLane == 3) params = eyeMonitor23->getCostParams();
+    else              params = eyeMonitor01->getCostParams();
+    params.opLatencyMs = comms->getOpLatency();
+    params.stepMsMax   = edAnyRunning() ? static_cast<double>(EYESCAN_STEP_MS_MAX) : 0.0;
+    for (int i = 0; i < ScanPlanner::SEQ_COUNT; i++)
+    {
+        params.sequenceOps[i]    = initCostParams.sequenceOps[i];
+        params.sequenceWaitMs[i] = initCostParams.sequenceWaitMs[i];
+    }
+    return params;
+}
+
 // ******* Emit signals on behalf of the Eye Scan module: *********
 
 void GT1724::emitEyeScanProgressUpdate(int lane, int type, int percent)                        { emit EyeScanProgressUpdate(lane, type, percent);    }
 void GT1724::emitEyeScanError(int lane, int type, int code)                                    { emit EyeScanError(lane, type, code);                }
-void GT1724::emitEyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes) { emit EyeScanFinished(lane, type, data, xRes, yRes); }
+void GT1724::emitEyeScanFinished(int lane, int type) { emit EyeScanFinished(lane, type); }
+void GT1724::emitEyeContourFinished(int lane, QVector<double> contourPhase, QVector<double> contourOffset, double eyeWidth, double eyeHeight)
+  { emit EyeContourFinished(lane, contourPhase, contourOffset, eyeWidth, eyeHeight); }
+void GT1724::emitEyeMaskTestFinished(int lane, bool pass, int hitCount, double margin, double bitsTested)
+  { emit EyeMaskTestFinished(lane, pass, hitCount, margin, bitsTested); }
+void GT1724::emitEyeROIScanFinished(int lane, QVector<double> data, int xRes, int yRes, int phaseStart, int phaseStep, int offsetStart, int offsetStep, int phaseShift)
+  { emit EyeROIScanFinished(lane, data, xRes, yRes, phaseStart, phaseStep, offsetStart, offsetStep, phaseShift); }
+void GT1724::emitEyeBathtubsFinished(int lane, QVector<int> vOffsets, QVector<double> curves, int xRes)
+  { emit EyeBathtubsFinished(lane, vOffsets, curves, xRes); }
+void GT1724::emitEyeBathtubFitFinished(int lane, QVector<double> targetBERs, QVector<double> openings, double rjRMS, double djDualDirac, double rSquared, bool valid, bool converged)
+  { emit EyeBathtubFitFinished(lane, targetBERs, openings, rjRMS, djDualDirac, rSquared, valid, converged); }
+void GT1724::emitEyeScanAutoStop(int lane, int type, bool stop, double floorBER, double confidence)
+  { emit EyeScanAutoStop(lane, type, stop, floorBER, confidence); }
+void GT1724::emitEyeMetricsFinished(int lane, QVector<double> metrics, QVector<double> contourPoints, QVector<int> contourSizes)
+  { emit EyeMetricsFinished(lane, metrics, contourPoints, contourSizes); }
+void GT1724::emitEyeArchiveSaved(int lane, QString fileName, int result)
+  { emit EyeArchiveSaved(lane, fileName, result); }
+void GT1724::emitEyeArchiveCompareFinished(int lane, int result, QVector<double> delta, int xRes, int yRes, double maxDelta, double rmsDelta, int cellsWorse, int cellsBetter)
+  { emit EyeArchiveCompareFinished(lane, result, delta, xRes, yRes, maxDelta, rmsDelta, cellsWorse, cellsBetter); }
+void GT1724::emitEyeDriftBaseline(int lane, QVector<double> baseline, QVector<double> stdDevs)
+  { emit EyeDriftBaseline(lane, baseline, stdDevs); }
+void GT1724::emitEyeDriftAlarm(int lane, QVector<int> metrics, QVector<double> baseline, QVector<double> current)
+  { emit EyeDriftAlarm(lane, metrics, baseline, current); }
+
+// *** Eye scanner - Queue a call to eyeScanService (if not already queued):
+void GT1724::eyeScanSchedule()
+{
+    if (eyeScanServicePending) return;
+    eyeScanServicePending = true;
+    QTimer::singleShot(0, this, SLOT(eyeScanService()));
+}
 
-// *** Eye scanner - Call 'processEvents' to check for EyeScanCancel signal:
-void GT1724::eyeScanCheckForCancel()
+/*!
+ \brief Run one step of a scan in progress
+ Eye, bathtub, ROI and contour scans and mask tests are state machines
+ (see EyeMonitor::scanStep). This slot advances ONE eye monitor by one step,
+ then queues itself again until all scans are done. If scans are running on both ED lanes, the monitors
+ take turns (so both scans run together), and the worker still returns to
+ its event loop after every step: the time between ED readings stays
+ within one step (EYESCAN_STEP_MS_MAX), rather than one step per monitor.
+ Between steps, other commands, timer updates and EyeScanCancel are
+ handled in order, with no re-entrancy.
+*/
+void GT1724::eyeScanService()
 {
-    QCoreApplication::processEvents();
+    eyeScanServicePending = false;
+    EyeMonitor *monitors[2] = { eyeMonitor01, eyeMonitor23 };
+    for (int i = 0; i < 2; i++)
+    {
+        const int edLane = eyeScanServiceNext;
+        eyeScanServiceNext = 1 - eyeScanServiceNext;
+        if (monitors[edLane]->scanActive())
+        {
+            eyeScanServiceStep(monitors[edLane], edLane);
+            break;
+        }
+    }
+    if (eyeMonitor01->scanActive() || eyeMonitor23->scanActive()) eyeScanSchedule();
+}
+
+// *** Eye scanner - Run one step of a scan, with ED snapshots around sweeps (see edSweepBegin):
+void GT1724::eyeScanServiceStep(EyeMonitor *em, int edLane)
+{
+    bool done;
+    bool edSnapshot = em->scanSweepNext() && edSweepBegin(edLane);
+    em->scanStep(&done);
+    if (edSnapshot) edSweepEnd(edLane);
+}
+
+// *** Eye scanner - Start the drift timer for the next drift snapshot due (or stop it if none):
+void GT1724::eyeDriftSchedule()
+{
+    qint64 wait = -1;
+    qint64 ms;
+    if ((ms = eyeMonitor01->driftMsUntilDue()) >= 0) wait = ms;
+    if ((ms = eyeMonitor23->driftMsUntilDue()) >= 0 && (wait < 0 || ms < wait)) wait = ms;
+    if (wait < 0) eyeDriftTimer->stop();
+    else          eyeDriftTimer->start(static_cast<int>(qMin(wait, static_cast<qint64>(INT_MAX))));
+}
+
+/*!
+ \brief Take each drift monitor snapshot which is due
+ Snapshots wait while any scan is in progress (the scan has the bus).
+ Snapshots have ED snapshots around them like eye scan sweeps (see
+ edSweepBegin).
+*/
+void GT1724::eyeDriftService()
+{
+    if (eyeMonitor01->scanActive() || eyeMonitor23->scanActive())
+    {
+        eyeDriftTimer->start(EYE_DRIFT_RETRY_MS);
+        return;
+    }
+    EyeMonitor *monitors[2] = { eyeMonitor01, eyeMonitor23 };
+    for (int edLane = 0; edLane < 2; edLane++)
+    {
+        if (monitors[edLane]->driftMsUntilDue() != 0) continue;
+        bool edSnapshot = edSweepBegin(edLane);
+        monitors[edLane]->driftStep();
+        if (edSnapshot) edSweepEnd(edLane);
+    }
+    eyeDriftSchedule();
 }
 
 
@@ -2558,7 +3126,8 @@ const QStringList GT1724::ED_EQ_BOOST_LIST =
 
 
 // -- H-Step and V-Step for Eye Scan: -------------
-const QList<int> GT1724::EYESCAN_VHSTEP_LOOKUP = { 1, 2, 4, 8 };
+const QList<int> GT1724::EYESCAN_VHSTEP_LOOKUP = { ScanPlanner::VHSTEP_LOOKUP[0], ScanPlanner::VHSTEP_LOOKUP[1],
+                                                   ScanPlanner::VHSTEP_LOOKUP[2], ScanPlanner::VHSTEP_LOOKUP[3] };
 const QStringList GT1724::EYESCAN_VHSTEP_LIST = { "1", "2", "4", "8" };
 const int GT1724::EYESCAN_VHSTEP_DEFAULT = 1;
 
@@ -14,10 +14,13 @@
 #include <QObject>
 #include <QStringList>
 #include <QTime>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #include "globals.h"
 #include "BertComponent.h"
 #include "I2CComms.h"
+#include "ScanPlanner.h"
 
 class EyeMonitor;
 
@@ -32,8 +35,22 @@ public:
     friend class EyeMonitor;
 
     // Scan types for Eye Monitor:
-    static const int GT1724_EYE_SCAN = 1;
-    static const int GT1724_BATHTUB_SCAN = 2;
+    static const int GT1724_EYE_SCAN = ScanPlanner::EYE_SCAN;
+    static const int GT1724_BATHTUB_SCAN = ScanPlanner::BATHTUB_SCAN;
+    static const int GT1724_CONTOUR_SCAN = 3;
+    static const int GT1724_MASK_TEST = 4;
+    static const int GT1724_ROI_SCAN = 5;
+    static const int GT1724_DRIFT_MONITOR = 6;  // Only used for EyeScanError (see EyeDriftStart)
+
+    // Number of values for each BER threshold in EyeMetricsFinished (see EyeMonitor::metricsRun):
+    static const int EYE_METRICS_VALUES = 8;
+
+    // Voltage offsets (1 - 127) for each item in the bathtub "Offset" list (see EyeBathtubStart):
+    static const QList<int>  EYESCAN_VOFF_LOOKUP;
+
+    // Longest eye scan step (one sweep and read back) while the ED is running, so
+    // ED readings continue during eye scans (mS; see edSweepBegin):
+    static const int EYESCAN_STEP_MS_MAX = 750;
 
     // NOTE: Lanes used by GT1724:
     //
@@ -57,6 +74,16 @@ public:
     void getOptions();
     int init();
 
+    // ED access for the frequency sweep (see FrequencySweep). These don't emit Result:
+    uint8_t getLaneOffset() const { return laneOffset; }
+    static int pgPatternCount() { return PG_PATTERN_LIST.count(); }
+    static int edPatternCount() { return ED_PATTERN_LIST.count(); }
+    bool edInUse() const;
+    int  configPG(int pattern, double bitRate);
+    int  edLockRead(bool locked[2]);
+    int  edCheckersEnable(int pattern, bool enable);
+    int  edCountGet(int edLane, double bitRate, double *bits, double *errors);
+
 #define GT1724_SIGNALS \
     void EDLosLol(int lane, bool los, bool lol);                    \
     void EDCount(int lane,                                          \
@@ -65,7 +92,21 @@ public:
                  double errors, double errorsTotal);                \
     void EyeScanProgressUpdate(int lane, int type, int percent);    \
     void EyeScanError(int lane, int type, int code);                \
-    void EyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes);
+    void EyeScanFinished(int lane, int type); \
+    void EyeContourFinished(int lane, QVector<double> contourPhase, QVector<double> contourOffset, double eyeWidth, double eyeHeight); \
+    void EyeMaskTestFinished(int lane, bool pass, int hitCount, double margin, double bitsTested); \
+    void EyeROIScanFinished(int lane, QVector<double> data, int xRes, int yRes, int phaseStart, int phaseStep, int offsetStart, int offsetStep, int phaseShift); \
+    void EyeBathtubsFinished(int lane, QVector<int> vOffsets, QVector<double> curves, int xRes); \
+    void EyeBathtubFitFinished(int lane, QVector<double> targetBERs, QVector<double> openings, double rjRMS, double djDualDirac, double rSquared, bool valid, bool converged); \
+    void EyeScanAutoStop(int lane, int type, bool stop, double floorBER, double confidence); \
+    void EyeMetricsFinished(int lane, QVector<double> metrics, QVector<double> contourPoints, QVector<int> contourSizes); \
+    void EyeArchiveSaved(int lane, QString fileName, int result); \
+    void EyeArchiveCompareFinished(int lane, int result, QVector<double> delta, int xRes, int yRes, double maxDelta, double rmsDelta, int cellsWorse, int cellsBetter); \
+    void EyeScanEstimated(int lane, int type, double seconds, double repeatSeconds, int parts, int bytesRead, int read24Frames); \
+    void EyeScanPlanned(int lane, int type, int result, int hStep, int vStep, int countRes, int repeatCount, double seconds); \
+    void CommsCostEstimated(int metaLane, double opLatencyMs, double edPollSeconds, double warmInitSeconds, double coldInitSeconds); \
+    void EyeDriftBaseline(int lane, QVector<double> baseline, QVector<double> stdDevs); \
+    void EyeDriftAlarm(int lane, QVector<int> metrics, QVector<double> baseline, QVector<double> current);
 
 #define GT1724_SLOTS \
     void CommsCheck(int metaLane); \
@@ -85,7 +126,21 @@ public:
     void EDErrorInject(int lane); \
     void EyeScanStart(int lane, int type, int hStep, int vStep, int vOffset, int countRes); \
     void EyeScanRepeat(int lane); \
-    void EyeScanCancel(int lane);
+    void EyeScanCancel(int lane); \
+    void EyeContourStart(int lane, int hStep, int countRes, double targetBER, int boundaryRepeats); \
+    void EyeMaskTestStart(int lane, int hStep, QVector<double> maskPoints, QVector<int> maskPolygonSizes, double targetBER, double confidence); \
+    void EyeROIScanStart(int lane, int phaseStart, int phaseStop, int phaseStep, int offsetStart, int offsetStop, int offsetStep, int countRes); \
+    void EyeBathtubStart(int lane, int hStep, QVector<int> vOffsets, int countRes, bool useEyeData); \
+    void EyeBathtubFitOptions(int lane, QVector<double> targetBERs, double fitBERMax, double tolerance); \
+    void EyeScanAutoStopOptions(int lane, bool enabled, double tolerance, double floorBER, double metricBER); \
+    void EyeMetricsOptions(int lane, QVector<double> thresholds); \
+    void EyeArchiveSave(int lane, QString fileName, QString serial); \
+    void EyeArchiveCompare(int lane, QString goldenFileName, double toleranceDecades); \
+    void EyeScanEstimate(int lane, int type, int hStep, int vStep, int countRes, int repeatCount, int nChannels); \
+    void EyeScanPlan(int lane, int type, double budgetSeconds, int nChannels); \
+    void CommsCostEstimate(int metaLane, int nEDLanes); \
+    void EyeDriftStart(int lane, int hStep, int countRes, double targetBER, double threshold, double dutyCycle); \
+    void EyeDriftStop(int lane);
 
 #define GT1724_CONNECT_SIGNALS(CLIENT, GT1724) \
     connect(GT1724, SIGNAL(EDLosLol(int, bool, bool)),         CLIENT, SLOT(EDLosLol(int, bool, bool)));                            \
@@ -94,8 +149,35 @@ public:
     connect(GT1724, SIGNAL(EyeScanProgressUpdate(int, int, int)),                                                                   \
                                                                CLIENT, SLOT(EyeScanProgressUpdate(int, int, int)));                 \
     connect(GT1724, SIGNAL(EyeScanError(int, int, int)),       CLIENT, SLOT(EyeScanError(int, int, int)));                          \
-    connect(GT1724, SIGNAL(EyeScanFinished(int, int, QVector<double>, int, int)),                                                   \
-                                                               CLIENT, SLOT(EyeScanFinished(int, int, QVector<double>, int, int))); \
+    connect(GT1724, SIGNAL(EyeScanFinished(int, int)),         CLIENT, SLOT(EyeScanFinished(int, int)));                            \
+    connect(GT1724, SIGNAL(EyeContourFinished(int, QVector<double>, QVector<double>, double, double)),                              \
+                                                               CLIENT, SLOT(EyeContourFinished(int, QVector<double>, QVector<double>, double, double))); \
+    connect(GT1724, SIGNAL(EyeMaskTestFinished(int, bool, int, double, double)),                                                    \
+                                                               CLIENT, SLOT(EyeMaskTestFinished(int, bool, int, double, double)));  \
+    connect(GT1724, SIGNAL(EyeROIScanFinished(int, QVector<double>, int, int, int, int, int, int, int)),                            \
+                                                               CLIENT, SLOT(EyeROIScanFinished(int, QVector<double>, int, int, int, int, int, int, int))); \
+    connect(GT1724, SIGNAL(EyeBathtubsFinished(int, QVector<int>, QVector<double>, int)),                                          \
+                                                               CLIENT, SLOT(EyeBathtubsFinished(int, QVector<int>, QVector<double>, int))); \
+    connect(GT1724, SIGNAL(EyeBathtubFitFinished(int, QVector<double>, QVector<double>, double, double, double, bool, bool)),       \
+                                                               CLIENT, SLOT(EyeBathtubFitFinished(int, QVector<double>, QVector<double>, double, double, double, bool, bool))); \
+    connect(GT1724, SIGNAL(EyeScanAutoStop(int, int, bool, double, double)),                                                        \
+                                                               CLIENT, SLOT(EyeScanAutoStop(int, int, bool, double, double)));      \
+    connect(GT1724, SIGNAL(EyeMetricsFinished(int, QVector<double>, QVector<double>, QVector<int>)),                                \
+                                                               CLIENT, SLOT(EyeMetricsFinished(int, QVector<double>, QVector<double>, QVector<int>))); \
+    connect(GT1724, SIGNAL(EyeArchiveSaved(int, QString, int)),                                                                     \
+                                                               CLIENT, SLOT(EyeArchiveSaved(int, QString, int)));                   \
+    connect(GT1724, SIGNAL(EyeArchiveCompareFinished(int, int, QVector<double>, int, int, double, double, int, int)),              \
+                                                               CLIENT, SLOT(EyeArchiveCompareFinished(int, int, QVector<double>, int, int, double, double, int, int))); \
+    connect(GT1724, SIGNAL(EyeScanEstimated(int, int, double, double, int, int, int)),                                              \
+                                                               CLIENT, SLOT(EyeScanEstimated(int, int, double, double, int, int, int))); \
+    connect(GT1724, SIGNAL(EyeScanPlanned(int, int, int, int, int, int, int, double)),                                              \
+                                                               CLIENT, SLOT(EyeScanPlanned(int, int, int, int, int, int, int, double))); \
+    connect(GT1724, SIGNAL(CommsCostEstimated(int, double, double, double, double)),                                                \
+                                                               CLIENT, SLOT(CommsCostEstimated(int, double, double, double, double))); \
+    connect(GT1724, SIGNAL(EyeDriftBaseline(int, QVector<double>, QVector<double>)),                                                \
+                                                               CLIENT, SLOT(EyeDriftBaseline(int, QVector<double>, QVector<double>))); \
+    connect(GT1724, SIGNAL(EyeDriftAlarm(int, QVector<int>, QVector<double>, QVector<double>)),                                     \
+                                                               CLIENT, SLOT(EyeDriftAlarm(int, QVector<int>, QVector<double>, QVector<double>))); \
                                                                                                                                     \
     connect(CLIENT, SIGNAL(CommsCheck(int)),                   GT1724, SLOT(CommsCheck(int)));                                      \
     connect(CLIENT, SIGNAL(GetTemperature(int)),               GT1724, SLOT(GetTemperature(int)));                                  \
@@ -118,6 +200,32 @@ public:
                                                                GT1724, SLOT(EyeScanStart(int, int, int, int, int, int)));           \
     connect(CLIENT, SIGNAL(EyeScanRepeat(int)),                GT1724, SLOT(EyeScanRepeat(int)));                                   \
     connect(CLIENT, SIGNAL(EyeScanCancel(int)),                GT1724, SLOT(EyeScanCancel(int)));                                   \
+    connect(CLIENT, SIGNAL(EyeContourStart(int, int, int, double, int)),                                                            \
+                                                               GT1724, SLOT(EyeContourStart(int, int, int, double, int)));          \
+    connect(CLIENT, SIGNAL(EyeMaskTestStart(int, int, QVector<double>, QVector<int>, double, double)),                              \
+                                                               GT1724, SLOT(EyeMaskTestStart(int, int, QVector<double>, QVector<int>, double, double))); \
+    connect(CLIENT, SIGNAL(EyeROIScanStart(int, int, int, int, int, int, int, int)),                                                \
+                                                               GT1724, SLOT(EyeROIScanStart(int, int, int, int, int, int, int, int))); \
+    connect(CLIENT, SIGNAL(EyeBathtubStart(int, int, QVector<int>, int, bool)),                                                     \
+                                                               GT1724, SLOT(EyeBathtubStart(int, int, QVector<int>, int, bool)));   \
+    connect(CLIENT, SIGNAL(EyeBathtubFitOptions(int, QVector<double>, double, double)),                                             \
+                                                               GT1724, SLOT(EyeBathtubFitOptions(int, QVector<double>, double, double))); \
+    connect(CLIENT, SIGNAL(EyeScanAutoStopOptions(int, bool, double, double, double)),                                              \
+                                                               GT1724, SLOT(EyeScanAutoStopOptions(int, bool, double, double, double))); \
+    connect(CLIENT, SIGNAL(EyeMetricsOptions(int, QVector<double>)),                                                                \
+                                                               GT1724, SLOT(EyeMetricsOptions(int, QVector<double>)));              \
+    connect(CLIENT, SIGNAL(EyeArchiveSave(int, QString, QString)),                                                                  \
+                                                               GT1724, SLOT(EyeArchiveSave(int, QString, QString)));                \
+    connect(CLIENT, SIGNAL(EyeArchiveCompare(int, QString, double)),                                                                \
+                                                               GT1724, SLOT(EyeArchiveCompare(int, QString, double)));              \
+    connect(CLIENT, SIGNAL(EyeScanEstimate(int, int, int, int, int, int, int)),                                                     \
+                                                               GT1724, SLOT(EyeScanEstimate(int, int, int, int, int, int, int)));   \
+    connect(CLIENT, SIGNAL(EyeScanPlan(int, int, double, int)),                                                                     \
+                                                               GT1724, SLOT(EyeScanPlan(int, int, double, int)));                   \
+    connect(CLIENT, SIGNAL(CommsCostEstimate(int, int)),       GT1724, SLOT(CommsCostEstimate(int, int)));                          \
+    connect(CLIENT, SIGNAL(EyeDriftStart(int, int, int, double, double, double)),                                                   \
+                                                               GT1724, SLOT(EyeDriftStart(int, int, int, double, double, double))); \
+    connect(CLIENT, SIGNAL(EyeDriftStop(int)),                 GT1724, SLOT(EyeDriftStop(int)));                                    \
     BERT_COMPONENT_CONNECT_SIGNALS(CLIENT, GT1724)
 
 signals:
@@ -128,11 +236,15 @@ signals:
 public slots:
     GT1724_SLOTS
 
+    // Private Slots:
+private slots:
+    void eyeScanService();
+    void eyeDriftService();
+
 
 private:
 
     // GT1724 Instrument Functions:
-    int  configPG          (int pattern, double bitRate);
     int  configSetDefaults (double bitRate);
 
     int  setLaneOn (int lane, bool laneOn, bool powerDownOnMute);
@@ -186,9 +298,26 @@ private:
     // Emit signals on behalf of EyeScan module:
     void emitEyeScanProgressUpdate(int lane, int type, int percent);
     void emitEyeScanError(int lane, int type, int code);
-    void emitEyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes);
-    // Eye scanner - check for cancel signal:
-    void eyeScanCheckForCancel();
+    void emitEyeScanFinished(int lane, int type);
+    void emitEyeContourFinished(int lane, QVector<double> contourPhase, QVector<double> contourOffset, double eyeWidth, double eyeHeight);
+    void emitEyeMaskTestFinished(int lane, bool pass, int hitCount, double margin, double bitsTested);
+    void emitEyeROIScanFinished(int lane, QVector<double> data, int xRes, int yRes, int phaseStart, int phaseStep, int offsetStart, int offsetStep, int phaseShift);
+    void emitEyeBathtubsFinished(int lane, QVector<int> vOffsets, QVector<double> curves, int xRes);
+    void emitEyeBathtubFitFinished(int lane, QVector<double> targetBERs, QVector<double> openings, double rjRMS, double djDualDirac, double rSquared, bool valid, bool converged);
+    void emitEyeScanAutoStop(int lane, int type, bool stop, double floorBER, double confidence);
+    void emitEyeMetricsFinished(int lane, QVector<double> metrics, QVector<double> contourPoints, QVector<int> contourSizes);
+    void emitEyeArchiveSaved(int lane, QString fileName, int result);
+    void emitEyeArchiveCompareFinished(int lane, int result, QVector<double> delta, int xRes, int yRes, double maxDelta, double rmsDelta, int cellsWorse, int cellsBetter);
+    void emitEyeDriftBaseline(int lane, QVector<double> baseline, QVector<double> stdDevs);
+    void emitEyeDriftAlarm(int lane, QVector<int> metrics, QVector<double> baseline, QVector<double> current);
+    // Eye scanner - run scans (see eyeScanService):
+    void eyeScanSchedule();
+    void eyeScanServiceStep(EyeMonitor *em, int edLane);
+    // Eye scanner - run drift monitor snapshots (see eyeDriftService):
+    void eyeDriftSchedule();
+    // Scan planner - get timings for cost estimates:
+    ScanPlanner::costParams_t costParamsGet(int modLane);
+    void initSequenceRecord(int sequence, const QElapsedTimer &timer, quint64 opsStart);
 
     // *** Lists of settings with lookups: ***
     static const QList<int> PG_OUTPUT_SWING_LOOKUP;
@@ -213,7 +342,6 @@ private:
     static const QStringList EYESCAN_VHSTEP_LIST;
     static const int EYESCAN_VHSTEP_DEFAULT;
 
-    static const QList<int>  EYESCAN_VOFF_LOOKUP;
     static const QStringList EYESCAN_VOFF_LIST;
     static const int EYESCAN_VOFF_DEFAULT;
 
@@ -249,6 +377,11 @@ private:
 
     EyeMonitor *eyeMonitor01;     // Eye Monitor modules used for carrying out eye scans on this device's ED lanes
     EyeMonitor *eyeMonitor23;     //  (one instance for each ED lane!)
+    bool eyeScanServicePending = false;  // true if eyeScanService is queued to run
+    int  eyeScanServiceNext = 0;         // ED lane (0 or 1) to be stepped next by eyeScanService
+    QTimer *eyeDriftTimer;               // Runs eyeDriftService when the next drift snapshot is due
+    static const int EYE_DRIFT_RETRY_MS = 1000;  // Delay for drift snapshots while a scan runs
+    ScanPlanner::costParams_t initCostParams;    // Costs of the init sequences, as counted by init (see initSequenceRecord)
 
     const uint8_t   i2cAddress;   // I2C Address of this chip (7 bit, i.e. not including R/W bit), supplied by creator
 
@@ -273,6 +406,11 @@ private:
         int lastMeasureTimeMs = 0;   //
         bool los = false;            //
         bool lol = false;            //
+        double bitRate = 0.0;        // Bit rate from the last GetEDCount request
+        double rawBits = 0.0;        // Counter totals as last read from the chip
+        double rawErrors = 0.0;      //
+        double bitsExcluded = 0.0;   // Counts accumulated during eye scan sweeps,
+        double errorsExcluded = 0.0; //  left out of ED results (see edSweepBegin)
     } edParameters_t;
 
     edParameters_t ed01;
@@ -284,6 +422,11 @@ private:
     uint8_t hexCharToInt(uint8_t byte);
     bool    hexCharsToInt(uint8_t charHi, uint8_t charLo, uint8_t *result);
     double  edBytesToDouble(const uint8_t bytes[2]);
+    int     edCountRead(int edLane, edParameters_t *ed, double bitRate);
+    void    edCountersStart(edParameters_t *ed, bool enable);
+    bool    edSweepBegin(int edLane);
+    void    edSweepEnd(int edLane);
+    bool    edAnyRunning() const { return ed01.edRunning || ed23.edRunning; }
     int     commsCheckOneRegister(int lane, uint8_t value, int &countGood, int &countError);
     int     getCurrentSettings(int *pattern);
     bool    checkForceCDRBypass(int forceCDRBypass, double bitRate);
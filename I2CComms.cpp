@@ -8,6 +8,7 @@
 #include <memory>
 #include <QDebug>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QStringList>
 #include <QtSerialPort/QSerialPortInfo>
 
@@ -67,6 +68,10 @@ const uint8_t I2CComms::I2C_OP_SET_MODE[] = { ISS_CMD, 0x02, 0x40, 0x04 };
 const uint8_t I2CComms::I2C_OP_SET_MODE_SIZE = sizeof(I2C_OP_SET_MODE);
 // Nb: I2C_OP_SET_MODE sets 50 KHz I2C Mode (hardware driver), with IO pins set high (not used).
 
+// ***** Transaction timing (see i2cOp): ****
+const double I2CComms::OP_LATENCY_DEFAULT = 5.0;   // I2COP_SLEEP_TIME plus a typical serial round trip
+const double I2CComms::OP_LATENCY_WEIGHT  = 0.05;
+
 const uint8_t I2CCommsWorker::I2C_OP_GET_VERSION[] = { ISS_CMD, 0x01 };
 const uint8_t I2CCommsWorker::I2C_OP_GET_VERSION_SIZE = sizeof(I2C_OP_GET_VERSION);
 
@@ -80,6 +85,7 @@ I2CComms::I2CComms()
 {
     DEBUG_I2C("I2CComms: Constructor")
     isOpen = false;
+    opLatencyMs = OP_LATENCY_DEFAULT;
 
     // Start the I2C worker thread:
     DEBUG_I2C("Creating I2CCommsWorker FROM thread " << QThread::currentThreadId())
@@ -725,7 +731,8 @@ int I2CComms::read24(const uint8_t  slaveAddress,
     {
         bytesRemaining = nBytes - bytesTotalRead;
         // Number of bytes to read this time: We must leave at least
-        // two for the last read operation.
+        // two for the last read operation (ScanPlanner::read24FrameCount
+        // follows the same splitting).
         if (bytesRemaining >= 18)
         {
             bytesRequestedThisRead = 16;
@@ -783,6 +790,67 @@ int I2CComms::read24(const uint8_t  slaveAddress,
 
 
 
+/*!
+ \brief Sequential read from a device with 16 bit addresses (e.g. EEPROM)
+ The first frame sets the address and reads up to READ_FRAME_MAX bytes
+ (I2C_AD2). Following frames carry on from the device's internal address
+ counter (I2C_AD0; no address phase), so a long block is read in the
+ fewest adaptor frames, sent back to back. If a frame fails, the retry
+ sets the address again, as the device's address counter isn't known.
+ The device must support sequential reads, and the read mustn't go past
+ the end of the device's address range.
+ \param slaveAddress  I2C address (7 bit)
+ \param regAddress    Address to start reading from
+ \param data          Buffer for the data (created by caller)
+ \param nBytes        Number of bytes to read
+ \return globals::OK
+ \return [error code]
+*/
+int I2CComms::readSequential(const uint8_t  slaveAddress,
+                             const uint16_t regAddress,
+                             uint8_t       *data,
+                             const size_t   nBytes)
+{
+    DEBUG_I2C("I2CComms: READ SEQUENTIAL")
+    size_t bytesTotalRead = 0;
+    bool addressSet = false;
+    int errorCounter = 0;
+    while (bytesTotalRead < nBytes)
+    {
+        size_t bytesThisRead = nBytes - bytesTotalRead;
+        if (bytesThisRead > READ_FRAME_MAX) bytesThisRead = READ_FRAME_MAX;
+        const uint16_t readAddress = (uint16_t)(regAddress + bytesTotalRead);
+        int result;
+        if (!addressSet)
+        {
+            uint8_t i2cData[] = { I2C_AD2,
+                                  I2CREAD(slaveAddress),
+                                  (uint8_t)(readAddress >> 8),
+                                  (uint8_t)readAddress,
+                                  (uint8_t)bytesThisRead };
+            result = i2cOp(sizeof(i2cData), i2cData, (uint8_t)bytesThisRead, data + bytesTotalRead);
+        }
+        else
+        {
+            uint8_t i2cData[] = { I2C_AD0,
+                                  I2CREAD(slaveAddress),
+                                  (uint8_t)bytesThisRead };
+            result = i2cOp(sizeof(i2cData), i2cData, (uint8_t)bytesThisRead, data + bytesTotalRead);
+        }
+        if (result != globals::OK)
+        {
+            addressSet = false;
+            COMMSERROR_RETRY(result)
+        }
+        addressSet = true;
+        bytesTotalRead += bytesThisRead;
+        errorCounter = 0;
+    }
+    return globals::OK;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////////
 //// PRIVATE Methods ///////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////
@@ -850,6 +918,10 @@ int I2CComms::i2cOp(const uint8_t  nBytesToWrite,
     DEBUG_I2C("I2CComms: Emitting I2CWorkerOp signal")
     DEBUG_I2C("vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv")
 
+    QElapsedTimer opTimer;
+    opTimer.start();
+    opCount++;
+
     emit I2CWorkerOp((int)nBytesToWrite,
                      (const char *)dataWrite,
                      (int)nBytesToRead,
@@ -858,7 +930,14 @@ int I2CComms::i2cOp(const uint8_t  nBytesToWrite,
     DEBUG_I2C("^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^")
     DEBUG_I2C("I2CComms: I2CWorkerOp signal returned.")
 
-    return commsWorker->getLastResult();
+    // Update the running average transaction time (used by ScanPlanner).
+    // Failed ops include error recovery delays, so aren't counted:
+    int result = commsWorker->getLastResult();
+    if (result == globals::OK)
+    {
+        opLatencyMs += OP_LATENCY_WEIGHT * ((static_cast<double>(opTimer.nsecsElapsed()) / 1.0e6) - opLatencyMs);
+    }
+    return result;
 }
 
 
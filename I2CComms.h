@@ -81,6 +81,14 @@ class I2CComms : public QObject
                  uint8_t *data,
                  const size_t nBytes);
 
+    int   readSequential(const uint8_t slaveAddress,
+                         const uint16_t regAddress,
+                         uint8_t *data,
+                         const size_t nBytes);
+
+    double getOpLatency() const { return opLatencyMs; }
+    quint64 getOpCount() const { return opCount; }
+
 signals:
     void I2CWorkerConnect(QString port);
     void I2CWorkerDisconnect();
@@ -100,6 +108,10 @@ private:
                      uint8_t *dataRead);
 
     static const int MAX_RETRIES   = 5;    // Maximum number of times to retry on I2C Error
+    static const int READ_FRAME_MAX = 64;  // Adaptor read buffer limit (bytes per frame)
+
+    static const double OP_LATENCY_DEFAULT;  // Assumed time for one adaptor transaction (mS) until measured
+    static const double OP_LATENCY_WEIGHT;   // Weight of each new measurement in the running average
 
     // Adaptor Command Bytes:
     static const uint8_t I2C_SGL = 0x53;   // Read/Write single byte for non-registered devices
@@ -120,6 +132,9 @@ private:
     bool isOpen;
     std::unique_ptr<I2CCommsWorker> commsWorker;
 
+    double opLatencyMs;  // Running average time for one adaptor transaction (mS), measured in i2cOp
+    quint64 opCount = 0; // Number of adaptor transactions since the port was created (see ScanPlanner::sequenceRecord)
+
 };
 
 
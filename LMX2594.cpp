@@ -6,6 +6,9 @@
 */
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
 
 #include "globals.h"
 #include "BertFile.h"
@@ -60,14 +63,17 @@ const size_t LMX2594::DEFAULT_FOUT_POWER_INDEX = 0;    // Default power setting
 const size_t LMX2594::DEFAULT_TRIG_POWER_INDEX = 1;    // Default power setting for trigger out (5 DBM)
 
 
-QList<LMXFrequencyProfile> LMX2594::frequencyProfiles = QList<LMXFrequencyProfile>();
+QVector<LMXFrequencyProfile> LMX2594::frequencyProfiles = QVector<LMXFrequencyProfile>();
 QStringList LMX2594::frequencyList = QStringList();
 uint16_t LMX2594::profileIndexDefault = 0;    // Index of default start-up frequency profile
 // DEPRECATED int LMX2594::instanceCount = 0;
 // DEPRECATED bool LMX2594::frequencyProfilesOK = false;
 
-QList<LMXFrequencyProfile> LMX2594::frequencyProfilesFromFiles = QList<LMXFrequencyProfile>();
+QVector<LMXFrequencyProfile> LMX2594::frequencyProfilesFromFiles = QVector<LMXFrequencyProfile>();
 QStringList LMX2594::frequencyListFromFiles = QStringList();
+const QString LMX2594::PROFILE_CACHE_FILE = QString("tcsprofiles.cache");
+
+const double LMX2594::REF_XO_FREQUENCY = 100.0;   // On board XO (MHz)
 
 
 
@@ -156,6 +162,7 @@ LMX2594::LMX2594(I2CComms *comms,
     selectedTrigDivideIndex = 0; // DEPRECATED  DEFAULT_DIVIDE_RATIO_INDEX;
     selectedFOutOutputPowerIndex = DEFAULT_FOUT_POWER_INDEX;
     selectedTrigOutputPowerIndex = DEFAULT_TRIG_POWER_INDEX;
+    shadowInvalidate();
 
     /* DEPRECATED MOVED
     // Read frequency profiles (Nb: These are static, so only read for first instantiation):
@@ -335,6 +342,11 @@ int LMX2594::init()
     }
     emit ListPopulate("listLMXFreq", globals::ALL_LANES, frequencyList, profileIndexDefault);
 
+    // VCO calibration results from earlier sessions on this instrument:
+    QString serial;
+    if (eeprom->readSerialNumber(serial) != globals::OK) serial.clear();
+    vcoCalLoad(serial);
+
     emit ShowMessage("Configuring Frequency Synthesizer...");
     // Initialise the comms (I2C to SPI adaptor):
     result = initAdaptor(comms, i2cAddress);
@@ -367,12 +379,13 @@ void LMX2594::GetLMXInfo()
     float frequency = 0.0;
     getFrequency(selectedProfileIndex, &frequency);
     emit LMXInfo(deviceID,
-                 selectedProfileIndex,
+                 (selectedProfileIndex == SYNTH_PROFILE_INDEX) ? -1 : selectedProfileIndex,  // -1: Not one of the listed profiles
                  selectedTrigOutputPowerIndex,
                  selectedFOutOutputPowerIndex,
                  selectedTrigDivideIndex,
                  flagOutputsOn,
-                 frequency);
+                 frequency,
+                 lockTimeMs);
 }
 
 
@@ -420,6 +433,11 @@ void LMX2594::SelectProfile(int indexProfile, bool triggerResync)
         emit Result(globals::OK, globals::ALL_LANES);
         emit ShowMessage("OK.");
     }
+    else if (result == globals::TIMEOUT)
+    {
+        emit ShowMessage("Synthesizer not locked!");
+        emit Result(result, globals::ALL_LANES);
+    }
     else
     {
         emit ShowMessage("Error selecting frequency!");
@@ -430,6 +448,39 @@ void LMX2594::SelectProfile(int indexProfile, bool triggerResync)
 }
 
 
+/*!
+ \brief Slot: Select any frequency
+ Sets the clock to a frequency which doesn't need to be in the list of
+ profiles (see selectFrequency). LMXInfo will show profile index -1.
+ \param frequency      Clock frequency (MHz); Clock is 1/2 bit rate
+ \param triggerResync  OPTIONAL: Should this change trigger a resync of other components?
+                       (See SelectProfile)
+*/
+void LMX2594::SelectFrequency(double frequency, bool triggerResync)
+{
+    DEBUG_LMX("LMX2594: Select frequency " << frequency << " MHz on Clock " << deviceID)
+    emit ShowMessage("Changing Synthesizer Frequency...");
+    int result = selectFrequency(frequency);
+    if (result == globals::OK)
+    {
+        emit Result(globals::OK, globals::ALL_LANES);
+        emit ShowMessage("OK.");
+    }
+    else if (result == globals::TIMEOUT)
+    {
+        emit ShowMessage("Synthesizer not locked!");
+        emit Result(result, globals::ALL_LANES);
+    }
+    else
+    {
+        emit ShowMessage("Error selecting frequency!");
+        emit Result(result, globals::ALL_LANES);
+    }
+    GetLMXInfo();
+    if (triggerResync) emit LMXSettingsChanged(deviceID);
+}
+
+
 
 /* DEPRECATED:
  *  No longer any slot to select Trigger Divide; Both RF outputs will be set to
@@ -598,23 +649,20 @@ void LMX2594::LMXVerifyFrequencyProfiles()
             return;
         }
         qDebug() << "Compare register values for Profile " << index << "...";
-        for (int regAddr = 0; regAddr < frequencyProfilesFromFiles[index].getRegisterCount(); regAddr++)
+        int regAddr = frequencyProfilesFromFiles[index].firstDifference(frequencyProfiles[index]);
+        if (regAddr >= 0)
         {
-            bool regFound;
-            uint16_t regValueFile = frequencyProfilesFromFiles[index].getRegisterValue(static_cast<uint8_t>(regAddr), &regFound);
-            uint16_t regValueEEPROM = frequencyProfiles[index].getRegisterValue(static_cast<uint8_t>(regAddr), &regFound);
-            if (regValueFile != regValueEEPROM)
-            {
-                qDebug() << "--Different register values at address " << regAddr
-                         << ": FILE = " << regValueFile << "; EEPROM = " << regValueEEPROM;
-                emit ShowMessage(QString("Verify FAILED: Register value is different at profile %1, reg %2 (%3 in FILES; %4 in EEPROM)")
-                                 .arg(index)
-                                 .arg(regAddr)
-                                 .arg(regValueFile)
-                                 .arg(regValueEEPROM));
-                emit Result(globals::GEN_ERROR, globals::ALL_LANES);
-                return;
-            }
+            uint16_t regValueFile = frequencyProfilesFromFiles[index].getRegisterValue(static_cast<uint8_t>(regAddr), nullptr);
+            uint16_t regValueEEPROM = frequencyProfiles[index].getRegisterValue(static_cast<uint8_t>(regAddr), nullptr);
+            qDebug() << "--Different register values at address " << regAddr
+                     << ": FILE = " << regValueFile << "; EEPROM = " << regValueEEPROM;
+            emit ShowMessage(QString("Verify FAILED: Register value is different at profile %1, reg %2 (%3 in FILES; %4 in EEPROM)")
+                             .arg(index)
+                             .arg(regAddr)
+                             .arg(regValueFile)
+                             .arg(regValueEEPROM));
+            emit Result(globals::GEN_ERROR, globals::ALL_LANES);
+            return;
         }
         qDebug() << "--Register values match.";
     }
@@ -660,6 +708,12 @@ void LMX2594::ResetDevice()
 
 /*!
  \brief Build a list of frequency profiles based on ".tcs" files found in a specified directory
+
+ Parsed profiles are kept in a cache file in the same directory
+ (PROFILE_CACHE_FILE). A file is only parsed again if it isn't in the cache,
+ or its size or modified time have changed and its contents don't match the
+ hash in the cache. The cache is rewritten if anything changed.
+
  \return globals::OK
  \return globals::DIRECTORY_NOT_FOUND
  \return globals::FILE_ERROR
@@ -672,61 +726,104 @@ int LMX2594::getProfilesFromRegisterFiles(const QString registerFilePath, QStrin
     QStringList freqFiles;
     int result;
     result = BertFile::readDirectory(registerFilePath, freqFiles);
+    freqFiles.removeAll(PROFILE_CACHE_FILE);
     if (freqFiles.empty())
     {
         qDebug() << "LMX2594: ERROR: No frequency profiles found. (Error: " << result << ")";
         return result;
     }
+
+    QMap<QString, profileCacheEntry_t> cacheEntries;
+    QMap<QString, profileCacheEntry_t> cacheEntriesNew;
+    result = profileCacheLoad(registerFilePath, partNo, cacheEntries);
+    DEBUG_LMX_PROFILES("Profile cache: " << cacheEntries.count() << " entries (" << result << ")")
+    bool cacheChanged = (result != globals::OK);
+    int filesParsed = 0;
+
     DEBUG_LMX_PROFILES(freqFiles.count() << " files found. Parsing...")
     foreach( QString fileName, freqFiles )
     {
         DEBUG_LMX_PROFILES("File: " << fileName)
-        QStringList defLines;
-        result = BertFile::readFile(registerFilePath + QString("\\") + QString(fileName), 400, defLines);
-        if (defLines.empty())
+        const QString filePath = registerFilePath + QString("\\") + QString(fileName);
+        QFileInfo fileInfo(filePath);
+        profileCacheEntry_t entry;
+        entry.size = fileInfo.size();
+        entry.modified = fileInfo.lastModified().toMSecsSinceEpoch();
+        entry.hash = 0;
+        bool cached = false;
+
+        if (cacheEntries.contains(fileName))
         {
-            qDebug() << "LMX2594: ERROR: Couldn't read file! (File: " << fileName << "; Error: " << result << ")";
+            const profileCacheEntry_t &cacheEntry = cacheEntries[fileName];
+            if (cacheEntry.size == entry.size && cacheEntry.modified == entry.modified)
+            {
+                entry = cacheEntry;
+                cached = true;
+            }
         }
-        else
+        if (!cached)
+        {
+            // Changed or new file: Check the contents against the cache before parsing.
+            QFile file(filePath);
+            if (file.open(QIODevice::ReadOnly))
+            {
+                QByteArray fileData = file.readAll();
+                file.close();
+                entry.hash = profileCacheHash(reinterpret_cast<const uint8_t *>(fileData.constData()), fileData.size());
+            }
+            cacheChanged = true;
+            if (cacheEntries.contains(fileName)
+             && cacheEntries[fileName].size == entry.size
+             && cacheEntries[fileName].hash == entry.hash)
+            {
+                entry.profile = cacheEntries[fileName].profile;   // Only the modified time changed
+                cached = true;
+            }
+        }
+        if (!cached)
         {
+            QStringList defLines;
+            result = BertFile::readFile(filePath, 400, defLines);
+            if (defLines.empty())
+            {
+                qDebug() << "LMX2594: ERROR: Couldn't read file! (File: " << fileName << "; Error: " << result << ")";
+                continue;   // Not cached: Try again next time
+            }
             // DEPRECATED LMXFrequencyProfile thisFrequencyProfile(partNo, REGISTER_COUNT, defLines);
-            LMXFrequencyProfile thisFrequencyProfile(REGISTER_COUNT);
-
-            result = parseTcsFrequencyProfile(defLines, partNo, thisFrequencyProfile);
+            entry.profile = LMXFrequencyProfile(REGISTER_COUNT);
+            parseTcsFrequencyProfile(defLines, partNo, entry.profile);
+            filesParsed++;
+        }
+        cacheEntriesNew.insert(fileName, entry);
 
-            if (result == globals::OK && thisFrequencyProfile.isValid())
+        const LMXFrequencyProfile &thisFrequencyProfile = entry.profile;
+        if (thisFrequencyProfile.isValid())
+        {
+            // File was parsed OK! (valid frequency profile):
+            if (frequencyProfilesFromFiles.empty())
             {
-                // File was parsed OK! (valid frequency profile):
-                if (frequencyProfilesFromFiles.empty())
-                {
-                    frequencyProfilesFromFiles.append(thisFrequencyProfile);
-                }
-                else
-                {
-                    // Already have frequencies. We want to insert this one
-                    // in the correct place in the list (sorted by frequency):
-                    QList<LMXFrequencyProfile>::iterator i;
-                    for (i = frequencyProfilesFromFiles.begin(); i != frequencyProfilesFromFiles.end(); ++i)
-                    {
-                        if (i->getFrequency() >= thisFrequencyProfile.getFrequency())
-                        {
-                            frequencyProfilesFromFiles.insert(i, thisFrequencyProfile);
-                            break;
-                        }
-                    }
-                    if (i == frequencyProfilesFromFiles.end())
-                    {
-                        frequencyProfilesFromFiles.append(thisFrequencyProfile);
-                    }
-                }
-                DEBUG_LMX_PROFILES("Parsed OK; Freq = " << thisFrequencyProfile.getFrequency())
+                frequencyProfilesFromFiles.append(thisFrequencyProfile);
+            }
+            else
+            {
+                // Already have frequencies. We want to insert this one
+                // in the correct place in the list (sorted by frequency):
+                int insertIndex = 0;
+                while (insertIndex < frequencyProfilesFromFiles.count()
+                    && frequencyProfilesFromFiles.at(insertIndex).getFrequency() < thisFrequencyProfile.getFrequency()) insertIndex++;
+                frequencyProfilesFromFiles.insert(insertIndex, thisFrequencyProfile);
             }
+            DEBUG_LMX_PROFILES("Profile OK; Freq = " << thisFrequencyProfile.getFrequency())
         }
     }
+    if (cacheEntriesNew.count() != cacheEntries.count()) cacheChanged = true;   // Files removed
+    if (cacheChanged) profileCacheSave(registerFilePath, partNo, cacheEntriesNew);
+    qDebug() << "LMX2594: " << cacheEntriesNew.count() << " register files; " << filesParsed << " parsed, "
+             << (cacheEntriesNew.count() - filesParsed) << " from cache.";
 
     // Create list of frequency values to display in UI:
     uint16_t thisIndex = 0;
-    QList<LMXFrequencyProfile>::iterator i;
+    QVector<LMXFrequencyProfile>::iterator i;
     for (i = frequencyProfilesFromFiles.begin(); i != frequencyProfilesFromFiles.end(); ++i)
     {
         float thisFrequency = i->getFrequency();
@@ -882,6 +979,191 @@ int LMX2594::parseTcsFrequencyProfile(QStringList &fileContent, const QString pa
 
 
 
+/*!
+ \brief Load the cache of parsed register def files
+ The file is memory mapped and checked (magic number, version, part number
+ and checksum) before any entries are used. Layout (native byte order;
+ the cache is only used on the machine which wrote it):
+   Header:   magic (4) | version (2) | part number length (2) | part number (UTF-8)
+             | entry count (2)
+   Entry:    file name length (2) | file name (UTF-8) | size (8) | modified (8)
+             | hash (4) | valid (1) | frequency (4) | register count (2)
+             | registers set (2) | [address (1) | value (2)] x registers set
+   Trailer:  checksum (4; profileCacheHash of everything before it)
+ \param registerFilePath  Register file directory
+ \param partNo            Part number the profiles were parsed for
+ \param entries           Cache entries by file name (cleared first)
+ \return globals::OK
+ \return globals::FILE_ERROR    No cache file, or couldn't read it
+ \return globals::INVALID_DATA  Cache file is from another version or part, or is damaged
+*/
+int LMX2594::profileCacheLoad(const QString &registerFilePath, const QString &partNo, QMap<QString, profileCacheEntry_t> &entries)
+{
+    entries.clear();
+    QFile cacheFile(registerFilePath + QString("\\") + PROFILE_CACHE_FILE);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return globals::FILE_ERROR;
+    const qint64 fileSize = cacheFile.size();
+    if (fileSize < 4)
+    {
+        cacheFile.close();
+        return globals::INVALID_DATA;
+    }
+    QByteArray fileData;
+    const uint8_t *data = cacheFile.map(0, fileSize);
+    if (!data)
+    {
+        fileData = cacheFile.readAll();   // Can't map: Read instead
+        data = reinterpret_cast<const uint8_t *>(fileData.constData());
+    }
+    const uint8_t *dataEnd = data + fileSize - 4;   // Start of checksum
+    int result = globals::INVALID_DATA;
+    uint32_t magic = 0, checkSum = 0;
+    uint16_t version = 0, partNoLength = 0, entryCount = 0;
+    QString partNoRead;
+
+    memcpy(&checkSum, dataEnd, 4);
+    if (checkSum != profileCacheHash(data, fileSize - 4)) goto finished;
+    if (!profileCacheTake(&data, dataEnd, &magic, 4)
+     || !profileCacheTake(&data, dataEnd, &version, 2)
+     || magic != PROFILE_CACHE_MAGIC
+     || version != PROFILE_CACHE_VERSION) goto finished;
+    if (!profileCacheTake(&data, dataEnd, &partNoLength, 2) || (dataEnd - data) < partNoLength) goto finished;
+    partNoRead = QString::fromUtf8(reinterpret_cast<const char *>(data), partNoLength);
+    data += partNoLength;
+    if (partNoRead != partNo) goto finished;
+    if (!profileCacheTake(&data, dataEnd, &entryCount, 2)) goto finished;
+
+    for (int entryIndex = 0; entryIndex < entryCount; entryIndex++)
+    {
+        profileCacheEntry_t entry;
+        uint16_t nameLength = 0, registerCount = 0, registersSet = 0;
+        uint8_t valid = 0, address = 0;
+        uint16_t value = 0;
+        float frequency = 0.0f;
+        if (!profileCacheTake(&data, dataEnd, &nameLength, 2) || (dataEnd - data) < nameLength) goto finished;
+        const QString fileName = QString::fromUtf8(reinterpret_cast<const char *>(data), nameLength);
+        data += nameLength;
+        if (!profileCacheTake(&data, dataEnd, &entry.size, 8)
+         || !profileCacheTake(&data, dataEnd, &entry.modified, 8)
+         || !profileCacheTake(&data, dataEnd, &entry.hash, 4)
+         || !profileCacheTake(&data, dataEnd, &valid, 1)
+         || !profileCacheTake(&data, dataEnd, &frequency, 4)
+         || !profileCacheTake(&data, dataEnd, &registerCount, 2)
+         || !profileCacheTake(&data, dataEnd, &registersSet, 2)) goto finished;
+        entry.profile = LMXFrequencyProfile(registerCount);
+        entry.profile.setFrequency(frequency);
+        for (int i = 0; i < registersSet; i++)
+        {
+            if (!profileCacheTake(&data, dataEnd, &address, 1)
+             || !profileCacheTake(&data, dataEnd, &value, 2)) goto finished;
+            entry.profile.setRegisterValue(address, value);
+        }
+        if (valid) entry.profile.setValid();
+        entries.insert(fileName, entry);
+    }
+    result = globals::OK;
+
+  finished:
+    if (result != globals::OK) entries.clear();
+    cacheFile.close();   // Also unmaps
+    return result;
+}
+
+
+
+/*!
+ \brief Save the cache of parsed register def files (see profileCacheLoad)
+ \param registerFilePath  Register file directory
+ \param partNo            Part number the profiles were parsed for
+ \param entries           Cache entries by file name
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't write the file
+*/
+int LMX2594::profileCacheSave(const QString &registerFilePath, const QString &partNo, const QMap<QString, profileCacheEntry_t> &entries)
+{
+    QByteArray data;
+    const QByteArray partNoData = partNo.toUtf8();
+    const uint32_t magic = PROFILE_CACHE_MAGIC;
+    const uint16_t version = PROFILE_CACHE_VERSION;
+    const uint16_t partNoLength = static_cast<uint16_t>(partNoData.size());
+    const uint16_t entryCount = static_cast<uint16_t>(entries.count());
+    data.append(reinterpret_cast<const char *>(&magic), 4);
+    data.append(reinterpret_cast<const char *>(&version), 2);
+    data.append(reinterpret_cast<const char *>(&partNoLength), 2);
+    data.append(partNoData.constData(), partNoLength);
+    data.append(reinterpret_cast<const char *>(&entryCount), 2);
+
+    foreach (QString fileName, entries.keys())
+    {
+        const profileCacheEntry_t &entry = entries[fileName];
+        const QByteArray nameData = fileName.toUtf8();
+        const uint16_t nameLength = static_cast<uint16_t>(nameData.size());
+        const uint8_t valid = (entry.profile.isValid()) ? 1 : 0;
+        const float frequency = entry.profile.getFrequency();
+        const uint16_t registerCount = static_cast<uint16_t>(entry.profile.getRegisterCount());
+        const uint16_t registersSet = static_cast<uint16_t>(entry.profile.getUsedRegisterCount());
+        data.append(reinterpret_cast<const char *>(&nameLength), 2);
+        data.append(nameData.constData(), nameLength);
+        data.append(reinterpret_cast<const char *>(&entry.size), 8);
+        data.append(reinterpret_cast<const char *>(&entry.modified), 8);
+        data.append(reinterpret_cast<const char *>(&entry.hash), 4);
+        data.append(reinterpret_cast<const char *>(&valid), 1);
+        data.append(reinterpret_cast<const char *>(&frequency), 4);
+        data.append(reinterpret_cast<const char *>(&registerCount), 2);
+        data.append(reinterpret_cast<const char *>(&registersSet), 2);
+        for (int address = 0; address < registerCount; address++)
+        {
+            if (!entry.profile.isRegisterSet(static_cast<uint8_t>(address))) continue;
+            const uint8_t addressByte = static_cast<uint8_t>(address);
+            const uint16_t value = entry.profile.getRegisterValue(addressByte, nullptr);
+            data.append(reinterpret_cast<const char *>(&addressByte), 1);
+            data.append(reinterpret_cast<const char *>(&value), 2);
+        }
+    }
+    const uint32_t checkSum = profileCacheHash(reinterpret_cast<const uint8_t *>(data.constData()), data.size());
+    data.append(reinterpret_cast<const char *>(&checkSum), 4);
+
+    QFile cacheFile(registerFilePath + QString("\\") + PROFILE_CACHE_FILE);
+    if (!cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        DEBUG_LMX("LMX2594: Couldn't write profile cache " << cacheFile.fileName())
+        return globals::FILE_ERROR;
+    }
+    const qint64 written = cacheFile.write(data);
+    cacheFile.close();
+    if (written != data.size()) return globals::FILE_ERROR;
+    DEBUG_LMX_PROFILES("Profile cache saved: " << entryCount << " entries; " << data.size() << " bytes")
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Hash for the profile cache (FNV-1a, 32 bit)
+*/
+uint32_t LMX2594::profileCacheHash(const uint8_t *data, qint64 size)
+{
+    uint32_t hash = 2166136261u;
+    for (qint64 i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+
+
+/*!
+ \brief Copy a value out of the profile cache data, and move past it
+ \return false if there isn't enough data left
+*/
+bool LMX2594::profileCacheTake(const uint8_t **data, const uint8_t *dataEnd, void *value, qint64 size)
+{
+    if ((dataEnd - *data) < size) return false;
+    memcpy(value, *data, static_cast<size_t>(size));
+    *data += size;
+    return true;
+}
+
+
+
 
 
 
@@ -900,60 +1182,207 @@ int LMX2594::parseTcsFrequencyProfile(QStringList &fileContent, const QString pa
 */
 int LMX2594::getFrequency(int index, float *frequency) const
 {
-    Q_ASSERT(index < (size_t)frequencyProfiles.count());
-    if (index >= frequencyProfiles.count()) return globals::OVERFLOW;
-    if (frequency) *frequency = frequencyProfiles.at(index).getFrequency();
+    const LMXFrequencyProfile *profile = profileGet(index);
+    if (!profile) return globals::OVERFLOW;
+    if (frequency) *frequency = profile->getFrequency();
     return globals::OK;
 }
 
 
+/*!
+ \brief Get a Frequency Profile by Index
+ \param index  Index of profile - 0 is first; SYNTH_PROFILE_INDEX for the
+               profile made by selectFrequency
+ \return Pointer to the profile, or NULL if there's no profile at index
+*/
+const LMXFrequencyProfile *LMX2594::profileGet(int index) const
+{
+    if (index == SYNTH_PROFILE_INDEX) return (synthProfile.isValid()) ? &synthProfile : NULL;
+    if (index < 0 || index >= frequencyProfiles.count()) return NULL;
+    return &frequencyProfiles.at(index);
+}
+
+
 /*!
  \brief Select Frequency Profile by Index
+
+ If the shadow copy holds every register in the profile (i.e. a profile
+ has already been loaded, with no write errors since), only the registers
+ which differ from the shadow copy are written, with no reset. Otherwise
+ the part is reset (unless it has just been reset) and all registers in
+ the profile are written. Either way, registers are written in descending
+ order, and R0 last (see runFCal), as required by the LMX2594 datasheet.
+
+ The output power / power down settings (R44 / R45) are merged into the
+ profile values before comparing, so the outputs aren't switched off and
+ back on during the change.
+
+ VCO calibration assist: After the first lock on a profile, the final
+ calibration values are read back and cached (see vcoCalRead). On later
+ selections of the profile they are used as the calibration start values
+ (VCO_SEL, VCO_CAPCTRL_STRT, VCO_DACISET_STRT), so FCAL only has to search
+ around the previous result. If the assisted calibration doesn't lock, the
+ cache entry is dropped and the calibration is run again from the profile
+ start values.
+
  \param index               Index of profile to get frequency from - 0 is first
+                            (SYNTH_PROFILE_INDEX: profile made by selectFrequency)
  \return globals::OK        Item found for requested index.
  \return globals::OVERFLOW  Index was larger than the list of frequency profiles
+ \return globals::TIMEOUT   Profile selected, but no lock after FCAL (see runFCal)
  \return [Error Code]       Error from derived class implementation (selectProfilePart)
 */
 int LMX2594::selectProfile(int index)
 {
-    Q_ASSERT(index < (size_t)frequencyProfiles.count());
-    if (index >= frequencyProfiles.count()) return globals::OVERFLOW;
-    DEBUG_LMX("LMX2594: Select frequency profile " << index << ": " << frequencyProfiles.at(index).getFrequency() << " MHz")
+    if (!profileGet(index)) return globals::OVERFLOW;
+    const LMXFrequencyProfile &profile = *profileGet(index);
+    DEBUG_LMX("LMX2594: Select frequency profile " << index << ": " << profile.getFrequency() << " MHz")
 
     uint8_t registerAddress;
-    uint16_t registerValue;
+    uint16_t registerValue, R44, R45;
     bool registerFound;
+    bool fullLoad = false;
+    bool assisted = vcoCalCache.contains(index);
+    int nWritten = 0;
     int result;
 
-    resetDevice();
+    // Restore the previous power settings and turn outputs on:
+    flagOutputsOn = true;
+    outputRegistersGet(index, &R44, &R45);
+
+    // Only write changed registers if the shadow copy covers the whole profile:
+    for (registerAddress = 112; registerAddress > 0; registerAddress--)
+    {
+        if (profile.isRegisterSet(registerAddress) && !shadowKnown[registerAddress]) fullLoad = true;
+    }
+    if (fullLoad && !shadowResetState) resetDevice();
 
     // Load registers in REVERSE ORDER; Don't load R0 (power control)
     for (registerAddress = 112; registerAddress > 0; registerAddress--)
     {
-        registerValue = frequencyProfiles.at(index).getRegisterValue(registerAddress, &registerFound);
-        if (registerFound)
+        registerValue = profile.getRegisterValue(registerAddress, &registerFound);
+        if (!registerFound) continue;
+        if (registerAddress == 44) registerValue = R44;
+        if (registerAddress == 45) registerValue = R45;
+        if (assisted) vcoCalAssistApply(index, registerAddress, &registerValue);
+        if (!fullLoad && shadowValues[registerAddress] == registerValue) continue;  // Unchanged
+        // DEBUG_LMX("LMX2594: Write " << QString().sprintf("0x%04X", registerValue) << " to register " << registerAddress;
+        result = writeRegister(registerAddress, registerValue);
+        if (result != globals::OK)
         {
-            // DEBUG_LMX("LMX2594: Write " << QString().sprintf("0x%04X", registerValue) << " to register " << registerAddress;
-            result = writeRegister(registerAddress, registerValue);
-            if (result != globals::OK)
-            {
-                DEBUG_LMX("LMX2594: ERROR writing register! (" << result << ")")
-                return globals::WRITE_ERROR;
-            }
+            DEBUG_LMX("LMX2594: ERROR writing register! (" << result << ")")
+            return globals::WRITE_ERROR;
         }
+        nWritten++;
     }
     selectedProfileIndex = static_cast<uint16_t>(index);
 
-    // Restore the previous power and divider settings
-    // and turn outputs on:
-    flagOutputsOn = true;
+    // Output settings: Only written here if the profile doesn't include R44 / R45:
     configureOutputs();
 
     // Calibrate: Required after changing PLL settings
-    runFCal();
+    // Nb: If there's no lock, the profile is still selected; TIMEOUT is returned so the caller can report it.
+    result = runFCal();
+    if (result != globals::OK && assisted)
+    {
+        // Cached start values no good (e.g. part changed): Calibrate again from the profile values.
+        DEBUG_LMX("LMX2594: Assisted FCAL failed (" << result << "); Retry without assist")
+        vcoCalCache.remove(index);
+        vcoCalSave();
+        const uint8_t assistRegisters[] = { 78, 20, 17 };
+        for (const uint8_t assistAddress : assistRegisters)
+        {
+            registerValue = profile.getRegisterValue(assistAddress, &registerFound);
+            if (registerFound) writeRegisterChanged(assistAddress, registerValue);
+        }
+        result = runFCal();
+    }
+    const int fcalResult = result;
+    if (result != globals::OK)
+    {
+        DEBUG_LMX("LMX2594: FCAL error: " << result)
+    }
+    else if (index != SYNTH_PROFILE_INDEX && !vcoCalCache.contains(index))
+    {
+        // First lock on this profile: Keep the calibration results.
+        // Nb: Not for synthesised frequencies; these have start values from the planner.
+        vcoCal_t cal;
+        bool isLocked = false;
+        result = vcoCalRead(&cal, &isLocked);
+        if (result == globals::OK && isLocked)
+        {
+            cal.frequency = profile.getFrequency();
+            vcoCalCache.insert(index, cal);
+            vcoCalSave();
+            DEBUG_LMX("LMX2594: VCO calibration cached: VCO_SEL = " << cal.vcoSel
+                      << "; CAPCTRL = " << cal.capCtrl << "; DACISET = " << cal.dacIset)
+        }
+        else
+        {
+            DEBUG_LMX("LMX2594: VCO calibration not cached (" << result << "; locked: " << isLocked << ")")
+        }
+    }
 
-    DEBUG_LMX("LMX2594: Registers set for profile!")
-    return globals::OK;
+    DEBUG_LMX("LMX2594: Registers set for profile! (" << nWritten << " registers written; "
+              << ((fullLoad) ? "full load" : "changed only")
+              << ((assisted) ? "; VCO cal assist" : "") << ")")
+    return fcalResult;
+}
+
+
+/*!
+ \brief Select any Frequency
+ Works out the register settings for the frequency (see LMXPllPlanner) and
+ loads them with selectProfile, so only the changed registers are written.
+
+ The profile nearest to the frequency is used as the base for the new
+ settings: The PLL settings (N, fraction, MASH order, channel divider,
+ VCO core and calibration start values, charge pump, FCAL adjustments) are
+ worked out here; other settings (reference path, loop filter related,
+ outputs) stay as set up for the instrument in the stored profiles.
+ The reference frequency is read from the SI5340 if there is one, or
+ REF_XO_FREQUENCY if not.
+
+ \param frequency  Clock frequency (MHz)
+ \return globals::OK
+ \return globals::NOT_INITIALISED  No frequency profiles to use as a base
+ \return globals::OVERFLOW         Frequency can't be reached
+ \return globals::INVALID_DATA     Base profile is missing PLL registers
+ \return [Error Code]              Error from selectProfile
+*/
+int LMX2594::selectFrequency(double frequency)
+{
+    if (frequencyProfiles.isEmpty()) return globals::NOT_INITIALISED;
+
+    // Base profile: Nearest frequency.
+    int baseIndex = 0;
+    for (int index = 1; index < frequencyProfiles.count(); index++)
+    {
+        if (qAbs(static_cast<double>(frequencyProfiles.at(index).getFrequency()) - frequency)
+          < qAbs(static_cast<double>(frequencyProfiles.at(baseIndex).getFrequency()) - frequency)) baseIndex = index;
+    }
+    const LMXFrequencyProfile &base = frequencyProfiles.at(baseIndex);
+
+    double fOsc = REF_XO_FREQUENCY;
+    if (refClock && refClock->getFrequencyOut() > 0.0f) fOsc = static_cast<double>(refClock->getFrequencyOut());
+
+    LMXPllPlanner::refPath_t ref;
+    LMXPllPlanner::plan_t plan;
+    int result = LMXPllPlanner::referenceRead(base, fOsc, &ref);
+    if (result != globals::OK) return result;
+    result = LMXPllPlanner::plan(ref, frequency, base, &plan);
+    if (result != globals::OK) return result;
+
+    LMXFrequencyProfile profile = base;
+    result = LMXPllPlanner::registersApply(plan, &profile);
+    if (result != globals::OK) return result;
+    profile.setFrequency(static_cast<float>(plan.fOut));
+    profile.setValid();
+    synthProfile = profile;
+
+    DEBUG_LMX("LMX2594: Synthesised " << plan.fOut << " MHz from profile " << baseIndex
+              << " (" << base.getFrequency() << " MHz); Reference " << fOsc << " MHz")
+    return selectProfile(SYNTH_PROFILE_INDEX);
 }
 
 
@@ -1011,7 +1440,27 @@ int LMX2594::selectTriggerDivide(const size_t index, const bool doFCal)
 
 /*!
  \brief Run frequency calibration
- \return globals::OK       Calibration OK
+
+ R0 is written with FCAL_EN low, then straight away with FCAL_EN set: FCAL
+ starts on the write which sets FCAL_EN, so the bit doesn't need to be held
+ low (each write already takes a few mS through the I2C to SPI adaptor).
+
+ Completion is detected by polling lock detect (see lockStatusRead) every
+ FCAL_LOCK_POLL_MS, until it has read "locked" FCAL_LOCK_CONFIRM times in
+ a row, or FCAL_LOCK_TIMEOUT_MS passes. Lock detect can still show lock
+ from the previous settings when FCAL starts, so "locked" reads only count
+ once lock detect has been seen to drop. FCAL may finish before the first
+ read if the frequency hasn't changed much, so if the first read shows
+ lock, it is checked with the VCO readback instead (rb_LD_VTUNE, read from
+ the part for the new settings; see vcoCalRead), and lock is only accepted
+ if that shows lock too. The time to lock is kept in lockTimeMs and
+ reported with LMXInfo.
+
+ If lock detect can't be read (no IO controller, and MUXout not set up for
+ register readback), waits FCAL_FIXED_SLEEP_MS instead.
+
+ \return globals::OK       Calibration OK (locked, or lock detect not available)
+ \return globals::TIMEOUT  No lock within FCAL_LOCK_TIMEOUT_MS
  \return [Error Code]      Error code from writeRegister
 */
 int LMX2594::runFCal()
@@ -1021,23 +1470,92 @@ int LMX2594::runFCal()
     // profile (these are fields in R0):
     bool bFound = false;
     uint16_t R0 = 0;
-    if (selectedProfileIndex < frequencyProfiles.count())
-    {
-        R0 = frequencyProfiles.at(selectedProfileIndex).getRegisterValue(0, &bFound);
-    }
+    const LMXFrequencyProfile *profile = profileGet(selectedProfileIndex);
+    if (profile) R0 = profile->getRegisterValue(0, &bFound);
     if (!bFound) R0 = R0_DEFAULT;
 
     // Clear the FCAL_EN bit:
     uint16_t tempR0 = R0 & ~R0_FCAL_EN;
 
     int result;
+    bool isLocked = false;
+    bool unlockSeen = false;
+    int lockedReads = 0;
+    QElapsedTimer fcalTimer;
+
+    lockTimeMs = -1;
     result = writeRegister(0, tempR0);  // FCCAL_EN low.
     if (result != globals::OK) return result;
-    globals::sleep(100);
 
     result = writeRegister(0, R0);  // Restore R0 (Should set FCAL_EN)
-    globals::sleep(100);
+    if (result != globals::OK) return result;
+    fcalTimer.start();
+
+    // Wait for lock:
+    while (fcalTimer.elapsed() < FCAL_LOCK_TIMEOUT_MS)
+    {
+        globals::sleep(FCAL_LOCK_POLL_MS);
+        result = lockStatusRead(&isLocked);
+        if (result == globals::NOT_IMPLEMENTED)
+        {
+            globals::sleep(FCAL_FIXED_SLEEP_MS);  // Lock detect not available: Fixed wait.
+            return globals::OK;
+        }
+        if (result != globals::OK) return result;
+        if (isLocked && !unlockSeen)
+        {
+            // Lock detect hasn't dropped since FCAL started, so it may be left over from
+            // the previous settings: Check the lock state for the new settings instead.
+            vcoCal_t cal;
+            result = vcoCalRead(&cal, &isLocked);
+            if (result != globals::OK) return result;
+            DEBUG_LMX("LMX: FCAL: No unlock seen; VCO readback: " << ((isLocked) ? "Locked" : "Not locked")
+                      << " (VCO_SEL " << cal.vcoSel << "; CAPCTRL " << cal.capCtrl << ")")
+            if (isLocked) lockedReads = FCAL_LOCK_CONFIRM;   // Readback is for the new settings: No need to confirm again
+        }
+        if (!isLocked)
+        {
+            unlockSeen = true;
+            lockedReads = 0;
+        }
+        else if (unlockSeen)
+        {
+            lockedReads++;
+        }
+        if (lockedReads >= FCAL_LOCK_CONFIRM)
+        {
+            lockTimeMs = static_cast<int>(fcalTimer.elapsed());
+            DEBUG_LMX("LMX: FCAL locked in " << lockTimeMs << " ms")
+            return globals::OK;
+        }
+    }
+    DEBUG_LMX("LMX: FCAL: No lock after " << FCAL_LOCK_TIMEOUT_MS << " ms!")
+    return globals::TIMEOUT;
+}
+
+
+
+/*!
+ \brief Read the LMX lock detect state
+ Uses the Lock Detect pin (via the IO controller) if MUXout is set up as lock
+ detect (LD_LED_ENABLE), or rb_LD_VTUNE in R110 otherwise.
+ \param isLocked  Used to return the lock state
+ \return globals::OK               Success
+ \return globals::NOT_IMPLEMENTED  No way to read lock detect
+ \return [error code]              Comms error
+*/
+int LMX2594::lockStatusRead(bool *isLocked)
+{
+    *isLocked = false;
+#ifdef LD_LED_ENABLE
+    if (!lockDetectIO) return globals::NOT_IMPLEMENTED;
+    return lockDetectIO->readLockDetect(isLocked);
+#else
+    uint16_t R110 = 0;
+    int result = readRegister(110, &R110);
+    if (result == globals::OK) *isLocked = (((R110 >> 9) & 0x03) == 2);  // rb_LD_VTUNE: 2 = Locked
     return result;
+#endif
 }
 
 
@@ -1054,10 +1572,8 @@ int LMX2594::resetDevice()
     // profile (these are fields in R0):
     bool bFound = false;
     uint16_t R0 = 0;
-    if (selectedProfileIndex < frequencyProfiles.count())
-    {
-        R0 = frequencyProfiles.at(selectedProfileIndex).getRegisterValue(0, &bFound);
-    }
+    const LMXFrequencyProfile *profile = profileGet(selectedProfileIndex);
+    if (profile) R0 = profile->getRegisterValue(0, &bFound);
     if (!bFound) R0 = R0_DEFAULT;  // Default to use if no profile selected.
 
     return resetPart(R0);
@@ -1127,7 +1643,9 @@ int LMX2594::initPart()
     // Step 2: Load default register values:
 
     // If frequency profiles were set up OK, load default profile:
+    // Nb: No lock yet (TIMEOUT) isn't fatal here; the profile is loaded, and lock is shown by the UI.
     result = selectProfile(profileIndexDefault);
+    if (result == globals::TIMEOUT) result = globals::OK;
     if (result == globals::OK)
     {
         DEBUG_LMX("LMX: Ouptut drivers ON")
@@ -1187,42 +1705,233 @@ int LMX2594::resetPart(uint16_t defaultR0)
 
     result = writeRegister(0, defaultR0);                 // Reset bit = Low.
     globals::sleep(LMX2594_RESET_POST_SLEEP);
+    // All registers except R0 are now back at their (unknown) power-on values:
+    shadowInvalidate();
+    if (result == globals::OK)
+    {
+        shadowValues[0]  = defaultR0;
+        shadowKnown[0]   = true;
+        shadowResetState = true;
+    }
     DEBUG_LMX(" -OK.")
     return result;
 }
 
 
 
+/*!
+ \brief Forget the shadow register values
+ Used when the state of the part isn't known (before init, and after reset).
+ The next profile selection will write every register.
+*/
+void LMX2594::shadowInvalidate()
+{
+    for (int i = 0; i < REGISTER_COUNT; i++)
+    {
+        shadowValues[i] = 0;
+        shadowKnown[i]  = false;
+    }
+    shadowResetState = false;
+}
 
-int LMX2594::configureOutputs()
+
+
+/*!
+ \brief Read back the VCO calibration results
+ Reads rb_VCO_SEL and rb_LD_VTUNE (R110), rb_VCO_CAPCTRL (R111) and
+ rb_VCO_DACISET (R112) after a calibration.
+
+ If MUXout is set up as Lock Detect (LD_LED_ENABLE), it is switched to serial
+ out for the readback, then switched back. FCAL_EN is cleared in both R0 writes
+ so that they don't start another calibration (runFCal sets it again).
+
+ \param cal       Used to return the calibration results (frequency not set)
+ \param isLocked  Used to return the lock state (rb_LD_VTUNE)
+ \return globals::OK
+ \return [error code]  Error from writeRegister or readRegister
+*/
+int LMX2594::vcoCalRead(vcoCal_t *cal, bool *isLocked)
 {
-    uint16_t R44 = 0, R45 = 0;
+    uint16_t R110 = 0;
+    uint16_t R111 = 0;
+    uint16_t R112 = 0;
+    int result;
+    *isLocked = false;
 
-    // We need to use MASH_RESET_EN and MASH_ORDER fields from profile for Reg 44:
+#ifdef LD_LED_ENABLE
+    const uint16_t R0 = ((shadowKnown[0]) ? shadowValues[0] : R0_DEFAULT) & ~R0_FCAL_EN;
+    result = writeRegister(0, R0 & ~R0_MUXOUT_LD_SEL);   // MUXout = Serial out
+    if (result != globals::OK) return result;
+    muxoutReadback = true;
+#endif
+
+    result = readRegister(110, &R110);
+    if (result == globals::OK) result = readRegister(111, &R111);
+    if (result == globals::OK) result = readRegister(112, &R112);
+
+#ifdef LD_LED_ENABLE
+    muxoutReadback = false;
+    int resultRestore = writeRegister(0, R0);             // MUXout = Lock Detect
+    if (result == globals::OK) result = resultRestore;
+#endif
+    if (result != globals::OK) return result;
+
+    cal->vcoSel  = (R110 >> 5) & 0x0007;
+    cal->capCtrl = R111 & 0x00FF;
+    cal->dacIset = R112 & 0x01FF;
+    *isLocked = (((R110 >> 9) & 0x03) == 2);  // rb_LD_VTUNE: 2 = Locked
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Merge cached VCO calibration start values into a profile register
+ Sets VCO_DACISET_STRT (R17), VCO_SEL (R20) and VCO_CAPCTRL_STRT (R78) from
+ the cache entry for the profile. Other registers, and profiles with no cache
+ entry, are unchanged.
+ \param profileIndex  Index of profile
+ \param regAddress    Register address
+ \param regValue      Register value from the profile; updated
+*/
+void LMX2594::vcoCalAssistApply(int profileIndex, uint8_t regAddress, uint16_t *regValue)
+{
+    if (!vcoCalCache.contains(profileIndex)) return;
+    const vcoCal_t cal = vcoCalCache.value(profileIndex);
+    switch (regAddress)
+    {
+    case 17: *regValue = setRegisterBits(*regValue, 9, 0,  cal.dacIset); break;   // VCO_DACISET_STRT
+    case 20: *regValue = setRegisterBits(*regValue, 3, 11, cal.vcoSel);  break;   // VCO_SEL
+    case 78: *regValue = setRegisterBits(*regValue, 8, 1,  cal.capCtrl); break;   // VCO_CAPCTRL_STRT
+    default: break;
+    }
+}
+
+
+
+/*!
+ \brief Load the VCO calibration cache for an instrument
+ Calibration results depend on the individual part, so the cache is kept in
+ a file for each instrument (by serial number) and clock (device ID) in the
+ application directory. Each line holds:
+   [profile index] [frequency, MHz] [VCO_SEL] [VCO_CAPCTRL] [VCO_DACISET]
+ Entries which don't match the current frequency profiles (e.g. new profiles
+ written to EEPROM) are ignored.
+ \param serial  Instrument serial number. If empty, results are cached for
+                this session only.
+*/
+void LMX2594::vcoCalLoad(const QString &serial)
+{
+    vcoCalCache.clear();
+    vcoCalFileName.clear();
+    QString serialClean = serial.trimmed();
+    for (int i = 0; i < serialClean.length(); i++)
+    {
+        if (!serialClean[i].isLetterOrNumber() && serialClean[i] != '-') serialClean[i] = '_';  // Safe for file name
+    }
+    if (serialClean.isEmpty() || globals::getAppPath().isEmpty())
+    {
+        DEBUG_LMX("LMX2594: No serial number; VCO calibration cache won't be saved.")
+        return;
+    }
+    vcoCalFileName = QString("%1\\vcocal_%2_%3.txt").arg(globals::getAppPath()).arg(serialClean).arg(deviceID);
+
+    QStringList lines;
+    int result = BertFile::readFile(vcoCalFileName, VCO_CAL_FILE_MAX_LINES, lines);
+    if (result != globals::OK) return;   // No cache yet
+    foreach (QString line, lines)
+    {
+        QStringList fields = line.simplified().split(' ');
+        if (fields.count() != 5) continue;
+        bool ok[5];
+        int index = fields[0].toInt(&ok[0]);
+        vcoCal_t cal;
+        cal.frequency = fields[1].toFloat(&ok[1]);
+        cal.vcoSel    = fields[2].toUShort(&ok[2]);
+        cal.capCtrl   = fields[3].toUShort(&ok[3]);
+        cal.dacIset   = fields[4].toUShort(&ok[4]);
+        if (!ok[0] || !ok[1] || !ok[2] || !ok[3] || !ok[4]) continue;
+        if (index < 0 || index >= frequencyProfiles.count()) continue;
+        if (qAbs(frequencyProfiles.at(index).getFrequency() - cal.frequency) > 0.01f) continue;
+        vcoCalCache.insert(index, cal);
+    }
+    DEBUG_LMX("LMX2594: " << vcoCalCache.count() << " VCO calibration results loaded from " << vcoCalFileName)
+}
+
+
+
+/*!
+ \brief Save the VCO calibration cache
+ See vcoCalLoad. Errors are logged only; the cache still works for this session.
+*/
+void LMX2594::vcoCalSave() const
+{
+    if (vcoCalFileName.isEmpty()) return;
+    QFile file(vcoCalFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        DEBUG_LMX("LMX2594: Couldn't write VCO calibration cache " << vcoCalFileName)
+        return;
+    }
+    foreach (int index, vcoCalCache.keys())
+    {
+        const vcoCal_t cal = vcoCalCache.value(index);
+        file.write(QString("%1 %2 %3 %4 %5\n")
+                   .arg(index)
+                   .arg(static_cast<double>(cal.frequency), 0, 'f', 4)
+                   .arg(cal.vcoSel)
+                   .arg(cal.capCtrl)
+                   .arg(cal.dacIset).toLatin1().data());
+    }
+    file.close();
+}
+
+
+
+/*!
+ \brief Get the output register settings (R44 and R45) for a profile
+ Uses MASH_RESET_EN and MASH_ORDER fields (R44) and OUTA_MUX / OUT_ISET (R45)
+ from the profile, with the selected output powers and power down state.
+ \param profileIndex  Index of profile (defaults are used if out of range)
+ \param R44           Used to return the value for R44
+ \param R45           Used to return the value for R45
+*/
+void LMX2594::outputRegistersGet(int profileIndex, uint16_t *R44, uint16_t *R45) const
+{
     bool bFound44 = false;
     bool bFound45 = false;
 
-    if (selectedProfileIndex < frequencyProfiles.count())
+    const LMXFrequencyProfile *profile = profileGet(profileIndex);
+    if (profile)
     {
-        R44 = frequencyProfiles.at(selectedProfileIndex).getRegisterValue(44, &bFound44);
-        R45 = frequencyProfiles.at(selectedProfileIndex).getRegisterValue(45, &bFound45);
+        *R44 = profile->getRegisterValue(44, &bFound44);
+        *R45 = profile->getRegisterValue(45, &bFound45);
     }
-    if (!bFound44) R44 = R44_DEFAULT;  // Default to use if no profile selected.
-    if (!bFound45) R45 = R45_DEFAULT;  // Default to use if no profile selected.
+    if (!bFound44) *R44 = R44_DEFAULT;  // Default to use if no profile selected.
+    if (!bFound45) *R45 = R45_DEFAULT;  // Default to use if no profile selected.
 
+    *R44 = (*R44 & 0xC03F) |  // Mask: OUTA_POW, OUTA_PD and OUTB_PD bits set to 0
+           static_cast<uint16_t>(POWER_CONSTS[selectedFOutOutputPowerIndex] << 8) | // OUTA_POW
+           static_cast<uint16_t>(((flagOutputsOn) ? 0x00 : 0x03) << 6);             // OUTA_PD and OUTB_PD
+
+    *R45 = (*R45 & 0xFFC0) |  // Mask: OUTB_PWR set to 0; other bits preserved
+           POWER_CONSTS[selectedTrigOutputPowerIndex];  // Set OUTB_POW
+}
 
-    DEBUG_LMX("RF Pow Index: " << selectedFOutOutputPowerIndex << " = " << POWER_CONSTS[selectedFOutOutputPowerIndex])
 
-    R44 = (R44 & 0xC03F) |  // Mask: OUTA_POW, OUTA_PD and OUTB_PD bits set to 0
-          (POWER_CONSTS[selectedFOutOutputPowerIndex] << 8) | // OUTA_POW
-          (((flagOutputsOn) ? 0x00 : 0x03) << 6);             // OUTA_PD and OUTB_PD
 
-    R45 = (R45 & 0xFFC0) |  // Mask: OUTB_PWR set to 0; other bits preserved
-           POWER_CONSTS[selectedTrigOutputPowerIndex];  // Set OUTB_POW
+
+int LMX2594::configureOutputs()
+{
+    uint16_t R44 = 0, R45 = 0;
+
+    DEBUG_LMX("RF Pow Index: " << selectedFOutOutputPowerIndex << " = " << POWER_CONSTS[selectedFOutOutputPowerIndex])
+    // We need to use MASH_RESET_EN and MASH_ORDER fields from profile for Reg 44:
+    outputRegistersGet(selectedProfileIndex, &R44, &R45);
 
     DEBUG_LMX("Set R44 to " << R44 << "; R45 to " << R45)
-    int result                        = writeRegister(44, R44);
-    if (result == globals::OK) result = writeRegister(45, R45);
+    int result                        = writeRegisterChanged(44, R44);
+    if (result == globals::OK) result = writeRegisterChanged(45, R45);
     DEBUG_LMX("Result: " << result)
     return result;
 
@@ -1250,7 +1959,7 @@ int LMX2594::configureOutputs()
 */
 void LMX2594::setSafeDefaults()
 {
-    QList<LMXFrequencyProfile>::iterator i;
+    QVector<LMXFrequencyProfile>::iterator i;
     for (i = frequencyProfiles.begin(); i != frequencyProfiles.end(); ++i)
     {
         DEBUG_LMX("Set SAFE defaults for " << i->getFrequency())
@@ -1354,11 +2063,32 @@ int LMX2594::writeRegister(const uint8_t regAddress, const uint16_t regValue)
 #ifdef LMX_REGISTER_DEBUG
      DEBUG_LMX("[LMX Register WRITE] Addr: " << regAddress << " Data: " << QString().sprintf("0x%04X", regValue) << " Result: " << result)
 #endif
+     // Update the shadow copy (if the write failed, the register value is unknown):
+     shadowValues[regAddress] = regValue;
+     shadowKnown[regAddress]  = (result == globals::OK);
+     if (regAddress != 0) shadowResetState = false;
      return result;
 }
 
 
 
+/*!
+ \brief Write value to LMX register, if different from the value last written
+ See writeRegister. Nothing is written if the shadow copy shows that the
+ register already holds regValue.
+ \return globals::OK               Success... Register data written (or unchanged)
+ \return [error code]              See writeRegister
+*/
+int LMX2594::writeRegisterChanged(const uint8_t regAddress, const uint16_t regValue)
+{
+    if (regAddress < REGISTER_COUNT
+     && shadowKnown[regAddress]
+     && shadowValues[regAddress] == regValue) return globals::OK;
+    return writeRegister(regAddress, regValue);
+}
+
+
+
 /*!
  \brief Set specific bits in a register value, leaving other bits unchanged
 
@@ -1424,10 +2154,8 @@ int LMX2594::writeRegisterBits(const uint8_t  address,
     uint16_t registerValue;
     bool bFound = false;
     // Get current setting for register (only want to change some bits):
-    if (selectedProfileIndex < frequencyProfiles.count())
-    {
-        registerOldValue = frequencyProfiles.at(selectedProfileIndex).getRegisterValue(address, &bFound);
-    }
+    const LMXFrequencyProfile *profile = profileGet(selectedProfileIndex);
+    if (profile) registerOldValue = profile->getRegisterValue(address, &bFound);
     if (!bFound) registerOldValue = registerDefaultValue;  // Default to use if no profile selected.
 
     registerValue = setRegisterBits(registerOldValue,
@@ -1456,11 +2184,15 @@ int LMX2594::readRegister(const uint8_t regAddress, uint16_t *regValue)
     if (regAddress >= REGISTER_COUNT) return globals::OVERFLOW;
 
 #ifdef LD_LED_ENABLE
-    // MUXout pin is set up as Lock Detect output; Can't read back register values!
-    Q_ASSERT(false);
-    Q_UNUSED(regValue);
-    return globals::NOT_IMPLEMENTED;
-#else
+    // MUXout pin is set up as Lock Detect output; Can't read back register values
+    // unless it has been switched to serial out for the moment (see vcoCalRead)!
+    if (!muxoutReadback)
+    {
+        Q_ASSERT(false);
+        Q_UNUSED(regValue);
+        return globals::NOT_IMPLEMENTED;
+    }
+#endif
 
     // Readback Step 1: Write to the SC18IS602B I2C-SPI bridge, using a register address
     // with uppermost bit (R/W) set to 1. Address is followed by two placeholder bytes.
@@ -1491,12 +2223,10 @@ int LMX2594::readRegister(const uint8_t regAddress, uint16_t *regValue)
     }
     *regValue = static_cast<uint16_t>((registerData[1] << 8) | registerData[2]);
 
-  #ifdef LMX_REGISTER_DEBUG
+#ifdef LMX_REGISTER_DEBUG
      DEBUG_LMX("[LMX Register READ] Addr: " << regAddress << " Data: " << INT_AS_HEX(*regValue,4) << " Result: " << result)
-  #endif
-    return result;
 #endif
-
+    return result;
 }
 
 
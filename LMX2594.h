@@ -10,6 +10,8 @@
 #define LMX2594_H
 
 #include <QList>
+#include <QVector>
+#include <QMap>
 #include <stdint.h>
 
 #include "globals.h"
@@ -17,6 +19,9 @@
 #include "BertComponent.h"
 #include "LMXFrequencyProfile.h"
 #include "M24M02.h"                // Needed to read / write frequency profiles to EEPROM
+#include "PCA9557.h"               // Lock Detect pin (see runFCal)
+#include "SI5340.h"                // Reference clock (see selectFrequency)
+#include "LMXPllPlanner.h"         // Register settings for any frequency (see selectFrequency)
 
 
 /*!
@@ -44,8 +49,18 @@ class LMX2594 : public BertComponent
     void getOptions();
     int init();                                                                     // Initialise the part
 
+    void setLockDetect(PCA9557 *lockDetectIO) { this->lockDetectIO = lockDetectIO; }  // IO controller with our Lock Detect pin (optional)
+    void setRefClock(SI5340 *refClock) { this->refClock = refClock; }                  // Reference clock generator (optional; fixed XO if not set)
+
+    // Profile / frequency selection for the frequency sweep (see FrequencySweep):
+    static int profileCount() { return frequencyProfiles.count(); }                 // Number of frequency profiles (0 until read from EEPROM)
+    int getFrequency(int index, float *frequency) const;                            // Find the frequency (MHz) of the frequency profile at the specificed index
+    int selectProfile(int index);                                                   // Switch to the frequency profile specified by index
+    int selectFrequency(double frequency);                                          // Switch to any frequency (register settings worked out here)
+    int getLockTimeMs() const { return lockTimeMs; }                                // Time from FCAL start to lock for the last profile selected (-1 if not locked)
+
 #define LMX2594_SIGNALS \
-    void LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPower, int indexFOutOutputPower, int indexTriggerDivide, bool outputsOn, float frequency); \
+    void LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPower, int indexFOutOutputPower, int indexTriggerDivide, bool outputsOn, float frequency, int lockTimeMs); \
     void LMXVTuneLock(int deviceID, bool isLocked); \
     void LMXSettingsChanged(int deviceID);
 
@@ -53,6 +68,7 @@ class LMX2594 : public BertComponent
     void GetLMXInfo();                                                         \
     void GetLMXVTuneLock();                                                    \
     void SelectProfile(int indexProfile, bool triggerResync = true);           \
+    void SelectFrequency(double frequency, bool triggerResync = true);         \
     void ConfigureOutputs(int indexFOutOutputPower,                            \
                           int indexTrigOutputPower,                            \
                           bool outputsOn,                                      \
@@ -63,12 +79,14 @@ class LMX2594 : public BertComponent
     void ResetDevice();
 
 #define LMX_CONNECT_SIGNALS(CLIENT, LMX2594) \
-    connect(LMX2594, SIGNAL(LMXInfo(int, int, int, int, int, bool, float)), CLIENT, SLOT(LMXInfo(int, int, int, int, int, bool, float)));               \
+    connect(LMX2594, SIGNAL(LMXInfo(int, int, int, int, int, bool, float, int)),                                                                      \
+                                                                            CLIENT, SLOT(LMXInfo(int, int, int, int, int, bool, float, int)));          \
     connect(LMX2594, SIGNAL(LMXVTuneLock(int, bool)),                       CLIENT, SLOT(LMXVTuneLock(int, bool)));                                     \
     connect(LMX2594, SIGNAL(LMXSettingsChanged(int)),                       CLIENT, SLOT(LMXSettingsChanged(int)));                                     \
     connect(CLIENT,  SIGNAL(GetLMXInfo()),                                  LMX2594, SLOT(GetLMXInfo()));                                               \
     connect(CLIENT,  SIGNAL(GetLMXVTuneLock()),                             LMX2594, SLOT(GetLMXVTuneLock()));                                          \
     connect(CLIENT,  SIGNAL(SelectProfile(int, bool)),                      LMX2594, SLOT(SelectProfile(int, bool)));                                   \
+    connect(CLIENT,  SIGNAL(SelectFrequency(double, bool)),                 LMX2594, SLOT(SelectFrequency(double, bool)));                              \
     connect(CLIENT,  SIGNAL(ConfigureOutputs(int, int, bool, bool)),        LMX2594, SLOT(ConfigureOutputs(int, int, bool, bool)));                     \
     connect(CLIENT,  SIGNAL(ReadTcsFrequencyProfiles(QString)),             LMX2594, SLOT(ReadTcsFrequencyProfiles(QString)));                          \
     connect(CLIENT,  SIGNAL(LMXEEPROMWriteFrequencyProfiles()),             LMX2594, SLOT(LMXEEPROMWriteFrequencyProfiles()));                          \
@@ -136,14 +154,30 @@ class LMX2594 : public BertComponent
     const uint32_t LMX2594_RESET_SLEEP = 600;        // Number of milliseconds to sleep during RESET (while RESET bit HIGH).
     const uint32_t LMX2594_RESET_POST_SLEEP = 400;   // Number of milliseconds to sleep AFTER RESET, before loading other registers.
 
+    // Frequency calibration (see runFCal):
+    static const int FCAL_LOCK_TIMEOUT_MS = 500;     // Give up waiting for lock after this long
+    static const int FCAL_LOCK_POLL_MS    = 1;       // Sleep between lock detect reads (plus the I2C read time)
+    static const int FCAL_LOCK_CONFIRM    = 2;       // Consecutive "locked" reads needed
+    static const int FCAL_FIXED_SLEEP_MS  = 100;     // Wait after FCAL if lock detect can't be read
+
+    static const int VCO_CAL_FILE_MAX_LINES = 1000;  // Limit for the VCO calibration cache file (see vcoCalLoad)
+
+    // Synthesised frequencies (see selectFrequency):
+    static const uint16_t SYNTH_PROFILE_INDEX = 0xFFFF;  // Profile index used for synthProfile
+    static const double REF_XO_FREQUENCY;                 // Reference frequency (MHz) if there's no SI5340
+
     //  **********************************************************************
 
     I2CComms *comms;
     const uint8_t i2cAddress;
     const int deviceID;
     M24M02 *eeprom;
+    PCA9557 *lockDetectIO = nullptr;   // Lock Detect pin, if available (set by BertWorker)
+    SI5340 *refClock = nullptr;        // Reference clock generator, if available (set by BertWorker)
 
     int spiAdaptorIsOpen = false;
+    bool muxoutReadback = false;       // MUXout temporarily set up as serial out (see vcoCalRead)
+    int lockTimeMs = -1;               // Time from FCAL start to lock for the last profile selected (-1 if unknown / not locked)
 
     /****** Clock Gen State: **********************/
     uint16_t   selectedProfileIndex = 0;
@@ -152,8 +186,30 @@ class LMX2594 : public BertComponent
     uint16_t   selectedTrigDivideIndex = 0;
     bool       flagOutputsOn = false;
 
+    // Shadow copy of the register values written to the part (see writeRegister).
+    // Used to write only the registers which change when switching profiles:
+    uint16_t   shadowValues[REGISTER_COUNT];
+    bool       shadowKnown[REGISTER_COUNT];
+    bool       shadowResetState = false;   // true if the part has been reset, and nothing but R0 written since
+
+    // VCO calibration results, read back after the first lock on each profile.
+    // Used as start values for later calibrations on the same profile (see selectProfile):
+    typedef struct vcoCal_t
+    {
+        float    frequency;   // Frequency of the profile (MHz); checked when the cache file is loaded
+        uint16_t vcoSel;      // rb_VCO_SEL      (R110) -> VCO_SEL          (R20)
+        uint16_t capCtrl;     // rb_VCO_CAPCTRL  (R111) -> VCO_CAPCTRL_STRT (R78)
+        uint16_t dacIset;     // rb_VCO_DACISET  (R112) -> VCO_DACISET_STRT (R17)
+    } vcoCal_t;
+
+    QMap<int, vcoCal_t> vcoCalCache;    // Calibration results for this part, by profile index
+    QString vcoCalFileName;             // File used to keep the cache for this instrument (empty = don't save)
+
+    // Profile for the last frequency set with selectFrequency (selected as SYNTH_PROFILE_INDEX):
+    LMXFrequencyProfile synthProfile;
+
     // Main Frequency Profiles: These are read from EEPROM
-    static QList<LMXFrequencyProfile> frequencyProfiles;
+    static QVector<LMXFrequencyProfile> frequencyProfiles;
     static QStringList frequencyList;
     static uint16_t profileIndexDefault;    // Index of default start-up frequency profile
     // DEPRECATED static bool frequencyProfilesOK;
@@ -166,7 +222,7 @@ class LMX2594 : public BertComponent
     //   and it contains some .TCS files.
     // If profiles are found as per above, they are displayed and the user has the
     // option to write them to EEPROM.
-    static QList<LMXFrequencyProfile> frequencyProfilesFromFiles;
+    static QVector<LMXFrequencyProfile> frequencyProfilesFromFiles;
     static QStringList frequencyListFromFiles;
 
 
@@ -177,21 +233,48 @@ class LMX2594 : public BertComponent
 
     static int parseTcsFrequencyProfile(QStringList &fileContent, const QString partNo, LMXFrequencyProfile &profileToFill);
 
+    // Cache of parsed register def files (see getProfilesFromRegisterFiles):
+    static const QString PROFILE_CACHE_FILE;                 // Cache file name (in the register file directory)
+    static const uint32_t PROFILE_CACHE_MAGIC   = 0x43534354; // "TCSC"
+    static const uint16_t PROFILE_CACHE_VERSION = 1;         // Change if the cache format changes
+
+    typedef struct profileCacheEntry_t
+    {
+        qint64   size;                 // File size (bytes)
+        qint64   modified;             // File last modified time (mS since epoch)
+        uint32_t hash;                 // Hash of file contents (see profileCacheHash)
+        LMXFrequencyProfile profile;   // Parsed profile (not valid if the file didn't parse)
+    } profileCacheEntry_t;
+
+    static int profileCacheLoad(const QString &registerFilePath, const QString &partNo, QMap<QString, profileCacheEntry_t> &entries);
+    static int profileCacheSave(const QString &registerFilePath, const QString &partNo, const QMap<QString, profileCacheEntry_t> &entries);
+    static uint32_t profileCacheHash(const uint8_t *data, qint64 size);
+    static bool profileCacheTake(const uint8_t **data, const uint8_t *dataEnd, void *value, qint64 size);
+
     static int initAdaptor(I2CComms *comms, const uint8_t i2cAddress);   // Initialise the I2C to SPI adaptor
 
     int initPart();                                                      // Part-specific Initialisation
-    int getFrequency(int index, float *frequency) const;                 // Find the frequency (MHz) of the frequency profile at the specificed index
-    int selectProfile(int index);                                        // Switch to the frequency profile specified by index
+    const LMXFrequencyProfile *profileGet(int index) const;              // Profile at index (or synthProfile), or NULL if none
     int runFCal();                                                       // Run frequency calibration
+    int lockStatusRead(bool *isLocked);                                  // Read lock detect (pin or register)
     int resetDevice();                                                   // Reset the part to default settings
     int configureOutputs();                                              // Output driver setup
     void setSafeDefaults();                                              // Set safe default settings
     int resetPart(uint16_t defaultR0);                                   // Part-specific reset function: Implemented by derived versions
+    void outputRegistersGet(int profileIndex, uint16_t *R44, uint16_t *R45) const;  // Output power / power down settings for a profile
+    void shadowInvalidate();                                             // Forget the shadow register values (part state unknown)
+
+    // VCO calibration assist:
+    int vcoCalRead(vcoCal_t *cal, bool *isLocked);                       // Read back the calibration results
+    void vcoCalAssistApply(int profileIndex, uint8_t regAddress, uint16_t *regValue);  // Merge cached start values into a profile register
+    void vcoCalLoad(const QString &serial);                              // Load the cache for an instrument
+    void vcoCalSave() const;                                             // Save the cache
 
 
     // Register writing:
 
     int writeRegister(const uint8_t regAddress, const uint16_t regValue);
+    int writeRegisterChanged(const uint8_t regAddress, const uint16_t regValue);
 
     uint16_t setRegisterBits(const uint16_t registerInputValue,
                              const uint8_t  nBits,
@@ -6,6 +6,7 @@
 */
 
 #include <QDebug>
+#include <string.h>
 
 #include "LMXFrequencyProfile.h"
 
@@ -15,12 +16,9 @@ LMXFrequencyProfile::LMXFrequencyProfile()
 
 LMXFrequencyProfile::LMXFrequencyProfile(const int registerCount)
 {
-     this->registerCount = registerCount;
+     setRegisterCount(registerCount);
 }
 
-LMXFrequencyProfile::~LMXFrequencyProfile()
-{}
-
 
 /*!
  \brief Set register value
@@ -29,13 +27,14 @@ LMXFrequencyProfile::~LMXFrequencyProfile()
  \param address  Register address to set a value for (0 to max address)
  \param value    Value for register
  \return globals::OK        Success
- \return globals::OVERFLOW  Address out of range (> LMX2594::MAX_REGISTER_ADDRESS)
+ \return globals::OVERFLOW  Address out of range (>= register count)
 */
 int LMXFrequencyProfile::setRegisterValue(const uint8_t address, const uint16_t value)
 {
     Q_ASSERT(address < registerCount);
-    if (address > registerCount) return globals::OVERFLOW;
-    registers.insert(address, value);
+    if (address >= registerCount) return globals::OVERFLOW;
+    registers[address] = value;
+    registersSet[address >> 5] |= (1u << (address & 0x1F));
     return globals::OK;
  }
 
@@ -59,10 +58,10 @@ uint16_t LMXFrequencyProfile::getRegisterValue(const uint8_t address, bool *regi
 {
     Q_ASSERT(address < registerCount);
 
-    if (registers.contains(address))
+    if (isRegisterSet(address))
     {
         if (registerFound) *registerFound = true;
-        return registers.value(address);
+        return registers[address];
     }
     else
     {
@@ -72,4 +71,122 @@ uint16_t LMXFrequencyProfile::getRegisterValue(const uint8_t address, bool *regi
 }
 
 
+/*!
+ \brief Get the number of registers which have been set
+*/
+int LMXFrequencyProfile::getUsedRegisterCount() const
+{
+    int count = 0;
+    for (int i = 0; i < SET_WORDS; i++)
+    {
+        uint32_t bits = registersSet[i];
+        while (bits)
+        {
+            bits &= bits - 1;
+            count++;
+        }
+    }
+    return count;
+}
+
+
+/*!
+ \brief Compare register values with another profile
+ Registers which haven't been set count as 0 (as for getRegisterValue).
+ \param other  Profile to compare with
+ \return Lowest register address where the values are different, or -1 if
+         all values are the same (up to the larger register count)
+*/
+int LMXFrequencyProfile::firstDifference(const LMXFrequencyProfile &other) const
+{
+    const int count = qMax(registerCount, other.registerCount);
+    if (memcmp(registers, other.registers, count * sizeof(registers[0])) == 0) return -1;
+    for (int address = 0; address < count; address++)
+    {
+        if (registers[address] != other.registers[address]) return address;
+    }
+    return -1;
+}
+
+
+/*!
+ \brief Hash of the profile contents (frequency and registers), e.g. for QHash
+ FNV-1a over the frequency, register set bitmap and register values.
+*/
+uint32_t LMXFrequencyProfile::hash() const
+{
+    uint32_t hashValue = 2166136261u;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&frequency);
+    size_t i;
+    for (i = 0; i < sizeof(frequency); i++)     hashValue = (hashValue ^ bytes[i]) * 16777619u;
+    bytes = reinterpret_cast<const uint8_t *>(registersSet);
+    for (i = 0; i < sizeof(registersSet); i++)  hashValue = (hashValue ^ bytes[i]) * 16777619u;
+    bytes = reinterpret_cast<const uint8_t *>(registers);
+    for (i = 0; i < static_cast<size_t>(registerCount) * sizeof(registers[0]); i++) hashValue = (hashValue ^ bytes[i]) * 16777619u;
+    return hashValue;
+}
+
+
+/*!
+ \brief Profiles are equal if they have the same frequency, register count and registers
+*/
+bool LMXFrequencyProfile::operator==(const LMXFrequencyProfile &other) const
+{
+    return frequency == other.frequency
+        && registerCount == other.registerCount
+        && memcmp(registersSet, other.registersSet, sizeof(registersSet)) == 0
+        && memcmp(registers, other.registers, sizeof(registers)) == 0;
+}
+
+
+/*!
+ \brief Get the register values as bytes
+ Registers 0 to (register count - 1), 2 bytes each, LSB first.
+ Registers which haven't been set are written as 0.
+ \param data  Buffer for the data: Must have room for (register count * 2) bytes
+ \return Number of bytes written
+*/
+int LMXFrequencyProfile::toBytes(uint8_t *data) const
+{
+    for (int address = 0; address < registerCount; address++)
+    {
+        data[(address * 2)]     = static_cast<uint8_t>(registers[address] & 0x00FF);
+        data[(address * 2) + 1] = static_cast<uint8_t>(registers[address] >> 8);
+    }
+    return registerCount * 2;
+}
+
+
+/*!
+ \brief Set register values from bytes (see toBytes)
+ Sets the register count, and sets all registers from 0 to (registerCount - 1).
+ Other registers are cleared.
+ \param data           Register data (registerCount * 2 bytes)
+ \param registerCount  Number of registers (limited to REGISTER_CAPACITY)
+*/
+void LMXFrequencyProfile::fromBytes(const uint8_t *data, int registerCount)
+{
+    memset(registers, 0, sizeof(registers));
+    memset(registersSet, 0, sizeof(registersSet));
+    setRegisterCount(registerCount);
+    for (int address = 0; address < this->registerCount; address++)
+    {
+        registers[address] = static_cast<uint16_t>(data[(address * 2) + 1] << 8) | data[address * 2];
+        registersSet[address >> 5] |= (1u << (address & 0x1F));
+    }
+}
+
+
+/*!
+ \brief Clear all register values (the register count is kept)
+*/
+void LMXFrequencyProfile::clear()
+{
+    memset(registers, 0, sizeof(registers));
+    memset(registersSet, 0, sizeof(registersSet));
+    valid = false;
+    frequency = 0.0;
+}
+
+
 
@@ -9,24 +9,30 @@
 #ifndef LMXFREQUENCYPROFILE_H
 #define LMXFREQUENCYPROFILE_H
 
-#include <QMap>
 #include <stdint.h>
+#include <QtGlobal>
 
 #include "globals.h"
 
 /*!
   \brief LMX Frequency Profile Class
-  Stores the register values for a frequency setting
+  Stores the register values for a frequency setting.
+  Values are kept in a fixed array (by register address), with a bitmap to
+  show which registers have been set, so profiles can be copied, compared
+  and serialised as plain blocks of memory (the class is trivially
+  copyable, and declared movable for Qt containers). Registers which
+  haven't been set read as 0.
 */
 class LMXFrequencyProfile
 {
 public:
 
+    static const int REGISTER_CAPACITY = 113;   // Largest register count (LMX2594 has 113 registers)
+
     LMXFrequencyProfile();
     explicit LMXFrequencyProfile(const int registerCount);
-    ~LMXFrequencyProfile();
 
-    void setRegisterCount(int registerCount) { this->registerCount = registerCount; }
+    void setRegisterCount(int registerCount) { this->registerCount = qBound(0, registerCount, static_cast<int>(REGISTER_CAPACITY)); }
     int getRegisterCount() const { return registerCount; }
 
     void setValid()            { valid = true;       }
@@ -37,8 +43,19 @@ public:
 
     int setRegisterValue(const uint8_t address, const uint16_t value);
     uint16_t getRegisterValue(const uint8_t address, bool *registerFound) const;
+    bool isRegisterSet(const uint8_t address) const
+    {
+        return (address < REGISTER_CAPACITY) && ((registersSet[address >> 5] >> (address & 0x1F)) & 1u);
+    }
+
+    int getUsedRegisterCount() const;
+
+    int firstDifference(const LMXFrequencyProfile &other) const;   // First register address with a different value (-1 if none)
+    uint32_t hash() const;
+    bool operator==(const LMXFrequencyProfile &other) const;
 
-    int getUsedRegisterCount() const { return registers.count(); }
+    int toBytes(uint8_t *data) const;                                     // Register values as bytes (2 per register, LSB first)
+    void fromBytes(const uint8_t *data, int registerCount);               // Set registers 0 to (registerCount - 1) from bytes
 
     void clear();
 
@@ -46,7 +63,7 @@ private:
 
     int registerCount = 0;
        // Maximum number of registers which can be stored. We assume they will be for addresses 0 to (registerCount-1)
-       // and enforce this limit. Note address is uint8_t so maximum possible number of registers is 256.
+       // and enforce this limit (no more than REGISTER_CAPACITY).
        // Note that data will only be stored for registers which have been set with setRegisterValue.
        // getUsedRegisterCount stores the actual number of registers we have stored.
        // Defaults to 0, so register valuess can't be set unless a count is supplied to the constructor,
@@ -55,10 +72,16 @@ private:
     bool valid = false;
     float frequency = 0.0;
 
-    QMap<uint8_t, uint16_t> registers;
+    static const int SET_WORDS = (REGISTER_CAPACITY + 31) / 32;
+
+    uint16_t registers[REGISTER_CAPACITY] = {};   // Register values, by address (0 if not set)
+    uint32_t registersSet[SET_WORDS] = {};        // Bit for each address: Register has been set
 
 };
 
+Q_DECLARE_TYPEINFO(LMXFrequencyProfile, Q_MOVABLE_TYPE);
+
 
+inline uint qHash(const LMXFrequencyProfile &profile, uint seed = 0) { return profile.hash() ^ seed; }
 
 #endif // LMXFREQUENCYPROFILE_H
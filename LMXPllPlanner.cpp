@@ -0,0 +1,324 @@
+/*!
+ \file   LMXPllPlanner.cpp
+ \brief  LMX2594 PLL Planner (register settings for any output frequency) - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+#include <math.h>
+
+#include "LMXPllPlanner.h"
+
+
+// VCO range (MHz):
+const double LMXPllPlanner::VCO_MIN_MHZ = 7500.0;
+const double LMXPllPlanner::VCO_MAX_MHZ = 15000.0;
+
+// Channel divider ratios, in order of CHDIV field value (R75):
+const int LMXPllPlanner::CHDIV_LIST[] =
+    { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64, 72, 96, 128, 192, 256, 384, 512, 768 };
+const int LMXPllPlanner::CHDIV_LIST_SIZE = sizeof(CHDIV_LIST) / sizeof(CHDIV_LIST[0]);
+
+// VCO cores (VCO_SEL = index + 1), with the start values for partial assist
+// at each end of the core's range (LMX2594 datasheet):
+const LMXPllPlanner::vcoCore_t LMXPllPlanner::VCO_CORES[] =
+{
+  //  fMin      fMax    capMin capMax dacMin dacMax
+    {  7500.0,  8600.0,  164,   12,   299,   240 },   // VCO1
+    {  8600.0,  9800.0,  165,   16,   356,   247 },   // VCO2
+    {  9800.0, 10800.0,  158,   19,   324,   224 },   // VCO3
+    { 10800.0, 12000.0,  140,    0,   383,   244 },   // VCO4
+    { 12000.0, 12900.0,  183,   36,   205,   146 },   // VCO5
+    { 12900.0, 13900.0,  155,    6,   242,   163 },   // VCO6
+    { 13900.0, 15000.0,  175,   19,   323,   244 }    // VCO7
+};
+const int LMXPllPlanner::VCO_CORES_SIZE = sizeof(VCO_CORES) / sizeof(VCO_CORES[0]);
+
+// Minimum N and PFD_DLY_SEL for each MASH order (LMX2594 datasheet).
+// Rows for each order are in ascending order of VCO frequency:
+const LMXPllPlanner::nDivLimit_t LMXPllPlanner::N_DIV_LIMITS[] =
+{
+  // MASH  fVcoMax  nMin  PFD_DLY_SEL
+    { 0,  12500.0,  28,  1 },
+    { 0,  15000.0,  32,  2 },
+    { 1,  10000.0,  28,  1 },
+    { 1,  12500.0,  32,  2 },
+    { 1,  15000.0,  36,  3 },
+    { 2,  10000.0,  32,  2 },
+    { 2,  15000.0,  36,  3 },
+    { 3,  10000.0,  36,  3 },
+    { 3,  15000.0,  40,  4 },
+    { 4,  10000.0,  44,  5 },
+    { 4,  15000.0,  48,  6 }
+};
+const int LMXPllPlanner::N_DIV_LIMITS_SIZE = sizeof(N_DIV_LIMITS) / sizeof(N_DIV_LIMITS[0]);
+
+// Highest phase detector frequency (MHz) for each MASH order:
+const double LMXPllPlanner::FPD_MAX_MHZ[5] = { 400.0, 300.0, 300.0, 300.0, 240.0 };
+
+// Charge pump current (mA) for each CPG code (0 = not used):
+const double LMXPllPlanner::CPG_CURRENTS[8] = { 0.0, 6.0, 0.0, 12.0, 3.0, 9.0, 0.0, 15.0 };
+
+
+
+/*!
+ \brief Read the reference path settings from a profile
+ \param profile  Profile to read (R9 - R12)
+ \param fOsc     Reference input frequency (MHz)
+ \param ref      Used to return the settings and phase detector frequency
+ \return globals::OK
+ \return globals::INVALID_DATA  Profile doesn't include the reference path registers
+ \return globals::OVERFLOW      Reference frequency not valid
+*/
+int LMXPllPlanner::referenceRead(const LMXFrequencyProfile &profile, double fOsc, refPath_t *ref)
+{
+    if (fOsc <= 0.0) return globals::OVERFLOW;
+    uint32_t osc2x, mult, pllR, preR;
+    if (!fieldGet(profile,  9, 1, 12, &osc2x)
+     || !fieldGet(profile, 10, 5, 7,  &mult)
+     || !fieldGet(profile, 11, 8, 4,  &pllR)
+     || !fieldGet(profile, 12, 12, 0, &preR)) return globals::INVALID_DATA;
+
+    ref->fOsc  = fOsc;
+    ref->osc2x = (osc2x != 0);
+    ref->mult  = (mult == 0) ? 1 : static_cast<int>(mult);  // 0 is treated as bypass
+    ref->pllR  = (pllR == 0) ? 1 : static_cast<int>(pllR);
+    ref->preR  = (preR == 0) ? 1 : static_cast<int>(preR);
+    ref->fPd   = (fOsc * ((ref->osc2x) ? 2.0 : 1.0) * ref->mult) / (ref->preR * ref->pllR);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Work out the PLL settings for an output frequency
+ \param ref   Reference path (see referenceRead)
+ \param fOut  Required output frequency (MHz)
+ \param base  Profile which the new settings will be applied to (see
+              registersApply). The MASH order (for fractional N) and charge
+              pump current / N ratio are taken from this profile.
+ \param plan  Used to return the settings
+ \return globals::OK
+ \return globals::OVERFLOW  Frequency can't be reached with this reference path
+*/
+int LMXPllPlanner::plan(const refPath_t &ref, double fOut, const LMXFrequencyProfile &base, plan_t *plan)
+{
+    const double fOutMin = VCO_MIN_MHZ / CHDIV_LIST[CHDIV_LIST_SIZE - 1];
+    if (ref.fPd <= 0.0 || fOut < fOutMin || fOut > VCO_MAX_MHZ) return globals::OVERFLOW;
+
+    // Output: VCO direct, or the smallest channel divider which puts the VCO in range:
+    int chDiv = 1;
+    plan->chDivIndex = -1;
+    if (fOut < VCO_MIN_MHZ)
+    {
+        for (int i = 0; i < CHDIV_LIST_SIZE; i++)
+        {
+            if ((fOut * CHDIV_LIST[i]) >= VCO_MIN_MHZ)
+            {
+                plan->chDivIndex = i;
+                chDiv = CHDIV_LIST[i];
+                break;
+            }
+        }
+    }
+    const double fVcoTarget = fOut * chDiv;
+    if (fVcoTarget < VCO_MIN_MHZ || fVcoTarget > VCO_MAX_MHZ) return globals::OVERFLOW;
+
+    // N divider:
+    const double ratio = fVcoTarget / ref.fPd;
+    plan->n = static_cast<uint32_t>(floor(ratio));
+    fractionFind(ratio - floor(ratio), DEN_MAX, &plan->num, &plan->den);
+    if (plan->num >= plan->den)
+    {
+        plan->n++;  // Rounded up to the next integer
+        plan->num = 0;
+        plan->den = 1;
+    }
+    plan->fVco = ref.fPd * (static_cast<double>(plan->n) + (static_cast<double>(plan->num) / plan->den));
+    plan->fOut = plan->fVco / chDiv;
+    if (plan->n > 0x7FFFF) return globals::OVERFLOW;  // PLL_N is 19 bits
+
+    // MASH order: Integer mode if no fraction; otherwise as used by the base profile:
+    uint32_t baseMashOrder = 0;
+    fieldGet(base, 44, 3, 0, &baseMashOrder);
+    if (plan->num == 0)                             plan->mashOrder = 0;
+    else if (baseMashOrder >= 1 && baseMashOrder <= 4) plan->mashOrder = static_cast<int>(baseMashOrder);
+    else                                            plan->mashOrder = MASH_ORDER_DEFAULT;
+    if (ref.fPd > FPD_MAX_MHZ[plan->mashOrder]) return globals::OVERFLOW;
+
+    // Minimum N and PFD delay:
+    int i;
+    for (i = 0; i < N_DIV_LIMITS_SIZE; i++)
+    {
+        if (N_DIV_LIMITS[i].mashOrder == plan->mashOrder && plan->fVco <= N_DIV_LIMITS[i].fVcoMax) break;
+    }
+    if (i >= N_DIV_LIMITS_SIZE) return globals::OVERFLOW;
+    if (plan->n < static_cast<uint32_t>(N_DIV_LIMITS[i].nMin)) return globals::OVERFLOW;  // fPD too high for this VCO frequency
+    plan->pfdDlySel = N_DIV_LIMITS[i].pfdDlySel;
+
+    // VCO core and calibration start values (partial assist):
+    for (i = 0; i < VCO_CORES_SIZE - 1; i++)
+    {
+        if (plan->fVco < VCO_CORES[i].fMax) break;
+    }
+    const vcoCore_t &core = VCO_CORES[i];
+    double position = (plan->fVco - core.fMin) / (core.fMax - core.fMin);
+    position = qBound(0.0, position, 1.0);
+    plan->vcoCore     = i + 1;
+    plan->capCtrlStrt = static_cast<uint16_t>(floor(core.capMin - ((core.capMin - core.capMax) * position) + 0.5));
+    plan->dacIsetStrt = static_cast<uint16_t>(floor(core.dacMin - ((core.dacMin - core.dacMax) * position) + 0.5));
+
+    // Charge pump: Loop gain goes as Icp / N (the VCO gain is taken as about
+    // the same near the base profile), so scale the base current with N:
+    uint32_t baseCpg = 0, baseNHigh = 0, baseNLow = 0;
+    fieldGet(base, 14, 3, 4, &baseCpg);
+    fieldGet(base, 34, 3, 0, &baseNHigh);
+    fieldGet(base, 36, 16, 0, &baseNLow);
+    const double baseN = static_cast<double>((baseNHigh << 16) | baseNLow);
+    const double baseCurrent = CPG_CURRENTS[baseCpg & 0x07];
+    plan->cpg = static_cast<int>(baseCpg);
+    if (baseCurrent > 0.0 && baseN > 0.0)
+    {
+        const double targetCurrent = baseCurrent * (static_cast<double>(plan->n) / baseN);
+        double bestError = -1.0;
+        for (int code = 0; code < 8; code++)
+        {
+            if (CPG_CURRENTS[code] <= 0.0) continue;
+            const double error = fabs(CPG_CURRENTS[code] - targetCurrent);
+            if (bestError < 0.0 || error < bestError)
+            {
+                bestError = error;
+                plan->cpg = code;
+            }
+        }
+    }
+
+    // Calibration adjustments for the phase detector frequency:
+    if      (ref.fPd <= 100.0) plan->fcalHpfdAdj = 0;
+    else if (ref.fPd <= 150.0) plan->fcalHpfdAdj = 1;
+    else if (ref.fPd <= 200.0) plan->fcalHpfdAdj = 2;
+    else                       plan->fcalHpfdAdj = 3;
+    if      (ref.fPd >= 10.0)  plan->fcalLpfdAdj = 0;
+    else if (ref.fPd >= 5.0)   plan->fcalLpfdAdj = 1;
+    else if (ref.fPd >= 2.5)   plan->fcalLpfdAdj = 2;
+    else                       plan->fcalLpfdAdj = 3;
+
+    qDebug() << "LMXPllPlanner: " << fOut << " MHz: fPD " << ref.fPd << "; N " << plan->n << " + " << plan->num << "/" << plan->den
+             << "; CHDIV " << chDiv << "; MASH " << plan->mashOrder << "; VCO" << plan->vcoCore << "; CPG " << plan->cpg
+             << "; Error " << ((plan->fOut - fOut) * 1e6) << " Hz";
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Write PLL settings into a profile
+ Only the fields set by plan are changed; the profile must already include
+ all the registers which hold them (e.g. a copy of a TICS profile).
+ \param plan     Settings from plan
+ \param profile  Profile to update
+ \return globals::OK
+ \return globals::INVALID_DATA  Profile is missing one or more of the registers
+*/
+int LMXPllPlanner::registersApply(const plan_t &plan, LMXFrequencyProfile *profile)
+{
+    bool ok = true;
+    ok &= fieldSet(profile,  0, 2, 7,  static_cast<uint32_t>(plan.fcalHpfdAdj));   // FCAL_HPFD_ADJ
+    ok &= fieldSet(profile,  0, 2, 5,  static_cast<uint32_t>(plan.fcalLpfdAdj));   // FCAL_LPFD_ADJ
+    ok &= fieldSet(profile, 14, 3, 4,  static_cast<uint32_t>(plan.cpg));           // CPG
+    ok &= fieldSet(profile, 17, 9, 0,  plan.dacIsetStrt);                           // VCO_DACISET_STRT
+    ok &= fieldSet(profile, 20, 3, 11, static_cast<uint32_t>(plan.vcoCore));       // VCO_SEL
+    ok &= fieldSet(profile, 20, 1, 10, 0);                                          // VCO_SEL_FORCE off (start value only)
+    ok &= fieldSet(profile, 34, 3, 0,  plan.n >> 16);                               // PLL_N[18:16]
+    ok &= fieldSet(profile, 36, 16, 0, plan.n & 0xFFFF);                            // PLL_N[15:0]
+    ok &= fieldSet(profile, 37, 6, 8,  static_cast<uint32_t>(plan.pfdDlySel));     // PFD_DLY_SEL
+    ok &= fieldSet(profile, 38, 16, 0, plan.den >> 16);                             // PLL_DEN[31:16]
+    ok &= fieldSet(profile, 39, 16, 0, plan.den & 0xFFFF);                          // PLL_DEN[15:0]
+    ok &= fieldSet(profile, 42, 16, 0, plan.num >> 16);                             // PLL_NUM[31:16]
+    ok &= fieldSet(profile, 43, 16, 0, plan.num & 0xFFFF);                          // PLL_NUM[15:0]
+    ok &= fieldSet(profile, 44, 3, 0,  static_cast<uint32_t>(plan.mashOrder));     // MASH_ORDER
+    if (plan.mashOrder > 0) ok &= fieldSet(profile, 44, 1, 5, 1);                   // MASH_RESET_N: Fractional modulator running
+    ok &= fieldSet(profile, 78, 8, 1,  plan.capCtrlStrt);                           // VCO_CAPCTRL_STRT
+    if (plan.chDivIndex < 0)
+    {
+        ok &= fieldSet(profile, 45, 2, 11, 1);                                      // OUTA_MUX = VCO
+    }
+    else
+    {
+        ok &= fieldSet(profile, 45, 2, 11, 0);                                      // OUTA_MUX = Channel divider
+        ok &= fieldSet(profile, 75, 5, 6,  static_cast<uint32_t>(plan.chDivIndex)); // CHDIV
+        ok &= fieldSet(profile, 31, 1, 14, (CHDIV_LIST[plan.chDivIndex] > 2) ? 1 : 0);  // CHDIV_DIV2
+    }
+    if (!ok) return globals::INVALID_DATA;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Find the closest fraction to a value
+ Continued fraction expansion, stopping at the last convergent with a
+ denominator no larger than denMax.
+ \param value   Value to approximate (0 <= value < 1)
+ \param denMax  Largest denominator
+ \param num     Used to return the numerator
+ \param den     Used to return the denominator (1 if value is 0)
+*/
+void LMXPllPlanner::fractionFind(double value, uint32_t denMax, uint32_t *num, uint32_t *den)
+{
+    // Convergents h/k; start with h(-1)/k(-1) = 1/0 and h(-2)/k(-2) = 0/1:
+    double h1 = 1.0, k1 = 0.0;
+    double h2 = 0.0, k2 = 1.0;
+    double x = value;
+    *num = 0;
+    *den = 1;
+    for (int term = 0; term < 64; term++)
+    {
+        const double a = floor(x);
+        const double h = (a * h1) + h2;
+        const double k = (a * k1) + k2;
+        if (k > static_cast<double>(denMax)) break;
+        *num = static_cast<uint32_t>(h);
+        *den = static_cast<uint32_t>(k);
+        if (fabs(value - (h / k)) < 1e-13) break;  // Exact (to double precision)
+        const double remainder = x - a;
+        if (remainder <= 0.0) break;
+        x = 1.0 / remainder;
+        h2 = h1;  k2 = k1;
+        h1 = h;   k1 = k;
+    }
+    if (*num == 0) *den = 1;
+}
+
+
+
+/*!
+ \brief Get a field from a profile register
+ \return true if the register is in the profile
+*/
+bool LMXPllPlanner::fieldGet(const LMXFrequencyProfile &profile, uint8_t address, int nBits, int shift, uint32_t *value)
+{
+    bool found = false;
+    const uint16_t registerValue = profile.getRegisterValue(address, &found);
+    if (!found) return false;
+    *value = (static_cast<uint32_t>(registerValue) >> shift) & ((1u << nBits) - 1);
+    return true;
+}
+
+
+
+/*!
+ \brief Set a field in a profile register (other bits are kept)
+ \return true if the register is in the profile
+*/
+bool LMXPllPlanner::fieldSet(LMXFrequencyProfile *profile, uint8_t address, int nBits, int shift, uint32_t value)
+{
+    bool found = false;
+    uint16_t registerValue = profile->getRegisterValue(address, &found);
+    if (!found) return false;
+    const uint32_t mask = ((1u << nBits) - 1) << shift;
+    registerValue = static_cast<uint16_t>((registerValue & ~mask) | ((value << shift) & mask));
+    profile->setRegisterValue(address, registerValue);
+    return true;
+}
@@ -0,0 +1,132 @@
+/*!
+ \file   LMXPllPlanner.h
+ \brief  LMX2594 PLL Planner (register settings for any output frequency) - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef LMXPLLPLANNER_H
+#define LMXPLLPLANNER_H
+
+#include <stdint.h>
+
+#include "globals.h"
+#include "LMXFrequencyProfile.h"
+
+
+/*!
+ \brief LMX2594 PLL Planner
+ Works out the PLL settings for an output frequency, and writes them into a
+ set of LMX2594 register values (see LMX2594::selectFrequency):
+
+  - Reference path: OSC_2X, MULT, PLL_R_PRE and PLL_R are read from a base
+    profile, and give the phase detector frequency (fPD) from the reference
+    (SI5340 output, or fixed XO).
+  - Output: Outputs at or above VCO_MIN_MHZ come straight from the VCO;
+    lower outputs use the smallest channel divider (CHDIV) which puts the VCO
+    in range.
+  - N divider: fVCO / fPD = N + NUM / DEN. The fraction is the closest one
+    with DEN < 2^32 (continued fractions), so decimal frequencies are usually
+    exact. Integer mode (MASH_ORDER = 0) is used if NUM = 0.
+  - MASH order / PFD delay: The base profile's MASH order is kept for
+    fractional N (or MASH_ORDER_DEFAULT for an integer base profile);
+    PFD_DLY_SEL and the minimum N come from the datasheet table.
+  - VCO: The core and the calibration start values (VCO_SEL,
+    VCO_CAPCTRL_STRT, VCO_DACISET_STRT) are interpolated from the datasheet
+    table for partial assist, so FCAL starts close to the answer.
+  - Charge pump: Scaled with N from the base profile, to keep the loop gain
+    (and loop filter response) about the same.
+  - FCAL_HPFD_ADJ / FCAL_LPFD_ADJ are set from fPD.
+
+ Other settings (loop filter related, output buffers, MUXout, etc) are
+ left as they are in the base profile.
+*/
+class LMXPllPlanner
+{
+public:
+
+    // Reference path settings (from a profile):
+    typedef struct refPath_t
+    {
+        double fOsc;      // Reference input frequency (MHz)
+        bool   osc2x;     // OSC_2X doubler
+        int    mult;      // MULT
+        int    preR;      // PLL_R_PRE
+        int    pllR;      // PLL_R
+        double fPd;       // Phase detector frequency (MHz)
+    } refPath_t;
+
+    // PLL settings for an output frequency:
+    typedef struct plan_t
+    {
+        double   fOut;          // Output frequency (MHz) given by the settings below
+        double   fVco;          // VCO frequency (MHz)
+        int      chDivIndex;    // Index into CHDIV_LIST (-1 = VCO output, no channel divider)
+        uint32_t n;             // PLL_N
+        uint32_t num;           // PLL_NUM
+        uint32_t den;           // PLL_DEN
+        int      mashOrder;     // MASH_ORDER (0 = integer mode)
+        int      pfdDlySel;     // PFD_DLY_SEL
+        int      vcoCore;       // VCO_SEL (1 - 7)
+        uint16_t capCtrlStrt;   // VCO_CAPCTRL_STRT
+        uint16_t dacIsetStrt;   // VCO_DACISET_STRT
+        int      cpg;           // CPG (charge pump gain code)
+        int      fcalHpfdAdj;   // FCAL_HPFD_ADJ
+        int      fcalLpfdAdj;   // FCAL_LPFD_ADJ
+    } plan_t;
+
+    static int referenceRead(const LMXFrequencyProfile &profile, double fOsc, refPath_t *ref);
+
+    static int plan(const refPath_t &ref,
+                    double fOut,                         // Required output frequency (MHz)
+                    const LMXFrequencyProfile &base,     // Profile to take MASH order and charge pump from
+                    plan_t *plan);
+
+    static int registersApply(const plan_t &plan, LMXFrequencyProfile *profile);
+
+    static const double VCO_MIN_MHZ;
+    static const double VCO_MAX_MHZ;
+
+private:
+
+    friend class TestLMXPllPlanner;  // Unit tests (tests/tst_lmxpllplanner)
+
+    static const int MASH_ORDER_DEFAULT = 3;          // MASH order for fractional N if the base profile is integer mode
+    static const uint32_t DEN_MAX = 0xFFFFFFFF;       // Largest PLL_DEN
+
+    static const int CHDIV_LIST[];                    // Channel divider ratios (by CHDIV field value)
+    static const int CHDIV_LIST_SIZE;
+
+    // VCO core ranges and start values for partial assist:
+    typedef struct vcoCore_t
+    {
+        double   fMin, fMax;         // Frequency range (MHz)
+        uint16_t capMin, capMax;     // VCO_CAPCTRL_STRT at fMin and fMax
+        uint16_t dacMin, dacMax;     // VCO_DACISET_STRT at fMin and fMax
+    } vcoCore_t;
+    static const vcoCore_t VCO_CORES[];
+    static const int VCO_CORES_SIZE;
+
+    // Minimum N and PFD_DLY_SEL, by MASH order and VCO frequency:
+    typedef struct nDivLimit_t
+    {
+        int    mashOrder;
+        double fVcoMax;      // Row applies up to this VCO frequency (MHz)
+        int    nMin;
+        int    pfdDlySel;
+    } nDivLimit_t;
+    static const nDivLimit_t N_DIV_LIMITS[];
+    static const int N_DIV_LIMITS_SIZE;
+
+    // Highest phase detector frequency (MHz), by MASH order:
+    static const double FPD_MAX_MHZ[5];
+
+    // Charge pump currents (mA) by CPG code (0 = not used):
+    static const double CPG_CURRENTS[8];
+
+    static void fractionFind(double value, uint32_t denMax, uint32_t *num, uint32_t *den);
+    static bool fieldGet(const LMXFrequencyProfile &profile, uint8_t address, int nBits, int shift, uint32_t *value);
+    static bool fieldSet(LMXFrequencyProfile *profile, uint8_t address, int nBits, int shift, uint32_t value);
+};
+
+#endif // LMXPLLPLANNER_H
@@ -8,6 +8,8 @@
 
 #include <QDebug>
 #include <QTime>  // For testing / profiling
+#include <QFile>
+#include <QDateTime>
 
 #include "M24M02.h"
 
@@ -60,6 +62,7 @@ M24M02::M24M02(I2CComms *comms, const uint8_t i2cAddress, const int deviceID)
         // qDebug() << "Mapping string " << stringID << ": Addr: " << address << "; Len: " << STRING_LENGTHS.value(stringID);
         address += STRING_LENGTHS.value(stringID);
     }
+    Q_ASSERT(address <= HEADER_ADDRESS);   // String table mustn't overlap the image cache header
 }
 
 
@@ -130,7 +133,7 @@ int M24M02::init()
  \return globals::OK
  \return [error code]
 */
-int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles)
+int M24M02::readFrequencyProfiles(int deviceID, QVector<LMXFrequencyProfile> &frequencyProfiles)
 {
     if (deviceID != this->deviceID) return globals::INVALID_BOARD;  // Not for us!
     DEBUG_EEPROM("M24M02: EEPROM Read Frequency Profiles - Device " << deviceID)
@@ -145,8 +148,6 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
     uint16_t address = 0;
     int result = globals::OK;
 
-    static const int MAX_PROFILES = 255;  // For sanity check... Max number of profiles which will fit in one page.
-
     // -- Read profile count from first 2 bytes: --
     uint16_t profileCount = 0;
     address = 0;
@@ -167,6 +168,14 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
     // Sub-page 0 stores number of profiles.
     int profilePageIndex = 1;
 
+    // Read all the profile sub-pages into the image (sequential reads; see imageBlocksRead):
+    result = imageFill(PAGE_FREQ_PROFILES, 256, profileCount * 256);
+    if (result != globals::OK)
+    {
+        DEBUG_EEPROM("M24M02: Error reading Frequency Profiles (" << result << ")")
+        return globals::INVALID_DATA;
+    }
+
     for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
     {
         LMXFrequencyProfile newProfile;
@@ -190,6 +199,7 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
     qDebug("EEPROM Read time elapsed: %d ms", t.elapsed());
     //##############################################
 
+    imageSave();
     DEBUG_EEPROM("M24M02: Frequency profiles read OK")
     return globals::OK;
 }
@@ -203,66 +213,84 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
  \return globals::OK
  \return [error code]
 */
-int M24M02::writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles)
+int M24M02::writeFrequencyProfiles(int deviceID, QVector<LMXFrequencyProfile> &frequencyProfiles)
 {
     if (deviceID != this->deviceID) return globals::INVALID_BOARD;  // Not for us!
-    if (frequencyProfiles.count() > 255)
+    const int profileCount = (frequencyProfiles.count() <= MAX_PROFILES) ? frequencyProfiles.count() : MAX_PROFILES;
+    if (frequencyProfiles.count() > MAX_PROFILES)
     {
-        DEBUG_EEPROM("M24M02: WARNING: Maximum of 255 frequency profiles can be stored! (have " << frequencyProfiles.count() << "; extras will be dropped.");
+        DEBUG_EEPROM("M24M02: WARNING: Maximum of " << MAX_PROFILES << " frequency profiles can be stored! (have " << frequencyProfiles.count() << "; extras will be dropped.");
     }
 
-    DEBUG_EEPROM("M24M02: EEPROM Write " << frequencyProfiles.length() << " Frequency Profiles - Device " << deviceID);
+    DEBUG_EEPROM("M24M02: EEPROM Write " << profileCount << " Frequency Profiles - Device " << deviceID);
     uint16_t address = 0;
     int result = globals::OK;
 
-
-     result = clearPROFILES();
-     if (result != globals::OK)
-     {
-            DEBUG_EEPROM("M24M02: Error delete Frequency Profiles (" << result << ")")
-            return result;
-     }
-
     //###### Time Recording - for testing ##########
     QTime t;
     t.start();
     //##############################################
 
-    // -- Write profile count as first 2 bytes: --
-    address = 0;
-    result = storeUInt16(PAGE_FREQ_PROFILES, &address, static_cast<uint16_t>(frequencyProfiles.length()), nullptr);
-    if (result != globals::OK)
-    {
-        DEBUG_EEPROM("M24M02: Error writing Frequency Profile count (" << result << ")")
-        return result;
-    }
-
-    // -- Write each profile: --
-    // Profiles are written one per 256 byte sub-page, starting at sub-page 1
-    // Sub-page 0 stores number of profiles.
-    int profilePageIndex = 1;
-    foreach(LMXFrequencyProfile profile, frequencyProfiles)
+    // Build the new contents of the profile area in memory:
+    //  Sub-page 0 stores number of profiles (first 2 bytes).
+    //  Profiles are stored one per 256 byte sub-page, starting at sub-page 1.
+    //  The rest of the area (at least PROFILE_AREA_MIN bytes) is cleared to 0xFF.
+    int areaSize = (profileCount + 1) * 256;
+    if (areaSize < PROFILE_AREA_MIN) areaSize = PROFILE_AREA_MIN;
+    QByteArray area(areaSize, static_cast<char>(0xFF));
+    uint8_t *areaData = reinterpret_cast<uint8_t *>(area.data());
+    areaData[0] = static_cast<uint8_t>(profileCount & 0x00FF);   // Little endian format
+    areaData[1] = static_cast<uint8_t>(profileCount >> 8);
+    for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
     {
-        address = static_cast<uint16_t>(profilePageIndex * 256);
-        result = storeFrequencyProfile(&address, profile);
+        LMXFrequencyProfile profile = frequencyProfiles.at(profileIndex);
+        int profileSize = 0;
+        result = frequencyProfileToBytes(profile, areaData + ((profileIndex + 1) * 256), &profileSize);
         if (result != globals::OK)
         {
-            DEBUG_EEPROM("M24M02: Error writing Frequency Profile for frequency " << profile.getFrequency() << " at address " << address << "(" << result << ")")
+            DEBUG_EEPROM("M24M02: Error writing Frequency Profile for frequency " << profile.getFrequency() << " (" << result << ")")
             return result;
         }
-        profilePageIndex++;
+    }
+
+    // Current contents, read from the EEPROM (so unchanged sub-pages can be skipped), then write:
+    emit ShowMessage("Write EEPROM...");
+    result = imageFill(PAGE_FREQ_PROFILES, 0, areaSize, true);
+    if (result == globals::OK) result = imageWriteBegin();
+    if (result == globals::OK) result = storeBlock(PAGE_FREQ_PROFILES, &address, areaData, areaSize);
+    if (result != globals::OK)
+    {
+        DEBUG_EEPROM("M24M02: Error writing Frequency Profiles (" << result << ")")
+        return result;
     }
 
     //##############################################
     qDebug("EEPROM Write time elapsed: %d ms", t.elapsed());
     //##############################################
 
+    result = imageWriteEnd();
+    if (result != globals::OK) return result;
     DEBUG_EEPROM("M24M02: Frequency profiles written OK")
     return globals::OK;
 }
 
 
 
+/*!
+ \brief Read the instrument serial number from the M24M02 EEPROM
+ Used by other components to key data which belong to this instrument
+ (see LMX2594::vcoCalLoad).
+ \param serial  Set to the serial number on success
+ \return globals::OK
+ \return [error code]
+*/
+int M24M02::readSerialNumber(QString &serial)
+{
+    return loadString(SERIAL, serial);
+}
+
+
+
 
 
 //---------------------------------------------------------
@@ -305,6 +333,7 @@ void M24M02::EEPROMReadStrings(int deviceID)
     qDebug("EEPROM Read time elapsed: %d ms", t.elapsed());
     //##############################################
 
+    if (result == globals::OK) imageSave();
     if (result == globals::OK) emit EEPROMStringData(this->deviceID, model, serial, productionDate, calibrationDate, warrantyStart, warrantyEnd, synthConfigVersion);
     emit Result(result, globals::ALL_LANES);
 }
@@ -340,13 +369,15 @@ void M24M02::EEPROMWriteStrings(int deviceID,
     //##############################################
 
     int result;
-    result                            = storeString( MODEL,                model              );
+    result                            = imageWriteBegin();
+    if (result == globals::OK) result = storeString( MODEL,                model              );
     if (result == globals::OK) result = storeString( SERIAL,               serial             );
     if (result == globals::OK) result = storeString( PROD_DATE,            productionDate     );
     if (result == globals::OK) result = storeString( CAL_DATE,             calibrationDate    );
     if (result == globals::OK) result = storeString( WARRANTY_START,       warrantyStart      );
     if (result == globals::OK) result = storeString( WARRANTY_END,         warrantyEnd        );
     if (result == globals::OK) result = storeString( SYNTH_CONFIG_VERSION, synthConfigVersion );
+    if (result == globals::OK) result = imageWriteEnd();
 
     //##############################################
     qDebug("EEPROM Write time elapsed: %d ms", t.elapsed());
@@ -405,17 +436,20 @@ int M24M02::storeBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t n
     if (nBytes < 1 || page > 3) return globals::OVERFLOW;
 
     int result = globals::OK;
+    const uint16_t startAddress = *address;
     int offsetInPageA = (*address) % 256;
     int offsetInPageB = ((*address) + nBytes - 1) % 256;
     if (offsetInPageA <= offsetInPageB)
     {
         // This write DOESN'T cross 256 byte sub-page. Single write OK!
-        qDebug() << "NORMAL WRITE! Start @ " << INT_AS_HEX(*address, 4);
-        result = comms->write(i2cAddress + page, *address, data, nBytes);
+        DEBUG_EEPROM_EXTRA("NORMAL WRITE! Start @ " << INT_AS_HEX(*address, 4))
+        result = comms->write(deviceAddress(page), *address, data, nBytes);
         if (result == globals::OK)
         {
             *address += nBytes;
-            waitStoreAck();
+            writeFrames++;
+            writeBytes += nBytes;
+            result = waitStoreAck();
         }
     }
     else
@@ -424,25 +458,33 @@ int M24M02::storeBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t n
         uint8_t nBytesA = static_cast<uint8_t>(256 - offsetInPageA);
         uint8_t nBytesB = nBytes - nBytesA;
 
-        qDebug() << "CROSS-SUBPAGE WRITE! Start @ " << INT_AS_HEX(*address, 4) << "(" << offsetInPageA << ")"
-                 << "; Last Byte At: " << INT_AS_HEX((*address) + nBytes - 1, 4) << "(" << offsetInPageB << ")"
-                 << "; Split after: " << INT_AS_HEX((*address) + nBytesA - 1, 4)
-                 << " leaving " << nBytesB << " bytes @ " << INT_AS_HEX((*address) + nBytesA, 4);
+        DEBUG_EEPROM_EXTRA("CROSS-SUBPAGE WRITE! Start @ " << INT_AS_HEX(*address, 4) << "(" << offsetInPageA << ")"
+                           << "; Last Byte At: " << INT_AS_HEX((*address) + nBytes - 1, 4) << "(" << offsetInPageB << ")"
+                           << "; Split after: " << INT_AS_HEX((*address) + nBytesA - 1, 4)
+                           << " leaving " << nBytesB << " bytes @ " << INT_AS_HEX((*address) + nBytesA, 4))
 
-        result = comms->write(i2cAddress + page, *address, data, nBytesA);
+        result = comms->write(deviceAddress(page), *address, data, nBytesA);
         if (result == globals::OK)
         {
             *address += nBytesA;
-            waitStoreAck();
-            result = comms->write(i2cAddress + page, *address, data, nBytesB);
+            writeFrames++;
+            writeBytes += nBytesA;
+            result = waitStoreAck();
+        }
+        if (result == globals::OK)
+        {
+            result = comms->write(deviceAddress(page), *address, data + nBytesA, nBytesB);
             if (result == globals::OK)
             {
                 *address += nBytesB;
-                waitStoreAck();
+                writeFrames++;
+                writeBytes += nBytesB;
+                result = waitStoreAck();
             }
         }
     }
 
+    imageInvalidate(page, startAddress, nBytes);   // Even if the write failed: contents now unknown
     DEBUG_EEPROM("[EEPROM Write Bytes]: Page: " << page << "; Addr AFTER: " << INT_AS_HEX(*address, 4) << "; Count: " << nBytes << "; Data: " << INT_AS_HEX(data[0], 2) << "... Result: " << result)
     return result;
 }
@@ -473,7 +515,7 @@ int M24M02::loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nB
     if (offsetInPageA <= offsetInPageB)
     {
         // This read DOESN'T cross 256 byte sub-page. Single read OK!
-        int result = comms->read(i2cAddress + page, *address, data, nBytes);
+        result = comms->read(deviceAddress(page), *address, data, nBytes);
         if (result == globals::OK) *address += nBytes;
     }
     else
@@ -487,11 +529,11 @@ int M24M02::loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nB
                  << "; Split after: " << INT_AS_HEX((*address) + nBytesA - 1, 4)
                  << " leaving " << nBytesB << " bytes @ " << INT_AS_HEX((*address) + nBytesA, 4);
         */
-        result = comms->read(i2cAddress + page, *address, data, nBytesA);
+        result = comms->read(deviceAddress(page), *address, data, nBytesA);
         if (result == globals::OK)
         {
             *address += nBytesA;
-            result = comms->read(i2cAddress + page, *address, data, nBytesB);
+            result = comms->read(deviceAddress(page), *address, data + nBytesA, nBytesB);
             if (result == globals::OK) *address += nBytesB;
         }
     }
@@ -505,34 +547,36 @@ int M24M02::loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nB
  * \brief Wait for store operation to finish
  * The EEPROM takes some time (up to 10 ms) after a write operation,
  * for the data to be written to the memory cells. During this time
- * it ignores I2C requests. This method repeatedly sends a request
- * with no data, until it receives an ACK (indicating the write
- * has finished).
+ * it ignores I2C requests. This method repeatedly checks the device
+ * address (I2CComms::pingAddress), until it receives an ACK (indicating
+ * the write has finished).
+ * Polls are sent back to back: each one is an adaptor transaction, which
+ * is already the shortest safe interval. A NACK from pingAddress isn't
+ * treated as a comms error, so there's no port reset or retry delay
+ * (unlike writeRaw).
  * \return globals::OK  Success - store has completed
  * \return [error code]
  */
 int M24M02::waitStoreAck()
 {
     DEBUG_EEPROM("EEPROM Write: Wait for ACK...")
+    QElapsedTimer ackTimer;
+    ackTimer.start();
     int result = globals::OK;
-    int retryCount = 0;
-    while (retryCount < 5)
+    int pollCount = 0;
+    while (true)
     {
-        DEBUG_EEPROM("-Try " << retryCount << "...")
-        result = comms->writeRaw(i2cAddress, 0, 0);
+        result = comms->pingAddress(i2cAddress);
+        pollCount++;
         if (result == globals::OK)
         {
-            DEBUG_EEPROM("--ACK!")
+            DEBUG_EEPROM("--ACK after " << pollCount << " polls")
             break;
         }
-        else
-        {
-            DEBUG_EEPROM("--No ACK (" << result << "). Waiting...")
-        }
-        retryCount++;
-        globals::sleep(2);
+        if (result != globals::DEVICE_NOT_FOUND) break;   // Comms error
+        if (ackTimer.elapsed() >= WRITE_ACK_TIMEOUT_MS) break;
     }
-    if (result != globals::OK) DEBUG_EEPROM("--WARNING: TIMED OUT without ACK!")
+    if (result != globals::OK) DEBUG_EEPROM("--WARNING: TIMED OUT without ACK! (" << result << ")")
     return result;
 }
 
@@ -580,7 +624,7 @@ int M24M02::storeUInt16(uint8_t page, uint16_t *address, uint16_t value, uint16_
 int M24M02::loadUInt16(uint8_t page, uint16_t *address, uint16_t *value, uint16_t *checkSum)
 {
     uint8_t dataBuffer[2] = { 0 };
-    int result = loadBytes(page, address, dataBuffer, 2);
+    int result = loadBlock(page, address, dataBuffer, 2);
 
     if (result == globals::OK)
     {
@@ -595,6 +639,15 @@ int M24M02::loadUInt16(uint8_t page, uint16_t *address, uint16_t *value, uint16_
 
 /*!
  \brief Store a block of byte data to M24M02 EEPROM
+ The data are split at 256 byte sub-page boundaries (see NOTE before storeBytes), so no
+ write can wrap around within a sub-page. For each sub-page:
+  - If that part of the image was read from the EEPROM in this session
+    (see imageFill), bytes which already match at the start and end are
+    skipped, and the sub-page is skipped completely if nothing has changed.
+    Blocks loaded from the cache file are always written: the cache could
+    be stale (e.g. the EEPROM was written by another host).
+  - The rest is written in as few adaptor frames as possible (up to
+    WRITE_BLK_SIZE bytes each), each followed by ACK polling (waitStoreAck).
  \param page      Page to use (0 - 3)
  \param address   Starting address for write (0 = start of page)
                   On SUCCESS, address is automatically incremented by the number of bytes stored.
@@ -606,11 +659,14 @@ int M24M02::loadUInt16(uint8_t page, uint16_t *address, uint16_t *value, uint16_
  \return globals::OVERFLOW  Insufficient space - write would overflow the end of the page
  \return [error code]       Comms error, etc.
 */
-int M24M02::storeBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t nBytes)
+int M24M02::storeBlock(uint8_t page, uint16_t *address, uint8_t *data, int nBytes)
 {
     // Check for write past end of page:
-    Q_ASSERT( (static_cast<int>(*address) + static_cast<int>(nBytes)) <= 65536 );
-    if ((static_cast<int>(*address) + static_cast<int>(nBytes)) > 65536) return globals::OVERFLOW;
+    Q_ASSERT( (static_cast<int>(*address) + nBytes) <= 65536 );
+    if ((static_cast<int>(*address) + nBytes) > 65536) return globals::OVERFLOW;
+    Q_ASSERT(page <= 3);
+    if (page > 3) return globals::OVERFLOW;
+    if (!imageChecked) imageOpen();
 
     int bytesLeftToWrite = nBytes; // Number of bytes left to write
     int srcOffset = 0;
@@ -618,12 +674,40 @@ int M24M02::storeBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t
 
     while (bytesLeftToWrite > 0)
     {
-        int bytesThisWrite = (bytesLeftToWrite <= WRITE_BLK_SIZE) ? bytesLeftToWrite : WRITE_BLK_SIZE;
+        // Part of the block in this sub-page:
+        const int offsetInSubPage = (*address) % WRITE_PAGE_SIZE;
+        const int bytesThisSubPage = (bytesLeftToWrite <= (WRITE_PAGE_SIZE - offsetInSubPage)) ? bytesLeftToWrite : (WRITE_PAGE_SIZE - offsetInSubPage);
+
+        // Skip bytes which already match the EEPROM (if read in this session):
+        int first = 0;
+        int last = bytesThisSubPage - 1;
+        const int imageOffset = (static_cast<int>(page) * 65536) + static_cast<int>(*address);
+        if (imageBlockRead[imageOffset / IMAGE_BLOCK_SIZE])
+        {
+            const uint8_t *imageData = reinterpret_cast<const uint8_t *>(image.constData()) + imageOffset;
+            while (first <= last && imageData[first] == data[srcOffset + first]) first++;
+            while (last >= first && imageData[last] == data[srcOffset + last]) last--;
+        }
 
-        result = storeBytes(page, address, data + srcOffset, static_cast<uint8_t>(bytesThisWrite));
-        if (result != globals::OK) return result;   // EEPROM write error!
-        srcOffset += bytesThisWrite;
-        bytesLeftToWrite -= bytesThisWrite;
+        if (first > last)
+        {
+            writePagesSkipped++;
+        }
+        else
+        {
+            uint16_t writeAddress = static_cast<uint16_t>(*address + first);
+            int writeOffset = first;
+            while (writeOffset <= last)
+            {
+                const int bytesThisWrite = ((last - writeOffset + 1) <= WRITE_BLK_SIZE) ? (last - writeOffset + 1) : WRITE_BLK_SIZE;
+                result = storeBytes(page, &writeAddress, data + srcOffset + writeOffset, static_cast<uint8_t>(bytesThisWrite));
+                if (result != globals::OK) return result;   // EEPROM write error!
+                writeOffset += bytesThisWrite;
+            }
+        }
+        *address += bytesThisSubPage;
+        srcOffset += bytesThisSubPage;
+        bytesLeftToWrite -= bytesThisSubPage;
     }
     return result;
 }
@@ -632,6 +716,8 @@ int M24M02::storeBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t
 
 /*!
  \brief Load a block of byte data from M24M02 EEPROM
+ Data come from the EEPROM image. Any blocks of the image which haven't
+ been read yet are read from the EEPROM first (see imageOpen).
  \param page      Page to use (0 - 3)
  \param address   Starting address for read (0 = start of page)
                   On SUCCESS, address is automatically incremented by the number of bytes stored.
@@ -648,21 +734,16 @@ int M24M02::loadBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t n
     // Check for read past end of page:
     Q_ASSERT( (static_cast<int>(*address) + static_cast<int>(nBytes)) <= 65536 );
     if ((static_cast<int>(*address) + static_cast<int>(nBytes)) > 65536) return globals::OVERFLOW;
+    Q_ASSERT(page <= 3);
+    if (page > 3) return globals::OVERFLOW;
+    if (nBytes == 0) return globals::OK;
 
-    int bytesLeftToRead = nBytes;
-    int destOffset = 0;
-    int result = globals::OK;
-
-    while (bytesLeftToRead > 0)
-    {
-        int bytesThisRead = (bytesLeftToRead <= READ_BLK_SIZE) ? bytesLeftToRead : READ_BLK_SIZE;
-
-        result = loadBytes(page, address, data + destOffset, static_cast<uint8_t>(bytesThisRead));
-        if (result != globals::OK) return result;   // EEPROM read error!
+    int result = imageFill(page, *address, nBytes);
+    if (result != globals::OK) return result;   // EEPROM read error!
 
-        destOffset += bytesThisRead;
-        bytesLeftToRead -= bytesThisRead;
-    }
+    const int imageOffset = (static_cast<int>(page) * 65536) + static_cast<int>(*address);
+    memcpy(data, image.constData() + imageOffset, nBytes);
+    *address += nBytes;
     return globals::OK;
 }
 
@@ -688,33 +769,16 @@ int M24M02::storeString(StringID stringID, const QString &stringData)
     int result = globals::OK;
 
     uint16_t address = stringInfo.address;
-    uint8_t NUL = 0x00;
     DEBUG_EEPROM("EEPROM: Storing string " << stringID << " at " << address << ": '" << stringData << "'")
 
-    uint8_t data[WRITE_BLK_SIZE];  // Temp buffer for reading blocks from eeprom; Max 59 bytes per write (I2C adaptor limit)
-
-    int bytesLeftToWrite = (stringData.length() <= stringInfo.maxLength) ? stringData.length() : stringInfo.maxLength;
-      // Number of bytes left to write; If string is longer than max length for this location, truncate.
-
-    int srcOffset = 0;
-    while (bytesLeftToWrite > 0)
-    {
-        int bytesThisWrite = (bytesLeftToWrite <= WRITE_BLK_SIZE) ? bytesLeftToWrite : WRITE_BLK_SIZE;
-
-        // Add characters to the temp buffer, stopping if we get to the end of the string:
-        for (int i = 0; i < bytesThisWrite; i++)
-        {
-            data[i] = static_cast<uint8_t>(stringData[i+srcOffset].toLatin1());
-        }
-        result = storeBytes(PAGE_STRINGS, &address, data, static_cast<uint8_t>(bytesThisWrite));
-        if (result != globals::OK) return result;   // EEPROM write error!
-
-        srcOffset += bytesThisWrite;
-        bytesLeftToWrite -= bytesThisWrite;
-    }
+    const int stringLength = (stringData.length() <= stringInfo.maxLength) ? stringData.length() : stringInfo.maxLength;
+      // If string is longer than max length for this location, truncate.
+    QByteArray data(stringInfo.maxLength, static_cast<char>(0x00));
+    for (int i = 0; i < stringLength; i++) data.data()[i] = stringData[i].toLatin1();
 
     // If we didn't fill the max space allocated for this string, add a NUL:
-    if (address < (stringInfo.address + stringInfo.maxLength)) result = storeBytes(PAGE_STRINGS, &address, &NUL, 1);
+    const int bytesToWrite = (stringLength < stringInfo.maxLength) ? (stringLength + 1) : stringLength;
+    if (bytesToWrite > 0) result = storeBlock(PAGE_STRINGS, &address, reinterpret_cast<uint8_t *>(data.data()), bytesToWrite);
     return result;
 }
 
@@ -747,11 +811,11 @@ int M24M02::loadString(StringID stringID, QString &stringData)
     {
         int bytesThisRead = (bytesLeftToRead <= READ_BLK_SIZE) ? bytesLeftToRead : READ_BLK_SIZE;
 
-        result = loadBytes(PAGE_STRINGS, &address, data, static_cast<uint8_t>(bytesThisRead));
+        result = loadBlock(PAGE_STRINGS, &address, data, static_cast<uint16_t>(bytesThisRead));
         if (result != globals::OK) return result;   // EEPROM read error!
 
         // Add characters to the returned string, stopping if we get a NUL:
-        for (int i = 0; i < READ_BLK_SIZE; i++)
+        for (int i = 0; i < bytesThisRead; i++)
         {
             if (data[i] == 0x00 || data[i] == 0xFF) return globals::OK;
               // NUL terminator or no data: End of string reached (C-style string).
@@ -767,75 +831,57 @@ int M24M02::loadString(StringID stringID, QString &stringData)
 
 
 /*!
- \brief Store an LMX Frequency Profile
- \param address  Address to store to
-                 On SUCCESS, address is automatically incremented by the number of bytes stored.
- \param profile  Profile to store
- \return globals::OK  Stored OK
+ \brief Convert an LMX Frequency Profile to the format stored in EEPROM
+ Frequency (4) | Register count (2) | Register values (2 each) | Checksum (2)
+ \param profile     Profile to convert
+ \param dataBuffer  Buffer for the data (at least 256 bytes)
+ \param nBytes      Set to the number of bytes used
+ \return globals::OK  Converted OK
  \return [Error code]
 */
-int M24M02::storeFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile)
+int M24M02::frequencyProfileToBytes(LMXFrequencyProfile &profile, uint8_t *dataBuffer, int *nBytes)
 {
-    int result;
     uint16_t checkSum = 0;
     uint16_t value = 0;
-    uint8_t registerAddress = 0;
+    *nBytes = 0;
 
-    DEBUG_EEPROM_EXTRA("storeFrequencyProfile: Address: " << *address << "; Frequency: " << profile.getFrequency())
+    DEBUG_EEPROM_EXTRA("frequencyProfileToBytes: Frequency: " << profile.getFrequency())
 
     // -- Frequency, converted to array of 4 bytes: --
     float frequency = profile.getFrequency();
     Q_ASSERT(sizeof frequency == 4);
     if (sizeof frequency != 4) return globals::GEN_ERROR; // Paranoid.
 
-    // Create a temp buffer in memory, to make writing to EEPROM faster:
-    uint16_t profileSize = 4    // Frequency
-                         + 2    // Register Count
-                         + static_cast<uint16_t>(profile.getRegisterCount() * 2)  // Register Values
-                         + 2;   // Checksum
-    uint8_t *dataBuffer = new uint8_t[profileSize];
-    if (!dataBuffer) return globals::MALLOC_ERROR;
+    const int profileSize = 4    // Frequency
+                          + 2    // Register Count
+                          + (profile.getRegisterCount() * 2)  // Register Values
+                          + 2;   // Checksum
+    if (profileSize > 256) return globals::OVERFLOW;   // Must fit in a 256 byte sub-page
     int bufferAddress = 0;
 
     DEBUG_EEPROM_EXTRA("-N Registers:  " << profile.getRegisterCount() << "; N Bytes: " << profileSize)
-    DEBUG_EEPROM_EXTRA("Checksum:++0:" << checkSum)
     memcpy(dataBuffer + bufferAddress, &frequency, 4);
-    checkSum += dataBuffer[0] + dataBuffer[1] + dataBuffer[2] + dataBuffer[3];
     bufferAddress += 4;
-    DEBUG_EEPROM_EXTRA("Checksum:++C:" << checkSum)
 
     // -- Number of registers: --
     value = static_cast<uint16_t>(profile.getRegisterCount());
     dataBuffer[bufferAddress]   = static_cast<uint8_t>(value & 0x00FF);
     dataBuffer[bufferAddress+1] = static_cast<uint8_t>(value >> 8);
-    checkSum += dataBuffer[bufferAddress] + dataBuffer[bufferAddress+1];
     bufferAddress += 2;
 
-    DEBUG_EEPROM_EXTRA("Checksum:++N:" << checkSum)
-
     // -- Register Values: --
-    for (registerAddress = 0; registerAddress < profile.getRegisterCount(); registerAddress++)
-    {
-        value = static_cast<uint16_t>(profile.getRegisterValue(registerAddress, nullptr));
-        dataBuffer[bufferAddress]   = static_cast<uint8_t>(value & 0x00FF);
-        dataBuffer[bufferAddress+1] = static_cast<uint8_t>(value >> 8);
-        DEBUG_EEPROM_EXTRA("  ->Write:" << INT_AS_HEX(dataBuffer[bufferAddress],2) << INT_AS_HEX(dataBuffer[bufferAddress + 1],2) << ": " << value)
-        checkSum += dataBuffer[bufferAddress] + dataBuffer[bufferAddress + 1];
-        bufferAddress += 2;
-        DEBUG_EEPROM_EXTRA("Checksum:  ++R:" << checkSum)
-    }
+    bufferAddress += profile.toBytes(dataBuffer + bufferAddress);
 
+    // Checksum is the sum of all bytes above:
+    for (int i = 0; i < bufferAddress; i++) checkSum += dataBuffer[i];
     DEBUG_EEPROM_EXTRA("Checksum Final: " << checkSum)
     // -- Checksum: --
     dataBuffer[bufferAddress]   = static_cast<uint8_t>(checkSum & 0x00FF);
     dataBuffer[bufferAddress+1] = static_cast<uint8_t>(checkSum >> 8);
     bufferAddress += 2;
 
-    result = storeBlock(PAGE_FREQ_PROFILES, address, dataBuffer, profileSize);
-
-    delete [] dataBuffer;
-    DEBUG_EEPROM_EXTRA("-Result:  " << result << "; Checksum: " << checkSum << "; Address now: " << *address)
-    return result;
+    *nBytes = bufferAddress;
+    return globals::OK;
 }
 
 
@@ -882,8 +928,7 @@ int M24M02::loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile
     uint16_t registerCount = 0;
     result = loadUInt16(PAGE_FREQ_PROFILES, address, &registerCount, &checksumCalculated);
     if (result != globals::OK) return result;
-    if (registerCount > 255) return globals::INVALID_DATA;  // Sanity check
-    profile.setRegisterCount(registerCount);
+    if (registerCount > LMXFrequencyProfile::REGISTER_CAPACITY) return globals::INVALID_DATA;  // Sanity check
     uint16_t readSize = (registerCount * 2) + 2;   // Data for registers, plus checksum
 
     DEBUG_EEPROM_EXTRA("-Found Register Count: " << registerCount << "; Address now: " << *address << "; Reading " << readSize << " more bytes.")
@@ -902,15 +947,8 @@ int M24M02::loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile
     DEBUG_EEPROM_EXTRA("-Data read. Address now: " << *address)
 
     // Add registers to the profile, and calculate the checksum:
-    for (uint8_t registerAddress = 0; registerAddress < registerCount; registerAddress++)
-    {
-        uint16_t value = static_cast<uint16_t>(dataBuffer[bufferAddress + 1] << 8) | dataBuffer[bufferAddress];
-        profile.setRegisterValue(registerAddress, value);
-        DEBUG_EEPROM_EXTRA("  ->Read:" << INT_AS_HEX(dataBuffer[bufferAddress],2) << INT_AS_HEX(dataBuffer[bufferAddress + 1],2) << ": " << value)
-        checksumCalculated += dataBuffer[bufferAddress] + dataBuffer[bufferAddress + 1];
-        bufferAddress += 2;
-        DEBUG_EEPROM_EXTRA("Checksum:  --R:" << checksumCalculated)
-    }
+    profile.fromBytes(dataBuffer, registerCount);
+    for (bufferAddress = 0; bufferAddress < (registerCount * 2); bufferAddress++) checksumCalculated += dataBuffer[bufferAddress];
 
     DEBUG_EEPROM_EXTRA("Checksum Final: " << checksumCalculated)
     // Extract the stored checksum:
@@ -968,28 +1006,374 @@ int M24M02::clearEEPROM()
 
 
 /*!
- * \brief Clear EEPROM PAGE_FREQ_PROFILES Memory
- * This method resets the contents of the string table to 0xFF (factory default).
- * Before write new Freq profiles, delete the previous profiles in EEPROM.
- * \return globals::OK   EEPROM responded OK; profiles cleared
- * \return [Error code]  Error occurred (comms not connected, etc).
- */
-int M24M02::clearPROFILES()
+ \brief Open the EEPROM image cache
+ Called once per connection, before the first load. Reads the header and the
+ serial number from the EEPROM, then loads the cache file for the instrument
+ if there is one. Cached blocks are only used if the file was saved with the
+ same generation as the header in the EEPROM. If the EEPROM has no valid
+ header (old instrument, or an interrupted write), nothing is cached between
+ sessions until the EEPROM is next written.
+ Cache file layout (native byte order; the file is only used on the machine
+ which wrote it):
+   magic (4) | version (2) | generation (4) | block count (2)
+   | [block index (2) | block data (256)] x block count
+   | checksum (4; imageHash of everything before it)
+ \return globals::OK            Cache file loaded
+ \return globals::FILE_ERROR    No cache file, or no header / serial number to key it
+ \return globals::INVALID_DATA  Cache file is damaged
+ \return [error code]           Couldn't read the EEPROM header
+*/
+int M24M02::imageOpen()
 {
-    int result;
-    uint8_t BLANK[32] = {0xFF};  //build a 32 bytes data buffer
-    const uint16_t startAddr = 0x0000;
-    const uint16_t endAddr = 0x4000;  //clear 0 - 16K bytes memory
-    emit ShowMessage("Clear EEPROM...");
-    for (uint16_t address = startAddr;
-                      address < endAddr;
-                      address=address+32)
+    imageChecked = true;
+    imageDirty = false;
+    imageGeneration = 0;
+    imageFileName.clear();
+    image = QByteArray(IMAGE_SIZE, static_cast<char>(0xFF));
+    imageBlockValid = QVector<bool>(IMAGE_BLOCKS, false);
+    imageBlockRead = QVector<bool>(IMAGE_BLOCKS, false);
+
+    int result = headerLoad(&imageGeneration);
+    if (result != globals::OK) return result;
+    if (imageGeneration == 0)
+    {
+        DEBUG_EEPROM("M24M02: No image header in EEPROM; cache not used.")
+        return globals::FILE_ERROR;
+    }
+
+    // Serial number (read directly, as the cache isn't valid yet):
+    const StringInfo serialInfo = strings.value(SERIAL);
+    uint8_t serialData[READ_BLK_SIZE];
+    uint16_t address = serialInfo.address;
+    const int serialLength = (serialInfo.maxLength <= READ_BLK_SIZE) ? serialInfo.maxLength : READ_BLK_SIZE;
+    result = loadBytes(PAGE_STRINGS, &address, serialData, static_cast<uint8_t>(serialLength));
+    if (result != globals::OK) return result;
+    QString serialClean;
+    for (int i = 0; i < serialLength; i++)
+    {
+        if (serialData[i] == 0x00 || serialData[i] == 0xFF) break;
+        QChar qCh = QChar(static_cast<char>(serialData[i]));
+        serialClean.append((qCh.isLetterOrNumber() || qCh == '-') ? qCh : QChar('_'));  // Safe for file name
+    }
+    if (serialClean.isEmpty() || globals::getAppPath().isEmpty())
+    {
+        DEBUG_EEPROM("M24M02: No serial number; EEPROM image cache won't be saved.")
+        return globals::FILE_ERROR;
+    }
+    imageFileName = QString("%1\\eeprom_%2_%3.cache").arg(globals::getAppPath()).arg(serialClean).arg(deviceID);
+
+    // Cache file:
+    QFile cacheFile(imageFileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return globals::FILE_ERROR;   // No cache yet
+    const QByteArray fileData = cacheFile.readAll();
+    cacheFile.close();
+
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(fileData.constData());
+    const int headerSize = 4 + 2 + 4 + 2;
+    const int entrySize = 2 + IMAGE_BLOCK_SIZE;
+    uint32_t magic = 0, generation = 0, checkSum = 0;
+    uint16_t version = 0, blockCount = 0;
+    if (fileData.size() < headerSize + 4) return globals::INVALID_DATA;
+    memcpy(&magic,      data,     4);
+    memcpy(&version,    data + 4, 2);
+    memcpy(&generation, data + 6, 4);
+    memcpy(&blockCount, data + 10, 2);
+    if (magic != IMAGE_FILE_MAGIC
+     || version != IMAGE_FILE_VERSION
+     || fileData.size() != headerSize + (blockCount * entrySize) + 4) return globals::INVALID_DATA;
+    memcpy(&checkSum, data + fileData.size() - 4, 4);
+    if (checkSum != imageHash(data, fileData.size() - 4)) return globals::INVALID_DATA;
+    if (generation != imageGeneration)
+    {
+        DEBUG_EEPROM("M24M02: EEPROM has changed since image was cached (generation " << generation << " -> " << imageGeneration << ")")
+        return globals::OK;
+    }
+
+    data += headerSize;
+    for (int i = 0; i < blockCount; i++)
+    {
+        uint16_t block = 0;
+        memcpy(&block, data, 2);
+        if (block >= IMAGE_BLOCKS) return globals::INVALID_DATA;
+        memcpy(image.data() + (block * IMAGE_BLOCK_SIZE), data + 2, IMAGE_BLOCK_SIZE);
+        imageBlockValid[block] = true;
+        data += entrySize;
+    }
+    qDebug() << "M24M02: " << blockCount << " EEPROM blocks loaded from cache " << imageFileName;
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Save the EEPROM image cache (see imageOpen)
+ Only saved if the image has changed and the EEPROM has a valid header.
+ Errors are logged only; the image still works for this session.
+*/
+void M24M02::imageSave()
+{
+    if (!imageDirty || imageGeneration == 0 || imageFileName.isEmpty()) return;
+
+    QByteArray fileData;
+    uint16_t blockCount = 0;
+    for (int block = 0; block < IMAGE_BLOCKS; block++) if (imageBlockValid[block]) blockCount++;
+    const uint32_t magic = IMAGE_FILE_MAGIC;
+    const uint16_t version = IMAGE_FILE_VERSION;
+    fileData.append(reinterpret_cast<const char *>(&magic), 4);
+    fileData.append(reinterpret_cast<const char *>(&version), 2);
+    fileData.append(reinterpret_cast<const char *>(&imageGeneration), 4);
+    fileData.append(reinterpret_cast<const char *>(&blockCount), 2);
+    for (int block = 0; block < IMAGE_BLOCKS; block++)
+    {
+        if (!imageBlockValid[block]) continue;
+        const uint16_t blockIndex = static_cast<uint16_t>(block);
+        fileData.append(reinterpret_cast<const char *>(&blockIndex), 2);
+        fileData.append(image.constData() + (block * IMAGE_BLOCK_SIZE), IMAGE_BLOCK_SIZE);
+    }
+    const uint32_t checkSum = imageHash(reinterpret_cast<const uint8_t *>(fileData.constData()), fileData.size());
+    fileData.append(reinterpret_cast<const char *>(&checkSum), 4);
+
+    QFile cacheFile(imageFileName);
+    if (!cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        DEBUG_EEPROM("M24M02: Couldn't write EEPROM image cache " << imageFileName)
+        return;
+    }
+    cacheFile.write(fileData);
+    cacheFile.close();
+    imageDirty = false;
+    DEBUG_EEPROM("M24M02: EEPROM image cache saved: " << blockCount << " blocks")
+}
+
+
+
+/*!
+ \brief Make sure part of the image has been read from the EEPROM
+ Each run of blocks which haven't been read yet is read with
+ sequential reads, one per sub-page (see imageBlocksRead).
+ \param page     Page number (0 - 3)
+ \param address  Start address within the page
+ \param nBytes   Number of bytes needed (mustn't go past the end of the page)
+ \param direct   If true, blocks loaded from the cache file are read again
+                 from the EEPROM (see storeBlock)
+ \return globals::OK
+ \return globals::OVERFLOW  Range goes past the end of the page
+ \return [error code]       EEPROM read error
+*/
+int M24M02::imageFill(uint8_t page, uint16_t address, int nBytes, bool direct)
+{
+    if (page > 3 || (static_cast<int>(address) + nBytes) > 65536) return globals::OVERFLOW;
+    if (nBytes <= 0) return globals::OK;
+    if (!imageChecked) imageOpen();
+
+    const int imageOffset = (static_cast<int>(page) * 65536) + static_cast<int>(address);
+    const int blockLast = (imageOffset + nBytes - 1) / IMAGE_BLOCK_SIZE;
+    int block = imageOffset / IMAGE_BLOCK_SIZE;
+    while (block <= blockLast)
+    {
+        if (imageBlockValid[block] && (!direct || imageBlockRead[block]))
         {
-            result = storeBytes(PAGE_FREQ_PROFILES, &address, &BLANK[0], 32);
-            if (result != globals::OK) return result;
-            qDebug()<<"Clear EEPROM address"<<address;
+            block++;
+            continue;
         }
+        int blockCount = 1;
+        while ((block + blockCount) <= blockLast
+            && !(imageBlockValid[block + blockCount] && (!direct || imageBlockRead[block + blockCount]))) blockCount++;
+        int result = imageBlocksRead(block, blockCount);
+        if (result != globals::OK) return result;
+        block += blockCount;
+    }
+    return globals::OK;
+}
 
+
+
+/*!
+ \brief Read blocks of the image from the EEPROM
+ Each block is one 256 byte sub-page, and is read with its own sequential
+ read (I2CComms::readSequential): only the first adaptor frame of each
+ sub-page sets the address, and each frame is as large as the adaptor
+ allows. Reads are still split at sub-page boundaries, as for loadBytes
+ (see NOTE before storeBytes): reads which run on across a sub-page
+ boundary haven't been checked on hardware.
+ \param blockFirst  Index of first block (0 to IMAGE_BLOCKS - 1)
+ \param blockCount  Number of blocks (all in the same 64 KB page)
+ \return globals::OK  Blocks read; now valid in the image
+ \return [error code]
+*/
+int M24M02::imageBlocksRead(int blockFirst, int blockCount)
+{
+    const int blocksPerPage = 65536 / IMAGE_BLOCK_SIZE;
+    const uint8_t page = static_cast<uint8_t>(blockFirst / blocksPerPage);
+    Q_ASSERT(((blockFirst + blockCount - 1) / blocksPerPage) == page);
+    const uint16_t address = static_cast<uint16_t>((blockFirst % blocksPerPage) * IMAGE_BLOCK_SIZE);
+    uint8_t *data = reinterpret_cast<uint8_t *>(image.data()) + (blockFirst * IMAGE_BLOCK_SIZE);
+
+    int result = globals::OK;
+    for (int i = 0; i < blockCount && result == globals::OK; i++)
+    {
+        result = comms->readSequential(deviceAddress(page),
+                                       static_cast<uint16_t>(address + (i * IMAGE_BLOCK_SIZE)),
+                                       data + (i * IMAGE_BLOCK_SIZE),
+                                       static_cast<size_t>(IMAGE_BLOCK_SIZE));
+    }
+    DEBUG_EEPROM("[EEPROM Read Blocks]: Page: " << page << "; Addr: " << INT_AS_HEX(address, 4) << "; Blocks: " << blockCount << "; Result: " << result)
+    if (result != globals::OK) return result;   // EEPROM read error!
+    for (int block = blockFirst; block < blockFirst + blockCount; block++)
+    {
+        imageBlockValid[block] = true;
+        imageBlockRead[block] = true;
+    }
+    imageDirty = true;
     return globals::OK;
 }
 
+
+
+/*!
+ \brief Invalidate the image after data are stored to the EEPROM
+ The blocks stored to are read back from the EEPROM before they are used
+ again, so loads after a write (e.g. verifying the profiles) see what is
+ really in the EEPROM, and the cache file never holds data which haven't
+ been read back.
+ \param page     Page number (0 - 3)
+ \param address  EEPROM address the data were stored to
+ \param nBytes   Number of bytes stored
+*/
+void M24M02::imageInvalidate(uint8_t page, uint16_t address, int nBytes)
+{
+    if (imageBlockValid.size() != IMAGE_BLOCKS || nBytes <= 0) return;   // Image not open yet
+    const int imageOffset = (static_cast<int>(page) * 65536) + static_cast<int>(address);
+    if (imageOffset + nBytes > IMAGE_SIZE) return;
+    const int blockLast = (imageOffset + nBytes - 1) / IMAGE_BLOCK_SIZE;
+    for (int block = imageOffset / IMAGE_BLOCK_SIZE; block <= blockLast; block++)
+    {
+        imageBlockValid[block] = false;
+        imageBlockRead[block] = false;
+    }
+}
+
+
+
+/*!
+ \brief Start a write to the EEPROM
+ The header is erased first, so that an interrupted write can't leave a
+ cache file which matches the EEPROM. See imageWriteEnd.
+ Also starts the write statistics.
+ \return globals::OK
+ \return [error code]  Couldn't write the header
+*/
+int M24M02::imageWriteBegin()
+{
+    if (!imageChecked) imageOpen();
+    writeTimer.start();
+    writeBytes = 0;
+    writeFrames = 0;
+    writePagesSkipped = 0;
+    return headerStore(0);
+}
+
+
+
+/*!
+ \brief Finish a write to the EEPROM
+ Writes a new generation to the header, and reports the write throughput.
+ The image cache isn't saved here: the blocks written are invalid until
+ they have been read back from the EEPROM (see imageInvalidate), and the
+ cache is saved after that read (e.g. readFrequencyProfiles). Until then,
+ the cache file has the old generation, so it won't be used after a
+ reconnect either.
+ \return globals::OK
+ \return [error code]  Couldn't write the header
+*/
+int M24M02::imageWriteEnd()
+{
+    uint32_t generation = imageGeneration + 1;
+    if (imageGeneration == 0)
+    {
+        // No previous generation: Start from the time, so an erased or
+        // replaced EEPROM won't match an old cache file.
+        generation = static_cast<uint32_t>(QDateTime::currentMSecsSinceEpoch() / 1000);
+    }
+    if (generation == 0 || generation == 0xFFFFFFFF) generation = 1;
+    int result = headerStore(generation);
+    if (result != globals::OK) return result;
+    imageGeneration = generation;
+    imageDirty = true;
+
+    const qint64 elapsedMs = writeTimer.elapsed();
+    qDebug() << "M24M02: EEPROM write: " << writeBytes << " bytes in " << writeFrames << " frames; "
+             << writePagesSkipped << " sub-pages unchanged; " << elapsedMs << " ms ("
+             << ((elapsedMs > 0) ? (static_cast<double>(writeBytes) * 1000.0 / static_cast<double>(elapsedMs)) : 0.0) << " bytes/s)";
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Load the image cache header from the EEPROM (always read directly)
+ \param generation  Set to the generation, or 0 if the header isn't valid
+ \return globals::OK
+ \return [error code]  Couldn't read the EEPROM
+*/
+int M24M02::headerLoad(uint32_t *generation)
+{
+    *generation = 0;
+    uint8_t headerData[HEADER_SIZE] = { 0 };
+    uint16_t address = HEADER_ADDRESS;
+    int result = loadBytes(PAGE_STRINGS, &address, headerData, HEADER_SIZE);
+    if (result != globals::OK) return result;
+
+    uint16_t checkSum = 0;
+    for (int i = 0; i < HEADER_SIZE - 2; i++) checkSum += headerData[i];
+    const uint16_t magic = static_cast<uint16_t>(headerData[1] << 8) | headerData[0];   // Little endian format
+    const uint16_t checkSumStored = static_cast<uint16_t>(headerData[7] << 8) | headerData[6];
+    if (magic != HEADER_MAGIC || checkSum != checkSumStored) return globals::OK;   // No header
+    *generation = static_cast<uint32_t>(headerData[2])
+                | (static_cast<uint32_t>(headerData[3]) << 8)
+                | (static_cast<uint32_t>(headerData[4]) << 16)
+                | (static_cast<uint32_t>(headerData[5]) << 24);
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Store the image cache header to the EEPROM
+ \param generation  New generation, or 0 to erase the header
+ \return globals::OK
+ \return [error code]
+*/
+int M24M02::headerStore(uint32_t generation)
+{
+    uint8_t headerData[HEADER_SIZE];
+    memset(headerData, 0xFF, HEADER_SIZE);
+    if (generation != 0)
+    {
+        headerData[0] = static_cast<uint8_t>(HEADER_MAGIC & 0x00FF);   // Little endian format
+        headerData[1] = static_cast<uint8_t>(HEADER_MAGIC >> 8);
+        headerData[2] = static_cast<uint8_t>(generation);
+        headerData[3] = static_cast<uint8_t>(generation >> 8);
+        headerData[4] = static_cast<uint8_t>(generation >> 16);
+        headerData[5] = static_cast<uint8_t>(generation >> 24);
+        uint16_t checkSum = 0;
+        for (int i = 0; i < HEADER_SIZE - 2; i++) checkSum += headerData[i];
+        headerData[6] = static_cast<uint8_t>(checkSum & 0x00FF);
+        headerData[7] = static_cast<uint8_t>(checkSum >> 8);
+    }
+    uint16_t address = HEADER_ADDRESS;
+    return storeBlock(PAGE_STRINGS, &address, headerData, HEADER_SIZE);
+}
+
+
+
+/*!
+ \brief Hash for the image cache file (FNV-1a, 32 bit)
+*/
+uint32_t M24M02::imageHash(const uint8_t *data, int size)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
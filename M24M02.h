@@ -17,13 +17,10 @@
 
          Only 8 bit characters are supported!
 
-         The implementation only supports the 1st page of the EEPROM
-         (64 KB out of the total 256 KB). This is because the upper two
-         address bits (=EEPROM page) are included as part of the I2C address
-         byte, which is inconvenient for this implementation as we use a
-         pre-defined I2C address. If more than 64 KB of EEPROM storage are
-         needed, the page number will need to be added to the I2C address
-         for reads and writes to the device.
+         The EEPROM is addressed as four 64 KB pages. The upper two
+         address bits (=EEPROM page) are part of the I2C address byte,
+         so the I2C address for each operation is worked out from the
+         page (see deviceAddress). Reads and writes can't cross a page.
 
          The following string items will be stored in the EEPROM:
 
@@ -34,6 +31,17 @@
             Warranty starting date  - "2018-10-23"   - 20  chars
             Warranty ending date    - "2018-10-23"   - 20  chars
 
+         EEPROM image cache: Contents read from the EEPROM are kept in an
+         image (in 256 byte blocks), which is saved to a file for each
+         instrument (by serial number) in the application directory. An
+         8 byte header after the string table holds a generation number,
+         which is changed every time the EEPROM is written by this class.
+         On connect, only the header and serial number are read; if the
+         generation matches the cache file, the cached blocks are used
+         and the bulk reads of strings and profiles are skipped. See
+         imageOpen. Blocks are invalidated when written, so the cache only
+         ever holds data which have been read from the EEPROM.
+
  \author J Cole-Baker (For Smartest)
  \date   Jul 2018
 
@@ -46,6 +54,9 @@
 #include <stdint.h>
 #include <QStringList>
 #include <QMap>
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
 #include <string.h>
 
 #include "globals.h"
@@ -66,8 +77,10 @@ public:
     void getOptions();
     int init();
 
-    int readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles);
-    int writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles);
+    int readFrequencyProfiles(int deviceID, QVector<LMXFrequencyProfile> &frequencyProfiles);
+    int writeFrequencyProfiles(int deviceID, QVector<LMXFrequencyProfile> &frequencyProfiles);
+
+    int readSerialNumber(QString &serial);
 
 #define M24M02_SIGNALS \
     void EEPROMStringData(int deviceID, QString model, QString serial, QString productionDate, QString calibrationDate, QString warrantyStart, QString warrantyEnd, QString synthConfigVersion);
@@ -124,11 +137,43 @@ private:
     // Max block sizes
     static const int WRITE_BLK_SIZE = 59;  // Limit of USB-I2C Adaptor write buffer
     static const int READ_BLK_SIZE = 64;   // Limit of USB-I2C Adaptor read buffer
+    static const int WRITE_PAGE_SIZE = 256;         // Writes are split at 256 byte sub-pages (see note in M24M02.cpp)
+    static const int WRITE_ACK_TIMEOUT_MS = 25;     // Write cycle is 10 ms max, plus time for the last poll
+
+    // Frequency profiles:
+    static const int MAX_PROFILES = 255;            // Max number of profiles which will fit in one page (also a sanity check)
+    static const int PROFILE_AREA_MIN = 0x4000;     // Size of profile area rewritten by writeFrequencyProfiles (unused sub-pages cleared)
+
+    // EEPROM image cache:
+    static const uint16_t HEADER_ADDRESS      = 0x00F8;       // Header (page 0): after the string table
+    static const int      HEADER_SIZE         = 8;            // Magic (2) | Generation (4) | Checksum (2)
+    static const uint16_t HEADER_MAGIC        = 0x4745;       // "EG"
+    static const int      IMAGE_BLOCK_SIZE    = 256;          // Image is read from the EEPROM in 256 byte blocks (one sub-page each)
+    static const int      IMAGE_SIZE          = 4 * 65536;    // Whole EEPROM (4 pages)
+    static const int      IMAGE_BLOCKS        = IMAGE_SIZE / IMAGE_BLOCK_SIZE;
+    static const uint32_t IMAGE_FILE_MAGIC    = 0x43504545;   // "EEPC"
+    static const uint16_t IMAGE_FILE_VERSION  = 1;
 
     I2CComms *comms;
     const uint8_t i2cAddress;
     const int deviceID;
 
+    bool imageChecked = false;       // Header has been checked and the cache file loaded (once per connection)
+    bool imageDirty = false;         // Image has changed since the cache file was saved
+    uint32_t imageGeneration = 0;    // Generation from the EEPROM header (0 = no valid header)
+    QByteArray image;                // EEPROM contents (see imageBlockValid)
+    QVector<bool> imageBlockValid;   // Blocks of the image which match the EEPROM
+    QVector<bool> imageBlockRead;    // Valid blocks which were read from the EEPROM in this session (not from the cache file)
+    QString imageFileName;           // Cache file (empty = don't save)
+
+    // Write statistics (from imageWriteBegin):
+    QElapsedTimer writeTimer;
+    int writeBytes = 0;              // Bytes written to the EEPROM
+    int writeFrames = 0;             // Adaptor write frames
+    int writePagesSkipped = 0;       // Sub-pages not written (contents already matched)
+
+    uint8_t deviceAddress(uint8_t page) const { return static_cast<uint8_t>(i2cAddress | (page & 0x03)); }
+
     int storeBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nBytes);
     int loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nBytes);
 
@@ -137,17 +182,27 @@ private:
 
     int waitStoreAck();
 
-    int storeBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t nBytes);
+    int storeBlock(uint8_t page, uint16_t *address, uint8_t *data, int nBytes);
     int loadBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t nBytes);
 
     int storeString(StringID stringID, const QString &stringData);
     int loadString(StringID stringID, QString &stringData);
 
-    int storeFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile);
+    int frequencyProfileToBytes(LMXFrequencyProfile &profile, uint8_t *dataBuffer, int *nBytes);
     int loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile);
 
     int clearEEPROM();
-    int clearPROFILES();
+
+    int imageOpen();
+    void imageSave();
+    int imageFill(uint8_t page, uint16_t address, int nBytes, bool direct = false);
+    int imageBlocksRead(int blockFirst, int blockCount);
+    void imageInvalidate(uint8_t page, uint16_t address, int nBytes);
+    int imageWriteBegin();
+    int imageWriteEnd();
+    int headerLoad(uint32_t *generation);
+    int headerStore(uint32_t generation);
+    static uint32_t imageHash(const uint8_t *data, int size);
 
 };
 
@@ -193,13 +193,11 @@ void PCA9557::SetEEPROMWriteEnable(bool enable)
 */
 void PCA9557::ReadLMXLockDetect()
 {
-    uint8_t value = 0;
-    int result = PCA9557::getPins(&value);
+    bool isLocked = false;
+    int result = readLockDetect(&isLocked);
     if (result == globals::OK)
     {
-        // qDebug() << "PCA9557: ReadLMXLockDetect: " << result << "; Pins: " << value;
-        if ((value >> 3) & 0x01) emit LMXLockDetect(deviceID, true);  // Lock Detect = Bit 3
-        else                     emit LMXLockDetect(deviceID, false);
+        emit LMXLockDetect(deviceID, isLocked);
     }
     else
     {
@@ -210,6 +208,26 @@ void PCA9557::ReadLMXLockDetect()
 
 
 
+/*!
+ \brief Read level of "Lock Detect" pin from LMX clock (wired to our input IO3)
+ Assumes that IO3 is set up as an input (power-on default, so this can be
+ used before init). One I2C read; no signals emitted.
+ \param isLocked  Used to return the lock state (true if Lock Detect is high)
+ \return globals::OK   Success
+ \return [error code]  Error reading the input register
+*/
+int PCA9557::readLockDetect(bool *isLocked)
+{
+    uint8_t value = 0;
+    int result = getPins(&value);
+    // qDebug() << "PCA9557: readLockDetect: " << result << "; Pins: " << value;
+    *isLocked = (result == globals::OK) && ((value >> 3) & 0x01);  // Lock Detect = Bit 3
+    return result;
+}
+
+
+
+
 /**********************************************************************************/
 /*  PRIVATE Methods                                                               */
 /**********************************************************************************/
@@ -36,6 +36,8 @@ public:
     void getOptions();
     int init();
 
+    int readLockDetect(bool *isLocked);   // Read the LMX Lock Detect pin (see LMX2594::runFCal)
+
 #define PCA9557_SIGNALS \
     void LMXLockDetect(int deviceId, bool isLocked);
 
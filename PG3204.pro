@@ -68,6 +68,13 @@ SOURCES += main.cpp\
     LMXFrequencyProfile.cpp \
     SI5340.cpp \
     branding.cpp \
+    BathtubFit.cpp \
+    EyeMetrics.cpp \
+    EyeFrame.cpp \
+    EyeArchive.cpp \
+    ScanPlanner.cpp \
+    FrequencySweep.cpp \
+    LMXPllPlanner.cpp \
     widgets/BertUIBGWidget.cpp
 
 HEADERS += mainwindow.h \
@@ -106,6 +113,13 @@ HEADERS += mainwindow.h \
     widgets/BertUITextInput.h \
     LMXFrequencyProfile.h \
     SI5340.h \
+    BathtubFit.h \
+    EyeMetrics.h \
+    EyeFrame.h \
+    EyeArchive.h \
+    ScanPlanner.h \
+    FrequencySweep.h \
+    LMXPllPlanner.h \
     widgets/BertUIBGWidget.h
 
 FORMS   += \
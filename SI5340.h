@@ -30,6 +30,8 @@ public:
     void getOptions();
     int init();
 
+    float getFrequencyOut() const { return frequencyOut; }   // Output (LMX reference) frequency, MHz (0 = Unknown)
+
 #define SI5340_SIGNALS \
     void RefClockInfo(int deviceID, int indexProfile, float frequencyIn, float frequencyOut, QString descriptionIn, QString descriptionOut); \
     void RefClockSettingsChanged(int deviceID);
@@ -0,0 +1,379 @@
+/*!
+ \file   ScanPlanner.cpp
+ \brief  Eye Scan Time and Bus Cost Planner - Implementation
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+#include <math.h>
+
+#include "ScanPlanner.h"
+
+
+const int ScanPlanner::VHSTEP_LOOKUP[VHSTEP_COUNT] = { 1, 2, 4, 8 };
+
+// Time for one adaptor transaction until measured: I2COP_SLEEP_TIME plus a typical
+// serial round trip, as assumed by I2CComms until its first transaction:
+const double ScanPlanner::OP_LATENCY_DEFAULT = 5.0;
+
+// Chip sweep time per cell for each count resolution (1, 2, 4, 8 bit), until measured.
+// Rough values only: EyeMonitor replaces them after the first sweep at each resolution.
+const double ScanPlanner::SWEEP_MS_PER_CELL_DEFAULT[4] = { 0.02, 0.04, 0.08, 0.16 };
+
+const double ScanPlanner::SWEEP_TIME_WEIGHT = 0.25;  // Weight of each new sweep time measurement in the running average
+
+// I2C traffic of the fixed parts of GT1724::init: Rough defaults only, used until
+// GT1724::init has counted the transactions of each sequence (see sequenceRecord):
+const ScanPlanner::sequenceCost_t ScanPlanner::SEQUENCE_COSTS[SEQ_COUNT] =
+{
+    { "macroCheck",          0, 1 },  // Macro 0x18
+    { "getCurrentSettings", 12, 2 },  // Output swing and PRBS option query macros; register reads
+    { "configPG",           22, 4 },  // Macros 0x60 x2, 0x64, 0x58; read-modify-write of power down / LOS / CDR bypass registers
+    { "configSetDefaults",  34, 5 }   // Macro 0x61; EQ boost, de-emphasis and lane on for 2 lanes; configPG
+};
+
+
+/*!
+ \brief Get default cost parameters (used until measurements are available)
+*/
+void ScanPlanner::defaultParams(costParams_t *params)
+{
+    params->opLatencyMs      = OP_LATENCY_DEFAULT;
+    params->imageMaximumSize = 0;
+    params->stepMsMax        = 0.0;
+    for (int i = 0; i < 4; i++) params->sweepMsPerCell[i] = SWEEP_MS_PER_CELL_DEFAULT[i];
+    for (int i = 0; i < SEQ_COUNT; i++)
+    {
+        // Each short macro: write code, one status poll, read output (see GT1724::runMacroStatic):
+        params->sequenceOps[i]    = SEQUENCE_COSTS[i].registerOps + (3 * SEQUENCE_COSTS[i].macros);
+        params->sequenceWaitMs[i] = static_cast<double>(SEQUENCE_COSTS[i].macros * MACRO_POLL_MS);
+    }
+}
+
+
+/*!
+ \brief Record the cost of one of the fixed init sequences, as it actually ran
+ The time not taken by transactions (at the current opLatencyMs) is
+ taken as waiting, e.g. for macro status polls.
+ \param params     Cost parameters to update
+ \param sequence   SEQ_xxx
+ \param ops        Adaptor transactions counted while the sequence ran (see I2CComms::getOpCount)
+ \param elapsedMs  Measured time for the sequence
+*/
+void ScanPlanner::sequenceRecord(costParams_t *params, int sequence, int ops, double elapsedMs)
+{
+    if (sequence < 0 || sequence >= SEQ_COUNT || ops < 0) return;
+    params->sequenceOps[sequence]    = ops;
+    params->sequenceWaitMs[sequence] = qMax(0.0, elapsedMs - (static_cast<double>(ops) * params->opLatencyMs));
+}
+
+
+/*!
+ \brief Update the sweep time for a count resolution from a measured sweep
+ The macro polling quantises the measured time to MACRO_POLL_MS, so
+ the chip time is taken as the middle of the last poll interval.
+ \param params         Cost parameters to update
+ \param countResIndex  Count resolution of the sweep (0 - 3)
+ \param cells          Number of cells swept
+ \param elapsedMs      Measured time for the Control Eye Sweep macro, including I2C transactions
+*/
+void ScanPlanner::sweepTimeRecord(costParams_t *params, int countResIndex, int cells, double elapsedMs)
+{
+    if (countResIndex < 0 || countResIndex > 3 || cells < 1) return;
+    // Take off the fixed transactions (write input, write code, read output):
+    const double pollMs = static_cast<double>(MACRO_POLL_MS) + params->opLatencyMs;
+    int polls = static_cast<int>(floor(((elapsedMs - (3.0 * params->opLatencyMs)) / pollMs) + 0.5));
+    if (polls < 1) polls = 1;
+    double chipMs = (static_cast<double>(polls) - 0.5) * static_cast<double>(MACRO_POLL_MS);
+    double msPerCell = chipMs / static_cast<double>(cells);
+    params->sweepMsPerCell[countResIndex] += SWEEP_TIME_WEIGHT * (msPerCell - params->sweepMsPerCell[countResIndex]);
+}
+
+
+/*!
+ \brief Estimate the time for one macro (see GT1724::runMacroStatic)
+ \param params       Cost parameters
+ \param dataInSize   Bytes of input data (0 = no input write)
+ \param dataOutSize  Bytes of output data (0 = no output read)
+ \param chipMs       Time the chip spends running the macro
+ \return Estimated time (mS)
+*/
+double ScanPlanner::macroMs(const costParams_t &params, int dataInSize, int dataOutSize, double chipMs)
+{
+    int ops = 1;                  // Write macro code
+    if (dataInSize > 0)  ops++;   // Write input data
+    if (dataOutSize > 0) ops++;   // Read output data
+    int polls = static_cast<int>(ceil(chipMs / static_cast<double>(MACRO_POLL_MS)));
+    if (polls < 1) polls = 1;
+    return (static_cast<double>(ops) * params.opLatencyMs) +
+           (static_cast<double>(polls) * (static_cast<double>(MACRO_POLL_MS) + params.opLatencyMs));
+}
+
+
+/*!
+ \brief Get the number of lines (rows) to sweep in one part of a scan
+ As many lines as fit in the output memory, but if params.stepMsMax is
+ set, no more than can be swept and read back in that time (at least
+ one line).
+ \param params         Cost parameters
+ \param numPhaseSteps  Samples per line
+ \param countResIndex  Count resolution index (0 - 3)
+ \return Number of lines (1 - 127)
+*/
+int ScanPlanner::sweepLinesMax(const costParams_t &params, int numPhaseSteps, int countResIndex)
+{
+    if (countResIndex < 0 || countResIndex > 3 || numPhaseSteps < 8) return 1;
+    const int bytesPerLine = (numPhaseSteps * (1 << countResIndex)) / 8;
+    const int imageSize    = (params.imageMaximumSize > 0) ? params.imageMaximumSize : IMAGE_SIZE_DEFAULT;
+    int lines = qBound(1, imageSize / bytesPerLine, 127);
+    if (params.stepMsMax > 0.0)
+    {
+        while (lines > 1 && partMs(params, lines, numPhaseSteps, countResIndex) > params.stepMsMax) lines--;
+    }
+    return lines;
+}
+
+
+/*!
+ \brief Estimate the time to sweep and read back one part of a scan (mS)
+*/
+double ScanPlanner::partMs(const costParams_t &params, int lines, int numPhaseSteps, int countResIndex)
+{
+    const int bytes = (lines * numPhaseSteps * (1 << countResIndex)) / 8;
+    const double chipMs = static_cast<double>(lines * numPhaseSteps) * params.sweepMsPerCell[countResIndex];
+    return macroMs(params, 8, 2, chipMs) +                                                            // Control Eye Sweep (macro 0x42)
+           (static_cast<double>(read24FrameCount(bytes)) * params.opLatencyMs);  // Read back
+}
+
+
+/*!
+ \brief Estimate the cost of an eye or bathtub scan
+ Follows the sequence in EyeMonitor::scanStepSetup / scanStepSweep:
+ each repeat queries the output memory, then sweeps and reads back
+ as many lines as will fit in the output memory until the scan is
+ finished.
+ \param params         Cost parameters
+ \param type           EYE_SCAN or BATHTUB_SCAN
+ \param hStepIndex     Index into VHSTEP_LOOKUP
+ \param vStepIndex     Index into VHSTEP_LOOKUP (ignored for bathtub scans)
+ \param countResIndex  Count resolution index (0 - 3)
+ \param repeatCount    Number of repeats
+ \param nChannels      Number of channels scanning at the same time
+ \param cost           Set to the estimated cost
+ \return globals::OK
+ \return globals::OVERFLOW  A parameter was out of range
+*/
+int ScanPlanner::eyeScanCost(const costParams_t &params,
+                             int type,
+                             int hStepIndex,
+                             int vStepIndex,
+                             int countResIndex,
+                             int repeatCount,
+                             int nChannels,
+                             eyeScanCost_t *cost)
+{
+    if ( (hStepIndex < 0) || (hStepIndex >= VHSTEP_COUNT) ||
+         (vStepIndex < 0) || (vStepIndex >= VHSTEP_COUNT) ||
+         (countResIndex < 0) || (countResIndex > 3) ||
+         (repeatCount < 1) || (nChannels < 1) ) return globals::OVERFLOW;
+
+    const int numPhaseSteps = 128 / VHSTEP_LOOKUP[hStepIndex];
+    const int countResBits  = 1 << countResIndex;
+    const int bytesPerLine  = (numPhaseSteps * countResBits) / 8;
+    const int linesMax      = sweepLinesMax(params, numPhaseSteps, countResIndex);
+
+    int numOffsetSteps;
+    if (type == EYE_SCAN)
+    {
+        numOffsetSteps = 128 / VHSTEP_LOOKUP[vStepIndex];
+        if (numOffsetSteps == 128) numOffsetSteps = 127;
+    }
+    else
+    {
+        numOffsetSteps = 1;
+    }
+
+    cost->parts        = 0;
+    cost->cells        = numPhaseSteps * numOffsetSteps;
+    cost->bytesRead    = 0;
+    cost->read24Frames = 0;
+    cost->macros       = 1;  // Query output memory (macro 0x41)
+
+    double totalMs = macroMs(params, 0, 4, 0.0);
+    double sweepMs = 0.0;
+    int linesRemaining = numOffsetSteps;
+    while (linesRemaining > 0)
+    {
+        int lines = qMin(linesRemaining, linesMax);
+        int bytes = lines * bytesPerLine;
+        int frames = read24FrameCount(bytes);
+        totalMs += partMs(params, lines, numPhaseSteps, countResIndex);
+        sweepMs += static_cast<double>(lines * numPhaseSteps) * params.sweepMsPerCell[countResIndex];
+        cost->parts++;
+        cost->macros++;
+        cost->bytesRead    += bytes;
+        cost->read24Frames += frames;
+        linesRemaining -= lines;
+    }
+
+    cost->sweepSeconds  = sweepMs / 1000.0;
+    cost->busSeconds    = (totalMs - sweepMs) / 1000.0;
+    cost->repeatSeconds = (totalMs / 1000.0) * static_cast<double>(nChannels);
+    cost->seconds       = cost->repeatSeconds * static_cast<double>(repeatCount);
+    return globals::OK;
+}
+
+
+/*!
+ \brief Choose scan settings to fit a time budget
+ Picks the finest resolution (most cells) for which one repeat fits in
+ the budget, then as many repeats as fit. Between settings with the same
+ number of cells, the one with the largest error count range (repeats
+ x maximum count per repeat; i.e. lowest BER floor) is used, then the
+ finer phase step.
+ \param params         Cost parameters
+ \param type           EYE_SCAN or BATHTUB_SCAN
+ \param budgetSeconds  Time available
+ \param nChannels      Number of channels scanning at the same time
+ \param plan           Set to the chosen settings. If nothing fits, set to the
+                       quickest possible scan (1 repeat), so the caller can
+                       report the minimum time needed.
+ \return globals::OK
+ \return globals::OVERFLOW  Even the quickest scan doesn't fit the budget
+*/
+int ScanPlanner::planBudget(const costParams_t &params,
+                            int type,
+                            double budgetSeconds,
+                            int nChannels,
+                            plan_t *plan)
+{
+    const int nSteps = VHSTEP_COUNT;
+    const int nVSteps = (type == EYE_SCAN) ? nSteps : 1;  // Bathtub scans have one row
+    bool found = false;
+    double bestRange = 0.0;
+    double quickest = -1.0;
+    eyeScanCost_t cost;
+
+    for (int hIndex = 0; hIndex < nSteps; hIndex++)
+    {
+        for (int vIndex = 0; vIndex < nVSteps; vIndex++)
+        {
+            for (int crIndex = 0; crIndex < 4; crIndex++)
+            {
+                if (eyeScanCost(params, type, hIndex, vIndex, crIndex, 1, nChannels, &cost) != globals::OK) continue;
+                if (quickest < 0.0 || cost.repeatSeconds < quickest)
+                {
+                    quickest = cost.repeatSeconds;
+                    if (!found)
+                    {
+                        plan->hStepIndex    = hIndex;
+                        plan->vStepIndex    = vIndex;
+                        plan->countResIndex = crIndex;
+                        plan->repeatCount   = 1;
+                        plan->cost          = cost;
+                    }
+                }
+                if (cost.repeatSeconds > budgetSeconds) continue;
+
+                int repeats = static_cast<int>(floor(budgetSeconds / cost.repeatSeconds));
+                double range = static_cast<double>(repeats) * static_cast<double>((1 << (1 << crIndex)) - 1);
+                bool better;
+                if      (!found)                           better = true;
+                else if (cost.cells != plan->cost.cells)   better = (cost.cells > plan->cost.cells);
+                else if (range != bestRange)               better = (range > bestRange);
+                else                                       better = (hIndex < plan->hStepIndex);
+                if (!better) continue;
+
+                found               = true;
+                bestRange           = range;
+                plan->hStepIndex    = hIndex;
+                plan->vStepIndex    = vIndex;
+                plan->countResIndex = crIndex;
+                plan->repeatCount   = repeats;
+                plan->cost          = cost;
+                plan->cost.seconds  = cost.repeatSeconds * static_cast<double>(repeats);
+            }
+        }
+    }
+    if (!found)
+    {
+        qDebug() << "Scan planner: No scan fits in " << budgetSeconds << " s; quickest needs " << quickest << " s";
+        return globals::OVERFLOW;
+    }
+    qDebug() << "Scan planner: Budget " << budgetSeconds << " s ->"
+             << " H Step: " << VHSTEP_LOOKUP[plan->hStepIndex]
+             << "; V Step: " << VHSTEP_LOOKUP[plan->vStepIndex]
+             << "; Resolution: " << (1 << plan->countResIndex)
+             << "; Repeats: " << plan->repeatCount
+             << "; Estimated time: " << plan->cost.seconds << " s";
+    return globals::OK;
+}
+
+
+/*!
+ \brief Estimate the time to read the ED counters (see GT1724::getEDCount)
+ Each lane needs two ED counter macros (bits and errors).
+ \param params    Cost parameters
+ \param nEDLanes  Number of ED lanes polled
+ \return Estimated time (seconds) for one poll of all lanes
+*/
+double ScanPlanner::edPollSeconds(const costParams_t &params, int nEDLanes)
+{
+    return (static_cast<double>(nEDLanes) * 2.0 * macroMs(params, 1, 2, 0.0)) / 1000.0;
+}
+
+
+/*!
+ \brief Estimate the time for GT1724::init
+ \param params      Cost parameters
+ \param coldBoot    If true, the macro file is downloaded and defaults are set
+ \param hexRecords  Number of records in the macro file (each is written with one
+                    write24 frame; ignored for a warm boot)
+ \return Estimated time (seconds)
+*/
+double ScanPlanner::initSeconds(const costParams_t &params, bool coldBoot, int hexRecords)
+{
+    double ms = sequenceMs(params, SEQ_MACRO_CHECK) +
+                sequenceMs(params, SEQ_GET_SETTINGS) +
+                sequenceMs(params, SEQ_CONFIG_PG);
+    if (coldBoot)
+    {
+        ms += sequenceMs(params, SEQ_MACRO_CHECK) +          // Recheck after download
+              sequenceMs(params, SEQ_SET_DEFAULTS) +
+              (static_cast<double>(hexRecords) * params.opLatencyMs);
+    }
+    return ms / 1000.0;
+}
+
+
+/*!
+ \brief Get the number of adaptor transactions used by I2CComms::read24
+ Follows the frame splitting in read24: up to 16 bytes per frame,
+ making sure the last frame reads at least 2 bytes.
+ \param nBytes  Number of bytes to read
+ \return Number of calls to i2cOp (not counting retries)
+*/
+int ScanPlanner::read24FrameCount(int nBytes)
+{
+    int bytesRemaining = nBytes;
+    int frames = 0;
+    while (bytesRemaining > 0)
+    {
+        if      (bytesRemaining >= 18) bytesRemaining -= 16;
+        else if (bytesRemaining >= 17) bytesRemaining -= 15;
+        else                           bytesRemaining = 0;
+        frames++;
+    }
+    return frames;
+}
+
+
+/*!
+ \brief Estimate the time for one of the fixed init sequences (mS; see sequenceRecord)
+*/
+double ScanPlanner::sequenceMs(const costParams_t &params, int sequence)
+{
+    return (static_cast<double>(params.sequenceOps[sequence]) * params.opLatencyMs) +
+           params.sequenceWaitMs[sequence];
+}
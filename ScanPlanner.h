@@ -0,0 +1,160 @@
+/*!
+ \file   ScanPlanner.h
+ \brief  Eye Scan Time and Bus Cost Planner - Class Header
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#ifndef SCANPLANNER_H
+#define SCANPLANNER_H
+
+#include "globals.h"
+
+
+/*!
+ \brief Eye Scan Time and Bus Cost Planner
+ Predicts how long eye / bathtub scans, ED polling and GT1724 init
+ sequences will take, from the same model of the I2C traffic that
+ they generate:
+
+  - Each adaptor transaction (i2cOp) takes opLatencyMs (measured
+    by I2CComms).
+  - The fixed parts of GT1724::init are costed from the number of
+    transactions and the wait time counted the last time each one
+    ran (see sequenceRecord).
+  - A macro writes its input data and code, then polls the status
+    register every MACRO_POLL_MS until the chip has finished (see
+    GT1724::runMacroStatic), then reads its output data.
+  - Eye scan data are read back with read24, in frames of up to
+    16 bytes (see read24FrameCount).
+  - The chip sweeps each scan cell in sweepMsPerCell (measured by
+    EyeMonitor for each count resolution).
+  - The output memory (imageMaximumSize) holds a limited number
+    of scan lines, so large scans are swept in several parts. Parts
+    may also be limited to stepMsMax (while the ED is running; see
+    GT1724::edSweepBegin).
+
+ Scans on different channels are stepped in turn on the same bus
+ (see GT1724::eyeScanService), so their times add.
+*/
+class ScanPlanner
+{
+public:
+
+    // Fixed sequences run by GT1724::init (see sequenceRecord):
+    static const int SEQ_MACRO_CHECK  = 0;   // GT1724::macroCheck
+    static const int SEQ_GET_SETTINGS = 1;   // GT1724::getCurrentSettings
+    static const int SEQ_CONFIG_PG    = 2;   // GT1724::configPG
+    static const int SEQ_SET_DEFAULTS = 3;   // GT1724::configSetDefaults (cold boot only)
+    static const int SEQ_COUNT        = 4;
+
+    // Scan types (GT1724::GT1724_EYE_SCAN and GT1724_BATHTUB_SCAN are defined from these):
+    static const int EYE_SCAN     = 1;
+    static const int BATHTUB_SCAN = 2;
+
+    // Phase / offset step sizes for each hStepIndex / vStepIndex (GT1724::EYESCAN_VHSTEP_LOOKUP is built from these):
+    static const int VHSTEP_COUNT = 4;
+    static const int VHSTEP_LOOKUP[VHSTEP_COUNT];
+
+    // Timings that the estimates are based on (measured, or defaults until measured):
+    typedef struct costParams_t
+    {
+        double opLatencyMs;        // Time for one I2C adaptor transaction (mS)
+        int    imageMaximumSize;   // Size of the eye scan output memory (bytes; 0 = not known yet)
+        double sweepMsPerCell[4];  // Chip time to sweep one cell (mS), for each count resolution index
+        double stepMsMax;          // Longest sweep and read back of one part (mS; 0 = no limit; see sweepLinesMax)
+        int    sequenceOps[SEQ_COUNT];     // Adaptor transactions in each fixed sequence
+        double sequenceWaitMs[SEQ_COUNT];  // Time spent waiting (i.e. macro polls) in each fixed sequence (mS)
+    } costParams_t;
+
+    // Estimated cost of an eye or bathtub scan. "Per repeat" values are for one channel:
+    typedef struct eyeScanCost_t
+    {
+        int    parts;           // Sweeps per repeat (output memory too small for the whole scan)
+        int    cells;           // Cells in the scan (xRes * yRes)
+        int    bytesRead;       // Bytes read back per repeat
+        int    read24Frames;    // Adaptor transactions to read back the data, per repeat
+        int    macros;          // Macros run per repeat
+        double sweepSeconds;    // Chip sweep time per repeat
+        double busSeconds;      // Bus time (transactions and macro polling) per repeat, not counting the sweep
+        double repeatSeconds;   // Time for one repeat on all channels
+        double seconds;         // Total time for all repeats on all channels
+    } eyeScanCost_t;
+
+    // Scan settings chosen to fit a time budget (see planBudget):
+    typedef struct plan_t
+    {
+        int hStepIndex;      // Index into VHSTEP_LOOKUP
+        int vStepIndex;      // Index into VHSTEP_LOOKUP
+        int countResIndex;   // Index into GT1724::EYESCAN_COUNTRES_LIST
+        int repeatCount;     // Number of scans to accumulate
+        eyeScanCost_t cost;  // Cost of the plan (for repeatCount repeats)
+    } plan_t;
+
+    static void defaultParams(costParams_t *params);
+
+    static void sequenceRecord(costParams_t *params,
+                               int sequence,         // SEQ_xxx
+                               int ops,              // Adaptor transactions counted while the sequence ran
+                               double elapsedMs);    // Measured time for the sequence
+
+    static void sweepTimeRecord(costParams_t *params,
+                                int countResIndex,
+                                int cells,           // Number of cells swept
+                                double elapsedMs);   // Measured time for the Control Eye Sweep macro
+
+    static double macroMs(const costParams_t &params,
+                          int dataInSize,
+                          int dataOutSize,
+                          double chipMs);            // Time the chip spends running the macro
+
+    static int sweepLinesMax(const costParams_t &params,
+                             int numPhaseSteps,
+                             int countResIndex);
+
+    static int eyeScanCost(const costParams_t &params,
+                           int type,                 // EYE_SCAN or BATHTUB_SCAN
+                           int hStepIndex,
+                           int vStepIndex,
+                           int countResIndex,
+                           int repeatCount,
+                           int nChannels,            // Number of channels scanning at the same time
+                           eyeScanCost_t *cost);
+
+    static int planBudget(const costParams_t &params,
+                          int type,
+                          double budgetSeconds,
+                          int nChannels,
+                          plan_t *plan);
+
+    static double edPollSeconds(const costParams_t &params, int nEDLanes);
+
+    static double initSeconds(const costParams_t &params,
+                              bool coldBoot,         // Macro file must be downloaded (see GT1724::init)
+                              int hexRecords);       // Number of records in the macro file
+
+    static int read24FrameCount(int nBytes);
+
+    static const int IMAGE_SIZE_DEFAULT = 4096;  // Assumed output memory size until read from the chip
+    static const int MACRO_POLL_MS      = 100;   // Macro status poll interval (see GT1724::runMacroStatic)
+
+private:
+    static const double OP_LATENCY_DEFAULT;
+    static const double SWEEP_MS_PER_CELL_DEFAULT[4];
+    static const double SWEEP_TIME_WEIGHT;
+
+    // I2C traffic for a fixed sequence of register ops and short macros (used until counted):
+    typedef struct sequenceCost_t
+    {
+        const char *name;
+        int registerOps;   // Single register reads / writes (one transaction each)
+        int macros;        // Macros which finish within one poll
+    } sequenceCost_t;
+
+    static const sequenceCost_t SEQUENCE_COSTS[SEQ_COUNT];
+
+    static double sequenceMs(const costParams_t &params, int sequence);
+    static double partMs(const costParams_t &params, int lines, int numPhaseSteps, int countResIndex);
+};
+
+#endif // SCANPLANNER_H
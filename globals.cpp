@@ -5,6 +5,8 @@
  \date   Jan 2015
 */
 
+#include <math.h>
+
 #include "globals.h"
 
 // Macro file information:
@@ -57,6 +59,45 @@ const size_t globals::N_MACRO_FILES = sizeof(MACRO_FILES) / sizeof(MACRO_FILES[0
 
 const double globals::BELOW_DETECTION_LIMIT = -999999.0;
 
+// Error / status codes: Values are set in globals.h. Defined here as well, so they
+// can be bound to references (e.g. QCOMPARE in the unit tests, qMax):
+const int globals::OK;
+const int globals::GEN_ERROR;
+const int globals::TIMEOUT;
+const int globals::OVERFLOW;
+const int globals::NOT_CONNECTED;
+const int globals::MACRO_ERROR;
+const int globals::READ_ERROR;
+const int globals::WRITE_ERROR;
+const int globals::FILE_ERROR;
+const int globals::BAD_LANE_ID;
+const int globals::WRITE_TIMEOUT;
+const int globals::WRITE_CONF_TIMEOUT;
+const int globals::READ_TIMEOUT;
+const int globals::ADAPTOR_READ_ERROR;
+const int globals::ADAPTOR_WRITE_ERROR;
+const int globals::MALLOC_ERROR;
+const int globals::BUSY_ERROR;
+const int globals::NOT_INITIALISED;
+const int globals::DIRECTORY_NOT_FOUND;
+const int globals::INVALID_BOARD;
+const int globals::DEVICE_NOT_FOUND;
+const int globals::INVALID_DATA;
+const int globals::END_OF_DATA;
+const int globals::BAD_CHECKSUM;
+const int globals::MISSING_GT1724;
+const int globals::MISSING_LMX;
+const int globals::MISSING_LMX_DEFS;
+const int globals::MISSING_PCA;
+const int globals::MISSING_EEPROM;
+const int globals::NOT_IMPLEMENTED;
+const int globals::READY;
+const int globals::IN_PROGRESS;
+const int globals::CANCELLED;
+const int globals::MACROS_LOADED;
+const int globals::MACROS_NOT_LOADED;
+const int globals::ALL_LANES;
+
 const QString globals::BUILD_VERSION = QString( "3.2.10" );
 const QString globals::BUILD_DATE = __DATE__ " " __TIME__;
 
@@ -77,3 +118,28 @@ QString globals::getAppPath()
     return globals::appPath;
 }
 
+
+/*!
+ \brief Poisson cumulative probability: P(X <= k) for mean lambda
+ Summed exactly for small means; a normal approximation is used above
+ POISSON_EXACT_MAX.
+*/
+double globals::poissonCdf(double k, double lambda)
+{
+    if (k < 0.0) return 0.0;
+    if (lambda <= 0.0) return 1.0;
+    if (lambda > POISSON_EXACT_MAX)
+    {
+        return 0.5 * erfc( -((floor(k) + 0.5) - lambda) / sqrt(2.0 * lambda) );
+    }
+    if (k > lambda + (20.0 * sqrt(lambda)) + 20.0) return 1.0;  // Far above the mean (keeps the sum short)
+    double term = exp(-lambda);
+    double sum = term;
+    for (int i = 1; i <= static_cast<int>(k); i++)
+    {
+        term *= lambda / i;
+        sum += term;
+    }
+    return qMin(sum, 1.0);
+}
+
@@ -131,6 +131,16 @@ public:
     static void sleep(unsigned int milliSeconds) { Sleep((DWORD)milliSeconds); }
 
 
+    /*!
+     \brief Poisson cumulative probability: P(X <= k) for mean lambda
+            Used for BER confidence decisions (eye mask test, frequency sweep).
+     \param k       Number of events (errors)
+     \param lambda  Expected number of events
+    */
+    static double poissonCdf(double k, double lambda);
+    static const int POISSON_EXACT_MAX = 1000;  // Above this expected count, use a normal approximation
+
+
     /*!
       \brief App Path: Path to the directory where the executable is located
              Must be SET from the main window constructor (or similar) before use.
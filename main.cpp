@@ -103,8 +103,9 @@ int main(int argc, char *argv[])
     QApplication a(argc, argv);
 
     qRegisterMetaType<QVector<double> >("QVector<double>");
+    qRegisterMetaType<QVector<int> >("QVector<int>");
     qRegisterMetaType<QString>("QString");
-    qRegisterMetaType<QList<LMXFrequencyProfile> >("QList<LMXFrequencyProfile>");
+    qRegisterMetaType<QVector<LMXFrequencyProfile> >("QVector<LMXFrequencyProfile>");
 
     BertWindow *w = new BertWindow(NULL);
     w->show();
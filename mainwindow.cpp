@@ -11,6 +11,39 @@ const QList<int> BertWindow::EYESCAN_REPEATS_LOOKUP =
 const QStringList BertWindow::EYESCAN_REPEATS_LIST =
    { "1", "5", "10", "50", "100", "500", "1000", "∞" };
 
+// -- Scan Time Limit Lookup (see ScanPlanner::planBudget): ------------
+// Maps the index of items in the eye scan and bathtub plot "Time Limit"
+// combo box to a time budget in seconds (for all selected channels).
+const QList<double> BertWindow::EYESCAN_PLAN_TIME_LOOKUP =
+   { 10.0, 30.0, 60.0, 300.0, 900.0, 3600.0 };
+
+const QStringList BertWindow::EYESCAN_PLAN_TIME_LIST =
+   { "10 s", "30 s", "1 min", "5 min", "15 min", "1 hour" };
+
+// -- Eye Drift Monitor settings (see EyeMonitor::driftStart): ------------
+const double BertWindow::EYE_DRIFT_TARGET_BER = 1.0e-3;
+const double BertWindow::EYE_DRIFT_THRESHOLD  = 0.05;
+const double BertWindow::EYE_DRIFT_DUTY_CYCLE = 0.02;
+
+// -- Frequency Sweep measurement time per rate (see FrequencySweep::start): ------------
+const QList<double> BertWindow::FREQ_SWEEP_TIME_LOOKUP =
+   { 1.0, 5.0, 10.0, 30.0, 60.0 };
+
+const QStringList BertWindow::FREQ_SWEEP_TIME_LIST =
+   { "1 s", "5 s", "10 s", "30 s", "60 s" };
+
+// -- Repeated scan auto-stop settings (see EyeMonitor::setAutoStopOptions): ------------
+const double BertWindow::EYE_AUTOSTOP_TOLERANCE  = 0.02;
+const double BertWindow::EYE_AUTOSTOP_METRIC_BER = 1.0e-3;
+
+// -- Eye Contour Scan settings (see EyeMonitor::startContourScan): ------------
+const double BertWindow::EYE_CONTOUR_TARGET_BER = 1.0e-3;
+const int    BertWindow::EYE_CONTOUR_REPEATS    = 3;
+
+// -- Golden Eye Compare settings (see EyeArchive::compare): ------------
+const double BertWindow::EYE_GOLDEN_TOLERANCE  = 0.5;
+const double BertWindow::EYE_GOLDEN_PLOT_RANGE = 3.0;
+
 
 
 BertWindow::BertWindow(QWidget *parent) :
@@ -263,7 +296,12 @@ void BertWindow::ListPopulate(QString name, int lane, QStringList items, int def
     eventsEnabled = false;
     listPopulate(name, lane, items, defaultIndex);
     // SPECIAL CASES:
-    if (name == "listLMXFreq") listPopulate("listEEPROMLMXFreq", lane, items, 0);
+    if (name == "listLMXFreq")
+    {
+        listPopulate("listEEPROMLMXFreq", lane, items, 0);
+        listPopulate("listFreqSweepFrom", lane, items, 0);
+        listPopulate("listFreqSweepTo", lane, items, items.size() - 1);
+    }
     eventsEnabled = true;
 }
 
@@ -349,8 +387,10 @@ void BertWindow::EDCount(int lane,
     // "bit error RATIO" as it is errors per bit, not errors per second.
 
     // Update the ED requests pending count: Choose the master or slave count based on the board for this lane.
-    if (BertChannel::laneToBoard(lane) == 0) edMasterRequestsPending--;
-    else                                     edSlaveRequestsPending--;
+    // Nb: The back end also sends counts without a request (snapshots taken during
+    // eye scans), so don't let the count go negative:
+    if (BertChannel::laneToBoard(lane) == 0) { if (edMasterRequestsPending > 0) edMasterRequestsPending--; }
+    else                                     { if (edSlaveRequestsPending > 0)  edSlaveRequestsPending--;  }
 
     // If this count is for a lane which wasn't locked, IGNORE the count:
     // The values will be all 0! Note we DO have to decrement the "pending" count
@@ -392,7 +432,7 @@ void BertWindow::EDCount(int lane,
 
 // ========== SLOTS - LMX Clock Source  ====================================
 
-void BertWindow::LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPower, int indexFOutOutputPower, int indexTriggerDivide, bool outputsOn, float frequency)
+void BertWindow::LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPower, int indexFOutOutputPower, int indexTriggerDivide, bool outputsOn, float frequency, int lockTimeMs)
 {
 #ifdef BERT_SIGNALS_DEBUG
     qDebug() << "Received Sig LMXInfo for clock " << deviceID;
@@ -404,6 +444,7 @@ void BertWindow::LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPowe
     Q_UNUSED(indexTriggerDivide)
     eventsEnabled = false;
     listLMXFreq->setCurrentIndex(indexProfile);
+    inputLMXFreq->setText(QString("%1").arg(static_cast<double>(frequency), 0, 'f', 3));  // MHz
     listLMXTrigOutPower->setCurrentIndex(indexTrigOutputPower);
     // Update the system-wide bit rate:
     bitRate = static_cast<double>(frequency) * 2.0 * 1e6; // Convert to GBits and double (clock is 1/2 rate)
@@ -412,6 +453,7 @@ void BertWindow::LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPowe
     valueBitRate_EyeScan->setText( QString("%1").arg( (bitRate/1e9), 0, 'f', 5)  );
     valueBitRate_Bathtub->setText( QString("%1").arg( (bitRate/1e9), 0, 'f', 5)  );
     qDebug() << "Bitrate Updated to " << bitRate;
+    if (lockTimeMs >= 0) qDebug() << "Clock lock time: " << lockTimeMs << " ms";
     tickCountClockLockUpdate = 0;
     eventsEnabled = true;
 }
@@ -492,6 +534,7 @@ void BertWindow::EEPROMStringData(int deviceID,
 
     UpdateString("InstrumentModel", 0, model);
     UpdateString("InstrumentSerial", 0, serial);
+    instrumentSerial = serial;
     UpdateString("InstrumentProductionDate", 0, productionDate);
     UpdateString("InstrumentCalibrationDate", 0, calibrationDate);
     UpdateString("InstrumentWarrantyStartDate", 0, warrantyStart);
@@ -674,6 +717,9 @@ void BertWindow::uiChangeOnConnect(bool connectedStatus)
     tabAnalysisEyeScan->setEnabled(connectedStatus);
     tabAnalysisBathtub->setEnabled(connectedStatus);
     tabAbout->setEnabled(true);
+
+    eyeDriftUIUpdate(false);  // Drift monitors don't survive a reconnect
+    freqSweepUIUpdate(false);
 }
 
 
@@ -720,11 +766,15 @@ void BertWindow::on_tabWidget_tabBarClicked(int index)
 void BertWindow::on_tabWidget_currentChanged(int index)
 {
     Q_UNUSED(index)
+    TabID tabID = static_cast<TabID>(tabWidget->currentWidget()->property("TabID").toInt());
+    // While the ED is running, eye and bathtub scans can be run alongside it
+    // (the back end keeps reading the ED counters during scans):
+    bool edScanTab = (tabID == TAB_ED) || (tabID == TAB_EYESCAN) || (tabID == TAB_BATHTUB);
     // Can't change tabs while connecting, or ED, eye scan or bathtub analysis is operating:
-    if ( (connectInProgress) ||
-         (edPending)         ||
-         (edRunning)         ||
-         (eyeScanRunning)    ||
+    if ( (connectInProgress)         ||
+         (edPending)                 ||
+         (edRunning && !edScanTab)   ||
+         (eyeScanRunning)            ||
          (bathtubRunning) )
     {
         tabWidget->setCurrentIndex(currentTabIndex);
@@ -734,7 +784,6 @@ void BertWindow::on_tabWidget_currentChanged(int index)
 
     // When changing to the ED page, update the Start / Stop button status
     // (this depends on info on other pages...)
-    TabID tabID = static_cast<TabID>(tabWidget->currentWidget()->property("TabID").toInt());
     if (tabID == TAB_ED) edStartStopReflect();
     currentTabIndex = tabWidget->currentIndex();
 }
@@ -925,6 +974,124 @@ void BertWindow::on_buttonVerifyLMXProfiles_clicked()
 // ***** Clock Synth Page ********************************************************
 // *******************************************************************************
 
+/*!
+ \brief Frequency Sweep UI Config
+ \param isRunning
+*/
+void BertWindow::freqSweepUIUpdate(bool isRunning)
+{
+    freqSweepRunning = isRunning;
+    buttonFreqSweep->setText(isRunning ? "Stop Sweep" : "Frequency Sweep");
+    listLMXFreq->setEnabled(!isRunning);
+    listFreqSweepFrom->setEnabled(!isRunning);
+    listFreqSweepTo->setEnabled(!isRunning);
+    inputFreqSweepStep->setEnabled(!isRunning);
+    listFreqSweepTime->setEnabled(!isRunning);
+    inputLMXFreq->setEnabled(!isRunning);
+    buttonLMXFreqSet->setEnabled(!isRunning);
+}
+
+
+/*!
+ \brief Get the clock frequency of the selected item in a frequency profile list
+ List items show the frequency in GHz first (see LMX2594::init).
+ \param list  listFreqSweepFrom or listFreqSweepTo
+ \return Frequency (MHz), or 0 if nothing is selected
+*/
+double BertWindow::freqSweepListFrequency(const BertUIList *list) const
+{
+    bool ok = false;
+    double frequencyGHz = list->currentText().section(' ', 0, 0, QString::SectionSkipEmpty).toDouble(&ok);
+    return (ok) ? (frequencyGHz * 1000.0) : 0.0;
+}
+
+
+/*!
+ \brief Set the synthesizer to the frequency typed in (see LMX2594::SelectFrequency)
+ The frequency doesn't need to be in the list of profiles: the register
+ settings are worked out from the nearest profile.
+*/
+void BertWindow::on_buttonLMXFreqSet_clicked()
+{
+    bool ok = false;
+    double frequency = inputLMXFreq->text().trimmed().toDouble(&ok);
+    if (!ok || frequency <= 0.0)
+    {
+        updateStatus("Enter the synthesizer frequency in MHz (clock frequency is 1/2 of the bit rate).");
+        return;
+    }
+    lampLMXLockMaster->setState(BertUILamp::ERR);
+
+    if (maxChannel > 4) lampLMXLockSlave->setState(BertUILamp::ERR);
+    else                lampLMXLockSlave->setState(BertUILamp::OFF);
+
+    lockUI(5000, 1);
+    emit SelectFrequency(frequency);
+}
+
+
+/*!
+ \brief Start / stop a frequency sweep (see BertWorker::FreqSweepStart)
+ Steps through the frequency profiles from "Sweep From" to "Sweep To",
+ measuring the BER on every ED lane for a fixed time at each rate. If a
+ sweep step is entered, steps through evenly spaced frequencies between
+ the two profiles instead (see BertWorker::FreqSweepStartRange). Uses
+ the PG and ED patterns of channel 1. The ED must be stopped first.
+*/
+void BertWindow::on_buttonFreqSweep_clicked()
+{
+    if (freqSweepRunning)
+    {
+        emit FreqSweepCancel();
+        updateStatus("Stopping Frequency Sweep...");
+        return;
+    }
+    BertChannel *bertChannel = getChannel(1);
+    int indexFrom = listFreqSweepFrom->currentIndex();
+    int indexTo = listFreqSweepTo->currentIndex();
+    int timeIndex = listFreqSweepTime->currentIndex();
+    if (!bertChannel || indexFrom < 0 || indexTo < 0 || timeIndex < 0) return;
+    if (edRunning)
+    {
+        updateStatus("Stop the Error Detector before running a Frequency Sweep.");
+        return;
+    }
+    const QString stepText = inputFreqSweepStep->text().trimmed();
+    if (!stepText.isEmpty())
+    {
+        bool ok = false;
+        double frequencyStep = stepText.toDouble(&ok);
+        if (!ok || frequencyStep <= 0.0)
+        {
+            updateStatus("Enter the sweep step in MHz, or leave it blank to sweep the frequency profiles.");
+            return;
+        }
+        freqSweepUIUpdate(true);
+        updateStatus(QString("Frequency Sweep: %1 MHz steps...").arg(frequencyStep));
+        emit FreqSweepStartRange(freqSweepListFrequency(listFreqSweepFrom),
+                                 freqSweepListFrequency(listFreqSweepTo),
+                                 frequencyStep,
+                                 bertChannel->getPG()->getPGPatternIndex(),
+                                 bertChannel->getED()->getEDPatternIndex(),
+                                 FREQ_SWEEP_TIME_LOOKUP[timeIndex],
+                                 0.0,                            // targetBER: Unused for fixed time measurements
+                                 0.0);                           // confidence: Fixed time
+        return;
+    }
+    QVector<int> profiles;
+    int step = (indexTo >= indexFrom) ? 1 : -1;
+    for (int i = indexFrom; i != indexTo + step; i += step) profiles.append(i);
+    freqSweepUIUpdate(true);
+    updateStatus(QString("Frequency Sweep: %1 rates...").arg(profiles.size()));
+    emit FreqSweepStart(profiles,
+                        bertChannel->getPG()->getPGPatternIndex(),
+                        bertChannel->getED()->getEDPatternIndex(),
+                        FREQ_SWEEP_TIME_LOOKUP[timeIndex],
+                        0.0,                                     // targetBER: Unused for fixed time measurements
+                        0.0);                                    // confidence: Fixed time
+}
+
+
 void BertWindow::frequencyProfileChanged(int index)
 {
     lampLMXLockMaster->setState(BertUILamp::ERR);
@@ -1455,6 +1622,8 @@ void BertWindow::edSetUpAndStart(bool start)
                               edChB->getEDPatternIndex(),   // ED Pattern Lanes 2/3
                               edChB->getEDPatternInvert(),  // ED pattern inverted Lanes 2/3
                               enableB);                     // ED Enabled Lanes 2/3
+            // Report the bus time used to read the counts (see CommsCostEstimated):
+            if (enableA || enableB) emit CommsCostEstimate(metaLane, (enableA ? 1 : 0) + (enableB ? 1 : 0));
         }
         else
         {
@@ -1515,6 +1684,12 @@ void BertWindow::errorInject(const uint8_t channel)
 void BertWindow::EyeScanProgressUpdate(int lane, int type, int progressPercent)
 {
     uint8_t eyeScanChannel = (lane + 1) / 2;
+    if (type == GT1724::GT1724_CONTOUR_SCAN)
+    {
+        // Contour scans are not repeated: Progress is for this channel only.
+        updateStatus( QString("Eye Contour Channel %1: %2 %").arg(eyeScanChannel).arg(progressPercent,3,10,QChar(' ')) );
+        return;
+    }
 
     // Calculate the TOTAL percentage completed, which is the percentage through
     // the current repeat, PLUS the repeats already done:
@@ -1551,8 +1726,30 @@ void BertWindow::EyeScanProgressUpdate(int lane, int type, int progressPercent)
 
 void BertWindow::EyeScanError(int lane, int type, int code)
 {
-    // Make sure ALL pending scans are cancelled:
+    if (type == GT1724::GT1724_DRIFT_MONITOR)
+    {
+        // Drift monitor runs in the background: Don't cancel other scans.
+        qDebug() << "Eye Drift Monitor ERROR: Lane :" << lane << "; Code: " << code;
+        updateStatus(QString("Eye Drift Monitor stopped on Channel %1: Error %2")
+                     .arg(BertChannel::laneToChannel(lane))
+                     .arg(code));
+        return;
+    }
+    if (code == globals::BUSY_ERROR)
+    {
+        // Refused because another scan was running on the lane: Leave that scan alone.
+        qDebug() << "Eye Scan BUSY: Scan type: " << type << "; Lane :" << lane;
+        updateStatus("Eye Scanner busy: Wait for the current scan to finish.");
+        // Contour and multi-row bathtub scans run on all channels together: Wait for the others.
+        if (type == GT1724::GT1724_CONTOUR_SCAN && eyeContourPending > 0 && --eyeContourPending > 0) return;
+        if (type == GT1724::GT1724_BATHTUB_SCAN && bathtubOffsetsPending > 0 && --bathtubOffsetsPending > 0) return;
+        if (type == GT1724::GT1724_EYE_SCAN || type == GT1724::GT1724_CONTOUR_SCAN) eyeScanUIUpdate(false);
+        if (type == GT1724::GT1724_BATHTUB_SCAN) bathtubUIUpdate(false);
+        return;
+    }
+    // Make sure ALL pending scans are cancelled, and drop any frames not yet shown:
     emit EyeScanCancel(globals::ALL_LANES);
+    EyeFrameMailbox::clear(globals::ALL_LANES);
     if (code == globals::CANCELLED)
     {
         // Scan cancelled!
@@ -1564,28 +1761,38 @@ void BertWindow::EyeScanError(int lane, int type, int code)
         qDebug() << "Eye scan ERROR: Scan type: " << type << "; Lane :" << lane << "; Code: " << code;
         updateStatus(QString("Error running Eye Scan: %1").arg(code));
     }
+    eyeContourPending = 0;
+    bathtubOffsetsPending = 0;
     eyeScanUIUpdate(false);
     bathtubUIUpdate(false);
 }
 
 
-void BertWindow::EyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes)
+void BertWindow::EyeScanFinished(int lane, int type)
 {
+    // Take the latest frame for this lane (shared with the worker; not copied).
+    // Only one notification is pending per lane, so this is the newest frame;
+    // may be null if the frame was discarded (e.g. scan cancelled).
+    const EyeFrame frame = EyeFrameMailbox::collect(lane);
     if (!eyeScanRunning && !bathtubRunning) return;  // Late arrival of update AFTER scan cancel?
 
     // Plot the results of this scan: Depends whether it is an eye diagram or a bathtub plot.
     int eyeScanChannel = BertChannel::laneToChannel(lane);
     eyeScansDone++;  // Finished one CHANNEL scan (may not be full repeat as there may be other channels to do yet).
 
-    if (type == GT1724::GT1724_EYE_SCAN)
+    if (frame.isNull())
+    {
+        qDebug() << "Eye scan frame for lane " << lane << " discarded; skipping plot.";
+    }
+    else if (type == GT1724::GT1724_EYE_SCAN)
     {
         ///////// EYE DIAGRAM: //////////////////////////////////////////
-        getChannel(eyeScanChannel)->getEyescan()->plotShowData(data, xRes, yRes);
+        getChannel(eyeScanChannel)->getEyescan()->plotShowData(frame.data(), frame.xRes(), frame.yRes());
     }
     else
     {
         //////// BATHTUB PLOT: //////////////////////////////////////
-        getChannel(eyeScanChannel)->getBathtub()->plotShowData(data);
+        getChannel(eyeScanChannel)->getBathtub()->plotShowData(frame.data());
     }
 
     // Are there any more lanes to scan during THIS repeat cycle?
@@ -1597,8 +1804,13 @@ void BertWindow::EyeScanFinished(int lane, int type, QVector<double> data, int x
         // No more channels to scan in THIS repeat.
         eyeScanRepeatsDone++;
         qDebug() << "Finished all scans for this repeat. Repeats Done: " << eyeScanRepeatsDone;
-        if (eyeScanRepeatsTotal < 0 ||                    // -1 means repeat forever.
-            eyeScanRepeatsDone < eyeScanRepeatsTotal)     // Repeat until we have done the requested number
+        // Stop early if all channels are done (bathtub fit converged, or auto-stop):
+        bool allChannelsDone = (eyeScanChannelDone.size() == eyeScanChannelCount) &&
+                               !eyeScanChannelDone.values().contains(false);
+        if (allChannelsDone) qDebug() << "No more repeats needed on any channel.";
+        if (!allChannelsDone &&
+            (eyeScanRepeatsTotal < 0 ||                   // -1 means repeat forever.
+             eyeScanRepeatsDone < eyeScanRepeatsTotal))   // Repeat until we have done the requested number
         {
             scanStarted = eyeScanStart(type, 1);  // Start again from first enabled channel
         }
@@ -1608,12 +1820,358 @@ void BertWindow::EyeScanFinished(int lane, int type, QVector<double> data, int x
     {
         qDebug() << "Finished all scans.";
         updateStatus("Eye Scan Finished.");
+        EyeFrameMailbox::clear(globals::ALL_LANES);
         if (type == GT1724::GT1724_EYE_SCAN) eyeScanUIUpdate(false);
         else                                 bathtubUIUpdate(false);
     }
 }
 
 
+/*!
+ \brief Eye Contour Finished slot
+ \param lane           ED lane which was scanned
+ \param contourPhase   Phase of each contour point (0 - 127; may be higher if eye wraps)
+ \param contourOffset  Voltage offset of each contour point (1 - 127)
+ \param eyeWidth       Width of eye at centre, in phase steps (128 steps = 1 UI)
+ \param eyeHeight      Height of eye, in offset steps
+*/
+void BertWindow::EyeContourFinished(int lane, QVector<double> contourPhase, QVector<double> contourOffset, double eyeWidth, double eyeHeight)
+{
+    Q_UNUSED(contourOffset)
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    qDebug() << "Eye Contour finished: Lane " << lane << "; " << contourPhase.size() << " points; Width: "
+             << eyeWidth << "; Height: " << eyeHeight;
+    updateStatus( QString("Eye Contour Channel %1: Width %2 UI; Height %3 steps")
+                  .arg(eyeScanChannel)
+                  .arg(eyeWidth / 128.0, 0, 'f', 3)
+                  .arg(eyeHeight, 0, 'f', 0) );
+    if (eyeContourPending <= 0) return;  // Late arrival after cancel?
+    if (--eyeContourPending > 0) return;  // Other channels still scanning
+    eyeScanUIUpdate(false);
+}
+
+
+void BertWindow::EyeMaskTestFinished(int lane, bool pass, int hitCount, double margin, double bitsTested)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    qDebug() << "Eye Mask Test finished: Lane " << lane << "; " << (pass ? "PASS" : "FAIL")
+             << "; Hits: " << hitCount << "; Margin: " << margin << "; Bits: " << bitsTested;
+    updateStatus( QString("Eye Mask Test Channel %1: %2 (%3 hits; margin %4 steps; %5 bits per point)")
+                  .arg(eyeScanChannel)
+                  .arg(pass ? "PASS" : "FAIL")
+                  .arg(hitCount)
+                  .arg(margin, 0, 'f', 0)
+                  .arg(bitsTested, 0, 'g', 3) );
+}
+
+
+void BertWindow::EyeROIScanFinished(int lane, QVector<double> data, int xRes, int yRes, int phaseStart, int phaseStep, int offsetStart, int offsetStep, int phaseShift)
+{
+    Q_UNUSED(data)
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    qDebug() << "Eye ROI Scan finished: Lane " << lane << "; " << xRes << " x " << yRes
+             << " points from phase " << phaseStart << " (step " << phaseStep << ", plot shift " << phaseShift
+             << "), offset " << offsetStart << " (step " << offsetStep << ")";
+    updateStatus( QString("Eye ROI Scan Channel %1: %2 x %3 points").arg(eyeScanChannel).arg(xRes).arg(yRes) );
+}
+
+
+/*!
+ \brief Eye Bathtubs Finished slot (multi-row bathtub scan)
+ The bathtub plot shows the worst case (highest BER) at each phase over all
+ of the offsets. Each curve is also shown as one row of the channel's eye
+ plot, lowest offset at the bottom, with points below the detection limit
+ set to the lowest BER measured.
+ \param curves  One curve (xRes points, log10 BER) per offset, in the order of vOffsets
+*/
+void BertWindow::EyeBathtubsFinished(int lane, QVector<int> vOffsets, QVector<double> curves, int xRes)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    const int nCurves = vOffsets.size();
+    qDebug() << "Bathtub Scan finished: Lane " << lane << "; " << nCurves << " curve(s) of " << xRes << " points";
+    BertChannel *bertChannel = getChannel(eyeScanChannel);
+    if (bertChannel && xRes > 0 && nCurves > 0 && curves.size() == (xRes * nCurves))
+    {
+        int i, x;
+        QVector<double> envelope = curves.mid(0, xRes);
+        double floorValue = 0.0;
+        for (i = 0; i < curves.size(); i++)
+        {
+            x = i % xRes;
+            if (curves[i] > envelope[x]) envelope[x] = curves[i];
+            if (curves[i] != globals::BELOW_DETECTION_LIMIT && curves[i] < floorValue) floorValue = curves[i];
+        }
+        bertChannel->getBathtub()->plotShowData(envelope);
+        if (nCurves > 1)
+        {
+            QMap<int, int> curveIndexes;  // Curve index for each offset (sorted by offset)
+            for (i = 0; i < nCurves; i++) curveIndexes.insert(vOffsets[i], i);
+            QVector<double> rows;
+            foreach (int curveIndex, curveIndexes)
+            {
+                for (x = 0; x < xRes; x++)
+                {
+                    const double value = curves[(curveIndex * xRes) + x];
+                    rows.append((value == globals::BELOW_DETECTION_LIMIT) ? floorValue : value);
+                }
+            }
+            bertChannel->getEyescan()->plotShowData(rows, xRes, curveIndexes.size());
+        }
+    }
+    updateStatus( QString("Bathtub Scan Channel %1: %2 curve(s)").arg(eyeScanChannel).arg(nCurves) );
+    if (bathtubOffsetsPending <= 0) return;  // Late arrival after cancel?
+    eyeScansDone++;
+    if (--bathtubOffsetsPending > 0) return;  // Other channels still scanning
+    bathtubUIUpdate(false);
+}
+
+
+void BertWindow::EyeBathtubFitFinished(int lane, QVector<double> targetBERs, QVector<double> openings, double rjRMS, double djDualDirac, double rSquared, bool valid, bool converged)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    eyeScanChannelDone[eyeScanChannel] = converged;
+    if (!valid)
+    {
+        qDebug() << "Bathtub Fit: Lane " << lane << ": Not enough data on the bathtub tails to fit yet.";
+        return;
+    }
+    QString openingText;
+    for (int i = 0; i < targetBERs.size() && i < openings.size(); i++)
+    {
+        openingText += QString(" %1 UI @ %2;").arg(openings[i], 0, 'f', 3).arg(targetBERs[i], 0, 'e', 0);
+    }
+    qDebug() << "Bathtub Fit: Lane " << lane << ": RJ " << rjRMS << " UI; DJ " << djDualDirac
+             << " UI; R^2 " << rSquared << "; Converged: " << converged;
+    updateStatus( QString("Bathtub Fit Channel %1: RJ %2 UI; DJ %3 UI; Opening%4")
+                  .arg(eyeScanChannel)
+                  .arg(rjRMS, 0, 'f', 4)
+                  .arg(djDualDirac, 0, 'f', 3)
+                  .arg(openingText) );
+}
+
+
+void BertWindow::EyeScanAutoStop(int lane, int type, bool stop, double floorBER, double confidence)
+{
+    Q_UNUSED(type)
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    // Nb: A converged bathtub fit (sent before this) also counts as done:
+    eyeScanChannelDone[eyeScanChannel] = eyeScanChannelDone.value(eyeScanChannel, false) || stop;
+    qDebug() << "Eye Scan Auto-Stop: Lane " << lane << "; Floor: " << floorBER
+             << "; Resolved: " << confidence << "; Stop: " << stop;
+    if (stop) updateStatus( QString("Eye Scan Channel %1: Auto-stop (floor %2; %3% of points resolved)")
+                            .arg(eyeScanChannel)
+                            .arg(floorBER, 0, 'e', 1)
+                            .arg(confidence * 100.0, 0, 'f', 0) );
+}
+
+
+void BertWindow::EyeMetricsFinished(int lane, QVector<double> metrics, QVector<double> contourPoints, QVector<int> contourSizes)
+{
+    Q_UNUSED(contourPoints)
+    Q_UNUSED(contourSizes)
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    const int n = GT1724::EYE_METRICS_VALUES;
+    for (int i = 0; (i + n) <= metrics.size(); i += n)
+    {
+        qDebug() << "Eye Metrics: Channel " << eyeScanChannel << " @ BER " << metrics[i]
+                 << ": Width " << metrics[i + 1] << " UI; Height " << metrics[i + 2]
+                 << " steps; Area " << metrics[i + 3] << "; Centre " << metrics[i + 4] << ", " << metrics[i + 5]
+                 << "; Crossing " << metrics[i + 6] << "; Contours " << metrics[i + 7];
+    }
+}
+
+
+void BertWindow::EyeArchiveSaved(int lane, QString fileName, int result)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    qDebug() << "Eye Archive Saved: Channel " << eyeScanChannel << "; File: " << fileName << "; Result: " << result;
+    if (result == globals::OK) updateStatus(QString("Eye Scan Channel %1 saved to %2").arg(eyeScanChannel).arg(fileName));
+    else                       updateStatus(QString("Error saving Eye Scan Channel %1: %2").arg(eyeScanChannel).arg(result));
+}
+
+
+/*!
+ \brief Eye Archive Compare Finished slot
+ Replaces the plot for the channel with the difference from the golden scan:
+ Points which are EYE_GOLDEN_PLOT_RANGE decades worse (higher BER) show at the
+ top of the colour scale, unchanged points in the middle, and better points
+ at the bottom.
+ \param delta  Difference from golden scan at each point (decades of BER; xRes * yRes, row by row)
+*/
+void BertWindow::EyeArchiveCompareFinished(int lane, int result, QVector<double> delta, int xRes, int yRes, double maxDelta, double rmsDelta, int cellsWorse, int cellsBetter)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    qDebug() << "Eye Golden Compare: Channel " << eyeScanChannel << "; Result: " << result
+             << "; Size: " << xRes << " x " << yRes << "; Max Delta: " << maxDelta << "; RMS Delta: " << rmsDelta
+             << "; Worse: " << cellsWorse << "; Better: " << cellsBetter;
+    if (result != globals::OK)
+    {
+        updateStatus(QString("Error comparing Eye Scan Channel %1 with golden scan: %2").arg(eyeScanChannel).arg(result));
+        return;
+    }
+    // Map the difference onto the log10(BER) scale used by the plots (-2 * range to 0):
+    QVector<double> deltaPlot(delta.size());
+    for (int i = 0; i < delta.size(); i++)
+    {
+        deltaPlot[i] = qBound(-2.0 * EYE_GOLDEN_PLOT_RANGE, delta[i] - EYE_GOLDEN_PLOT_RANGE, 0.0);
+    }
+    BertChannel *bertChannel = getChannel(eyeScanChannel);
+    if (bertChannel && deltaPlot.size() == (xRes * yRes))
+    {
+        if (yRes > 1) bertChannel->getEyescan()->plotShowData(deltaPlot, xRes, yRes);
+        else          bertChannel->getBathtub()->plotShowData(deltaPlot);
+    }
+    updateStatus( QString("Eye Scan Channel %1 vs golden: %2 points worse, %3 better (RMS %4 decades)")
+                  .arg(eyeScanChannel)
+                  .arg(cellsWorse)
+                  .arg(cellsBetter)
+                  .arg(rmsDelta, 0, 'f', 2) );
+}
+
+
+/*!
+ \brief Eye Scan Estimated slot (see ScanPlanner)
+ \param seconds        Estimated time for all repeats on all channels
+ \param repeatSeconds  Estimated time for one repeat on all channels
+*/
+void BertWindow::EyeScanEstimated(int lane, int type, double seconds, double repeatSeconds, int parts, int bytesRead, int read24Frames)
+{
+    qDebug() << "Eye Scan Estimate: Lane " << lane << "; Type: " << type << "; Total: " << seconds
+             << " s; Per repeat: " << repeatSeconds << " s; Parts: " << parts
+             << "; Bytes: " << bytesRead << "; Read frames: " << read24Frames;
+    QString scanName = (type == GT1724::GT1724_EYE_SCAN) ? "Eye Scan" : "Bathtub Scan";
+    if (eyeScanRepeatsTotal < 0) updateStatus(QString("%1: Estimated %2 s per repeat").arg(scanName).arg(repeatSeconds, 0, 'f', 1));
+    else                         updateStatus(QString("%1: Estimated time %2 s").arg(scanName).arg(seconds, 0, 'f', 1));
+}
+
+
+/*!
+ \brief Eye Scan Planned slot (see ScanPlanner)
+ Selects the planned settings in the eye scan / bathtub options. The
+ repeat count is rounded down to the nearest item in the repeats list.
+*/
+void BertWindow::EyeScanPlanned(int lane, int type, int result, int hStep, int vStep, int countRes, int repeatCount, double seconds)
+{
+    qDebug() << "Eye Scan Plan: Lane " << lane << "; Type: " << type << "; Result: " << result
+             << "; H Step: " << hStep << "; V Step: " << vStep << "; Count Res: " << countRes
+             << "; Repeats: " << repeatCount << "; Estimated time: " << seconds << " s";
+    if (result != globals::OK)
+    {
+        updateStatus(QString("Scan time too short: Quickest scan takes %1 s").arg(seconds, 0, 'f', 1));
+        return;
+    }
+    int repeatsIndex = 0;
+    for (int i = 0; i < EYESCAN_REPEATS_LOOKUP.size(); i++)
+    {
+        if (EYESCAN_REPEATS_LOOKUP[i] > 0 && EYESCAN_REPEATS_LOOKUP[i] <= repeatCount) repeatsIndex = i;
+    }
+    if (type == GT1724::GT1724_EYE_SCAN)
+    {
+        listEyeScanHStep->setCurrentIndex(hStep);
+        listEyeScanVStep->setCurrentIndex(vStep);
+        listEyeScanCountRes->setCurrentIndex(countRes);
+        listEyeScanRepeats->setCurrentIndex(repeatsIndex);
+    }
+    else
+    {
+        listBathtubHStep->setCurrentIndex(hStep);
+        listBathtubCountRes->setCurrentIndex(countRes);
+        listBathtubRepeats->setCurrentIndex(repeatsIndex);
+    }
+    updateStatus(QString("Scan settings selected: Estimated time %1 s").arg(seconds, 0, 'f', 1));
+}
+
+
+/*!
+ \brief Comms Cost Estimated slot (see ScanPlanner)
+ Requested when the error detector is started (see edSetUpAndStart).
+*/
+void BertWindow::CommsCostEstimated(int metaLane, double opLatencyMs, double edPollSeconds, double warmInitSeconds, double coldInitSeconds)
+{
+    qDebug() << "Comms Cost Estimate: Lane " << metaLane << "; I2C op: " << opLatencyMs
+             << " ms; ED poll: " << edPollSeconds << " s; Init (warm): " << warmInitSeconds
+             << " s; Init (cold): " << coldInitSeconds << " s";
+    updateStatus( QString("Core %1: Reading ED counts takes %2 ms (I2C op %3 ms); Re-Sync takes %4 s")
+                  .arg(1 + (metaLane / 4))
+                  .arg(edPollSeconds * 1000.0, 0, 'f', 0)
+                  .arg(opLatencyMs, 0, 'f', 1)
+                  .arg(warmInitSeconds, 0, 'f', 1) );
+}
+
+
+/*!
+ \brief Eye Drift Baseline slot (see EyeMonitor::driftStart)
+ \param baseline  Baseline value of each drift metric (UI)
+ \param stdDevs   Standard deviation of each metric over the baseline snapshots (UI)
+*/
+void BertWindow::EyeDriftBaseline(int lane, QVector<double> baseline, QVector<double> stdDevs)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    qDebug() << "Eye Drift Baseline: Channel " << eyeScanChannel << "; Metrics: " << baseline << "; Std Dev: " << stdDevs;
+    if (!baseline.isEmpty()) updateStatus( QString("Eye Drift Monitor Channel %1: Baseline opening %2 UI")
+                                           .arg(eyeScanChannel)
+                                           .arg(baseline.last(), 0, 'f', 3) );
+}
+
+
+/*!
+ \brief Eye Drift Alarm slot (see EyeMonitor::driftEvaluate)
+ \param metrics   Indexes of the metrics which have shrunk
+ \param baseline  Baseline value of each of these metrics (UI)
+ \param current   Current (smoothed) value of each of these metrics (UI)
+*/
+void BertWindow::EyeDriftAlarm(int lane, QVector<int> metrics, QVector<double> baseline, QVector<double> current)
+{
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    QString changeText;
+    for (int i = 0; i < metrics.size() && i < baseline.size() && i < current.size(); i++)
+    {
+        changeText += QString(" #%1 %2 -> %3 UI;").arg(metrics[i]).arg(baseline[i], 0, 'f', 3).arg(current[i], 0, 'f', 3);
+    }
+    qDebug() << "Eye Drift ALARM: Channel " << eyeScanChannel << ":" << changeText;
+    updateStatus(QString("Eye Drift Monitor Channel %1: Eye closing:%2").arg(eyeScanChannel).arg(changeText));
+}
+
+
+/*!
+ \brief Frequency Sweep Result slot (see FrequencySweep)
+ One row per rate. For each ED lane: relockMs is -1 if the lane didn't lock.
+*/
+void BertWindow::FreqSweepResult(int step, int profileIndex, double frequency, int lockTimeMs,
+                                 QVector<int> lanes, QVector<int> relockMs, QVector<double> bits, QVector<double> errors)
+{
+    QString laneText;
+    for (int i = 0; i < lanes.size() && i < relockMs.size() && i < bits.size() && i < errors.size(); i++)
+    {
+        int channel = BertChannel::laneToChannel(lanes[i]);
+        if (relockMs[i] < 0)
+        {
+            laneText += QString(" CH%1 No lock;").arg(channel);
+            continue;
+        }
+        double ber = (bits[i] > 0.0) ? (errors[i] / bits[i]) : 0.0;
+        laneText += QString(" CH%1 BER %2 (%3 ms);").arg(channel).arg(ber, 0, 'e', 2).arg(relockMs[i]);
+    }
+    qDebug() << "Frequency Sweep: Step " << step << "; Profile " << profileIndex << "; " << frequency
+             << " MHz; LMX lock " << lockTimeMs << " ms;" << laneText;
+    updateStatus(QString("Frequency Sweep %1 MHz:%2").arg(frequency, 0, 'f', 3).arg(laneText));
+}
+
+
+/*!
+ \brief Frequency Sweep Finished slot
+ \param result  globals::OK, globals::CANCELLED, or error code
+ \param steps   Number of rates measured
+*/
+void BertWindow::FreqSweepFinished(int result, int steps)
+{
+    qDebug() << "Frequency Sweep finished: " << steps << " steps; Result " << result;
+    freqSweepUIUpdate(false);
+    if (result == globals::OK) updateStatus(QString("Frequency Sweep finished (%1 rates).").arg(steps));
+    else                       updateStatus(QString("Frequency Sweep stopped after %1 rates (%2).").arg(steps).arg(result));
+}
+
+
 
 
 /*!
@@ -1631,6 +2189,12 @@ void BertWindow::eyeScanUIUpdate(bool isRunning)
     listEyeScanHStep->setEnabled(!isRunning);
     listEyeScanCountRes->setEnabled(!isRunning);
     listEyeScanRepeats->setEnabled(!isRunning);
+    listEyeScanPlanTime->setEnabled(!isRunning);
+    buttonEyeScanPlan->setEnabled(!isRunning);
+    checkEyeScanAutoStop->setEnabled(!isRunning);
+    buttonEyeContour->setEnabled(!isRunning);
+    buttonEyeGoldenSave->setEnabled(!isRunning);
+    buttonEyeGoldenCompare->setEnabled(!isRunning);
     checkESEnableAll->setEnabled(!isRunning);
     paneESCheckBoxes->setEnabled(!isRunning);
 }
@@ -1661,6 +2225,8 @@ bool BertWindow::eyeScanStart(int type, int firstChannel)
         if (channelChecked)
         {
             int lane = bertChannel->getEDLane();
+            // Skip channels which need no more repeats (frees up the bus for other channels):
+            if (bertChannel->eyeScanStartedFlag && eyeScanChannelDone.value(bertChannel->getChannel(), false)) continue;
             if (bertChannel->eyeScanStartedFlag)
             {
                 // Already started eye scans on this channel. Request a repeat:
@@ -1682,7 +2248,7 @@ bool BertWindow::eyeScanStart(int type, int firstChannel)
                 {
                     emit EyeScanStart(lane,
                                       GT1724::GT1724_BATHTUB_SCAN,
-                                      0,                                     //  hStep: We always use 1 for Bathtub Plot (no point doing low res scan!)
+                                      listBathtubHStep->currentIndex(),      //  hStep
                                       0,                                     //  vStep: Unused for Bathtub Plot
                                       listBathtubVOffset->currentIndex(),    //  vOffset
                                       listBathtubCountRes->currentIndex());  // countRes
@@ -1697,6 +2263,41 @@ bool BertWindow::eyeScanStart(int type, int firstChannel)
 }
 
 
+/*!
+ \brief Start a contour scan on every enabled eye scan channel
+ Uses the horizontal step and resolution from the eye scan options. The
+ scans run together (see EyeMonitor::startContourScan).
+ \return Number of channels started
+*/
+int BertWindow::eyeContourStart()
+{
+    int started = 0;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getEyeScanChannelEnabled()) continue;
+        emit EyeContourStart(bertChannel->getEDLane(),
+                             listEyeScanHStep->currentIndex(),
+                             listEyeScanCountRes->currentIndex(),
+                             EYE_CONTOUR_TARGET_BER,
+                             EYE_CONTOUR_REPEATS);
+        started++;
+    }
+    return started;
+}
+
+
+void BertWindow::on_buttonEyeContour_clicked()
+{
+    eyeScanUIUpdate(true);
+    eyeContourPending = eyeContourStart();
+    if (eyeContourPending == 0)
+    {
+        updateStatus(QString("No channels selected for eye contour scan."));
+        eyeScanUIUpdate(false);
+    }
+}
+
+
 void BertWindow::on_checkESEnableAll_clicked(bool checked)
 {
     foreach (BertChannel *bertChannel, bertChannels)
@@ -1712,6 +2313,7 @@ void BertWindow::on_buttonEyeScanStart_clicked()
     bool scanStarted = false;
     eyeScanRepeatsTotal = EYESCAN_REPEATS_LOOKUP[listEyeScanRepeats->currentIndex()];
     eyeScanRepeatsDone = 0;
+    eyeScanChannelDone.clear();
     eyeScanChannelCount = 0;
 
     qDebug() << "Eye Scan Start Clicked: Running eye scan with " << eyeScanRepeatsTotal << " repeats.";
@@ -1734,13 +2336,102 @@ void BertWindow::on_buttonEyeScanStart_clicked()
     }
     else
     {
-        // At least one channel selected! Start scans.
+        // At least one channel selected! Estimate the time, then start scans:
+        eyeScanAutoStopSet(checkEyeScanAutoStop->isChecked());
+        eyeScanEstimate(GT1724::GT1724_EYE_SCAN, eyeScanChannelCount);
         scanStarted = eyeScanStart(GT1724::GT1724_EYE_SCAN, 1);  // Start from first enabled channel
     }
     if (!scanStarted) eyeScanUIUpdate(false);  // No channels to scan...
 }
 
 
+/*!
+ \brief Request an estimate of the scan time (see EyeScanEstimated)
+ Uses the current scan settings and the first enabled channel.
+ \param type           GT1724_EYE_SCAN or GT1724_BATHTUB_SCAN
+ \param channelCount   Number of channels which will be scanned
+*/
+void BertWindow::eyeScanEstimate(int type, int channelCount)
+{
+    int repeatCount = (eyeScanRepeatsTotal > 0) ? eyeScanRepeatsTotal : 1;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        bool channelChecked;
+        if (type == GT1724::GT1724_EYE_SCAN) channelChecked = bertChannel->getEyeScanChannelEnabled();
+        else                                 channelChecked = bertChannel->getBathtubChannelEnabled();
+        if (!channelChecked) continue;
+        if (type == GT1724::GT1724_EYE_SCAN)
+        {
+            emit EyeScanEstimate(bertChannel->getEDLane(),
+                                 type,
+                                 listEyeScanHStep->currentIndex(),
+                                 listEyeScanVStep->currentIndex(),
+                                 listEyeScanCountRes->currentIndex(),
+                                 repeatCount,
+                                 channelCount);
+        }
+        else
+        {
+            emit EyeScanEstimate(bertChannel->getEDLane(),
+                                 type,
+                                 listBathtubHStep->currentIndex(),
+                                 0,
+                                 listBathtubCountRes->currentIndex(),
+                                 repeatCount,
+                                 channelCount);
+        }
+        return;
+    }
+}
+
+
+/*!
+ \brief Enable or disable auto-stop for repeated scans (see EyeScanAutoStop)
+ When enabled, a channel gets no more repeats once its eye metrics are stable.
+ Set on all lanes before each eye scan or bathtub run.
+*/
+void BertWindow::eyeScanAutoStopSet(bool enabled)
+{
+    emit EyeScanAutoStopOptions(globals::ALL_LANES,
+                                enabled,
+                                EYE_AUTOSTOP_TOLERANCE,
+                                0.0,                       // No floor target: Stop on stable metrics only
+                                EYE_AUTOSTOP_METRIC_BER);
+}
+
+
+/*!
+ \brief Choose scan settings to fit the selected time limit (see EyeScanPlanned)
+ The time limit covers all repeats on all enabled channels. Uses the
+ timings measured on the first enabled channel.
+ \param type  GT1724_EYE_SCAN or GT1724_BATHTUB_SCAN
+*/
+void BertWindow::eyeScanPlan(int type)
+{
+    int channelCount = 0;
+    int lane = -1;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        bool channelChecked;
+        if (type == GT1724::GT1724_EYE_SCAN) channelChecked = bertChannel->getEyeScanChannelEnabled();
+        else                                 channelChecked = bertChannel->getBathtubChannelEnabled();
+        if (!channelChecked) continue;
+        if (lane < 0) lane = bertChannel->getEDLane();
+        channelCount++;
+    }
+    if (channelCount == 0)
+    {
+        updateStatus(QString("No channels selected for scan."));
+        return;
+    }
+    int timeIndex;
+    if (type == GT1724::GT1724_EYE_SCAN) timeIndex = listEyeScanPlanTime->currentIndex();
+    else                                 timeIndex = listBathtubPlanTime->currentIndex();
+    if (timeIndex < 0 || timeIndex >= EYESCAN_PLAN_TIME_LOOKUP.size()) return;
+    emit EyeScanPlan(lane, type, EYESCAN_PLAN_TIME_LOOKUP[timeIndex], channelCount);
+}
+
+
 void BertWindow::on_buttonEyeScanStop_clicked()
 {
     emit EyeScanCancel(globals::ALL_LANES);
@@ -1748,6 +2439,106 @@ void BertWindow::on_buttonEyeScanStop_clicked()
 }
 
 
+/*!
+ \brief Golden eye file for a channel (see EyeArchive)
+ Kept in the application folder, one per instrument and channel.
+*/
+QString BertWindow::eyeGoldenFileName(int channel)
+{
+    QString serialClean;
+    foreach (QChar qCh, instrumentSerial)
+    {
+        serialClean.append((qCh.isLetterOrNumber() || qCh == '-') ? qCh : QChar('_'));  // Safe for file name
+    }
+    if (serialClean.isEmpty()) serialClean = QString("unknown");
+    return QString("%1\\golden_%2_ch%3.eye").arg(globals::getAppPath()).arg(serialClean).arg(channel);
+}
+
+
+/*!
+ \brief Save the last scan on each selected channel as the golden scan
+*/
+void BertWindow::on_buttonEyeGoldenSave_clicked()
+{
+    int channelCount = 0;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getEyeScanChannelEnabled()) continue;
+        emit EyeArchiveSave(bertChannel->getEDLane(), eyeGoldenFileName(bertChannel->getChannel()), instrumentSerial);
+        channelCount++;
+    }
+    if (channelCount == 0) updateStatus(QString("No channels selected for eye scan."));
+}
+
+
+/*!
+ \brief Compare the last scan on each selected channel with its golden scan
+ Results are plotted in EyeArchiveCompareFinished.
+*/
+void BertWindow::on_buttonEyeGoldenCompare_clicked()
+{
+    int channelCount = 0;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getEyeScanChannelEnabled()) continue;
+        emit EyeArchiveCompare(bertChannel->getEDLane(), eyeGoldenFileName(bertChannel->getChannel()), EYE_GOLDEN_TOLERANCE);
+        channelCount++;
+    }
+    if (channelCount == 0) updateStatus(QString("No channels selected for eye scan."));
+}
+
+
+/*!
+ \brief Eye Drift Monitor UI Config
+ \param isRunning
+*/
+void BertWindow::eyeDriftUIUpdate(bool isRunning)
+{
+    eyeDriftRunning = isRunning;
+    buttonEyeDrift->setText(isRunning ? "Stop Drift Mon." : "Drift Monitor");
+}
+
+
+/*!
+ \brief Start / stop the eye drift monitor (see EyeMonitor::driftStart)
+ The monitor runs in the background on the channels selected for eye
+ scan, using the horizontal step and resolution from the eye scan
+ options. Snapshots wait while other scans run.
+*/
+void BertWindow::on_buttonEyeDrift_clicked()
+{
+    if (eyeDriftRunning)
+    {
+        emit EyeDriftStop(globals::ALL_LANES);
+        eyeDriftUIUpdate(false);
+        updateStatus("Eye Drift Monitor stopped.");
+        return;
+    }
+    int channelCount = 0;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (bertChannel->getEyeScanChannelEnabled()) channelCount++;
+    }
+    if (channelCount == 0)
+    {
+        updateStatus(QString("No channels selected for eye drift monitor."));
+        return;
+    }
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getEyeScanChannelEnabled()) continue;
+        emit EyeDriftStart(bertChannel->getEDLane(),
+                           listEyeScanHStep->currentIndex(),
+                           listEyeScanCountRes->currentIndex(),
+                           EYE_DRIFT_TARGET_BER,
+                           EYE_DRIFT_THRESHOLD,
+                           EYE_DRIFT_DUTY_CYCLE / static_cast<double>(channelCount));
+    }
+    eyeDriftUIUpdate(true);
+    updateStatus(QString("Eye Drift Monitor started on %1 channel(s): Measuring baseline...").arg(channelCount));
+}
+
+
 
 
 
@@ -1767,8 +2558,13 @@ void BertWindow::bathtubUIUpdate(bool isRunning)
     buttonBathtubStart->setEnabled(!isRunning);
     buttonBathtubStop->setEnabled(isRunning);
     listBathtubVOffset->setEnabled(!isRunning);
+    listBathtubHStep->setEnabled(!isRunning);
     listBathtubCountRes->setEnabled(!isRunning);
     listBathtubRepeats->setEnabled(!isRunning);
+    listBathtubPlanTime->setEnabled(!isRunning);
+    buttonBathtubPlan->setEnabled(!isRunning);
+    checkBathtubAutoStop->setEnabled(!isRunning);
+    buttonBathtubOffsets->setEnabled(!isRunning);
     checkBPEnableAll->setEnabled(!isRunning);
     paneBPCheckBoxes->setEnabled(!isRunning);
 }
@@ -1789,6 +2585,7 @@ void BertWindow::on_buttonBathtubStart_clicked()
     bool scanStarted = false;
     eyeScanRepeatsTotal = EYESCAN_REPEATS_LOOKUP[listBathtubRepeats->currentIndex()];
     eyeScanRepeatsDone = 0;
+    eyeScanChannelDone.clear();
     eyeScanChannelCount = 0;
     qDebug() << "Bathtub Scan Start Clicked: Running eye scan with " << eyeScanRepeatsTotal << " repeats.";
     // Count the number of enabled eyescan channels:
@@ -1810,12 +2607,62 @@ void BertWindow::on_buttonBathtubStart_clicked()
     }
     else
     {
-        // At least one channel selected! Start scans.
+        // At least one channel selected! Estimate the time, then start scans:
+        eyeScanAutoStopSet(checkBathtubAutoStop->isChecked());
+        eyeScanEstimate(GT1724::GT1724_BATHTUB_SCAN, eyeScanChannelCount);
         scanStarted = eyeScanStart(GT1724::GT1724_BATHTUB_SCAN, 1);  // Start from first enabled channel
     }
     if (!scanStarted) bathtubUIUpdate(false);  // No channels to scan...
 }
 
+/*!
+ \brief Start a multi-row bathtub scan on every enabled bathtub channel
+ Scans at every offset in the "Offset" list, using the horizontal step and
+ resolution from the bathtub options. Curves are taken from the last eye
+ scan instead if it covers all of the offsets (see EyeMonitor::startBathtubScan).
+ The scans run together.
+ \return Number of channels started
+*/
+int BertWindow::bathtubOffsetsStart()
+{
+    int started = 0;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getBathtubChannelEnabled()) continue;
+        emit EyeBathtubStart(bertChannel->getEDLane(),
+                             listBathtubHStep->currentIndex(),
+                             GT1724::EYESCAN_VOFF_LOOKUP.toVector(),
+                             listBathtubCountRes->currentIndex(),
+                             true);
+        started++;
+    }
+    return started;
+}
+
+
+void BertWindow::on_buttonBathtubOffsets_clicked()
+{
+    bathtubUIUpdate(true);
+    // Progress is shown as for a single repeat (see EyeScanProgressUpdate):
+    eyeScanRepeatsTotal = 1;
+    eyeScanRepeatsDone = 0;
+    eyeScansTotal = 0;
+    eyeScansDone = 0;
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getBathtubChannelEnabled()) continue;
+        bertChannel->getBathtub()->plotClear();
+        eyeScansTotal++;
+    }
+    bathtubOffsetsPending = bathtubOffsetsStart();
+    if (bathtubOffsetsPending == 0)
+    {
+        updateStatus( QString("No channels selected for bathtub plot scan.") );
+        bathtubUIUpdate(false);
+    }
+}
+
+
 void BertWindow::on_buttonBathtubStop_clicked()
 {
     emit EyeScanCancel(globals::ALL_LANES);
@@ -1891,18 +2738,31 @@ QWidget *BertWindow::makeUI(QWidget *parent)
     vGrid = 35;
     x = 16; y = 30;
     groupClock = new BertUIGroup("groupClock", parent, "Frequency Synthesizer Configuration",                 -1,  0, 0, 600, 0);
-    groupClock->setMinimumHeight(150);
+    groupClock->setMinimumHeight(150 + (6 * vGrid));
     new                          BertUILabel  ("", groupClock, "Synthesizer Frequency:",                      -1,  x, y,        135 );
+    new                          BertUILabel  ("", groupClock, "Set Frequency (MHz):",                        -1,  x, y+=vGrid, 135 );
     new                          BertUILabel  ("", groupClock, "Synthesizer VCO Lock:",                       -1,  x, y+=vGrid, 135 );
     new                          BertUILabel  ("", groupClock, "Trigger Out Divide Ratio:",                   -1,  x, y+=vGrid, 135 );
     new                          BertUILabel  ("", groupClock, "Trigger RF Output Power:",                    -1,  x, y+=vGrid, 135 );
+    new                          BertUILabel  ("", groupClock, "Frequency Sweep From:",                       -1,  x, y+=vGrid, 135 );
+    new                          BertUILabel  ("", groupClock, "Frequency Sweep To:",                         -1,  x, y+=vGrid, 135 );
+    new                          BertUILabel  ("", groupClock, "Sweep Step (MHz):",                           -1,  x, y+=vGrid, 135 );
+    new                          BertUILabel  ("", groupClock, "Sweep Time per Rate:",                        -1,  x, y+=vGrid, 135 );
     x = 166; y = 30;
     listLMXFreq            = new BertUIList   ("listLMXFreq",            groupClock, QStringList(),           -1,  x, y,        201 );
+    inputLMXFreq           = new BertUITextInput ("inputLMXFreq",         groupClock, "",                      -1,  x, y+=vGrid, 91  );
+    buttonLMXFreqSet       = new BertUIButton ("buttonLMXFreqSet",       groupClock, "Set",                   -1,  x+110, y,    91  );
     lampLMXLockMaster      = new BertUILamp   ("", groupClock, "Lock", "No Lock", BertUILamp::OFF,            -1,  x, y+=vGrid, 100 );
     lampLMXLockSlave       = new BertUILamp   ("", groupClock, "Lock", "No Lock", BertUILamp::OFF,            -1,  x+110, y,    100 );
 
     listLMXTrigOutDivRatio = new BertUIList   ("listLMXTrigOutDivRatio", groupClock, QStringList(),           -1,  x, y+=vGrid, 91  );
     listLMXTrigOutPower    = new BertUIList   ("listLMXTrigOutPower",    groupClock, QStringList(),           -1,  x, y+=vGrid, 91  );
+    listFreqSweepFrom      = new BertUIList   ("listFreqSweepFrom",      groupClock, QStringList(),           -1,  x, y+=vGrid, 201 );
+    listFreqSweepTo        = new BertUIList   ("listFreqSweepTo",        groupClock, QStringList(),           -1,  x, y+=vGrid, 201 );
+    inputFreqSweepStep     = new BertUITextInput ("inputFreqSweepStep",   groupClock, "",                      -1,  x, y+=vGrid, 91  );
+    new                          BertUILabel  ("", groupClock, "Blank: Profiles only",                        -1,  x+110, y,    135 );
+    listFreqSweepTime      = new BertUIList   ("listFreqSweepTime",      groupClock, FREQ_SWEEP_TIME_LIST,    -1,  x, y+=vGrid, 91  );
+    buttonFreqSweep        = new BertUIButton ("buttonFreqSweep",        groupClock, "Frequency Sweep",       -1,  x, y+=vGrid, 201 );
 
     layoutClockSynth = new QVBoxLayout(parent);
     layoutClockSynth->addWidget(groupClock);
@@ -1985,11 +2845,20 @@ QWidget *BertWindow::makeUI(QWidget *parent)
     new                        BertUILabel    ("",                      groupEyeScanOpts, "Horiz. Step:",   -1, x, y+=vGrid, 62 );
     new                        BertUILabel    ("",                      groupEyeScanOpts, "Resolution:",    -1, x, y+=vGrid, 62 );
     new                        BertUILabel    ("",                      groupEyeScanOpts, "Repeats:",       -1, x, y+=vGrid, 62 );
+    new                        BertUILabel    ("",                      groupEyeScanOpts, "Time Limit:",    -1, x, y+=vGrid, 62 );
     x = 73; y = 45+(vGrid*3);
     listEyeScanVStep     = new BertUIList     ("listEyeScanVStep",      groupEyeScanOpts, QStringList(),    -1, x, y,        51 );
     listEyeScanHStep     = new BertUIList     ("listEyeScanHStep",      groupEyeScanOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listEyeScanCountRes  = new BertUIList     ("listEyeScanCountRes",   groupEyeScanOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listEyeScanRepeats   = new BertUIList     ("listEyeScanRepeats",    groupEyeScanOpts, EYESCAN_REPEATS_LIST, -1, x, y+=vGrid, 51 );
+    listEyeScanPlanTime  = new BertUIList     ("listEyeScanPlanTime",   groupEyeScanOpts, EYESCAN_PLAN_TIME_LIST, -1, x, y+=vGrid, 51 );
+    x = 10;
+    buttonEyeScanPlan    = new BertUIButton   ("buttonEyeScanPlan",     groupEyeScanOpts, "Fit to Time",    -1, x, y+=vGrid, 111);
+    checkEyeScanAutoStop = new BertUICheckBox ("checkEyeScanAutoStop",  groupEyeScanOpts, "Auto-Stop",      -1, 12, y+=vGrid, 101);
+    buttonEyeContour     = new BertUIButton   ("buttonEyeContour",      groupEyeScanOpts, "Contour Scan",   -1, x, y+=vGrid+10, 111);
+    buttonEyeDrift       = new BertUIButton   ("buttonEyeDrift",        groupEyeScanOpts, "Drift Monitor",  -1, x, y+=vGrid, 111);
+    buttonEyeGoldenSave  = new BertUIButton   ("buttonEyeGoldenSave",   groupEyeScanOpts, "Save as Golden", -1, x, y+=vGrid+10, 111);
+    buttonEyeGoldenCompare = new BertUIButton ("buttonEyeGoldenCompare", groupEyeScanOpts, "Compare Golden", -1, x, y+=vGrid,  111);
     // Channel enable checkboxes:
     checkESEnableAll = new BertUICheckBox ("checkESEnableAll", groupEyeScanOpts, "Scan ALL", -1, 12, y+=vGrid+10, 101    );
     paneESCheckBoxes = new BertUIPane     ("",                 groupEyeScanOpts,             -1, 17, y+=vGrid-4,  110, 0 );
@@ -2025,14 +2894,21 @@ QWidget *BertWindow::makeUI(QWidget *parent)
     buttonBathtubStop->setEnabled(false);
      x = 10; y = 45+(vGrid*3);
     new                        BertUILabel    ("",                      groupBathtubOpts, "Offset:",        -1, x, y,        62 );
+    new                        BertUILabel    ("",                      groupBathtubOpts, "Horiz. Step:",   -1, x, y+=vGrid, 62 );
     new                        BertUILabel    ("",                      groupBathtubOpts, "Resolution:",    -1, x, y+=vGrid, 62 );
     new                        BertUILabel    ("",                      groupBathtubOpts, "Repeats:",       -1, x, y+=vGrid, 62 );
+    new                        BertUILabel    ("",                      groupBathtubOpts, "Time Limit:",    -1, x, y+=vGrid, 62 );
     x = 73; y = 45+(vGrid*3);
     listBathtubVOffset   = new BertUIList     ("listBathtubVOffset",    groupBathtubOpts, QStringList(),    -1, x, y,        51 );
+    listBathtubHStep     = new BertUIList     ("listBathtubHStep",      groupBathtubOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listBathtubCountRes  = new BertUIList     ("listBathtubCountRes",   groupBathtubOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listBathtubRepeats   = new BertUIList     ("listBathtubRepeats",    groupBathtubOpts, EYESCAN_REPEATS_LIST, -1, x, y+=vGrid, 51 );
+    listBathtubPlanTime  = new BertUIList     ("listBathtubPlanTime",   groupBathtubOpts, EYESCAN_PLAN_TIME_LIST, -1, x, y+=vGrid, 51 );
+    x = 10;
+    buttonBathtubPlan    = new BertUIButton   ("buttonBathtubPlan",     groupBathtubOpts, "Fit to Time",    -1, x, y+=vGrid, 111);
+    checkBathtubAutoStop = new BertUICheckBox ("checkBathtubAutoStop",  groupBathtubOpts, "Auto-Stop",      -1, 12, y+=vGrid, 101);
+    buttonBathtubOffsets = new BertUIButton   ("buttonBathtubOffsets",  groupBathtubOpts, "All Offsets",    -1, x, y+=vGrid+10, 111);
     // Channel enable checkboxes:
-    y+=vGrid;
     checkBPEnableAll = new BertUICheckBox ("checkBPEnableAll", groupBathtubOpts, "Scan ALL", -1, 12, y+=vGrid+10, 101    );
     paneBPCheckBoxes = new BertUIPane     ("",                 groupBathtubOpts,             -1, 17, y+=vGrid-4,  110, 0 );
     paneBPCheckBoxes->setMinimumHeight(1);
@@ -45,6 +45,7 @@
 #include "BertWorker.h"
 #include "BertFile.h"
 #include "LMXFrequencyProfile.h"
+#include "EyeFrame.h"
 
 
 
@@ -149,6 +150,8 @@ private slots:
     void on_listLMXFreq_currentIndexChanged(int index)             IF_UI_ENABLED(frequencyProfileChanged(index))
     void on_listLMXTrigOutDivRatio_currentIndexChanged(int index)  UI_EVENT(2000, 1, SelectTriggerDivide(index))
     void on_listLMXTrigOutPower_currentIndexChanged(int index)     UI_EVENT(2000, 1, ConfigureOutputs(-1, index, true))
+    void on_buttonLMXFreqSet_clicked();
+    void on_buttonFreqSweep_clicked();
 
     void listRefClockProfiles_currentIndexChanged(int index)       UI_EVENT(5000, 1, RefClockSelectProfile(index, true))
 
@@ -179,10 +182,17 @@ private slots:
     void on_buttonEyeScanStart_clicked();
     void on_buttonEyeScanStop_clicked();
     void on_checkESEnableAll_clicked(bool checked);
+    void on_buttonEyeDrift_clicked();
+    void on_buttonEyeContour_clicked();
+    void on_buttonEyeScanPlan_clicked() { eyeScanPlan(GT1724::GT1724_EYE_SCAN); }
+    void on_buttonEyeGoldenSave_clicked();
+    void on_buttonEyeGoldenCompare_clicked();
 
     // --- Bathtub Page: ---------------
     void on_buttonBathtubStart_clicked();
     void on_buttonBathtubStop_clicked();
+    void on_buttonBathtubPlan_clicked() { eyeScanPlan(GT1724::GT1724_BATHTUB_SCAN); }
+    void on_buttonBathtubOffsets_clicked();
     void on_checkBPEnableAll_clicked(bool checked);
 
 
@@ -214,6 +224,8 @@ private:
     void uiChangeOnConnect(bool connectedStatus);
 
     void frequencyProfileChanged(int index);
+    void freqSweepUIUpdate(bool isRunning);
+    double freqSweepListFrequency(const BertUIList *list) const;
 
     void pgDemphChanged(int level);
 
@@ -229,8 +241,15 @@ private:
 
     void eyeScanUIUpdate(bool isRunning);
     bool eyeScanStart(int type, int firstChannel);
+    int  eyeContourStart();
+    void eyeScanEstimate(int type, int channelCount);
+    void eyeScanPlan(int type);
+    void eyeScanAutoStopSet(bool enabled);
+    void eyeDriftUIUpdate(bool isRunning);
+    QString eyeGoldenFileName(int channel);
 
     void bathtubUIUpdate(bool isRunning);
+    int  bathtubOffsetsStart();
 
     void closeEvent(QCloseEvent *event);
 
@@ -257,10 +276,28 @@ private:
 
     static const QStringList EYESCAN_REPEATS_LIST;     // List of options for "Repeats" list (Eyescan and Bathtub plot)
     static const QList<int>  EYESCAN_REPEATS_LOOKUP;   // Lookup table of actual values associated with "repeats" list
+    static const QStringList EYESCAN_PLAN_TIME_LIST;   // List of options for "Time Limit" list (Eyescan and Bathtub plot)
+    static const QList<double> EYESCAN_PLAN_TIME_LOOKUP; // Lookup table of time limits (seconds) associated with "Time Limit" list
 
     static const int HEIGHT_ADD_TEMPS = 30;      // "Temperature" group on connect page: Add this much extra height to box after first row of temperatures
     static const int HEIGHT_ADD_CHECKBOX = 30;   // "Scan Channel" checkboxes on Eyescan / Bathtub pages: Add this much extra height per row
 
+    static const double EYE_DRIFT_TARGET_BER;    // Eye drift monitor: BER which defines the eye opening
+    static const double EYE_DRIFT_THRESHOLD;     // Eye drift monitor: Shrink in eye opening (UI) which raises an alarm
+    static const double EYE_DRIFT_DUTY_CYCLE;    // Eye drift monitor: Fraction of bus time used by snapshots (shared by all channels)
+
+    static const QStringList FREQ_SWEEP_TIME_LIST;     // List of options for frequency sweep "Time per Rate" list
+    static const QList<double> FREQ_SWEEP_TIME_LOOKUP; // Lookup table of measurement times (seconds) associated with "Time per Rate" list
+
+    static const double EYE_AUTOSTOP_TOLERANCE;  // Auto-stop: Change in eye metrics between repeats (relative) which counts as stable
+    static const double EYE_AUTOSTOP_METRIC_BER; // Auto-stop: BER which defines the open part of the eye
+
+    static const double EYE_CONTOUR_TARGET_BER;  // Contour scan: BER which defines the boundary of the eye
+    static const int    EYE_CONTOUR_REPEATS;     // Contour scan: Number of sweeps used to confirm each boundary point
+
+    static const double EYE_GOLDEN_TOLERANCE;    // Golden eye compare: Change in BER (decades) which counts as worse / better
+    static const double EYE_GOLDEN_PLOT_RANGE;   // Golden eye compare: Change in BER (decades) at each end of the plot colour scale
+
 
     // Bert Worker Class: Handles the work of communicating with the hardware
     BertWorker *bertWorker;
@@ -314,6 +351,8 @@ private:
     int  eyeScansTotal = 0;     // Number of eye scans to do in this run (=[active channels] * [repeats])
     int  eyeScansDone = 0;      // Number of eye scans finished in this run
 
+    QMap<int, bool> eyeScanChannelDone;  // Channel needs no more repeats (bathtub fit converged, or auto-stop), for each channel
+
     bool connectInProgress = false;
     bool commsConnected;
     bool eventsEnabled = false;
@@ -323,7 +362,13 @@ private:
     bool edPending = false;
     bool edRunning = false;
     bool eyeScanRunning = false;
+    bool eyeDriftRunning = false;
+    int  eyeContourPending = 0;       // Channels with a contour scan still to finish
     bool bathtubRunning = false;
+    int  bathtubOffsetsPending = 0;   // Channels with a multi-row bathtub scan still to finish
+    bool freqSweepRunning = false;
+
+    QString instrumentSerial;   // From EEPROM; stored in golden eye files
 
     int currentTabIndex = 0;
 
@@ -359,10 +404,17 @@ private:
     BertUIGroup         *groupClock;
     QVBoxLayout         *layoutClockSynth;
     BertUIList          *listLMXFreq;
+    BertUITextInput     *inputLMXFreq;
+    BertUIButton        *buttonLMXFreqSet;
     BertUILamp          *lampLMXLockMaster;
     BertUILamp          *lampLMXLockSlave;
     BertUIList          *listLMXTrigOutDivRatio;
     BertUIList          *listLMXTrigOutPower;
+    BertUIList          *listFreqSweepFrom;
+    BertUIList          *listFreqSweepTo;
+    BertUITextInput     *inputFreqSweepStep;
+    BertUIList          *listFreqSweepTime;
+    BertUIButton        *buttonFreqSweep;
 
     BertUIGroup         *groupRefClock;
     BertUIList          *listRefClockProfiles;
@@ -390,6 +442,13 @@ private:
     BertUIList          *listEyeScanHStep;
     BertUIList          *listEyeScanCountRes;
     BertUIList          *listEyeScanRepeats;
+    BertUIList          *listEyeScanPlanTime;
+    BertUIButton        *buttonEyeScanPlan;
+    BertUICheckBox      *checkEyeScanAutoStop;
+    BertUIButton        *buttonEyeContour;
+    BertUIButton        *buttonEyeDrift;
+    BertUIButton        *buttonEyeGoldenSave;
+    BertUIButton        *buttonEyeGoldenCompare;
     BertUICheckBox      *checkESEnableAll;
     BertUIPane          *paneESCheckBoxes;
     QGridLayout         *layoutESCheckboxes;
@@ -400,8 +459,13 @@ private:
     BertUIButton        *buttonBathtubStart;
     BertUIButton        *buttonBathtubStop;
     BertUIList          *listBathtubVOffset;
+    BertUIList          *listBathtubHStep;
     BertUIList          *listBathtubCountRes;
     BertUIList          *listBathtubRepeats;
+    BertUIList          *listBathtubPlanTime;
+    BertUIButton        *buttonBathtubPlan;
+    BertUICheckBox      *checkBathtubAutoStop;
+    BertUIButton        *buttonBathtubOffsets;
     BertUICheckBox      *checkBPEnableAll;
     BertUIPane          *paneBPCheckBoxes;
     QGridLayout         *layoutBPCheckboxes;
@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Unit tests for the non-hardware modules
+# (build with qmake; run each test or use "make check")
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += tst_eyemetrics \
+           tst_bathtubfit \
+           tst_scanplanner \
+           tst_lmxpllplanner \
+           tst_lmxfrequencyprofile \
+           tst_eyearchive
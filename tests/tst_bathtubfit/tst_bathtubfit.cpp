@@ -0,0 +1,131 @@
+/*!
+ \file   tst_bathtubfit.cpp
+ \brief  Unit Tests: BathtubFit
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QtTest>
+#include <math.h>
+
+#include "BathtubFit.h"
+
+class TestBathtubFit : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void qFromBERInverse();
+    void fitDualDirac();
+    void fitNotEnoughPoints();
+    void fitBERMaxRange();
+
+private:
+    static double tailBER(double q);
+    static QVector<double> curveMake(int nPoints, double muLeft, double muRight, double sigma, double floorBER);
+};
+
+
+/*!
+ \brief BER of one Gaussian tail, Q standard deviations from its Dirac edge
+*/
+double TestBathtubFit::tailBER(double q)
+{
+    return BathtubFit::TRANSITION_DENSITY * 0.5 * erfc(q / sqrt(2.0));
+}
+
+
+/*!
+ \brief Make a bathtub curve from the dual-Dirac model
+ Same form as a bathtub scan: log10(BER) at each phase step across 1 UI,
+ with points below floorBER set to BELOW_DETECTION_LIMIT.
+*/
+QVector<double> TestBathtubFit::curveMake(int nPoints, double muLeft, double muRight, double sigma, double floorBER)
+{
+    QVector<double> curve;
+    for (int i = 0; i < nPoints; i++)
+    {
+        const double x = static_cast<double>(i) / static_cast<double>(nPoints);
+        const double ber = tailBER((x - muLeft) / sigma) + tailBER((muRight - x) / sigma);
+        if (ber < floorBER) curve.append(globals::BELOW_DETECTION_LIMIT);
+        else                curve.append(log10(ber));
+    }
+    return curve;
+}
+
+
+/*!
+ \brief qFromBER is the inverse of the tail model
+*/
+void TestBathtubFit::qFromBERInverse()
+{
+    const QVector<double> qValues = { 0.5, 1.0, 3.0, 5.0, 7.0 };
+    foreach (double q, qValues)
+    {
+        QVERIFY(fabs(BathtubFit::qFromBER(tailBER(q)) - q) < 1e-6);
+    }
+}
+
+
+/*!
+ \brief Fit a curve made from the model
+
+ Dirac edges at 0.2 and 0.8 UI, RJ 0.02 UI RMS, floor 1e-9. Only points
+ at BER <= 1e-3 are fitted, where the other tail is negligible, so the
+ model parameters should be recovered almost exactly.
+*/
+void TestBathtubFit::fitDualDirac()
+{
+    const double muLeft = 0.2, muRight = 0.8, sigma = 0.02;
+    const QVector<double> curve = curveMake(128, muLeft, muRight, sigma, 1e-9);
+    BathtubFit::result_t result;
+    QCOMPARE(BathtubFit::fit(curve, 1e-3, &result), globals::OK);
+    QVERIFY(result.valid);
+    QVERIFY(result.pointsLeft >= BathtubFit::MIN_TAIL_POINTS);
+    QVERIFY(result.pointsRight >= BathtubFit::MIN_TAIL_POINTS);
+    QVERIFY(fabs(result.muLeft - muLeft) < 1e-4);
+    QVERIFY(fabs(result.muRight - muRight) < 1e-4);
+    QVERIFY(fabs(result.rjRMS - sigma) < 1e-4);
+    QVERIFY(fabs(result.djDualDirac - (1.0 - (muRight - muLeft))) < 1e-3);
+    QVERIFY(result.rSquaredLeft > 0.9999);
+    QVERIFY(result.rSquaredRight > 0.9999);
+
+    // Extrapolated opening at 1e-12:
+    const double q = BathtubFit::qFromBER(1e-12);
+    const double expected = (muRight - muLeft) - (2.0 * q * sigma);
+    QVERIFY(fabs(BathtubFit::eyeOpening(result, 1e-12) - expected) < 1e-3);
+    // Closed eye:
+    QCOMPARE(BathtubFit::eyeOpening(result, 1e-300), 0.0);
+}
+
+
+/*!
+ \brief Tails too short to fit (only a few points between the floor and fitBERMax)
+*/
+void TestBathtubFit::fitNotEnoughPoints()
+{
+    // Very steep tails: RJ much smaller than the phase step.
+    const QVector<double> curve = curveMake(32, 0.2, 0.8, 0.001, 1e-9);
+    BathtubFit::result_t result;
+    QCOMPARE(BathtubFit::fit(curve, 1e-3, &result), globals::INVALID_DATA);
+    QVERIFY(!result.valid);
+    QCOMPARE(BathtubFit::eyeOpening(result, 1e-12), 0.0);
+}
+
+
+/*!
+ \brief fitBERMax must be between 0 and the transition density
+*/
+void TestBathtubFit::fitBERMaxRange()
+{
+    const QVector<double> curve = curveMake(128, 0.2, 0.8, 0.02, 1e-9);
+    BathtubFit::result_t result;
+    QCOMPARE(BathtubFit::fit(curve, 0.0, &result), globals::OVERFLOW);
+    QCOMPARE(BathtubFit::fit(curve, BathtubFit::TRANSITION_DENSITY, &result), globals::OVERFLOW);
+    QCOMPARE(BathtubFit::fit(QVector<double>(4, -3.0), 1e-3, &result), globals::OVERFLOW);
+}
+
+
+QTEST_APPLESS_MAIN(TestBathtubFit)
+
+#include "tst_bathtubfit.moc"
@@ -0,0 +1,234 @@
+/*!
+ \file   tst_eyearchive.cpp
+ \brief  Unit Tests: EyeArchive
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <math.h>
+
+#include "EyeArchive.h"
+
+class TestEyeArchive : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void saveLoadRoundTrip();
+    void longRunsAndWideCounts();
+    void decodeRejectsBadData();
+    void saveRejectsBadRecord();
+    void compareGolden();
+
+private:
+    static EyeArchive::record_t recordMake(int xRes, int yRes, int countResBits, int repeatCount);
+    static QByteArray fileRead(const QString &fileName);
+};
+
+
+/*!
+ \brief Make an eye-like scan: Saturated at the left and right edges,
+        open in the middle, with a gradient of counts in between
+*/
+EyeArchive::record_t TestEyeArchive::recordMake(int xRes, int yRes, int countResBits, int repeatCount)
+{
+    EyeArchive::record_t record;
+    record.lane         = 2;
+    record.type         = 1;  // GT1724_EYE_SCAN
+    record.xRes         = xRes;
+    record.yRes         = yRes;
+    record.hStep        = 2;
+    record.vStep        = 4;
+    record.vOffset      = 1;
+    record.phaseShift   = -5;
+    record.countResBits = countResBits;
+    record.repeatCount  = repeatCount;
+    record.timestamp    = Q_INT64_C(1790000000000);
+    record.serial       = "SB-000123";
+
+    const quint32 saturated = EyeArchive::saturatedCount(record);
+    for (int y = 0; y < yRes; y++)
+    {
+        for (int x = 0; x < xRes; x++)
+        {
+            const int edge = qMin(x, xRes - 1 - x);  // Distance from nearest edge
+            quint32 count;
+            if      (edge < 4)  count = saturated;
+            else if (edge < 12) count = static_cast<quint32>((saturated / (edge - 2)) + y);
+            else                count = 0;
+            record.counts.append(count);
+        }
+    }
+    return record;
+}
+
+
+/*!
+ \brief Read a whole file
+*/
+QByteArray TestEyeArchive::fileRead(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+
+/*!
+ \brief Save and load a scan; everything comes back unchanged, in fewer bytes than the raw counts
+*/
+void TestEyeArchive::saveLoadRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("eye.sbeye");
+    const EyeArchive::record_t record = recordMake(64, 32, 8, 10);
+
+    QCOMPARE(EyeArchive::save(fileName, record), globals::OK);
+    const QByteArray fileData = fileRead(fileName);
+    QVERIFY(fileData.size() > EyeArchive::HEADER_SIZE);
+    QVERIFY(fileData.size() < (record.counts.size() * 2));
+
+    EyeArchive::record_t loaded;
+    QCOMPARE(EyeArchive::load(fileName, &loaded), globals::OK);
+    QCOMPARE(loaded.lane,         record.lane);
+    QCOMPARE(loaded.type,         record.type);
+    QCOMPARE(loaded.xRes,         record.xRes);
+    QCOMPARE(loaded.yRes,         record.yRes);
+    QCOMPARE(loaded.hStep,        record.hStep);
+    QCOMPARE(loaded.vStep,        record.vStep);
+    QCOMPARE(loaded.vOffset,      record.vOffset);
+    QCOMPARE(loaded.phaseShift,   record.phaseShift);
+    QCOMPARE(loaded.countResBits, record.countResBits);
+    QCOMPARE(loaded.repeatCount,  record.repeatCount);
+    QCOMPARE(loaded.timestamp,    record.timestamp);
+    QCOMPARE(loaded.serial,       record.serial);
+    QVERIFY(loaded.counts == record.counts);
+
+    // Decoding the same bytes from memory gives the same result:
+    EyeArchive::record_t decoded;
+    QCOMPARE(EyeArchive::decode(reinterpret_cast<const uchar *>(fileData.constData()), fileData.size(), &decoded), globals::OK);
+    QVERIFY(decoded.counts == record.counts);
+}
+
+
+/*!
+ \brief Runs longer than RUN_LENGTH_MAX are split, and counts above
+        0xFFFF use 4 byte literals
+*/
+void TestEyeArchive::longRunsAndWideCounts()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // All open: 256 * 127 cells of zero (more than one run):
+    EyeArchive::record_t record = recordMake(256, 127, 8, 1);
+    record.counts.fill(0);
+    const QString fileZero = dir.filePath("zero.sbeye");
+    QCOMPARE(EyeArchive::save(fileZero, record), globals::OK);
+    QVERIFY(fileRead(fileZero).size() < (EyeArchive::HEADER_SIZE + 16));
+    EyeArchive::record_t loaded;
+    QCOMPARE(EyeArchive::load(fileZero, &loaded), globals::OK);
+    QVERIFY(loaded.counts == record.counts);
+
+    // Saturated count 255 * 1000 = 255000, more than 16 bits:
+    record = recordMake(128, 16, 8, 1000);
+    QVERIFY(EyeArchive::saturatedCount(record) > 0xFFFF);
+    const QString fileWide = dir.filePath("wide.sbeye");
+    QCOMPARE(EyeArchive::save(fileWide, record), globals::OK);
+    QCOMPARE(EyeArchive::load(fileWide, &loaded), globals::OK);
+    QVERIFY(loaded.counts == record.counts);
+}
+
+
+/*!
+ \brief Corrupt, truncated or foreign data are rejected
+*/
+void TestEyeArchive::decodeRejectsBadData()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("eye.sbeye");
+    QCOMPARE(EyeArchive::save(fileName, recordMake(64, 32, 8, 10)), globals::OK);
+    const QByteArray good = fileRead(fileName);
+    EyeArchive::record_t record;
+
+    QByteArray data = good;
+    data[EyeArchive::HEADER_SIZE + 1] = static_cast<char>(data[EyeArchive::HEADER_SIZE + 1] ^ 0x01);
+    QCOMPARE(EyeArchive::decode(reinterpret_cast<const uchar *>(data.constData()), data.size(), &record), globals::BAD_CHECKSUM);
+
+    data = good;
+    data[0] = 'X';
+    QCOMPARE(EyeArchive::decode(reinterpret_cast<const uchar *>(data.constData()), data.size(), &record), globals::INVALID_DATA);
+
+    data = good.left(good.size() - 1);
+    QCOMPARE(EyeArchive::decode(reinterpret_cast<const uchar *>(data.constData()), data.size(), &record), globals::INVALID_DATA);
+
+    data = good.left(EyeArchive::HEADER_SIZE - 1);
+    QCOMPARE(EyeArchive::decode(reinterpret_cast<const uchar *>(data.constData()), data.size(), &record), globals::INVALID_DATA);
+
+    QCOMPARE(EyeArchive::load(dir.filePath("missing.sbeye"), &record), globals::FILE_ERROR);
+}
+
+
+/*!
+ \brief Records without a complete count plane can't be saved
+*/
+void TestEyeArchive::saveRejectsBadRecord()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    EyeArchive::record_t record = recordMake(64, 32, 8, 10);
+    record.counts.removeLast();
+    QCOMPARE(EyeArchive::save(dir.filePath("bad.sbeye"), record), globals::INVALID_DATA);
+    record.counts.clear();
+    record.xRes = 0;
+    QCOMPARE(EyeArchive::save(dir.filePath("bad.sbeye"), record), globals::INVALID_DATA);
+}
+
+
+/*!
+ \brief Compare with a golden scan
+*/
+void TestEyeArchive::compareGolden()
+{
+    const EyeArchive::record_t golden = recordMake(64, 32, 8, 10);
+    EyeArchive::diff_t diff;
+
+    // Identical:
+    QCOMPARE(EyeArchive::compare(golden, golden, 0.1, &diff), globals::OK);
+    QCOMPARE(diff.delta.size(), golden.counts.size());
+    QCOMPARE(diff.maxDelta, 0.0);
+    QCOMPARE(diff.rmsDelta, 0.0);
+    QCOMPARE(diff.cellsWorse, 0);
+    QCOMPARE(diff.cellsBetter, 0);
+    QCOMPARE(diff.openCells, diff.openCellsGolden);
+
+    // One open cell closed (BER at 1 decade above the floor); one error cell opened:
+    EyeArchive::record_t scan = golden;
+    const int closedCell = 32;   // Middle of the first row
+    const int openedCell = 8;    // In the gradient
+    QCOMPARE(scan.counts[closedCell], 0u);
+    QVERIFY(scan.counts[openedCell] > 0u);
+    scan.counts[closedCell] = 10;
+    scan.counts[openedCell] = 0;
+    QCOMPARE(EyeArchive::compare(scan, golden, 0.1, &diff), globals::OK);
+    QCOMPARE(diff.cellsWorse, 1);
+    QCOMPARE(diff.cellsBetter, 1);
+    QCOMPARE(diff.openCells, diff.openCellsGolden);
+    QVERIFY(fabs(diff.delta[closedCell] - 1.0) < 1e-9);
+    QVERIFY(diff.delta[openedCell] < -0.1);
+    QVERIFY(fabs(diff.maxDelta) >= 1.0);
+
+    // Different resolutions can't be compared:
+    scan = recordMake(32, 32, 8, 10);
+    QCOMPARE(EyeArchive::compare(scan, golden, 0.1, &diff), globals::INVALID_DATA);
+}
+
+
+QTEST_APPLESS_MAIN(TestEyeArchive)
+
+#include "tst_eyearchive.moc"
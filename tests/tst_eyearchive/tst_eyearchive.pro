@@ -0,0 +1,16 @@
+QT       += testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=c++11
+
+TEMPLATE = app
+TARGET   = tst_eyearchive
+
+CONFIG  += qt console testcase
+CONFIG  -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_eyearchive.cpp \
+           ../../EyeArchive.cpp \
+           ../../globals.cpp
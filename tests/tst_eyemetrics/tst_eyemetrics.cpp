@@ -0,0 +1,320 @@
+/*!
+ \file   tst_eyemetrics.cpp
+ \brief  Unit Tests: EyeMetrics
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QtTest>
+#include <math.h>
+
+#include "EyeMetrics.h"
+
+class TestEyeMetrics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void computeDiamondEye();
+    void computeOutOfRange();
+    void computeWorkspaceReuse();
+    void centreFindDiamondEye();
+    void centreFindWrappedEye();
+    void centreFindOffCentreOutlier();
+    void centreFindClosedEye();
+    void contourSaddleCentreHigh();
+    void contourSaddleCentreLow();
+    void contourSaddleMirrored();
+
+private:
+    static const int    SIZE_X = 64;
+    static const int    SIZE_Y = 32;
+    static const double N_BITS;
+    static const double BER;
+
+    static QVector<double> eyeMake(int centreX);
+    static double columnDistance(double a, double b);
+    static bool hasSegment(const QVector<double> &points, const QVector<int> &sizes,
+                           double x0, double y0, double x1, double y1);
+};
+
+const double TestEyeMetrics::N_BITS = 1.0e6;
+const double TestEyeMetrics::BER    = 1.0e-3;
+
+
+/*!
+ \brief Make a diamond shaped eye (SIZE_X x SIZE_Y)
+
+ Open (no errors) where |x - centreX| / 20 + |y - 16| / 10 < 1, with
+ x measured around the row (the eye may wrap past the end). Closed cells
+ have an error count which grows with the distance from the centre
+ column, up to BER 0.5 half a UI away. For centreX = 32: the widest row
+ is row 16 (columns 13 - 51), and the centre column is open from row 7
+ to row 25.
+*/
+QVector<double> TestEyeMetrics::eyeMake(int centreX)
+{
+    QVector<double> counts;
+    for (int y = 0; y < SIZE_Y; y++)
+    {
+        for (int x = 0; x < SIZE_X; x++)
+        {
+            const double dx = columnDistance(x, centreX);
+            const double dy = fabs(static_cast<double>(y - 16));
+            if (((dx / 20.0) + (dy / 10.0)) < 1.0) counts.append(0.0);
+            else                                    counts.append(N_BITS * 0.5 * ((dx + 1.0) / ((SIZE_X / 2) + 1.0)));
+        }
+    }
+    return counts;
+}
+
+
+/*!
+ \brief Distance between two columns, around the row
+*/
+double TestEyeMetrics::columnDistance(double a, double b)
+{
+    const double d = fabs(a - b);
+    return qMin(d, SIZE_X - d);
+}
+
+
+/*!
+ \brief Check for a 2 point polyline between two points (in either direction)
+*/
+bool TestEyeMetrics::hasSegment(const QVector<double> &points, const QVector<int> &sizes,
+                                double x0, double y0, double x1, double y1)
+{
+    const double TOL = 1e-9;
+    int start = 0;
+    foreach (int size, sizes)
+    {
+        if (size == 2)
+        {
+            const double ax = points[2 * start],       ay = points[(2 * start) + 1];
+            const double bx = points[2 * (start + 1)], by = points[(2 * (start + 1)) + 1];
+            if ((fabs(ax - x0) < TOL && fabs(ay - y0) < TOL && fabs(bx - x1) < TOL && fabs(by - y1) < TOL) ||
+                (fabs(ax - x1) < TOL && fabs(ay - y1) < TOL && fabs(bx - x0) < TOL && fabs(by - y0) < TOL)) return true;
+        }
+        start += size;
+    }
+    return false;
+}
+
+
+/*!
+ \brief Width, height, area, centre and crossing of a diamond eye
+*/
+void TestEyeMetrics::computeDiamondEye()
+{
+    const QVector<double> counts = eyeMake(32);
+    EyeMetrics::metrics_t metrics;
+    QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, N_BITS, BER, &metrics), globals::OK);
+    QCOMPARE(metrics.ber, BER);
+    QCOMPARE(metrics.width, 39);
+    QCOMPARE(metrics.widthRow, 16);
+    QCOMPARE(metrics.height, 19);
+    QVERIFY(fabs(metrics.centreX - 32.0) < 1e-9);
+    QVERIFY(fabs(metrics.centreY - 16.0) < 1e-9);
+    QCOMPARE(metrics.crossingX, 0);
+
+    int area = 0;
+    foreach (double count, counts) if (count == 0.0) area++;
+    QCOMPARE(metrics.area, area);
+
+    // Contour: One closed polyline around the open area, between the open and closed cells:
+    QCOMPARE(metrics.contourSizes.size(), 1);
+    QCOMPARE(metrics.contourPoints.size(), 2 * metrics.contourSizes[0]);
+    for (int i = 0; i < metrics.contourPoints.size(); i += 2)
+    {
+        const double dx = fabs(metrics.contourPoints[i] - 32.0);
+        const double dy = fabs(metrics.contourPoints[i + 1] - 16.0);
+        QVERIFY(((dx / 20.0) + (dy / 10.0)) > 0.8);
+        QVERIFY(((dx / 20.0) + (dy / 10.0)) < 1.2);
+    }
+
+    // Threshold above every count: the whole grid is open:
+    QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, N_BITS, 0.6, &metrics), globals::OK);
+    QCOMPARE(metrics.width, static_cast<int>(SIZE_X));
+    QCOMPARE(metrics.height, static_cast<int>(SIZE_Y));
+    QCOMPARE(metrics.area, SIZE_X * SIZE_Y);
+}
+
+
+/*!
+ \brief Parameters out of range
+*/
+void TestEyeMetrics::computeOutOfRange()
+{
+    const QVector<double> counts = eyeMake(32);
+    EyeMetrics::metrics_t metrics;
+    QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y - 1, N_BITS, BER, &metrics), globals::OVERFLOW);
+    QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, 0.0, BER, &metrics), globals::OVERFLOW);
+    QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, N_BITS, 0.0, &metrics), globals::OVERFLOW);
+    EyeMetrics::centre_t centre;
+    QCOMPARE(EyeMetrics::centreFind(counts, 1, SIZE_Y, N_BITS, BER, &centre), globals::OVERFLOW);
+    QCOMPARE(EyeMetrics::centreFind(counts, SIZE_X, SIZE_Y + 1, N_BITS, BER, &centre), globals::OVERFLOW);
+}
+
+
+/*!
+ \brief A reused workspace (prepared for a larger grid) gives the same results
+*/
+void TestEyeMetrics::computeWorkspaceReuse()
+{
+    EyeMetrics::workspace_t workspace;
+    EyeMetrics::metrics_t metrics, expected;
+    QCOMPARE(EyeMetrics::workspacePrepare(&workspace, 128, 128), globals::OK);
+    for (int centreX = 20; centreX <= 44; centreX += 12)
+    {
+        const QVector<double> counts = eyeMake(centreX);
+        QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, N_BITS, BER, &expected), globals::OK);
+        QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, N_BITS, BER, &metrics, &workspace), globals::OK);
+        QCOMPARE(metrics.width, expected.width);
+        QCOMPARE(metrics.height, expected.height);
+        QCOMPARE(metrics.area, expected.area);
+        QCOMPARE(metrics.centreX, expected.centreX);
+        QCOMPARE(metrics.centreY, expected.centreY);
+        QCOMPARE(metrics.crossingX, expected.crossingX);
+        QCOMPARE(metrics.contourSizes, expected.contourSizes);
+        QCOMPARE(metrics.contourPoints, expected.contourPoints);
+    }
+    QCOMPARE(workspace.field.size(), 128 * 128);  // Not shrunk
+}
+
+
+/*!
+ \brief Centre of a diamond eye in the middle of the row
+*/
+void TestEyeMetrics::centreFindDiamondEye()
+{
+    EyeMetrics::centre_t centre;
+    QCOMPARE(EyeMetrics::centreFind(eyeMake(32), SIZE_X, SIZE_Y, N_BITS, BER, &centre), globals::OK);
+    QVERIFY(fabs(centre.centreX - 32.0) <= 0.5);
+    QVERIFY(centre.windowWidth > 10);
+    QVERIFY(centre.windowWidth < 39);
+    QVERIFY(columnDistance(centre.crossingX, 0.0) <= 1.0);
+    QVERIFY(centre.confidence > 0.5);
+}
+
+
+/*!
+ \brief Centre of an eye split across the ends of the row
+*/
+void TestEyeMetrics::centreFindWrappedEye()
+{
+    EyeMetrics::centre_t centre;
+    QCOMPARE(EyeMetrics::centreFind(eyeMake(2), SIZE_X, SIZE_Y, N_BITS, BER, &centre), globals::OK);
+    QVERIFY(columnDistance(centre.centreX, 2.0) <= 0.5);
+    QVERIFY(centre.windowStart > 32);   // Window starts near the end of the row and wraps
+    QVERIFY(columnDistance(centre.crossingX, 34.0) <= 1.0);
+    QVERIFY(centre.confidence > 0.5);
+}
+
+
+/*!
+ \brief An off-centre outlier doesn't move the centre
+
+ Row 0 (the edge of the scan, where the eye is noisy) has a long open run
+ away from the eye, wider than the eye itself, and one column inside the
+ eye has errors on a few rows. The widest-row centre from compute follows
+ the outlier row; centreFind stays on the eye.
+*/
+void TestEyeMetrics::centreFindOffCentreOutlier()
+{
+    QVector<double> counts = eyeMake(32);
+    for (int x = 0; x < 48; x++) counts[x] = 0.0;                                  // Outlier row
+    for (int y = 12; y < 16; y++) counts[(y * SIZE_X) + 36] = N_BITS * 0.01;      // Noisy column in the eye
+
+    EyeMetrics::metrics_t metrics;
+    QCOMPARE(EyeMetrics::compute(counts, SIZE_X, SIZE_Y, N_BITS, BER, &metrics), globals::OK);
+    QCOMPARE(metrics.widthRow, 0);
+    QVERIFY(fabs(metrics.centreX - 32.0) > 5.0);
+
+    EyeMetrics::centre_t centre;
+    QCOMPARE(EyeMetrics::centreFind(counts, SIZE_X, SIZE_Y, N_BITS, BER, &centre), globals::OK);
+    QVERIFY(fabs(centre.centreX - 32.0) <= 1.0);
+    QVERIFY(centre.windowStart <= 36);
+    QVERIFY((centre.windowStart + centre.windowWidth) > 36);   // Noisy column didn't split the window
+    QVERIFY(centre.confidence > 0.5);
+}
+
+
+/*!
+ \brief No open cells: no centre, confidence 0
+*/
+void TestEyeMetrics::centreFindClosedEye()
+{
+    const QVector<double> counts(SIZE_X * SIZE_Y, N_BITS * 0.5);
+    EyeMetrics::centre_t centre;
+    QCOMPARE(EyeMetrics::centreFind(counts, SIZE_X, SIZE_Y, N_BITS, BER, &centre), globals::OK);
+    QCOMPARE(centre.confidence, 0.0);
+    QCOMPARE(centre.windowWidth, 0);
+}
+
+
+/*!
+ \brief Saddle (case 5) with the centre above the level
+
+ Counts (row by row):  1000    1
+                          1 1000
+ With 1000 bits, log10(BER) is 0 -3 / -3 0. At BER 10^-1.8 the centre
+ (-1.5) is above the level, so the two high corners are joined and the
+ contour cuts off the low corners (top right and bottom left).
+*/
+void TestEyeMetrics::contourSaddleCentreHigh()
+{
+    const QVector<double> counts = { 1000.0,    1.0,
+                                        1.0, 1000.0 };
+    EyeMetrics::metrics_t metrics;
+    QCOMPARE(EyeMetrics::compute(counts, 2, 2, 1000.0, pow(10.0, -1.8), &metrics), globals::OK);
+    QCOMPARE(metrics.contourSizes.size(), 2);
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 0.6, 0.0, 1.0, 0.4));  // Top -> right
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 0.4, 1.0, 0.0, 0.6));  // Bottom -> left
+}
+
+
+/*!
+ \brief Saddle (case 5) with the centre below the level
+
+ Same counts at BER 10^-1.2: the centre (-1.5) is below the level, so the
+ contour cuts off the high corners (top left and bottom right).
+*/
+void TestEyeMetrics::contourSaddleCentreLow()
+{
+    const QVector<double> counts = { 1000.0,    1.0,
+                                        1.0, 1000.0 };
+    EyeMetrics::metrics_t metrics;
+    QCOMPARE(EyeMetrics::compute(counts, 2, 2, 1000.0, pow(10.0, -1.2), &metrics), globals::OK);
+    QCOMPARE(metrics.contourSizes.size(), 2);
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 0.0, 0.4, 0.4, 0.0));  // Left -> top
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 1.0, 0.6, 0.6, 1.0));  // Right -> bottom
+}
+
+
+/*!
+ \brief Saddle (case 10): high corners at top right and bottom left
+*/
+void TestEyeMetrics::contourSaddleMirrored()
+{
+    const QVector<double> counts = {    1.0, 1000.0,
+                                     1000.0,    1.0 };
+    EyeMetrics::metrics_t metrics;
+
+    // Centre above the level: cut off the low corners (top left, bottom right):
+    QCOMPARE(EyeMetrics::compute(counts, 2, 2, 1000.0, pow(10.0, -1.8), &metrics), globals::OK);
+    QCOMPARE(metrics.contourSizes.size(), 2);
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 0.0, 0.4, 0.4, 0.0));
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 1.0, 0.6, 0.6, 1.0));
+
+    // Centre below the level: cut off the high corners (top right, bottom left):
+    QCOMPARE(EyeMetrics::compute(counts, 2, 2, 1000.0, pow(10.0, -1.2), &metrics), globals::OK);
+    QCOMPARE(metrics.contourSizes.size(), 2);
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 0.6, 0.0, 1.0, 0.4));
+    QVERIFY(hasSegment(metrics.contourPoints, metrics.contourSizes, 0.4, 1.0, 0.0, 0.6));
+}
+
+
+QTEST_APPLESS_MAIN(TestEyeMetrics)
+
+#include "tst_eyemetrics.moc"
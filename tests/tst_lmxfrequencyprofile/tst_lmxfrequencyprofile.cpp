@@ -0,0 +1,191 @@
+/*!
+ \file   tst_lmxfrequencyprofile.cpp
+ \brief  Unit Tests: LMXFrequencyProfile
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QtTest>
+#include <type_traits>
+
+#include "LMXFrequencyProfile.h"
+
+class TestLMXFrequencyProfile : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void copyable();
+    void registerSetGet();
+    void firstDifference();
+    void hash();
+    void toBytes();
+    void fromBytes();
+
+private:
+    static const int REGISTER_COUNT = 113;  // LMX2594 registers (R0 - R112)
+
+    static LMXFrequencyProfile profileMake(float frequency);
+};
+
+
+/*!
+ \brief Make a profile with a few registers set
+*/
+LMXFrequencyProfile TestLMXFrequencyProfile::profileMake(float frequency)
+{
+    LMXFrequencyProfile profile(REGISTER_COUNT);
+    profile.setFrequency(frequency);
+    profile.setRegisterValue(0,   0x251C);
+    profile.setRegisterValue(36,  0x0064);
+    profile.setRegisterValue(44,  0x1FA3);
+    profile.setRegisterValue(112, 0xABCD);
+    profile.setValid();
+    return profile;
+}
+
+
+/*!
+ \brief Profiles can be copied as plain memory
+*/
+void TestLMXFrequencyProfile::copyable()
+{
+    QVERIFY(std::is_trivially_copyable<LMXFrequencyProfile>::value);
+    QVERIFY(!QTypeInfo<LMXFrequencyProfile>::isStatic);
+
+    const LMXFrequencyProfile profile = profileMake(10.3125f);
+    LMXFrequencyProfile copy;
+    memcpy(&copy, &profile, sizeof(profile));
+    QVERIFY(copy == profile);
+    QCOMPARE(copy.getRegisterValue(44, nullptr), static_cast<uint16_t>(0x1FA3));
+}
+
+
+/*!
+ \brief Registers which haven't been set read as 0 and aren't found
+*/
+void TestLMXFrequencyProfile::registerSetGet()
+{
+    LMXFrequencyProfile profile = profileMake(10.3125f);
+    QCOMPARE(profile.getRegisterCount(), static_cast<int>(REGISTER_COUNT));
+    QCOMPARE(profile.getUsedRegisterCount(), 4);
+
+    bool found = false;
+    QCOMPARE(profile.getRegisterValue(112, &found), static_cast<uint16_t>(0xABCD));
+    QVERIFY(found);
+    QCOMPARE(profile.getRegisterValue(1, &found), static_cast<uint16_t>(0));
+    QVERIFY(!found);
+    QVERIFY(profile.isRegisterSet(36));
+    QVERIFY(!profile.isRegisterSet(37));
+
+    profile.clear();
+    QCOMPARE(profile.getUsedRegisterCount(), 0);
+    QCOMPARE(profile.getRegisterCount(), static_cast<int>(REGISTER_COUNT));
+    QVERIFY(!profile.isValid());
+}
+
+
+/*!
+ \brief Lowest register address with a different value
+*/
+void TestLMXFrequencyProfile::firstDifference()
+{
+    const LMXFrequencyProfile profile = profileMake(10.3125f);
+    LMXFrequencyProfile other = profile;
+    QCOMPARE(profile.firstDifference(other), -1);
+
+    other.setRegisterValue(44, 0x1FA2);
+    QCOMPARE(profile.firstDifference(other), 44);
+    other.setRegisterValue(36, 0x0065);
+    QCOMPARE(profile.firstDifference(other), 36);
+    QCOMPARE(other.firstDifference(profile), 36);
+
+    // Registers which haven't been set count as 0:
+    other = profile;
+    other.setRegisterValue(5, 0x0000);
+    QCOMPARE(profile.firstDifference(other), -1);
+    other.setRegisterValue(112, 0x0000);
+    QCOMPARE(profile.firstDifference(other), 112);
+
+    // Frequency isn't compared:
+    other = profile;
+    other.setFrequency(12.5f);
+    QCOMPARE(profile.firstDifference(other), -1);
+}
+
+
+/*!
+ \brief Equal profiles have equal hashes; changes to the contents change the hash
+*/
+void TestLMXFrequencyProfile::hash()
+{
+    const LMXFrequencyProfile profile = profileMake(10.3125f);
+    LMXFrequencyProfile other = profileMake(10.3125f);
+    QVERIFY(other == profile);
+    QCOMPARE(other.hash(), profile.hash());
+    QCOMPARE(qHash(other), qHash(profile));
+
+    other.setRegisterValue(36, 0x0065);
+    QVERIFY(!(other == profile));
+    QVERIFY(other.hash() != profile.hash());
+
+    other = profileMake(12.5f);
+    QVERIFY(!(other == profile));
+    QVERIFY(other.hash() != profile.hash());
+
+    // Setting a register to 0 changes the register set (but not the values):
+    other = profile;
+    other.setRegisterValue(5, 0x0000);
+    QVERIFY(other.hash() != profile.hash());
+}
+
+
+/*!
+ \brief Register values as bytes: 2 per register, LSB first; unset registers are 0
+*/
+void TestLMXFrequencyProfile::toBytes()
+{
+    const LMXFrequencyProfile profile = profileMake(10.3125f);
+    uint8_t data[REGISTER_COUNT * 2];
+    memset(data, 0xEE, sizeof(data));
+    QCOMPARE(profile.toBytes(data), static_cast<int>(REGISTER_COUNT * 2));
+    QCOMPARE(data[0],   static_cast<uint8_t>(0x1C));
+    QCOMPARE(data[1],   static_cast<uint8_t>(0x25));
+    QCOMPARE(data[2],   static_cast<uint8_t>(0x00));
+    QCOMPARE(data[3],   static_cast<uint8_t>(0x00));
+    QCOMPARE(data[72],  static_cast<uint8_t>(0x64));
+    QCOMPARE(data[73],  static_cast<uint8_t>(0x00));
+    QCOMPARE(data[224], static_cast<uint8_t>(0xCD));
+    QCOMPARE(data[225], static_cast<uint8_t>(0xAB));
+}
+
+
+/*!
+ \brief Round trip through bytes; fromBytes sets every register up to the count
+*/
+void TestLMXFrequencyProfile::fromBytes()
+{
+    const LMXFrequencyProfile profile = profileMake(10.3125f);
+    uint8_t data[REGISTER_COUNT * 2];
+    profile.toBytes(data);
+
+    LMXFrequencyProfile loaded = profileMake(12.5f);
+    loaded.setRegisterValue(7, 0x1234);
+    loaded.fromBytes(data, REGISTER_COUNT);
+    QCOMPARE(loaded.getRegisterCount(), static_cast<int>(REGISTER_COUNT));
+    QCOMPARE(loaded.getUsedRegisterCount(), static_cast<int>(REGISTER_COUNT));
+    QCOMPARE(loaded.firstDifference(profile), -1);
+    QCOMPARE(loaded.getRegisterValue(7, nullptr), static_cast<uint16_t>(0));
+
+    // Shorter profile: Registers past the count are cleared:
+    loaded.fromBytes(data, 40);
+    QCOMPARE(loaded.getRegisterCount(), 40);
+    QCOMPARE(loaded.getUsedRegisterCount(), 40);
+    QVERIFY(!loaded.isRegisterSet(44));
+    QCOMPARE(loaded.getRegisterValue(36, nullptr), static_cast<uint16_t>(0x0064));
+}
+
+
+QTEST_APPLESS_MAIN(TestLMXFrequencyProfile)
+
+#include "tst_lmxfrequencyprofile.moc"
@@ -0,0 +1,16 @@
+QT       += testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=c++11
+
+TEMPLATE = app
+TARGET   = tst_lmxfrequencyprofile
+
+CONFIG  += qt console testcase
+CONFIG  -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_lmxfrequencyprofile.cpp \
+           ../../LMXFrequencyProfile.cpp \
+           ../../globals.cpp
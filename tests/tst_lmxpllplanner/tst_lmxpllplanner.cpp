@@ -0,0 +1,202 @@
+/*!
+ \file   tst_lmxpllplanner.cpp
+ \brief  Unit Tests: LMXPllPlanner
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QtTest>
+#include <math.h>
+
+#include "LMXPllPlanner.h"
+
+class TestLMXPllPlanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fractionFind();
+    void vcoDirect();
+    void channelDivider();
+    void fractionalN();
+    void outOfRange();
+    void referenceRead();
+
+private:
+    static const int REGISTER_COUNT = 113;  // LMX2594 registers (R0 - R112)
+
+    static LMXPllPlanner::refPath_t refMake(double fPd);
+};
+
+
+/*!
+ \brief Make a reference path with a given phase detector frequency (MHz)
+*/
+LMXPllPlanner::refPath_t TestLMXPllPlanner::refMake(double fPd)
+{
+    LMXPllPlanner::refPath_t ref;
+    ref.fOsc  = fPd;
+    ref.osc2x = false;
+    ref.mult  = 1;
+    ref.preR  = 1;
+    ref.pllR  = 1;
+    ref.fPd   = fPd;
+    return ref;
+}
+
+
+/*!
+ \brief Closest fraction with a limited denominator
+*/
+void TestLMXPllPlanner::fractionFind()
+{
+    uint32_t num = 99, den = 99;
+    LMXPllPlanner::fractionFind(0.0, 1000, &num, &den);
+    QCOMPARE(num, 0u);
+    QCOMPARE(den, 1u);
+
+    LMXPllPlanner::fractionFind(0.75, 1000, &num, &den);
+    QCOMPARE(num, 3u);
+    QCOMPARE(den, 4u);
+
+    LMXPllPlanner::fractionFind(1.0 / 3.0, 1000, &num, &den);
+    QCOMPARE(num, 1u);
+    QCOMPARE(den, 3u);
+
+    // Fractional part of pi: Convergents 1/7, 15/106, 16/113, 4687/33102 ...
+    LMXPllPlanner::fractionFind(0.14159265358979, 100, &num, &den);
+    QCOMPARE(num, 1u);
+    QCOMPARE(den, 7u);
+    LMXPllPlanner::fractionFind(0.14159265358979, 1000, &num, &den);
+    QCOMPARE(num, 16u);
+    QCOMPARE(den, 113u);
+}
+
+
+/*!
+ \brief Outputs in the VCO range use the VCO directly (integer N here)
+*/
+void TestLMXPllPlanner::vcoDirect()
+{
+    const LMXFrequencyProfile base(REGISTER_COUNT);
+    LMXPllPlanner::plan_t plan;
+    QCOMPARE(LMXPllPlanner::plan(refMake(100.0), 10000.0, base, &plan), globals::OK);
+    QCOMPARE(plan.chDivIndex, -1);
+    QCOMPARE(plan.n, 100u);
+    QCOMPARE(plan.num, 0u);
+    QCOMPARE(plan.mashOrder, 0);
+    QVERIFY(fabs(plan.fVco - 10000.0) < 1e-9);
+    QVERIFY(fabs(plan.fOut - 10000.0) < 1e-9);
+    QCOMPARE(plan.vcoCore, 3);
+
+    // Ends of the VCO range:
+    QCOMPARE(LMXPllPlanner::plan(refMake(100.0), LMXPllPlanner::VCO_MIN_MHZ, base, &plan), globals::OK);
+    QCOMPARE(plan.chDivIndex, -1);
+    QCOMPARE(plan.vcoCore, 1);
+    QCOMPARE(LMXPllPlanner::plan(refMake(100.0), LMXPllPlanner::VCO_MAX_MHZ, base, &plan), globals::OK);
+    QCOMPARE(plan.chDivIndex, -1);
+    QCOMPARE(plan.vcoCore, 7);
+}
+
+
+/*!
+ \brief Lower outputs use the smallest channel divider which puts the VCO in range
+*/
+void TestLMXPllPlanner::channelDivider()
+{
+    const LMXFrequencyProfile base(REGISTER_COUNT);
+    const QVector<double> fOutValues = { 7499.0, 5000.0, 3750.0, 2500.0, 1000.0, 156.25, 100.0, 10.0 };
+    foreach (double fOut, fOutValues)
+    {
+        LMXPllPlanner::plan_t plan;
+        QCOMPARE(LMXPllPlanner::plan(refMake(100.0), fOut, base, &plan), globals::OK);
+        QVERIFY(plan.chDivIndex >= 0);
+        QVERIFY(plan.chDivIndex < LMXPllPlanner::CHDIV_LIST_SIZE);
+        const int chDiv = LMXPllPlanner::CHDIV_LIST[plan.chDivIndex];
+        QVERIFY(plan.fVco >= LMXPllPlanner::VCO_MIN_MHZ);
+        QVERIFY(plan.fVco <= LMXPllPlanner::VCO_MAX_MHZ);
+        if (plan.chDivIndex > 0)
+        {
+            // Next smaller divider would put the VCO below its range:
+            QVERIFY((fOut * LMXPllPlanner::CHDIV_LIST[plan.chDivIndex - 1]) < LMXPllPlanner::VCO_MIN_MHZ);
+        }
+        QVERIFY(fabs((plan.fVco / chDiv) - plan.fOut) < 1e-9);
+        QVERIFY(fabs(plan.fOut - fOut) < 1e-9);
+    }
+
+    // Specific cases: 5000 MHz -> /2; 1000 MHz -> /8; 10 MHz -> /768:
+    LMXPllPlanner::plan_t plan;
+    LMXPllPlanner::plan(refMake(100.0), 5000.0, base, &plan);
+    QCOMPARE(LMXPllPlanner::CHDIV_LIST[plan.chDivIndex], 2);
+    LMXPllPlanner::plan(refMake(100.0), 1000.0, base, &plan);
+    QCOMPARE(LMXPllPlanner::CHDIV_LIST[plan.chDivIndex], 8);
+    QCOMPARE(plan.n, 80u);
+    LMXPllPlanner::plan(refMake(100.0), 10.0, base, &plan);
+    QCOMPARE(LMXPllPlanner::CHDIV_LIST[plan.chDivIndex], 768);
+}
+
+
+/*!
+ \brief Fractional N: N + NUM / DEN matches fVco / fPD
+*/
+void TestLMXPllPlanner::fractionalN()
+{
+    const LMXFrequencyProfile base(REGISTER_COUNT);  // No MASH order set: Default is used
+    const double fPd = 100.0;
+    const QVector<double> fOutValues = { 10000.123456, 12345.678, 2666.6666, 161.1328125 };
+    foreach (double fOut, fOutValues)
+    {
+        LMXPllPlanner::plan_t plan;
+        QCOMPARE(LMXPllPlanner::plan(refMake(fPd), fOut, base, &plan), globals::OK);
+        QVERIFY(plan.num > 0);
+        QVERIFY(plan.num < plan.den);
+        QCOMPARE(plan.mashOrder, static_cast<int>(LMXPllPlanner::MASH_ORDER_DEFAULT));
+        const double ratio = static_cast<double>(plan.n) + (static_cast<double>(plan.num) / plan.den);
+        QVERIFY(fabs((ratio * fPd) - plan.fVco) < 1e-6);
+        QVERIFY(fabs(plan.fOut - fOut) < 1e-6);  // Within 1 Hz
+    }
+}
+
+
+/*!
+ \brief Frequencies which can't be reached
+*/
+void TestLMXPllPlanner::outOfRange()
+{
+    const LMXFrequencyProfile base(REGISTER_COUNT);
+    LMXPllPlanner::plan_t plan;
+    const double fOutMin = LMXPllPlanner::VCO_MIN_MHZ / 768.0;
+    QCOMPARE(LMXPllPlanner::plan(refMake(100.0), LMXPllPlanner::VCO_MAX_MHZ + 1.0, base, &plan), globals::OVERFLOW);
+    QCOMPARE(LMXPllPlanner::plan(refMake(100.0), fOutMin * 0.99, base, &plan), globals::OVERFLOW);
+    QCOMPARE(LMXPllPlanner::plan(refMake(0.0), 10000.0, base, &plan), globals::OVERFLOW);
+    // fPD too high for the minimum N (integer mode, N = 25 < 28):
+    QCOMPARE(LMXPllPlanner::plan(refMake(400.0), 10000.0, base, &plan), globals::OVERFLOW);
+}
+
+
+/*!
+ \brief Reference path from profile registers
+*/
+void TestLMXPllPlanner::referenceRead()
+{
+    LMXFrequencyProfile profile(REGISTER_COUNT);
+    LMXPllPlanner::refPath_t ref;
+    QCOMPARE(LMXPllPlanner::referenceRead(profile, 100.0, &ref), globals::INVALID_DATA);
+
+    profile.setRegisterValue(9,  1 << 12);   // OSC_2X
+    profile.setRegisterValue(10, 1 << 7);    // MULT = 1 (bypass)
+    profile.setRegisterValue(11, 2 << 4);    // PLL_R = 2
+    profile.setRegisterValue(12, 1);         // PLL_R_PRE = 1
+    QCOMPARE(LMXPllPlanner::referenceRead(profile, 100.0, &ref), globals::OK);
+    QVERIFY(ref.osc2x);
+    QCOMPARE(ref.mult, 1);
+    QCOMPARE(ref.pllR, 2);
+    QCOMPARE(ref.preR, 1);
+    QVERIFY(fabs(ref.fPd - 100.0) < 1e-9);
+    QCOMPARE(LMXPllPlanner::referenceRead(profile, 0.0, &ref), globals::OVERFLOW);
+}
+
+
+QTEST_APPLESS_MAIN(TestLMXPllPlanner)
+
+#include "tst_lmxpllplanner.moc"
@@ -0,0 +1,17 @@
+QT       += testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=c++11
+
+TEMPLATE = app
+TARGET   = tst_lmxpllplanner
+
+CONFIG  += qt console testcase
+CONFIG  -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_lmxpllplanner.cpp \
+           ../../LMXPllPlanner.cpp \
+           ../../LMXFrequencyProfile.cpp \
+           ../../globals.cpp
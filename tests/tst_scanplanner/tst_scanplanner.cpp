@@ -0,0 +1,221 @@
+/*!
+ \file   tst_scanplanner.cpp
+ \brief  Unit Tests: ScanPlanner
+ \author Smartest
+ \date   Oct 2026
+*/
+
+#include <QtTest>
+#include <math.h>
+
+#include "ScanPlanner.h"
+
+class TestScanPlanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void macroTime();
+    void sequenceRecordWait();
+    void initFromRecordedSequences();
+    void eyeScanParts();
+    void bathtubScanParts();
+    void stepLimitSplitsScan();
+    void planFitsBudget();
+    void planTooShort();
+    void read24Frames();
+
+private:
+    static ScanPlanner::costParams_t paramsMake();
+};
+
+
+/*!
+ \brief Cost parameters with round numbers: 5 ms per transaction, 4096 byte output memory
+*/
+ScanPlanner::costParams_t TestScanPlanner::paramsMake()
+{
+    ScanPlanner::costParams_t params;
+    ScanPlanner::defaultParams(&params);
+    params.opLatencyMs      = 5.0;
+    params.imageMaximumSize = 4096;
+    return params;
+}
+
+
+/*!
+ \brief Macro time: one transaction per write / read, plus whole status polls
+*/
+void TestScanPlanner::macroTime()
+{
+    const ScanPlanner::costParams_t params = paramsMake();
+    const double pollMs = ScanPlanner::MACRO_POLL_MS + params.opLatencyMs;
+    // Code only; finishes within one poll:
+    QVERIFY(fabs(ScanPlanner::macroMs(params, 0, 0, 0.0) - (5.0 + pollMs)) < 1e-9);
+    // Input, code and output; chip runs for 2.5 polls (rounded up to 3):
+    QVERIFY(fabs(ScanPlanner::macroMs(params, 8, 2, 2.5 * ScanPlanner::MACRO_POLL_MS) - (15.0 + (3.0 * pollMs))) < 1e-9);
+}
+
+
+/*!
+ \brief Recorded sequences: time not spent on transactions is waiting (never negative)
+*/
+void TestScanPlanner::sequenceRecordWait()
+{
+    ScanPlanner::costParams_t params = paramsMake();
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_GET_SETTINGS, 10, 200.0);
+    QCOMPARE(params.sequenceOps[ScanPlanner::SEQ_GET_SETTINGS], 10);
+    QVERIFY(fabs(params.sequenceWaitMs[ScanPlanner::SEQ_GET_SETTINGS] - 150.0) < 1e-9);
+
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_GET_SETTINGS, 10, 20.0);
+    QVERIFY(fabs(params.sequenceWaitMs[ScanPlanner::SEQ_GET_SETTINGS]) < 1e-9);
+
+    // Invalid sequence is ignored:
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_COUNT, 99, 999.0);
+    QCOMPARE(params.sequenceOps[ScanPlanner::SEQ_GET_SETTINGS], 10);
+}
+
+
+/*!
+ \brief Init estimates reproduce the recorded sequence times
+*/
+void TestScanPlanner::initFromRecordedSequences()
+{
+    ScanPlanner::costParams_t params = paramsMake();
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_MACRO_CHECK,   2, 120.0);
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_GET_SETTINGS, 10, 250.0);
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_CONFIG_PG,    30, 400.0);
+    ScanPlanner::sequenceRecord(&params, ScanPlanner::SEQ_SET_DEFAULTS, 40, 900.0);
+    const double warm = 0.120 + 0.250 + 0.400;
+    QVERIFY(fabs(ScanPlanner::initSeconds(params, false, 100) - warm) < 1e-9);
+    // Cold boot: Macro download (one transaction per record), macro check again, and set defaults:
+    QVERIFY(fabs(ScanPlanner::initSeconds(params, true, 100) - (warm + 0.500 + 0.120 + 0.900)) < 1e-9);
+}
+
+
+/*!
+ \brief Full resolution 8 bit eye scan is split into parts that fit the output memory
+
+ 128 phase steps x 8 bits = 128 bytes per line, so 32 of the 127 lines
+ fit in 4096 bytes: 4 parts.
+*/
+void TestScanPlanner::eyeScanParts()
+{
+    const ScanPlanner::costParams_t params = paramsMake();
+    ScanPlanner::eyeScanCost_t cost;
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, 0, 0, 3, 1, 1, &cost), globals::OK);
+    QCOMPARE(cost.cells, 128 * 127);
+    QCOMPARE(cost.parts, 4);
+    QCOMPARE(cost.macros, 5);
+    QCOMPARE(cost.bytesRead, 127 * 128);
+    QVERIFY(fabs(cost.sweepSeconds - ((128 * 127) * params.sweepMsPerCell[3] / 1000.0)) < 1e-9);
+
+    // Repeats and channels multiply the time:
+    ScanPlanner::eyeScanCost_t cost2;
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, 0, 0, 3, 3, 2, &cost2), globals::OK);
+    QVERIFY(fabs(cost2.repeatSeconds - (2.0 * cost.repeatSeconds)) < 1e-9);
+    QVERIFY(fabs(cost2.seconds - (6.0 * cost.repeatSeconds)) < 1e-9);
+
+    // Out of range:
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, 4, 0, 3, 1, 1, &cost), globals::OVERFLOW);
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, 0, 0, 4, 1, 1, &cost), globals::OVERFLOW);
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, 0, 0, 3, 0, 1, &cost), globals::OVERFLOW);
+}
+
+
+/*!
+ \brief Bathtub scan: one line (horizontal step applies; vertical step ignored)
+*/
+void TestScanPlanner::bathtubScanParts()
+{
+    const ScanPlanner::costParams_t params = paramsMake();
+    ScanPlanner::eyeScanCost_t cost;
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::BATHTUB_SCAN, 1, 3, 3, 1, 1, &cost), globals::OK);
+    QCOMPARE(cost.cells, 64);
+    QCOMPARE(cost.parts, 1);
+    QCOMPARE(cost.bytesRead, 64);
+}
+
+
+/*!
+ \brief A step time limit (ED running) splits the scan into smaller parts
+*/
+void TestScanPlanner::stepLimitSplitsScan()
+{
+    ScanPlanner::costParams_t params = paramsMake();
+    QCOMPARE(ScanPlanner::sweepLinesMax(params, 128, 3), 32);
+    // Shorter than any part: one line at a time:
+    params.stepMsMax = 1.0;
+    QCOMPARE(ScanPlanner::sweepLinesMax(params, 128, 3), 1);
+    ScanPlanner::eyeScanCost_t cost;
+    QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, 0, 0, 3, 1, 1, &cost), globals::OK);
+    QCOMPARE(cost.parts, 127);
+}
+
+
+/*!
+ \brief A long budget gets the finest scan, with as many repeats as fit
+*/
+void TestScanPlanner::planFitsBudget()
+{
+    const ScanPlanner::costParams_t params = paramsMake();
+    const double budget = 3600.0;
+    ScanPlanner::plan_t plan;
+    QCOMPARE(ScanPlanner::planBudget(params, ScanPlanner::EYE_SCAN, budget, 2, &plan), globals::OK);
+    QCOMPARE(plan.hStepIndex, 0);
+    QCOMPARE(plan.vStepIndex, 0);
+    QVERIFY(plan.repeatCount >= 1);
+    QVERIFY(plan.cost.seconds <= budget);
+    QVERIFY(plan.cost.seconds + plan.cost.repeatSeconds > budget);  // One more repeat wouldn't fit
+
+    QCOMPARE(ScanPlanner::planBudget(params, ScanPlanner::BATHTUB_SCAN, budget, 1, &plan), globals::OK);
+    QCOMPARE(plan.hStepIndex, 0);
+    QCOMPARE(plan.vStepIndex, 0);
+    QVERIFY(plan.cost.seconds <= budget);
+}
+
+
+/*!
+ \brief Nothing fits: the quickest scan is returned so the minimum time can be shown
+*/
+void TestScanPlanner::planTooShort()
+{
+    const ScanPlanner::costParams_t params = paramsMake();
+    ScanPlanner::plan_t plan;
+    QCOMPARE(ScanPlanner::planBudget(params, ScanPlanner::EYE_SCAN, 0.001, 1, &plan), globals::OVERFLOW);
+    QCOMPARE(plan.repeatCount, 1);
+    QVERIFY(plan.cost.repeatSeconds > 0.001);
+    ScanPlanner::eyeScanCost_t cost;
+    for (int h = 0; h < ScanPlanner::VHSTEP_COUNT; h++)
+    {
+        for (int v = 0; v < ScanPlanner::VHSTEP_COUNT; v++)
+        {
+            for (int cr = 0; cr < 4; cr++)
+            {
+                QCOMPARE(ScanPlanner::eyeScanCost(params, ScanPlanner::EYE_SCAN, h, v, cr, 1, 1, &cost), globals::OK);
+                QVERIFY(cost.repeatSeconds >= plan.cost.repeatSeconds);
+            }
+        }
+    }
+}
+
+
+/*!
+ \brief read24 frames: 16 bytes each, never leaving less than 2 bytes for the last one
+*/
+void TestScanPlanner::read24Frames()
+{
+    QCOMPARE(ScanPlanner::read24FrameCount(0), 0);
+    QCOMPARE(ScanPlanner::read24FrameCount(1), 1);
+    QCOMPARE(ScanPlanner::read24FrameCount(16), 1);
+    QCOMPARE(ScanPlanner::read24FrameCount(17), 2);   // 15 + 2
+    QCOMPARE(ScanPlanner::read24FrameCount(18), 2);   // 16 + 2
+    QCOMPARE(ScanPlanner::read24FrameCount(32), 2);
+    QCOMPARE(ScanPlanner::read24FrameCount(33), 3);   // 16 + 15 + 2
+    QCOMPARE(ScanPlanner::read24FrameCount(4096), 256);
+}
+
+
+QTEST_APPLESS_MAIN(TestScanPlanner)
+
+#include "tst_scanplanner.moc"